@@ -0,0 +1,142 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "adnl-test-network-simulator.h"
+
+namespace ton {
+
+namespace adnl {
+
+SimulatedNetworkManager::LinkStats &SimulatedNetworkManager::LinkStats::operator+=(const LinkStats &other) {
+  sent_packets += other.sent_packets;
+  sent_bytes += other.sent_bytes;
+  delivered_packets += other.delivered_packets;
+  delivered_bytes += other.delivered_bytes;
+  lost_packets += other.lost_packets;
+  dropped_packets += other.dropped_packets;
+  reordered_packets += other.reordered_packets;
+  return *this;
+}
+
+void SimulatedNetworkManager::send_udp_packet(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, td::IPAddress dst_addr,
+                                              td::uint32 priority, td::BufferSlice data) {
+  if (allowed_sources_.count(src_id) == 0 || allowed_destinations_.count(dst_id) == 0) {
+    // just drop
+    return;
+  }
+  auto &link = get_link(src_id, dst_id);
+  const auto &options = link.custom_options ? link.options : default_options_;
+  link.stats.sent_packets++;
+  link.stats.sent_bytes += data.size();
+
+  double now = td::Time::now();
+  if (options.loss > 0 && random_double() < options.loss) {
+    link.stats.lost_packets++;
+    return;
+  }
+
+  double sent_at = now;
+  if (options.bandwidth > 0) {
+    double start = std::max(now, link.busy_until);
+    if ((start - now) * options.bandwidth + static_cast<double>(data.size()) > options.queue_size) {
+      link.stats.dropped_packets++;
+      return;
+    }
+    link.busy_until = sent_at = start + static_cast<double>(data.size()) / options.bandwidth;
+  }
+
+  double deliver_at = sent_at + options.latency;
+  if (options.jitter > 0) {
+    deliver_at += random_double() * options.jitter;
+  }
+  if (options.reorder > 0 && random_double() < options.reorder) {
+    link.stats.reordered_packets++;
+    deliver_at += options.reorder_delay;
+  } else {
+    deliver_at = std::max(deliver_at, link.last_delivery_at);
+    link.last_delivery_at = deliver_at;
+  }
+
+  in_flight_.emplace(std::make_pair(deliver_at, seqno_++), Packet{src_id, dst_id, dst_addr, std::move(data)});
+  alarm_timestamp().relax(td::Timestamp::at(in_flight_.begin()->first.first));
+}
+
+void SimulatedNetworkManager::alarm() {
+  CHECK(callback_);
+  double now = td::Time::now();
+  while (!in_flight_.empty() && in_flight_.begin()->first.first <= now) {
+    auto packet = std::move(in_flight_.begin()->second);
+    in_flight_.erase(in_flight_.begin());
+
+    auto &stats = get_link(packet.src, packet.dst).stats;
+    stats.delivered_packets++;
+    stats.delivered_bytes += packet.data.size();
+    AdnlCategoryMask m;
+    m[0] = true;
+    callback_->receive_packet(packet.addr, std::move(m), std::move(packet.data));
+  }
+  if (!in_flight_.empty()) {
+    alarm_timestamp() = td::Timestamp::at(in_flight_.begin()->first.first);
+  }
+}
+
+void SimulatedNetworkManager::add_node_id(AdnlNodeIdShort id, bool allow_send, bool allow_receive) {
+  if (allow_send) {
+    allowed_sources_.insert(id);
+  } else {
+    allowed_sources_.erase(id);
+  }
+  if (allow_receive) {
+    allowed_destinations_.insert(id);
+  } else {
+    allowed_destinations_.erase(id);
+  }
+}
+
+void SimulatedNetworkManager::set_default_link_options(LinkOptions options) {
+  default_options_ = options;
+}
+
+void SimulatedNetworkManager::set_link_options(AdnlNodeIdShort src, AdnlNodeIdShort dst, LinkOptions options) {
+  auto &link = get_link(src, dst);
+  link.options = options;
+  link.custom_options = true;
+}
+
+void SimulatedNetworkManager::get_link_stats(AdnlNodeIdShort src, AdnlNodeIdShort dst,
+                                             td::Promise<LinkStats> promise) {
+  promise.set_value(LinkStats{get_link(src, dst).stats});
+}
+
+void SimulatedNetworkManager::get_total_stats(td::Promise<LinkStats> promise) {
+  LinkStats total;
+  for (auto &p : links_) {
+    total += p.second.stats;
+  }
+  promise.set_value(std::move(total));
+}
+
+SimulatedNetworkManager::Link &SimulatedNetworkManager::get_link(AdnlNodeIdShort src, AdnlNodeIdShort dst) {
+  return links_[std::make_pair(src, dst)];
+}
+
+double SimulatedNetworkManager::random_double() {
+  return static_cast<double>(rnd_() >> 11) * (1.0 / static_cast<double>(1ull << 53));
+}
+
+}  // namespace adnl
+
+}  // namespace ton
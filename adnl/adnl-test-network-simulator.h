@@ -0,0 +1,149 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "adnl/adnl.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <map>
+#include <set>
+
+namespace ton {
+
+namespace adnl {
+
+/*
+ * Network manager for in-process tests and benchmarks, like TestLoopbackNetworkManager, but every packet goes
+ * through a simulated link between its source and destination.
+ * A link delays packets by latency plus uniform jitter, loses them with the given probability, serializes them
+ * at the given bandwidth into a queue of limited size (tail drop) and holds back some of them to reorder.
+ * Packets are delivered from alarm(), so with a Scheduler created with skip_timeouts the idle time between
+ * deliveries is skipped and simulated seconds cost only the CPU time spent processing the packets.
+ * Random decisions come from a generator with a fixed seed.
+ */
+class SimulatedNetworkManager : public AdnlNetworkManager {
+ public:
+  struct LinkOptions {
+    double latency = 0.0;
+    // extra delay, uniform in [0, jitter]; packets still arrive in order unless they are reordered
+    double jitter = 0.0;
+    double loss = 0.0;
+    // bytes per second, 0 means unlimited
+    double bandwidth = 0.0;
+    // bytes waiting to be serialized, a packet that does not fit is dropped
+    double queue_size = 1 << 20;
+    // probability that a packet is held back for reorder_delay, so that the packets sent after it overtake it
+    double reorder = 0.0;
+    double reorder_delay = 0.01;
+
+    LinkOptions with_latency(double latency, double jitter = 0.0) {
+      this->latency = latency;
+      this->jitter = jitter;
+      return *this;
+    }
+    LinkOptions with_loss(double loss) {
+      this->loss = loss;
+      return *this;
+    }
+    LinkOptions with_bandwidth(double bandwidth, double queue_size = 1 << 20) {
+      this->bandwidth = bandwidth;
+      this->queue_size = queue_size;
+      return *this;
+    }
+    LinkOptions with_reorder(double reorder, double reorder_delay = 0.01) {
+      this->reorder = reorder;
+      this->reorder_delay = reorder_delay;
+      return *this;
+    }
+  };
+
+  struct LinkStats {
+    td::uint64 sent_packets = 0;
+    td::uint64 sent_bytes = 0;
+    td::uint64 delivered_packets = 0;
+    td::uint64 delivered_bytes = 0;
+    td::uint64 lost_packets = 0;
+    td::uint64 dropped_packets = 0;
+    td::uint64 reordered_packets = 0;
+
+    LinkStats &operator+=(const LinkStats &other);
+  };
+
+  explicit SimulatedNetworkManager(td::uint64 seed = 0) : rnd_(seed) {
+  }
+
+  void install_callback(std::unique_ptr<Callback> callback) override {
+    CHECK(!callback_);
+    callback_ = std::move(callback);
+  }
+
+  void add_self_addr(td::IPAddress addr, AdnlCategoryMask cat_mask, td::uint32 priority) override {
+  }
+  void add_proxy_addr(td::IPAddress addr, td::uint16 local_port, std::shared_ptr<AdnlProxy> proxy,
+                      AdnlCategoryMask cat_mask, td::uint32 priority) override {
+  }
+  void set_local_id_category(AdnlNodeIdShort id, td::uint8 cat) override {
+  }
+  void send_udp_packet(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, td::IPAddress dst_addr, td::uint32 priority,
+                       td::BufferSlice data) override;
+
+  void add_node_id(AdnlNodeIdShort id, bool allow_send, bool allow_receive);
+
+  // applies to the links without their own options, including the ones that already exist
+  void set_default_link_options(LinkOptions options);
+  void set_link_options(AdnlNodeIdShort src, AdnlNodeIdShort dst, LinkOptions options);
+
+  void get_link_stats(AdnlNodeIdShort src, AdnlNodeIdShort dst, td::Promise<LinkStats> promise);
+  void get_total_stats(td::Promise<LinkStats> promise);
+
+  void alarm() override;
+
+ private:
+  struct Link {
+    LinkOptions options;
+    bool custom_options = false;
+    // the moment the last accepted packet is fully serialized
+    double busy_until = 0.0;
+    // the latest delivery of a packet that was not reordered
+    double last_delivery_at = 0.0;
+    LinkStats stats;
+  };
+  struct Packet {
+    AdnlNodeIdShort src;
+    AdnlNodeIdShort dst;
+    td::IPAddress addr;
+    td::BufferSlice data;
+  };
+
+  td::Random::Xorshift128plus rnd_;
+  LinkOptions default_options_;
+  std::set<AdnlNodeIdShort> allowed_sources_;
+  std::set<AdnlNodeIdShort> allowed_destinations_;
+  std::map<std::pair<AdnlNodeIdShort, AdnlNodeIdShort>, Link> links_;
+  // packets in flight by delivery time, then by the order of sending
+  std::map<std::pair<double, td::uint64>, Packet> in_flight_;
+  td::uint64 seqno_ = 0;
+  std::unique_ptr<Callback> callback_;
+
+  Link &get_link(AdnlNodeIdShort src, AdnlNodeIdShort dst);
+  double random_double();
+};
+
+}  // namespace adnl
+
+}  // namespace ton
@@ -0,0 +1,88 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "catchain-types.h"
+
+#include "td/actor/PromiseFuture.h"
+#include "td/utils/buffer.h"
+#include "td/utils/Time.h"
+
+#include <vector>
+
+namespace ton {
+
+namespace catchain {
+
+// Group commit of catchain block writes.
+// Writes are queued and taken as one batch at most BATCH_DELAY after the first of them, or at once when a write has
+// a promise (somebody waits for it) or the batch grows over BATCH_MAX_SIZE. A batch keeps the order of its writes,
+// so a root block pointer queued after a block is never written before it.
+class CatChainDbWriteQueue {
+ public:
+  static constexpr double BATCH_DELAY = 0.05;
+  static constexpr size_t BATCH_MAX_SIZE = 1 << 20;
+  // sync delay of batches that nobody waits for, same as for single writes of received blocks
+  static constexpr double SYNC_DELAY = 1.0;
+
+  struct Batch {
+    std::vector<std::pair<CatChainBlockHash, td::BufferSlice>> values;
+    std::vector<td::Promise<td::Unit>> promises;
+    size_t size = 0;
+    double sync_delay = SYNC_DELAY;
+  };
+
+  // returns true if the batch should be taken now
+  bool push(CatChainBlockHash key, td::BufferSlice value, td::Promise<td::Unit> promise = {}) {
+    batch_.size += value.size();
+    batch_.values.emplace_back(key, std::move(value));
+    if (promise) {
+      batch_.promises.push_back(std::move(promise));
+      batch_.sync_delay = 0.0;
+    }
+    if (!batch_.promises.empty() || batch_.size >= BATCH_MAX_SIZE) {
+      return true;
+    }
+    if (!flush_at_) {
+      flush_at_ = td::Timestamp::in(BATCH_DELAY);
+    }
+    return false;
+  }
+
+  bool empty() const {
+    return batch_.values.empty();
+  }
+
+  td::Timestamp flush_at() const {
+    return flush_at_;
+  }
+
+  Batch take_batch() {
+    flush_at_ = td::Timestamp::never();
+    Batch batch = std::move(batch_);
+    batch_ = Batch{};
+    return batch;
+  }
+
+ private:
+  Batch batch_;
+  td::Timestamp flush_at_;
+};
+
+}  // namespace catchain
+
+}  // namespace ton
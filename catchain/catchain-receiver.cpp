@@ -138,8 +138,7 @@ void CatChainReceiverImpl::receive_block(adnl::AdnlNodeIdShort src, tl_object_pt
   create_block(std::move(block), td::SharedSlice{payload.as_slice()});
 
   if (!opts_.debug_disable_db) {
-    db_.set(
-        id, std::move(raw_data), [](td::Unit) {}, 1.0);
+    db_write(id, std::move(raw_data));
   }
   block_written_to_db(id);
 }
@@ -300,43 +299,27 @@ void CatChainReceiverImpl::add_block_cont_3(tl_object_ptr<ton_api::catchain_bloc
   }
 }
 
-void CatChainReceiverImpl::add_block_cont_2(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload) {
-  if (opts_.debug_disable_db) {
-    add_block_cont_3(std::move(block), std::move(payload));
-    return;
-  }
-
-  CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload);
-
-  td::BufferSlice raw_data{id.as_array().size()};
-  raw_data.as_slice().copy_from(as_slice(id));
-
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = std::move(block),
-                                       payload = std::move(payload)](td::Result<td::Unit> R) mutable {
-    R.ensure();
-    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_3, std::move(block), std::move(payload));
-  });
-
-  db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(P), 0);
-}
-
 void CatChainReceiverImpl::add_block_cont(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload) {
   validate_block_sync(block, payload.as_slice()).ensure();
   if (opts_.debug_disable_db) {
-    add_block_cont_2(std::move(block), std::move(payload));
+    add_block_cont_3(std::move(block), std::move(payload));
     return;
   }
   CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload.as_slice());
 
   td::BufferSlice raw_data = serialize_tl_object(block, true, payload.as_slice());
+  td::BufferSlice root_data{id.as_array().size()};
+  root_data.as_slice().copy_from(as_slice(id));
 
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = std::move(block),
                                        payload = std::move(payload)](td::Result<td::Unit> R) mutable {
     R.ensure();
-    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_2, std::move(block), std::move(payload));
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_3, std::move(block), std::move(payload));
   });
 
-  db_.set(id, std::move(raw_data), std::move(P), 0);
+  // the block and the new root pointer are committed in one batch
+  db_write(id, std::move(raw_data));
+  db_write(CatChainBlockHash::zero(), std::move(root_data), std::move(P));
 }
 
 void CatChainReceiverImpl::add_block(td::BufferSlice payload, std::vector<CatChainBlockHash> deps) {
@@ -558,6 +541,7 @@ void CatChainReceiverImpl::start_up() {
 }
 
 void CatChainReceiverImpl::tear_down() {
+  flush_db_writes();
   td::actor::send_closure(overlay_manager_, &overlay::Overlays::delete_overlay, get_source(local_idx_)->get_adnl_id(),
                           overlay_id_);
 }
@@ -948,7 +932,7 @@ bool CatChainReceiverImpl::unsafe_start_up_check_completed() {
     td::actor::send_closure(SelfId, &CatChainReceiverImpl::written_unsafe_root_block, block);
   });
 
-  db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(P), 0);
+  db_write(CatChainBlockHash::zero(), std::move(raw_data), std::move(P));
   initial_sync_complete_at_ = td::Timestamp::in(EXPECTED_INITIAL_SYNC_DURATION);
   LOG(INFO) << "catchain: need update root";
   return false;
@@ -962,6 +946,9 @@ void CatChainReceiverImpl::written_unsafe_root_block(CatChainReceivedBlock *bloc
 
 void CatChainReceiverImpl::alarm() {
   alarm_timestamp() = td::Timestamp::never();
+  if (db_queue_.flush_at() && db_queue_.flush_at().is_in_past()) {
+    flush_db_writes();
+  }
   if (next_sync_ && next_sync_.is_in_past() && get_sources_cnt() > 1) {
     next_sync_ = td::Timestamp::in(td::Random::fast(SYNC_INTERVAL_MIN, SYNC_INTERVAL_MAX));
     for (unsigned i = 0; i < SYNC_ITERATIONS; i++) {
@@ -998,6 +985,7 @@ void CatChainReceiverImpl::alarm() {
   alarm_timestamp().relax(next_rotate_);
   alarm_timestamp().relax(next_sync_);
   alarm_timestamp().relax(initial_sync_complete_at_);
+  alarm_timestamp().relax(db_queue_.flush_at());
 }
 
 void CatChainReceiverImpl::send_fec_broadcast(td::BufferSlice data) {
@@ -1040,6 +1028,44 @@ void CatChainReceiverImpl::block_written_to_db(CatChainBlockHash hash) {
   run_scheduler();
 }
 
+void CatChainReceiverImpl::db_write(CatChainBlockHash key, td::BufferSlice value, td::Promise<td::Unit> promise) {
+  if (db_queue_.push(key, std::move(value), std::move(promise))) {
+    flush_db_writes();
+  } else {
+    alarm_timestamp().relax(db_queue_.flush_at());
+  }
+}
+
+void CatChainReceiverImpl::flush_db_writes() {
+  if (db_queue_.empty()) {
+    return;
+  }
+  auto batch = db_queue_.take_batch();
+  std::vector<size_t> sizes;
+  sizes.reserve(batch.values.size());
+  for (auto &value : batch.values) {
+    sizes.push_back(value.second.size());
+  }
+  // the latency is the time of the commit itself, not of the wait for a delayed sync
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), sizes = std::move(sizes),
+                                       promises = std::move(batch.promises)](td::Result<double> R) mutable {
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::written_db_batch, std::move(sizes), R.move_as_ok(),
+                            std::move(promises));
+  });
+  db_.set_batch_timed(std::move(batch.values), std::move(P), batch.sync_delay);
+}
+
+void CatChainReceiverImpl::written_db_batch(std::vector<size_t> sizes, double latency,
+                                            std::vector<td::Promise<td::Unit>> promises) {
+  db_stats_.batches++;
+  for (size_t size : sizes) {
+    db_stats_.add_write(size, latency);
+  }
+  for (auto &promise : promises) {
+    promise.set_value(td::Unit());
+  }
+}
+
 static void destroy_db(const std::string& name, td::uint32 attempt) {
   auto S = td::RocksDb::destroy(name);
   if (S.is_ok()) {
@@ -26,6 +26,7 @@
 #include "catchain-receiver.h"
 #include "catchain-receiver-source.h"
 #include "catchain-received-block.h"
+#include "catchain-db-write-queue.hpp"
 
 #include "td/db/KeyValueAsync.h"
 
@@ -100,7 +101,6 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   void run_scheduler();
   void add_block(td::BufferSlice data, std::vector<CatChainBlockHash> deps) override;
   void add_block_cont(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
-  void add_block_cont_2(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
   void add_block_cont_3(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
   void debug_add_fork(td::BufferSlice payload, CatChainBlockHeight height,
                       std::vector<CatChainBlockHash> deps) override;
@@ -125,6 +125,13 @@ class CatChainReceiverImpl final : public CatChainReceiver {
 
   void block_written_to_db(CatChainBlockHash hash);
 
+  void db_write(CatChainBlockHash key, td::BufferSlice value, td::Promise<td::Unit> promise = {});
+  void flush_db_writes();
+  void written_db_batch(std::vector<size_t> sizes, double latency, std::vector<td::Promise<td::Unit>> promises);
+  void get_db_stats(td::Promise<CatChainDbStats> promise) override {
+    promise.set_result(db_stats_);
+  }
+
   bool unsafe_start_up_check_completed();
   void written_unsafe_root_block(CatChainReceivedBlock *block);
 
@@ -214,6 +221,9 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   using DbType = td::KeyValueAsync<CatChainBlockHash, td::BufferSlice>;
   DbType db_;
 
+  CatChainDbWriteQueue db_queue_;
+  CatChainDbStats db_stats_;
+
   bool intentional_fork_ = false;
   td::Timestamp initial_sync_complete_at_{td::Timestamp::never()};
   bool allow_unsafe_self_blocks_resync_{false};
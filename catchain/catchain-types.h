@@ -22,6 +22,9 @@
 #include "adnl/adnl-node-id.hpp"
 #include "ton/ton-types.h"
 
+#include <algorithm>
+#include <array>
+
 namespace ton {
 
 namespace catchain {
@@ -36,6 +39,32 @@ struct CatChainNode {
   PublicKey pub_key;
 };
 
+// Catchain block writes to the database since the start of the catchain.
+// Latency is the time of the database commit that made a batch durable. It does not include the delay before the
+// sync of batches that nobody waits for (CatChainDbWriteQueue::SYNC_DELAY).
+struct CatChainDbStats {
+  // upper bounds of latency histogram buckets (seconds); the last bucket has no upper bound
+  static constexpr std::array<double, 11> LATENCY_BOUNDS = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05,
+                                                            0.1,   0.2,   0.5,   1.0,  2.0};
+
+  td::uint64 writes = 0;
+  td::uint64 batches = 0;
+  td::uint64 bytes = 0;
+  double max_latency = 0.0;
+  std::array<td::uint32, LATENCY_BOUNDS.size() + 1> latency_hist{};
+
+  void add_write(size_t size, double latency) {
+    writes++;
+    bytes += size;
+    max_latency = std::max(max_latency, latency);
+    size_t i = 0;
+    while (i < LATENCY_BOUNDS.size() && latency > LATENCY_BOUNDS[i]) {
+      i++;
+    }
+    latency_hist[i]++;
+  }
+};
+
 }  // namespace catchain
 
 }  // namespace ton
@@ -97,6 +97,7 @@ class CatChain : public td::actor::Actor {
                               td::Timestamp timeout, td::BufferSlice query, td::uint64 max_answer_size,
                               td::actor::ActorId<adnl::AdnlSenderInterface> via) = 0;
   virtual void get_source_heights(td::Promise<std::vector<CatChainBlockHeight>> promise) = 0;
+  virtual void get_db_stats(td::Promise<CatChainDbStats> promise) = 0;
   virtual void destroy() = 0;
 
   static td::actor::ActorOwn<CatChain> create(std::unique_ptr<Callback> callback, const CatChainOptions &opts,
@@ -124,6 +124,9 @@ class CatChainImpl : public CatChain {
     }
     promise.set_result(std::move(heights));
   }
+  void get_db_stats(td::Promise<CatChainDbStats> promise) override {
+    td::actor::send_closure(receiver_, &CatChainReceiverInterface::get_db_stats, std::move(promise));
+  }
   void destroy() override;
   CatChainImpl(std::unique_ptr<Callback> callback, const CatChainOptions &opts,
                td::actor::ActorId<keyring::Keyring> keyring, td::actor::ActorId<adnl::Adnl> adnl,
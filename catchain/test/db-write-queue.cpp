@@ -0,0 +1,101 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "catchain/catchain-db-write-queue.hpp"
+
+#include "td/utils/tests.h"
+
+namespace {
+
+using ton::catchain::CatChainBlockHash;
+using ton::catchain::CatChainDbWriteQueue;
+
+CatChainBlockHash block_hash(td::uint8 x) {
+  CatChainBlockHash hash = CatChainBlockHash::zero();
+  hash.as_slice()[0] = x;
+  return hash;
+}
+
+td::BufferSlice block_data(size_t size, char c) {
+  td::BufferSlice data{size};
+  data.as_slice().fill(c);
+  return data;
+}
+
+}  // namespace
+
+TEST(CatChainDbWriteQueue, ReceivedBlocks) {
+  CatChainDbWriteQueue queue;
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(!queue.flush_at());
+  for (td::uint8 i = 1; i <= 3; i++) {
+    ASSERT_TRUE(!queue.push(block_hash(i), block_data(100, (char)i)));
+  }
+  ASSERT_TRUE(!queue.empty());
+  ASSERT_TRUE(static_cast<bool>(queue.flush_at()));
+  ASSERT_TRUE(queue.flush_at().at() <= td::Timestamp::in(CatChainDbWriteQueue::BATCH_DELAY).at());
+
+  auto batch = queue.take_batch();
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(!queue.flush_at());
+  ASSERT_EQ(3u, batch.values.size());
+  for (td::uint8 i = 1; i <= 3; i++) {
+    ASSERT_TRUE(batch.values[i - 1].first == block_hash(i));
+    ASSERT_EQ(block_data(100, (char)i).as_slice(), batch.values[i - 1].second.as_slice());
+  }
+  ASSERT_EQ(300u, batch.size);
+  ASSERT_TRUE(batch.promises.empty());
+  // nobody waits for received blocks, they are synced with a delay like before batching
+  ASSERT_TRUE(batch.sync_delay >= 1.0);
+}
+
+TEST(CatChainDbWriteQueue, RootPointerAfterBlocks) {
+  CatChainDbWriteQueue queue;
+  ASSERT_TRUE(!queue.push(block_hash(1), block_data(100, 'a')));
+  // own block, then the root pointer that refers to it, as in CatChainReceiverImpl::add_block_cont
+  ASSERT_TRUE(!queue.push(block_hash(2), block_data(200, 'b')));
+  bool written = false;
+  ASSERT_TRUE(queue.push(CatChainBlockHash::zero(), td::BufferSlice(block_hash(2).as_slice()),
+                         [&](td::Result<td::Unit> R) { written = R.is_ok(); }));
+
+  auto batch = queue.take_batch();
+  ASSERT_EQ(3u, batch.values.size());
+  ASSERT_TRUE(batch.values[0].first == block_hash(1));
+  ASSERT_TRUE(batch.values[1].first == block_hash(2));
+  ASSERT_TRUE(batch.values[2].first == CatChainBlockHash::zero());
+  ASSERT_EQ(block_hash(2).as_slice(), batch.values[2].second.as_slice());
+  // somebody waits for the root pointer, so the batch is synced at once
+  ASSERT_EQ(0.0, batch.sync_delay);
+  ASSERT_EQ(1u, batch.promises.size());
+  batch.promises[0].set_value(td::Unit());
+  ASSERT_TRUE(written);
+
+  // the next batch starts clean
+  ASSERT_TRUE(!queue.push(block_hash(3), block_data(100, 'c')));
+  batch = queue.take_batch();
+  ASSERT_EQ(1u, batch.values.size());
+  ASSERT_TRUE(batch.promises.empty());
+  ASSERT_TRUE(batch.sync_delay >= 1.0);
+}
+
+TEST(CatChainDbWriteQueue, MaxSize) {
+  CatChainDbWriteQueue queue;
+  ASSERT_TRUE(!queue.push(block_hash(1), block_data(CatChainDbWriteQueue::BATCH_MAX_SIZE / 2, 'a')));
+  ASSERT_TRUE(queue.push(block_hash(2), block_data(CatChainDbWriteQueue::BATCH_MAX_SIZE / 2, 'b')));
+  auto batch = queue.take_batch();
+  ASSERT_EQ(2u, batch.values.size());
+  ASSERT_EQ(CatChainDbWriteQueue::BATCH_MAX_SIZE, batch.size);
+}
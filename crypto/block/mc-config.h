@@ -738,6 +738,9 @@ class ConfigInfo : public Config, public ShardConfig {
   Ref<vm::Cell> get_state_extra_root() const {
     return state_extra_root_;
   }
+  Ref<vm::Cell> get_state_root() const {
+    return state_root;
+  }
   ton::BlockSeqno get_vert_seqno() const {
     return vert_seqno;
   }
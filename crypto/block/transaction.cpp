@@ -1793,11 +1793,12 @@ bool Transaction::prepare_action_phase(const ActionPhaseConfig& cfg) {
     if (account.is_special) {
       return true;
     }
-    auto S = check_state_limits(cfg.size_limits);
+    auto S = check_state_limits(cfg.size_limits, true, cfg.storage_stat_cache.get());
     if (S.is_error()) {
       // Rollback changes to state, fail action phase
       LOG(INFO) << "Account state size exceeded limits: " << S.move_as_error();
       new_storage_stat.clear();
+      new_storage_stat_cache = nullptr;
       new_code = old_code;
       new_data = old_data;
       new_library = old_library;
@@ -2838,12 +2839,14 @@ static td::uint32 get_public_libraries_diff_count(const td::Ref<vm::Cell>& old_l
  *
  * @param size_limits The size limits configuration.
  * @param update_storage_stat Store storage stat in the Transaction's CellStorageStat.
+ * @param storage_stat_cache Cache of account storage stats of the current block, may be null.
  *
  * @returns A `td::Status` indicating the result of the check.
  *          - If the state limits are within the allowed range, returns OK.
  *          - If the state limits exceed the maximum allowed range, returns an error.
  */
-td::Status Transaction::check_state_limits(const SizeLimitsConfig& size_limits, bool update_storage_stat) {
+td::Status Transaction::check_state_limits(const SizeLimitsConfig& size_limits, bool update_storage_stat,
+                                           vm::StorageStatCache* storage_stat_cache) {
   auto cell_equal = [](const td::Ref<vm::Cell>& a, const td::Ref<vm::Cell>& b) -> bool {
     if (a.is_null()) {
       return b.is_null();
@@ -2870,9 +2873,20 @@ td::Status Transaction::check_state_limits(const SizeLimitsConfig& size_limits,
     }
     return td::Status::OK();
   };
-  TRY_STATUS(add_used_storage(new_code));
-  TRY_STATUS(add_used_storage(new_data));
-  TRY_STATUS(add_used_storage(new_library));
+  td::optional<vm::StorageStatCache::Usage> cached_usage;
+  if (storage_stat_cache) {
+    std::vector<td::Ref<vm::Cell>> roots{new_code, new_data, new_library};
+    TRY_RESULT_ASSIGN(cached_usage, storage_stat_cache->compute(account.addr, roots, storage_stat.limit_cells,
+                                                                storage_stat.limit_bits));
+  }
+  if (cached_usage) {
+    storage_stat.cells = cached_usage.value().cells;
+    storage_stat.bits = cached_usage.value().bits;
+  } else {
+    TRY_STATUS(add_used_storage(new_code));
+    TRY_STATUS(add_used_storage(new_data));
+    TRY_STATUS(add_used_storage(new_library));
+  }
   if (timer.elapsed() > 0.1) {
     LOG(INFO) << "Compute used storage took " << timer.elapsed() << "s";
   }
@@ -2893,6 +2907,7 @@ td::Status Transaction::check_state_limits(const SizeLimitsConfig& size_limits,
   if (update_storage_stat) {
     // storage_stat will be reused in compute_state()
     new_storage_stat = std::move(storage_stat);
+    new_storage_stat_cache = cached_usage && acc_status == Account::acc_active ? storage_stat_cache : nullptr;
   }
   return res;
 }
@@ -3157,7 +3172,20 @@ bool Transaction::compute_state() {
     stats = new_stats.unwrap();
   } else {
     td::Timer timer;
-    stats.add_used_storage(Ref<vm::Cell>(storage)).ensure();
+    td::optional<vm::StorageStatCache::Usage> extra;
+    if (new_storage_stat_cache) {
+      // cells of code, data and library are in the cache, only the rest of the AccountStorage cell is counted here
+      extra = new_storage_stat_cache->compute_extra(account.addr, storage);
+      if (!extra) {
+        stats = vm::CellStorageStat{};
+      }
+    }
+    if (extra) {
+      stats.cells += extra.value().cells;
+      stats.bits += extra.value().bits;
+    } else {
+      stats.add_used_storage(Ref<vm::Cell>(storage)).ensure();
+    }
     if (timer.elapsed() > 0.1) {
       LOG(INFO) << "Compute used storage took " << timer.elapsed() << "s";
     }
@@ -23,6 +23,7 @@
 #include "vm/cellslice.h"
 #include "vm/dict.h"
 #include "vm/boc.h"
+#include "vm/storage-stat-cache.h"
 #include <ostream>
 #include "tl/tlblib.hpp"
 #include "td/utils/bits.h"
@@ -170,6 +171,8 @@ struct ActionPhaseConfig {
   bool message_skip_enabled{false};
   bool disable_custom_fess{false};
   td::optional<td::Bits256> mc_blackhole_addr;
+  // storage stat of account states shared by the transactions of one block, may be null
+  std::shared_ptr<vm::StorageStatCache> storage_stat_cache;
   const MsgPrices& fetch_msg_prices(bool is_masterchain) const {
     return is_masterchain ? fwd_mc : fwd_std;
   }
@@ -372,6 +375,8 @@ struct Transaction {
   std::unique_ptr<ActionPhase> action_phase;
   std::unique_ptr<BouncePhase> bounce_phase;
   vm::CellStorageStat new_storage_stat;
+  // set if new_storage_stat was taken from this cache: its seen cells are kept in the cache, not in new_storage_stat
+  vm::StorageStatCache* new_storage_stat_cache{nullptr};
   bool gas_limit_overridden{false};
   Transaction(const Account& _account, int ttype, ton::LogicalTime req_start_lt, ton::UnixTime _now,
               Ref<vm::Cell> _inmsg = {});
@@ -386,7 +391,8 @@ struct Transaction {
   bool run_precompiled_contract(const ComputePhaseConfig& cfg, precompiled::PrecompiledSmartContract& precompiled);
   bool prepare_compute_phase(const ComputePhaseConfig& cfg);
   bool prepare_action_phase(const ActionPhaseConfig& cfg);
-  td::Status check_state_limits(const SizeLimitsConfig& size_limits, bool update_storage_stat = true);
+  td::Status check_state_limits(const SizeLimitsConfig& size_limits, bool update_storage_stat = true,
+                                vm::StorageStatCache* storage_stat_cache = nullptr);
   bool prepare_bounce_phase(const ActionPhaseConfig& cfg);
   bool compute_state();
   bool serialize();
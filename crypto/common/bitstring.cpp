@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "common/bitstring.h"
+#include <atomic>
 #include <cstring>
 #include <limits>
 #include "td/utils/as.h"
@@ -24,6 +25,13 @@
 #include "td/utils/misc.h"
 #include "crypto/openssl/digest.hpp"
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TON_BITSTRING_X86 1
+#include <immintrin.h>
+#else
+#define TON_BITSTRING_X86 0
+#endif
+
 namespace td {
 
 template class Ref<BitString>;
@@ -121,7 +129,309 @@ std::ostream& operator<<(std::ostream& os, Ref<BitString> bs_ref) {
 
 namespace bitstring {
 
+namespace {
+
+// shorter strings are handled by the word-at-a-time code only
+constexpr std::size_t simd_min_bits = 128;
+
+/*
+ * Byte kernels. "Shifted" ones take the bytes of a bit string that starts r bits (0 < r < 8) into a[0],
+ * byte i of it being (a[i] << r) | (a[i + 1] >> (8 - r)); they read a[0..n].
+ */
+
+// first i < n such that a[i] != b[i], or n
+std::size_t mismatch_scalar(const unsigned char* a, const unsigned char* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto x = as<td::uint64>(a + i) ^ as<td::uint64>(b + i);
+    if (x) {
+      return i + (td::count_trailing_zeroes64(x) >> 3);
+    }
+  }
+  while (i < n && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+// first i < n such that byte i of shifted a differs from b[i], or n
+std::size_t mismatch_shifted_scalar(const unsigned char* a, int r, const unsigned char* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto x = (td::bswap64(as<td::uint64>(a + i)) << r) | (a[i + 8] >> (8 - r));
+    x ^= td::bswap64(as<td::uint64>(b + i));
+    if (x) {
+      return i + (td::count_leading_zeroes64(x) >> 3);
+    }
+  }
+  while (i < n && (unsigned char)((a[i] << r) | (a[i + 1] >> (8 - r))) == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+// to[i] = byte i of shifted from, i < n
+void copy_shifted_scalar(unsigned char* to, const unsigned char* from, int r, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto x = (td::bswap64(as<td::uint64>(from + i)) << r) | (from[i + 8] >> (8 - r));
+    as<td::uint64>(to + i) = td::bswap64(x);
+  }
+  for (; i < n; i++) {
+    to[i] = (unsigned char)((from[i] << r) | (from[i + 1] >> (8 - r)));
+  }
+}
+
+#if TON_BITSTRING_X86
+
+#define TON_BITSTRING_SSE2 __attribute__((target("sse2")))
+#define TON_BITSTRING_AVX2 __attribute__((target("avx2")))
+
+// there are no 8-bit shifts: shift 16-bit lanes and mask off the bits that crossed a byte boundary
+TON_BITSTRING_SSE2 inline __attribute__((always_inline)) __m128i shifted_load_sse2(const unsigned char* p, __m128i sl,
+                                                                                   __m128i sr, __m128i mask_l,
+                                                                                   __m128i mask_r) {
+  auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+  return _mm_or_si128(_mm_and_si128(_mm_sll_epi16(x, sl), mask_l), _mm_and_si128(_mm_srl_epi16(y, sr), mask_r));
+}
+
+TON_BITSTRING_AVX2 inline __attribute__((always_inline)) __m256i shifted_load_avx2(const unsigned char* p, __m128i sl,
+                                                                                   __m128i sr, __m256i mask_l,
+                                                                                   __m256i mask_r) {
+  auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+  return _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi16(x, sl), mask_l),
+                         _mm256_and_si256(_mm256_srl_epi16(y, sr), mask_r));
+}
+
+TON_BITSTRING_SSE2 std::size_t mismatch_sse2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned eq = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (eq != 0xffff) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+  }
+  return i + mismatch_scalar(a + i, b + i, n - i);
+}
+
+TON_BITSTRING_SSE2 std::size_t mismatch_shifted_sse2(const unsigned char* a, int r, const unsigned char* b,
+                                                     std::size_t n) {
+  auto sl = _mm_cvtsi32_si128(r), sr = _mm_cvtsi32_si128(8 - r);
+  auto mask_l = _mm_set1_epi8((char)(0xff << r)), mask_r = _mm_set1_epi8((char)(0xff >> (8 - r)));
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto x = shifted_load_sse2(a + i, sl, sr, mask_l, mask_r);
+    auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned eq = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (eq != 0xffff) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+  }
+  return i + mismatch_shifted_scalar(a + i, r, b + i, n - i);
+}
+
+TON_BITSTRING_SSE2 void copy_shifted_sse2(unsigned char* to, const unsigned char* from, int r, std::size_t n) {
+  auto sl = _mm_cvtsi32_si128(r), sr = _mm_cvtsi32_si128(8 - r);
+  auto mask_l = _mm_set1_epi8((char)(0xff << r)), mask_r = _mm_set1_epi8((char)(0xff >> (8 - r)));
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), shifted_load_sse2(from + i, sl, sr, mask_l, mask_r));
+  }
+  copy_shifted_scalar(to + i, from + i, r, n - i);
+}
+
+// the 16-byte steps are repeated here rather than calling the SSE2 kernels, so that no legacy SSE code runs
+// with the upper halves of the ymm registers in use
+TON_BITSTRING_AVX2 std::size_t mismatch_avx2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    unsigned eq = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+    if (eq != 0xffffffffu) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+  }
+  if (i + 16 <= n) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned eq = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (eq != 0xffff) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+    i += 16;
+  }
+  return i + mismatch_scalar(a + i, b + i, n - i);
+}
+
+TON_BITSTRING_AVX2 std::size_t mismatch_shifted_avx2(const unsigned char* a, int r, const unsigned char* b,
+                                                     std::size_t n) {
+  auto sl = _mm_cvtsi32_si128(r), sr = _mm_cvtsi32_si128(8 - r);
+  auto mask_l = _mm256_set1_epi8((char)(0xff << r)), mask_r = _mm256_set1_epi8((char)(0xff >> (8 - r)));
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto x = shifted_load_avx2(a + i, sl, sr, mask_l, mask_r);
+    auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    unsigned eq = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+    if (eq != 0xffffffffu) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+  }
+  if (i + 16 <= n) {
+    auto x = shifted_load_sse2(a + i, sl, sr, _mm256_castsi256_si128(mask_l), _mm256_castsi256_si128(mask_r));
+    auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned eq = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (eq != 0xffff) {
+      return i + td::count_trailing_zeroes32(~eq);
+    }
+    i += 16;
+  }
+  return i + mismatch_shifted_scalar(a + i, r, b + i, n - i);
+}
+
+TON_BITSTRING_AVX2 void copy_shifted_avx2(unsigned char* to, const unsigned char* from, int r, std::size_t n) {
+  auto sl = _mm_cvtsi32_si128(r), sr = _mm_cvtsi32_si128(8 - r);
+  auto mask_l = _mm256_set1_epi8((char)(0xff << r)), mask_r = _mm256_set1_epi8((char)(0xff >> (8 - r)));
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i),
+                        shifted_load_avx2(from + i, sl, sr, mask_l, mask_r));
+  }
+  if (i + 16 <= n) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i),
+                     shifted_load_sse2(from + i, sl, sr, _mm256_castsi256_si128(mask_l), _mm256_castsi256_si128(mask_r)));
+    i += 16;
+  }
+  copy_shifted_scalar(to + i, from + i, r, n - i);
+}
+
+#endif
+
+struct Kernels {
+  std::size_t (*mismatch)(const unsigned char* a, const unsigned char* b, std::size_t n);
+  std::size_t (*mismatch_shifted)(const unsigned char* a, int r, const unsigned char* b, std::size_t n);
+  void (*copy_shifted)(unsigned char* to, const unsigned char* from, int r, std::size_t n);
+};
+
+const Kernels scalar_kernels{mismatch_scalar, mismatch_shifted_scalar, copy_shifted_scalar};
+#if TON_BITSTRING_X86
+const Kernels sse2_kernels{mismatch_sse2, mismatch_shifted_sse2, copy_shifted_sse2};
+const Kernels avx2_kernels{mismatch_avx2, mismatch_shifted_avx2, copy_shifted_avx2};
+#endif
+
+const Kernels& get_kernels(SimdImpl impl) {
+  switch (impl) {
+#if TON_BITSTRING_X86
+    case SimdImpl::Sse2:
+      return sse2_kernels;
+    case SimdImpl::Avx2:
+      return avx2_kernels;
+#endif
+    default:
+      return scalar_kernels;
+  }
+}
+
+std::atomic<int> current_simd_impl{-1};
+
+const Kernels& kernels() {
+  auto impl = current_simd_impl.load(std::memory_order_relaxed);
+  if (impl < 0) {
+    impl = static_cast<int>(best_simd_impl());
+    current_simd_impl.store(impl, std::memory_order_relaxed);
+  }
+  return get_kernels(static_cast<SimdImpl>(impl));
+}
+
+void bits_memcpy_words(unsigned char* to, int to_offs, const unsigned char* from, int from_offs,
+                       std::size_t bit_count);
+int bits_memcmp_words(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2, int bs2_offs,
+                      std::size_t bit_count, std::size_t* same_upto);
+
+}  // namespace
+
+bool is_supported(SimdImpl impl) {
+  switch (impl) {
+    case SimdImpl::Scalar:
+      return true;
+#if TON_BITSTRING_X86
+    case SimdImpl::Sse2:
+      return __builtin_cpu_supports("sse2");
+    case SimdImpl::Avx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+SimdImpl best_simd_impl() {
+  static const SimdImpl impl = [] {
+    for (auto impl : {SimdImpl::Avx2, SimdImpl::Sse2}) {
+      if (is_supported(impl)) {
+        return impl;
+      }
+    }
+    return SimdImpl::Scalar;
+  }();
+  return impl;
+}
+
+SimdImpl simd_impl() {
+  kernels();
+  return static_cast<SimdImpl>(current_simd_impl.load(std::memory_order_relaxed));
+}
+
+void set_simd_impl(SimdImpl impl) {
+  CHECK(is_supported(impl));
+  current_simd_impl.store(static_cast<int>(impl), std::memory_order_relaxed);
+}
+
+const char* simd_impl_name(SimdImpl impl) {
+  switch (impl) {
+    case SimdImpl::Scalar:
+      return "scalar";
+    case SimdImpl::Sse2:
+      return "sse2";
+    case SimdImpl::Avx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
 void bits_memcpy(unsigned char* to, int to_offs, const unsigned char* from, int from_offs, std::size_t bit_count) {
+  from += (from_offs >> 3);
+  to += (to_offs >> 3);
+  from_offs &= 7;
+  to_offs &= 7;
+  // with equal offsets the bulk of the work is done by memcpy
+  if (bit_count < simd_min_bits || from_offs == to_offs) {
+    bits_memcpy_words(to, to_offs, from, from_offs, bit_count);
+    return;
+  }
+  int head = (8 - to_offs) & 7;
+  if (head) {
+    bits_memcpy_words(to, to_offs, from, from_offs, head);
+    to++;
+    from_offs += head;
+    from += (from_offs >> 3);
+    from_offs &= 7;
+    bit_count -= head;
+  }
+  // now to is byte aligned and from is not
+  std::size_t n = bit_count >> 3;
+  kernels().copy_shifted(to, from, from_offs, n);
+  bits_memcpy_words(to + n, 0, from + n, from_offs, bit_count & 7);
+}
+
+namespace {
+
+void bits_memcpy_words(unsigned char* to, int to_offs, const unsigned char* from, int from_offs,
+                       std::size_t bit_count) {
   if (bit_count <= 0) {
     return;
   }
@@ -196,6 +506,8 @@ void bits_memcpy(unsigned char* to, int to_offs, const unsigned char* from, int
   }
 }
 
+}  // namespace
+
 void bits_memcpy(BitPtr to, ConstBitPtr from, std::size_t bit_count) {
   bits_memcpy(to.ptr, to.offs, from.ptr, from.offs, bit_count);
 }
@@ -346,6 +658,43 @@ std::size_t bits_memscan_rev(ConstBitPtr bs, std::size_t bit_count, bool cmp_to)
 
 int bits_memcmp(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2, int bs2_offs, std::size_t bit_count,
                 std::size_t* same_upto) {
+  if (bit_count < simd_min_bits) {
+    return bits_memcmp_words(bs1, bs1_offs, bs2, bs2_offs, bit_count, same_upto);
+  }
+  bs1 += (bs1_offs >> 3);
+  bs2 += (bs2_offs >> 3);
+  bs1_offs &= 7;
+  bs2_offs &= 7;
+  std::size_t processed = (8 - bs1_offs) & 7;
+  if (processed) {
+    int res = bits_memcmp_words(bs1, bs1_offs, bs2, bs2_offs, processed, same_upto);
+    if (res) {
+      return res;
+    }
+    bs1++;
+    bs2_offs += (int)processed;
+    bs2 += (bs2_offs >> 3);
+    bs2_offs &= 7;
+    bit_count -= processed;
+  }
+  // now bs1 is byte aligned; skip the equal bytes and let the word-at-a-time code find the first differing bit
+  std::size_t n = bit_count >> 3;
+  auto& k = kernels();
+  std::size_t same = bs2_offs ? k.mismatch_shifted(bs2, bs2_offs, bs1, n) : k.mismatch(bs1, bs2, n);
+  processed += same * 8;
+  bit_count -= same * 8;
+  std::size_t rest = 0;
+  int res = bits_memcmp_words(bs1 + same, 0, bs2 + same, bs2_offs, bit_count, &rest);
+  if (same_upto) {
+    *same_upto = processed + rest;
+  }
+  return res;
+}
+
+namespace {
+
+int bits_memcmp_words(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2, int bs2_offs,
+                      std::size_t bit_count, std::size_t* same_upto) {
   if (!bit_count) {
     return 0;
   }
@@ -416,6 +765,8 @@ int bits_memcmp(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2
   return 0;
 }
 
+}  // namespace
+
 int bits_memcmp(ConstBitPtr bs1, ConstBitPtr bs2, std::size_t bit_count, std::size_t* same_upto) {
   return bits_memcmp(bs1.ptr, bs1.offs, bs2.ptr, bs2.offs, bit_count, same_upto);
 }
@@ -433,6 +784,16 @@ int bits_lexcmp(ConstBitPtr bs1, std::size_t bs1_bit_count, ConstBitPtr bs2, std
   return bits_lexcmp(bs1.ptr, bs1.offs, bs1_bit_count, bs2.ptr, bs2.offs, bs2_bit_count);
 }
 
+std::size_t bits_common_prefix(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2, int bs2_offs,
+                               std::size_t bit_count) {
+  std::size_t same_upto = 0;
+  return bits_memcmp(bs1, bs1_offs, bs2, bs2_offs, bit_count, &same_upto) ? same_upto : bit_count;
+}
+
+std::size_t bits_common_prefix(ConstBitPtr bs1, ConstBitPtr bs2, std::size_t bit_count) {
+  return bits_common_prefix(bs1.ptr, bs1.offs, bs2.ptr, bs2.offs, bit_count);
+}
+
 void bits_store_long_top(unsigned char* to, int to_offs, unsigned long long val, unsigned top_bits) {
   CHECK(top_bits <= 64);
   if (top_bits <= 0) {
@@ -46,6 +46,9 @@ int bits_memcmp(ConstBitPtr bs1, ConstBitPtr bs2, std::size_t bit_count, std::si
 int bits_lexcmp(const unsigned char* bs1, int bs1_offs, std::size_t bs1_bit_count, const unsigned char* bs2,
                 int bs2_offs, std::size_t bs2_bit_count);
 int bits_lexcmp(ConstBitPtr bs1, std::size_t bs1_bit_count, ConstBitPtr bs2, std::size_t bs2_bit_count);
+std::size_t bits_common_prefix(const unsigned char* bs1, int bs1_offs, const unsigned char* bs2, int bs2_offs,
+                               std::size_t bit_count);
+std::size_t bits_common_prefix(ConstBitPtr bs1, ConstBitPtr bs2, std::size_t bit_count);
 std::size_t bits_memscan(const unsigned char* ptr, int offs, std::size_t bit_count, bool cmp_to);
 std::size_t bits_memscan_rev(const unsigned char* ptr, int offs, std::size_t bit_count, bool cmp_to);
 std::size_t bits_memscan(ConstBitPtr bs, std::size_t bit_count, bool cmp_to);
@@ -67,6 +70,21 @@ std::string bits_to_binary(ConstBitPtr bs, std::size_t len);
 std::string bits_to_hex(const unsigned char* ptr, int offs, std::size_t len);
 std::string bits_to_hex(ConstBitPtr bs, std::size_t len);
 
+/*
+ * Long copies and comparisons (bits_memcpy with different bit offsets, bits_memcmp, bits_common_prefix) align
+ * one of the operands to a byte boundary and process the rest with byte kernels chosen at runtime:
+ *  - Avx2, Sse2: 32 or 16 bytes at a time on x86;
+ *  - Scalar: 8 bytes at a time, used on other CPUs.
+ */
+enum class SimdImpl { Scalar, Sse2, Avx2 };
+
+bool is_supported(SimdImpl impl);
+SimdImpl best_simd_impl();
+SimdImpl simd_impl();
+// for tests and benchmarks; affects all threads
+void set_simd_impl(SimdImpl impl);
+const char* simd_impl_name(SimdImpl impl);
+
 }  // namespace bitstring
 
 template <class Pt>
@@ -0,0 +1,375 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "sha256-batch.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "openssl/digest.hpp"
+
+#include "td/utils/check.h"
+#include "td/utils/port/thread_local.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TON_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define TON_SHA256_X86 0
+#endif
+
+namespace td {
+namespace sha256_batch {
+
+namespace {
+
+struct CpuFeatures {
+  bool sha = false;
+  bool avx2 = false;
+};
+
+const CpuFeatures &cpu_features() {
+  static const CpuFeatures features = [] {
+    CpuFeatures res;
+#if TON_SHA256_X86
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      res.sha = ((ebx >> 29) & 1) && __builtin_cpu_supports("sse4.1");
+    }
+    res.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return res;
+  }();
+  return features;
+}
+
+void hash_openssl(const unsigned char *data, std::size_t size, unsigned char *digest) {
+  static TD_THREAD_LOCAL digest::SHA256 *hasher;
+  init_thread_local<digest::SHA256>(hasher);
+  hasher->reset();
+  hasher->feed(data, size);
+  hasher->extract(digest);
+}
+
+#if TON_SHA256_X86
+
+alignas(16) const uint32 K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const uint32 H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+// Copies the incomplete last block of a message into tail and pads it; returns the size of the padded tail
+std::size_t pad_tail(const unsigned char *data, std::size_t size, unsigned char tail[128]) {
+  std::size_t rem = size & 63;
+  if (rem != 0) {
+    std::memcpy(tail, data + size - rem, rem);
+  }
+  tail[rem] = 0x80;
+  std::size_t tail_size = rem < 56 ? 64 : 128;
+  std::memset(tail + rem + 1, 0, tail_size - rem - 1 - 8);
+  uint64 bits = static_cast<uint64>(size) * 8;
+  for (int i = 0; i < 8; i++) {
+    tail[tail_size - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+  }
+  return tail_size;
+}
+
+std::size_t padded_blocks(std::size_t size) {
+  return (size + 9 + 63) / 64;
+}
+
+void store_be32(unsigned char *dest, uint32 x) {
+  dest[0] = static_cast<unsigned char>(x >> 24);
+  dest[1] = static_cast<unsigned char>(x >> 16);
+  dest[2] = static_cast<unsigned char>(x >> 8);
+  dest[3] = static_cast<unsigned char>(x);
+}
+
+__attribute__((target("sha,sse4.1"))) void compress_shani(uint32 state[8], const unsigned char *data,
+                                                           std::size_t blocks) {
+  const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+  __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);                // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1B);          // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+
+  for (; blocks > 0; blocks--, data += 64) {
+    __m128i abef_save = state0;
+    __m128i cdgh_save = state1;
+    __m128i msgs[4];
+    for (int i = 0; i < 16; i++) {
+      __m128i &cur = msgs[i & 3];
+      if (i < 4) {
+        cur = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), bswap);
+      } else {
+        // W[t] = sigma1(W[t-2]) + W[t-7] + sigma0(W[t-15]) + W[t-16] for four rounds at once
+        __m128i w = _mm_sha256msg1_epu32(cur, msgs[(i + 1) & 3]);
+        w = _mm_add_epi32(w, _mm_alignr_epi8(msgs[(i + 3) & 3], msgs[(i + 2) & 3], 4));
+        cur = _mm_sha256msg2_epu32(w, msgs[(i + 3) & 3]);
+      }
+      __m128i msg = _mm_add_epi32(cur, _mm_load_si128(reinterpret_cast<const __m128i *>(K + 4 * i)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);        // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);     // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);  // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);     // HGFE
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+}
+
+void hash_shani(const unsigned char *data, std::size_t size, unsigned char *digest) {
+  uint32 state[8];
+  std::memcpy(state, H0, sizeof(state));
+  compress_shani(state, data, size / 64);
+  unsigned char tail[128];
+  compress_shani(state, tail, pad_tail(data, size, tail) / 64);
+  for (int i = 0; i < 8; i++) {
+    store_be32(digest + 4 * i, state[i]);
+  }
+}
+
+#define TON_SHA256_AVX2 __attribute__((target("avx2")))
+
+TON_SHA256_AVX2 inline __m256i rotr_avx2(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// One block for each of the eight lanes; s[i] holds word i of the eight states
+TON_SHA256_AVX2 void compress_avx2(__m256i s[8], const unsigned char *const blocks[8]) {
+  const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9,
+                                        10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  __m256i w[16];
+  for (int t = 0; t < 16; t++) {
+    int x[8];
+    for (int j = 0; j < 8; j++) {
+      std::memcpy(&x[j], blocks[j] + 4 * t, 4);
+    }
+    w[t] = _mm256_shuffle_epi8(_mm256_setr_epi32(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]), bswap);
+  }
+
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+  for (int t = 0; t < 64; t++) {
+    __m256i wt;
+    if (t < 16) {
+      wt = w[t];
+    } else {
+      __m256i w15 = w[(t - 15) & 15];
+      __m256i w2 = w[(t - 2) & 15];
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(w15, 7), rotr_avx2(w15, 18)),
+                                    _mm256_srli_epi32(w15, 3));
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(w2, 17), rotr_avx2(w2, 19)),
+                                    _mm256_srli_epi32(w2, 10));
+      wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+      w[t & 15] = wt;
+    }
+    __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(e, 6), rotr_avx2(e, 11)), rotr_avx2(e, 25));
+    __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+    __m256i kw = _mm256_add_epi32(wt, _mm256_set1_epi32(static_cast<int>(K[t])));
+    __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1), _mm256_add_epi32(ch, kw));
+    __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(a, 2), rotr_avx2(a, 13)), rotr_avx2(a, 22));
+    __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    __m256i t2 = _mm256_add_epi32(sigma0, maj);
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi32(t1, t2);
+  }
+  s[0] = _mm256_add_epi32(s[0], a);
+  s[1] = _mm256_add_epi32(s[1], b);
+  s[2] = _mm256_add_epi32(s[2], c);
+  s[3] = _mm256_add_epi32(s[3], d);
+  s[4] = _mm256_add_epi32(s[4], e);
+  s[5] = _mm256_add_epi32(s[5], f);
+  s[6] = _mm256_add_epi32(s[6], g);
+  s[7] = _mm256_add_epi32(s[7], h);
+}
+
+// All eight messages must have the same number of padded blocks; a message may occupy several lanes
+TON_SHA256_AVX2 void hash_lanes_avx2(const Message *const msgs[8], std::size_t blocks) {
+  __m256i s[8];
+  for (int i = 0; i < 8; i++) {
+    s[i] = _mm256_set1_epi32(static_cast<int>(H0[i]));
+  }
+  unsigned char tails[8][128];
+  std::size_t full[8];
+  for (int j = 0; j < 8; j++) {
+    full[j] = msgs[j]->size / 64;
+    pad_tail(msgs[j]->data, msgs[j]->size, tails[j]);
+  }
+  for (std::size_t i = 0; i < blocks; i++) {
+    const unsigned char *ptrs[8];
+    for (int j = 0; j < 8; j++) {
+      ptrs[j] = i < full[j] ? msgs[j]->data + 64 * i : tails[j] + 64 * (i - full[j]);
+    }
+    compress_avx2(s, ptrs);
+  }
+  for (int i = 0; i < 8; i++) {
+    alignas(32) uint32 words[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(words), s[i]);
+    for (int j = 0; j < 8; j++) {
+      store_be32(msgs[j]->digest + 4 * i, words[j]);
+    }
+  }
+}
+
+void hash_avx2(Span<Message> messages) {
+  // Messages are grouped by their number of blocks; longer ones are hashed one by one
+  constexpr std::size_t max_blocks = 8;
+  constexpr std::size_t min_lanes = 3;
+  const Message *pending[max_blocks + 1][8];
+  std::size_t pending_cnt[max_blocks + 1] = {};
+  for (auto &message : messages) {
+    auto blocks = padded_blocks(message.size);
+    if (blocks > max_blocks) {
+      hash_openssl(message.data, message.size, message.digest);
+      continue;
+    }
+    pending[blocks][pending_cnt[blocks]++] = &message;
+    if (pending_cnt[blocks] == 8) {
+      hash_lanes_avx2(pending[blocks], blocks);
+      pending_cnt[blocks] = 0;
+    }
+  }
+  for (std::size_t blocks = 1; blocks <= max_blocks; blocks++) {
+    auto cnt = pending_cnt[blocks];
+    if (cnt >= min_lanes) {
+      for (auto j = cnt; j < 8; j++) {
+        pending[blocks][j] = pending[blocks][0];
+      }
+      hash_lanes_avx2(pending[blocks], blocks);
+    } else {
+      for (std::size_t j = 0; j < cnt; j++) {
+        hash_openssl(pending[blocks][j]->data, pending[blocks][j]->size, pending[blocks][j]->digest);
+      }
+    }
+  }
+}
+
+#endif
+
+std::atomic<int> selected_impl{-1};
+
+}  // namespace
+
+bool is_supported(Impl impl) {
+  switch (impl) {
+    case Impl::OpenSSL:
+      return true;
+    case Impl::ShaNi:
+      return TON_SHA256_X86 && cpu_features().sha;
+    case Impl::Avx2:
+      return TON_SHA256_X86 && cpu_features().avx2;
+  }
+  return false;
+}
+
+Impl best_impl() {
+  static const Impl impl = [] {
+    if (is_supported(Impl::ShaNi)) {
+      return Impl::ShaNi;
+    }
+    if (is_supported(Impl::Avx2)) {
+      return Impl::Avx2;
+    }
+    return Impl::OpenSSL;
+  }();
+  return impl;
+}
+
+Impl current_impl() {
+  auto impl = selected_impl.load(std::memory_order_relaxed);
+  if (impl < 0) {
+    impl = static_cast<int>(best_impl());
+    selected_impl.store(impl, std::memory_order_relaxed);
+  }
+  return static_cast<Impl>(impl);
+}
+
+void set_impl(Impl impl) {
+  CHECK(is_supported(impl));
+  selected_impl.store(static_cast<int>(impl), std::memory_order_relaxed);
+}
+
+Slice impl_name(Impl impl) {
+  switch (impl) {
+    case Impl::OpenSSL:
+      return "openssl";
+    case Impl::ShaNi:
+      return "sha-ni";
+    case Impl::Avx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void hash(Span<Message> messages) {
+  hash(messages, current_impl());
+}
+
+void hash(Span<Message> messages, Impl impl) {
+  CHECK(is_supported(impl));
+  switch (impl) {
+#if TON_SHA256_X86
+    case Impl::ShaNi:
+      for (auto &message : messages) {
+        hash_shani(message.data, message.size, message.digest);
+      }
+      return;
+    case Impl::Avx2:
+      hash_avx2(messages);
+      return;
+#endif
+    default:
+      for (auto &message : messages) {
+        hash_openssl(message.data, message.size, message.digest);
+      }
+      return;
+  }
+}
+
+void hash_one(Slice data, unsigned char *digest) {
+#if TON_SHA256_X86
+  if (current_impl() == Impl::ShaNi) {
+    hash_shani(data.ubegin(), data.size(), digest);
+    return;
+  }
+#endif
+  hash_openssl(data.ubegin(), data.size(), digest);
+}
+
+}  // namespace sha256_batch
+}  // namespace td
@@ -0,0 +1,51 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/utils/Slice.h"
+#include "td/utils/Span.h"
+
+namespace td {
+namespace sha256_batch {
+
+/*
+ * SHA-256 of many short independent messages (cell representations are at most 266 bytes).
+ * The implementation is chosen at runtime:
+ *  - ShaNi: one message at a time with the x86 SHA extensions;
+ *  - Avx2: eight messages with the same number of blocks are hashed in parallel, one per 32-bit lane;
+ *  - OpenSSL: fallback for other CPUs (OpenSSL has its own assembly for ARMv8 and others).
+ */
+enum class Impl { OpenSSL, ShaNi, Avx2 };
+
+struct Message {
+  const unsigned char *data;
+  std::size_t size;
+  unsigned char *digest;  // 32 bytes
+};
+
+bool is_supported(Impl impl);
+Impl best_impl();
+// the implementation used by hash(messages) and hash_one(), best_impl() by default; can be changed for benchmarks
+Impl current_impl();
+void set_impl(Impl impl);
+Slice impl_name(Impl impl);
+
+void hash(Span<Message> messages);
+void hash(Span<Message> messages, Impl impl);
+void hash_one(Slice data, unsigned char *digest);
+
+}  // namespace sha256_batch
+}  // namespace td
@@ -25,18 +25,29 @@
 #include <cstring>
 #include <cstdlib>
 #include <cmath>
+#include <map>
 #include "common/refcnt.hpp"
 #include "common/bigint.hpp"
 #include "common/refint.h"
 #include "common/bigexp.h"
 #include "common/bitstring.h"
 #include "common/util.h"
+#include "common/sha256-batch.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "vm/dict.h"
+#include "vm/boc.h"
+#include "vm/boc-frames.h"
+#include "vm/storage-stat-cache.h"
+#include "block/block-parse.h"
+#include "block/transaction.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
 
 static std::stringstream create_ss() {
   std::stringstream ss;
@@ -654,3 +665,537 @@ TEST(uint64_exp, main) {
   }
   REGRESSION_VERIFY(os.str());
 }
+
+// extra = (number of leaves, sum of 32-bit values)
+struct CountSumAugmentation : vm::dict::AugmentationData {
+  bool skip_extra(vm::CellSlice& cs) const override {
+    return cs.advance(96);
+  }
+  bool eval_leaf(vm::CellBuilder& cb, vm::CellSlice& val_cs) const override {
+    return cb.store_long_bool(1, 32) && cb.store_long_bool(val_cs.prefetch_ulong(32), 64);
+  }
+  bool eval_fork(vm::CellBuilder& cb, vm::CellSlice& left_cs, vm::CellSlice& right_cs) const override {
+    return cb.store_long_bool(left_cs.fetch_ulong(32) + right_cs.fetch_ulong(32), 32) &&
+           cb.store_long_bool(left_cs.fetch_ulong(64) + right_cs.fetch_ulong(64), 64);
+  }
+  bool eval_empty(vm::CellBuilder& cb) const override {
+    return cb.store_long_bool(0, 96);
+  }
+};
+
+static td::Ref<vm::CellSlice> make_dict_value(td::uint32 x) {
+  vm::CellBuilder cb;
+  cb.store_long(x, 32);
+  return vm::load_cell_slice_ref(cb.finalize());
+}
+
+template <unsigned N>
+static std::vector<std::pair<td::BitArray<N>, td::Ref<vm::CellSlice>>> gen_dict_updates(
+    td::Random::Xorshift128plus& rnd, const std::vector<td::BitArray<N>>& present, size_t count, int delete_prob) {
+  std::map<td::BitArray<N>, td::Ref<vm::CellSlice>> updates;
+  for (size_t i = 0; i < count; i++) {
+    td::BitArray<N> key;
+    if (!present.empty() && rnd.fast(0, 1)) {
+      key = present[rnd.fast(0, (int)present.size() - 1)];
+    } else {
+      // few distinct first bytes and zero tails make labels split and merge often
+      key.set_zero();
+      key.bits().store_uint(rnd.fast(0, 3), 8);
+      (key.bits() + 8).store_uint(rnd() >> rnd.fast(0, 63), 64);
+    }
+    updates[key] = rnd.fast(0, 99) < delete_prob ? td::Ref<vm::CellSlice>{} : make_dict_value((td::uint32)rnd());
+  }
+  return {updates.begin(), updates.end()};
+}
+
+TEST(Dictionary, AugmentedBulkUpdate) {
+  CountSumAugmentation aug;
+  td::Random::Xorshift128plus rnd(123);
+  for (int iter = 0; iter < 200; iter++) {
+    vm::AugmentedDictionary dict1{256, aug}, dict2{256, aug};
+    std::vector<td::BitArray<256>> present;
+    for (int round = 0; round < 5; round++) {
+      auto updates = gen_dict_updates<256>(rnd, present, rnd.fast(0, 1 << rnd.fast(0, 8)), rnd.fast(0, 100));
+      for (auto& upd : updates) {
+        if (upd.second.is_null()) {
+          dict1.lookup_delete(upd.first);
+        } else {
+          CHECK(dict1.set(upd.first, upd.second));
+        }
+      }
+      CHECK(dict2.bulk_update(updates));
+      ASSERT_EQ(dict1.is_empty(), dict2.is_empty());
+      if (!dict1.is_empty()) {
+        ASSERT_EQ(dict1.get_root_cell()->get_hash(), dict2.get_root_cell()->get_hash());
+      }
+      present.clear();
+      for (auto entry : dict2.range()) {
+        present.emplace_back(entry.first);
+      }
+      CHECK(dict2.validate_all());
+    }
+  }
+
+  // unsorted or repeated keys are rejected
+  vm::AugmentedDictionary dict{256, aug};
+  td::BitArray<256> a = td::Bits256::zero(), b = td::Bits256::zero();
+  b[0] = true;
+  std::vector<std::pair<td::BitArray<256>, td::Ref<vm::CellSlice>>> updates{{b, make_dict_value(1)},
+                                                                            {a, make_dict_value(2)}};
+  CHECK(!dict.bulk_update(updates));
+  updates[0].first = a;
+  CHECK(!dict.bulk_update(updates));
+  CHECK(dict.is_empty());
+}
+
+TEST(Dictionary, AugmentedBulkUpdateModes) {
+  using SetMode = vm::Dictionary::SetMode;
+  CountSumAugmentation aug;
+  td::Random::Xorshift128plus rnd(321);
+  int failed = 0;
+  for (int iter = 0; iter < 500; iter++) {
+    vm::AugmentedDictionary dict2{256, aug};
+    td::Ref<vm::Cell> root1;
+    std::vector<td::BitArray<256>> present;
+    for (int round = 0; round < 4; round++) {
+      auto updates = gen_dict_updates<256>(rnd, present, rnd.fast(1, 1 << rnd.fast(0, 5)), rnd.fast(0, 50));
+      std::vector<SetMode> modes;
+      bool ok = true;
+      vm::AugmentedDictionary expected{root1, 256, aug};
+      for (auto& upd : updates) {
+        // mostly the modes the collator uses for ShardAccounts: Add for new keys, Replace for the present ones
+        bool is_present = expected.lookup(upd.first).not_null();
+        SetMode mode = rnd.fast(0, 9) ? (is_present || upd.second.is_null() ? SetMode::Replace : SetMode::Add)
+                                      : (rnd.fast(0, 1) ? SetMode::Add : SetMode::Replace);
+        if (upd.second.is_null()) {
+          ok &= expected.lookup_delete(upd.first).not_null() || mode != SetMode::Replace;
+        } else {
+          ok &= expected.set(upd.first, upd.second, mode);
+        }
+        modes.push_back(mode);
+      }
+      auto old_root = dict2.get_root_cell();
+      ASSERT_EQ(ok, dict2.bulk_update(updates, modes));
+      if (ok) {
+        root1 = expected.get_root_cell();
+      } else {
+        // nothing is changed by a failed bulk update
+        ++failed;
+        ASSERT_EQ(old_root.get(), dict2.get_root_cell().get());
+      }
+      ASSERT_EQ(root1.is_null(), dict2.is_empty());
+      if (root1.not_null()) {
+        ASSERT_EQ(root1->get_hash(), dict2.get_root_cell()->get_hash());
+      }
+      present.clear();
+      for (auto entry : dict2.range()) {
+        present.emplace_back(entry.first);
+      }
+    }
+  }
+  CHECK(failed > 0);
+}
+
+TEST(Cells, Sha256Batch) {
+  td::Random::Xorshift128plus rnd(123);
+  std::vector<std::string> inputs;
+  for (int i = 0; i < 1000; i++) {
+    // mostly cell-sized messages, some of them longer than the multi-lane kernel takes
+    inputs.push_back(td::rand_string(0, 127, rnd.fast(0, i % 10 == 0 ? 1000 : 300)));
+  }
+  for (auto impl : {td::sha256_batch::Impl::OpenSSL, td::sha256_batch::Impl::ShaNi, td::sha256_batch::Impl::Avx2}) {
+    if (!td::sha256_batch::is_supported(impl)) {
+      LOG(INFO) << "SHA-256 implementation " << td::sha256_batch::impl_name(impl) << " is not supported";
+      continue;
+    }
+    for (size_t batch_size : {1, 7, 8, 100, 1000}) {
+      std::vector<td::Bits256> digests(batch_size);
+      std::vector<td::sha256_batch::Message> messages;
+      for (size_t i = 0; i < batch_size; i++) {
+        messages.push_back({td::Slice(inputs[i]).ubegin(), inputs[i].size(), digests[i].data()});
+      }
+      td::sha256_batch::hash(messages, impl);
+      for (size_t i = 0; i < batch_size; i++) {
+        ASSERT_EQ(td::sha256(inputs[i]), digests[i].as_slice().str());
+      }
+    }
+  }
+  td::Bits256 digest;
+  td::sha256_batch::hash_one(inputs[0], digest.data());
+  ASSERT_EQ(td::sha256(inputs[0]), digest.as_slice().str());
+}
+
+static bool get_bit(const unsigned char* ptr, std::size_t i) {
+  return (ptr[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+static void set_bit(unsigned char* ptr, std::size_t i, bool value) {
+  unsigned char mask = (unsigned char)(0x80 >> (i & 7));
+  ptr[i >> 3] = (unsigned char)(value ? ptr[i >> 3] | mask : ptr[i >> 3] & ~mask);
+}
+
+static std::vector<td::bitstring::SimdImpl> supported_simd_impls() {
+  std::vector<td::bitstring::SimdImpl> res;
+  for (auto impl : {td::bitstring::SimdImpl::Scalar, td::bitstring::SimdImpl::Sse2, td::bitstring::SimdImpl::Avx2}) {
+    if (td::bitstring::is_supported(impl)) {
+      res.push_back(impl);
+    } else {
+      LOG(INFO) << "bitstring kernels " << td::bitstring::simd_impl_name(impl) << " are not supported";
+    }
+  }
+  return res;
+}
+
+TEST(Bitstring, SimdKernels) {
+  td::Random::Xorshift128plus rnd(123);
+  auto saved_impl = td::bitstring::simd_impl();
+  for (auto impl : supported_simd_impls()) {
+    td::bitstring::set_simd_impl(impl);
+    for (int iter = 0; iter < 30000; iter++) {
+      unsigned char a[160], b[160], c[160];
+      for (int i = 0; i < 160; i++) {
+        a[i] = (unsigned char)rnd();
+        b[i] = (unsigned char)rnd();
+      }
+      std::size_t len = rnd.fast(0, 9) ? rnd.fast(0, 1150) : rnd.fast(0, 300);
+      int a_offs = rnd.fast(0, 15), b_offs = rnd.fast(0, 15);
+
+      std::memcpy(c, b, sizeof(c));
+      td::bitstring::bits_memcpy(c, b_offs, a, a_offs, len);
+      for (std::size_t i = 0; i < sizeof(c) * 8; i++) {
+        bool expected = i >= (std::size_t)b_offs && i < b_offs + len ? get_bit(a, a_offs + i - b_offs) : get_bit(b, i);
+        ASSERT_EQ(expected, get_bit(c, i));
+      }
+
+      // b gets the same bits as a, except for the bit at position diff
+      std::size_t diff = len > 0 && rnd.fast(0, 3) ? rnd.fast(0, (int)len - 1) : len;
+      for (std::size_t i = 0; i < len; i++) {
+        set_bit(b, b_offs + i, get_bit(a, a_offs + i) != (i == diff));
+      }
+      std::size_t same_upto = 0;
+      int res = td::bitstring::bits_memcmp(a, a_offs, b, b_offs, len, &same_upto);
+      if (diff == len) {
+        ASSERT_EQ(0, res);
+        ASSERT_EQ(len, same_upto);
+      } else {
+        ASSERT_EQ(get_bit(a, a_offs + diff) ? 1 : -1, res);
+        ASSERT_EQ(diff, same_upto);
+        ASSERT_EQ(-res, td::bitstring::bits_memcmp(b, b_offs, a, a_offs, len));
+      }
+      ASSERT_EQ(diff, td::bitstring::bits_common_prefix(a, a_offs, b, b_offs, len));
+    }
+  }
+  td::bitstring::set_simd_impl(saved_impl);
+}
+
+static td::Ref<vm::Cell> gen_random_cell_dag(td::Random::Xorshift128plus& rnd, int cells) {
+  std::vector<td::Ref<vm::Cell>> pool;
+  for (int i = 0; i < cells; i++) {
+    auto type = rnd.fast(0, 19);
+    if (type == 0 && !pool.empty()) {
+      auto cell = pool[rnd.fast(0, (int)pool.size() - 1)];
+      if (cell->get_level() == 0) {
+        pool.push_back(vm::CellBuilder::create_pruned_branch(cell, 1));
+        continue;
+      }
+    }
+    if (type == 1 && !pool.empty()) {
+      auto cell = pool[rnd.fast(0, (int)pool.size() - 1)];
+      if (cell->get_level() > 0) {
+        pool.push_back(vm::CellBuilder::create_merkle_proof(cell));
+        continue;
+      }
+    }
+    vm::CellBuilder cb;
+    auto bits = rnd.fast(0, 1023);
+    for (int j = 0; j < bits; j++) {
+      cb.store_long_bool(rnd.fast(0, 1), 1);
+    }
+    auto refs = pool.empty() ? 0 : rnd.fast(0, 4);
+    for (int j = 0; j < refs; j++) {
+      // half of the references go to recent cells, so that the dag gets deep
+      int lo = rnd.fast(0, 1) ? std::max(0, (int)pool.size() - 20) : 0;
+      cb.store_ref(pool[rnd.fast(lo, (int)pool.size() - 1)]);
+    }
+    pool.push_back(cb.finalize());
+  }
+  vm::CellBuilder cb;
+  for (int j = 0; j < 4; j++) {
+    cb.store_ref(pool[pool.size() - 1 - j * pool.size() / 4]);
+  }
+  return cb.finalize();
+}
+
+TEST(Cells, BocDeserializeBatchedHashes) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int iter = 0; iter < 50; iter++) {
+    auto root = gen_random_cell_dag(rnd, rnd.fast(10, 2000));
+    for (int mode : {0, 31}) {
+      auto data = vm::std_boc_serialize(root, mode).move_as_ok();
+      auto new_root = vm::std_boc_deserialize(data, false, true).move_as_ok();
+      ASSERT_EQ(root->get_level_mask().get_mask(), new_root->get_level_mask().get_mask());
+      for (td::uint32 level = 0; level <= vm::Cell::max_level; level++) {
+        ASSERT_EQ(root->get_hash(level), new_root->get_hash(level));
+        ASSERT_EQ(root->get_depth(level), new_root->get_depth(level));
+      }
+    }
+  }
+}
+
+static std::string write_boc_frames(td::Slice data, size_t frame_size, td::Random::Xorshift128plus& rnd) {
+  std::string path = "boc-frames-test";
+  td::unlink(path).ignore();
+  auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+  vm::boc_frames::Writer writer{fd, frame_size};
+  while (!data.empty()) {
+    auto s = std::min<size_t>(data.size(), rnd.fast(0, 3) ? rnd.fast(0, 100) : rnd.fast(0, 100000));
+    writer.append(data.substr(0, s)).ensure();
+    data.remove_prefix(s);
+  }
+  writer.finalize().ensure();
+  fd.close();
+  return path;
+}
+
+TEST(Cells, BocFrames) {
+  td::Random::Xorshift128plus rnd(123);
+  std::vector<std::string> inputs;
+  inputs.push_back("");
+  inputs.push_back("ab");
+  inputs.push_back(td::rand_string(0, 127, 100000));
+  for (int i = 0; i < 3; i++) {
+    auto root = gen_random_cell_dag(rnd, rnd.fast(1000, 5000));
+    inputs.push_back(vm::std_boc_serialize(root, 31).move_as_ok().as_slice().str());
+  }
+  for (auto& data : inputs) {
+    for (size_t frame_size : {(size_t)1, (size_t)1000, (size_t)4096, vm::boc_frames::default_frame_size}) {
+      auto path = write_boc_frames(data, frame_size, rnd);
+      auto stored = td::read_file(path).move_as_ok();
+      ASSERT_TRUE(vm::boc_frames::is_framed(stored));
+      ASSERT_EQ(data, vm::boc_frames::decompress(stored.clone()).move_as_ok().as_slice().str());
+
+      auto reader = vm::boc_frames::Reader::open(path).move_as_ok();
+      ASSERT_TRUE(reader.is_framed());
+      ASSERT_EQ(data.size(), reader.raw_size());
+      ASSERT_EQ(stored.size(), reader.stored_size());
+      ASSERT_EQ(data, reader.read(0, -1).move_as_ok().as_slice().str());
+      ASSERT_EQ(stored.as_slice().str(), reader.read_stored(0, -1).move_as_ok().as_slice().str());
+      for (int i = 0; i < 100; i++) {
+        auto offset = rnd.fast(0, (int)data.size());
+        auto size = rnd.fast(0, 20000);
+        ASSERT_EQ(td::Slice(data).substr(offset).truncate(size), reader.read(offset, size).move_as_ok().as_slice());
+      }
+      ASSERT_TRUE(reader.read((td::int64)data.size() + 1, 1).is_error());
+
+      // sequential decoding of a download split into random parts
+      vm::boc_frames::StreamDecoder decoder;
+      td::Slice rest = stored.as_slice();
+      while (!rest.empty()) {
+        auto s = std::min<size_t>(rest.size(), rnd.fast(1, 50000));
+        decoder.feed(rest.substr(0, s)).ensure();
+        rest.remove_prefix(s);
+      }
+      decoder.finish().ensure();
+      std::string decoded;
+      for (auto& part : decoder.extract_decoded()) {
+        decoded += part.as_slice().str();
+      }
+      ASSERT_EQ(data, decoded);
+
+      vm::boc_frames::StreamDecoder truncated;
+      truncated.feed(stored.as_slice().substr(0, stored.size() - 1)).ensure();
+      ASSERT_TRUE(truncated.finish().is_error());
+
+      // corrupted index
+      if (!data.empty()) {
+        auto corrupted = stored.as_slice().str();
+        corrupted[corrupted.size() - vm::boc_frames::footer_size - 1] ^= 1;
+        td::write_file(path, corrupted).ensure();
+        ASSERT_TRUE(vm::boc_frames::Reader::open(path).is_error());
+      }
+      td::unlink(path).ignore();
+    }
+
+    // plain files are read as they are
+    td::write_file("boc-frames-test", data).ensure();
+    auto reader = vm::boc_frames::Reader::open("boc-frames-test").move_as_ok();
+    ASSERT_TRUE(!reader.is_framed());
+    ASSERT_EQ(data, reader.read(0, -1).move_as_ok().as_slice().str());
+    ASSERT_EQ(td::Slice(data).substr(std::min<size_t>(data.size(), 10)).str(),
+              reader.read(std::min<size_t>(data.size(), 10), -1).move_as_ok().as_slice().str());
+    ASSERT_EQ(data, vm::boc_frames::decompress(td::BufferSlice(data)).move_as_ok().as_slice().str());
+    td::unlink("boc-frames-test").ignore();
+  }
+}
+
+class MapCellDbReader : public vm::CellDbReader {
+ public:
+  explicit MapCellDbReader(td::Ref<vm::Cell> root) {
+    add(std::move(root));
+  }
+  td::Result<td::Ref<vm::DataCell>> load_cell(td::Slice hash) override {
+    auto it = cells_.find(td::Bits256(hash.ubegin()));
+    if (it == cells_.end()) {
+      return td::Status::Error("cell not found");
+    }
+    return it->second;
+  }
+
+ private:
+  std::map<td::Bits256, td::Ref<vm::DataCell>> cells_;
+
+  void add(td::Ref<vm::Cell> cell) {
+    auto data_cell = cell->load_cell().move_as_ok().data_cell;
+    if (!cells_.emplace(cell->get_hash().bits(), data_cell).second) {
+      return;
+    }
+    for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+      add(data_cell->get_ref(i));
+    }
+  }
+};
+
+TEST(Cells, BocSerializeToFileLargeCompressed) {
+  td::Random::Xorshift128plus rnd(123);
+  auto root = gen_random_cell_dag(rnd, 3000);
+  auto reader = std::make_shared<MapCellDbReader>(root);
+  std::string files[2] = {"boc-large-plain", "boc-large-compressed"};
+  for (int i = 0; i < 2; i++) {
+    td::unlink(files[i]).ignore();
+    auto fd = td::FileFd::open(files[i], td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+    vm::std_boc_serialize_to_file_large(reader, root->get_hash(), fd, 31, {}, i == 1).ensure();
+    fd.close();
+  }
+  auto plain = td::read_file(files[0]).move_as_ok();
+  auto compressed = td::read_file(files[1]).move_as_ok();
+  ASSERT_EQ(vm::std_boc_serialize(root, 31).move_as_ok().as_slice(), plain.as_slice());
+  ASSERT_TRUE(vm::boc_frames::is_framed(compressed));
+  ASSERT_EQ(plain.as_slice(), vm::boc_frames::decompress(std::move(compressed)).move_as_ok().as_slice());
+  for (auto& file : files) {
+    td::unlink(file).ignore();
+  }
+}
+
+TEST(Cells, StorageStatCache) {
+  td::Random::Xorshift128plus rnd(123);
+  std::vector<td::Ref<vm::Cell>> pool;
+  auto new_cell = [&]() {
+    vm::CellBuilder cb;
+    cb.store_long(rnd() >> 1, rnd.fast(0, 63));
+    int refs = pool.empty() ? 0 : rnd.fast(0, 4);
+    for (int i = 0; i < refs; i++) {
+      cb.store_ref(pool[rnd.fast(0, (int)pool.size() - 1)]);
+    }
+    pool.push_back(cb.finalize());
+    return pool.back();
+  };
+  auto random_root = [&]() -> td::Ref<vm::Cell> {
+    switch (rnd.fast(0, 3)) {
+      case 0:
+        return {};
+      case 1:
+        return pool.empty() ? td::Ref<vm::Cell>{} : pool[rnd.fast(0, (int)pool.size() - 1)];
+      default:
+        return new_cell();
+    }
+  };
+  auto reference = [](const std::vector<td::Ref<vm::Cell>>& roots, td::uint64 limit_cells,
+                      td::uint64 limit_bits) -> td::Result<vm::StorageStatCache::Usage> {
+    vm::CellStorageStat stat;
+    stat.limit_cells = limit_cells;
+    stat.limit_bits = limit_bits;
+    for (const auto& root : roots) {
+      if (root.not_null()) {
+        TRY_STATUS(stat.add_used_storage(root).move_as_status());
+      }
+    }
+    vm::StorageStatCache::Usage usage;
+    usage.cells = stat.cells;
+    usage.bits = stat.bits;
+    return usage;
+  };
+
+  vm::StorageStatCache cache{400};
+  for (int i = 0; i < 3000; i++) {
+    td::Bits256 account = td::Bits256::zero();
+    account.as_array()[0] = (unsigned char)rnd.fast(0, 3);
+    std::vector<td::Ref<vm::Cell>> roots{random_root(), random_root(), random_root()};
+    auto limit_cells = rnd.fast(0, 1) ? std::numeric_limits<td::uint64>::max() : rnd.fast(0, 200);
+    auto limit_bits = rnd.fast(0, 1) ? std::numeric_limits<td::uint64>::max() : rnd.fast(0, 6000);
+    auto expected = reference(roots, limit_cells, limit_bits);
+    auto r_usage = cache.compute(account, roots, limit_cells, limit_bits);
+    ASSERT_EQ(expected.is_ok(), r_usage.is_ok());
+    if (expected.is_ok()) {
+      auto usage = r_usage.move_as_ok();
+      CHECK(usage);
+      ASSERT_EQ(expected.ok().cells, usage.value().cells);
+      ASSERT_EQ(expected.ok().bits, usage.value().bits);
+    }
+    CHECK(cache.size() <= 400);
+  }
+  CHECK(cache.get_stats().hits > 0);
+  CHECK(cache.get_stats().evictions > 0);
+
+  // states with Merkle proofs are left to CellStorageStat
+  td::Bits256 account = td::Bits256::zero();
+  std::vector<td::Ref<vm::Cell>> roots{new_cell(), vm::CellBuilder::create_merkle_proof(new_cell())};
+  auto r_usage = cache.compute(account, roots, std::numeric_limits<td::uint64>::max(),
+                               std::numeric_limits<td::uint64>::max());
+  CHECK(r_usage.is_ok() && !r_usage.ok());
+  roots.pop_back();
+  r_usage = cache.compute(account, roots, std::numeric_limits<td::uint64>::max(),
+                          std::numeric_limits<td::uint64>::max());
+  CHECK(r_usage.is_ok() && r_usage.ok());
+}
+
+TEST(Cells, StorageStatCacheAccountState) {
+  // the extra currency dict of the balance shares cells with code and data: they are counted once
+  vm::Dictionary extra{32};
+  for (td::uint32 id = 1; id <= 4; id++) {
+    vm::CellBuilder cb;
+    CHECK(block::tlb::t_VarUInteger_32.store_integer_value(cb, td::BigInt256(id * 1000)));
+    CHECK(extra.set_builder(td::BitArray<32>(id), cb));
+  }
+  auto extra_root = extra.get_root_cell();
+  auto extra_left = vm::load_cell_slice(extra_root).prefetch_ref(0);
+  auto extra_right = vm::load_cell_slice(extra_root).prefetch_ref(1);
+  auto new_cell = [](int x, std::vector<td::Ref<vm::Cell>> refs) {
+    vm::CellBuilder cb;
+    cb.store_long(x, 32);
+    for (auto& ref : refs) {
+      cb.store_ref(std::move(ref));
+    }
+    return cb.finalize();
+  };
+
+  td::Bits256 addr = td::Bits256::zero();
+  addr.as_array()[0] = 0x11;
+  block::Account account{0, addr.cbits()};
+  CHECK(account.init_new(1000));
+  account.status = block::Account::acc_active;
+  account.balance = block::CurrencyCollection{1000000000, extra_root};
+  account.code = new_cell(1, {});
+  account.data = new_cell(2, {});
+
+  auto run = [&](vm::StorageStatCache* cache, td::Ref<vm::Cell> code, td::Ref<vm::Cell> data) {
+    block::transaction::Transaction trans{account, block::transaction::Transaction::tr_ord, 0, 1000};
+    trans.new_code = std::move(code);
+    trans.new_data = std::move(data);
+    trans.check_state_limits(block::SizeLimitsConfig{}, true, cache).ensure();
+    CHECK(trans.compute_state());
+    return std::make_pair(trans.new_storage_stat.cells, trans.new_storage_stat.bits);
+  };
+  std::vector<std::pair<td::Ref<vm::Cell>, td::Ref<vm::Cell>>> states{
+      {new_cell(3, {extra_left}), new_cell(4, {extra_root})},
+      {new_cell(3, {extra_root}), new_cell(5, {extra_right, new_cell(6, {})})},
+      {new_cell(7, {}), new_cell(8, {extra_left})}};
+  vm::StorageStatCache cache;
+  vm::StorageStatCache small_cache{1};
+  for (const auto& state : states) {
+    auto expected = run(nullptr, state.first, state.second);
+    ASSERT_EQ(expected, run(&cache, state.first, state.second));
+    // the account is evicted before compute_state()
+    ASSERT_EQ(expected, run(&small_cache, state.first, state.second));
+  }
+  CHECK(cache.get_stats().hits > 0);
+}
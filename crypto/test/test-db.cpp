@@ -17,12 +17,16 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "vm/boc.h"
+#include "vm/boc-frames.h"
 #include "vm/cellslice.h"
 #include "vm/cells.h"
 #include "common/AtomicRef.h"
+#include "common/bitstring.h"
+#include "common/sha256-batch.h"
 #include "vm/cells/CellString.h"
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
+#include "vm/dict.h"
 #include "vm/db/CellStorage.h"
 #include "vm/db/CellHashTable.h"
 #include "vm/db/TonDb.h"
@@ -483,6 +487,123 @@ TEST(Cell, MerkleProof) {
   }
 };
 
+TEST(Cell, PreciseMerkleProof) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 1000; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd, true);
+    auto exploration = CellExplorer::random_explore(cell, rnd);
+
+    PreciseMerkleProofBuilder pb{cell};
+    {
+      auto tracking = pb.track();
+      auto exploration2 = CellExplorer::explore(pb.root(), exploration.ops);
+      ASSERT_EQ(exploration.log, exploration2.log);
+    }
+    auto proof = pb.extract_proof().move_as_ok();
+
+    auto usage_tree = std::make_shared<CellUsageTree>();
+    auto usage_cell = UsageCell::create(cell, usage_tree->root_ptr());
+    CellExplorer::explore(usage_cell, exploration.ops);
+    auto proof2 = MerkleProof::generate(cell, usage_tree.get());
+    ASSERT_EQ(proof2->get_hash(), proof->get_hash());
+
+    auto virtualized_proof = MerkleProof::virtualize(proof, 1);
+    auto exploration3 = CellExplorer::explore(virtualized_proof, exploration.ops);
+    ASSERT_EQ(exploration.log, exploration3.log);
+  }
+}
+
+TEST(Cell, PreciseMerkleProofNested) {
+  td::Random::Xorshift128plus rnd{123};
+  auto cell1 = gen_random_cell(1000, rnd, false);
+  auto cell2 = gen_random_cell(1000, rnd, false);
+  auto exploration1 = CellExplorer::random_explore(cell1, rnd);
+  auto exploration2 = CellExplorer::random_explore(cell2, rnd);
+
+  PreciseMerkleProofBuilder pb1{cell1}, pb2{cell2};
+  auto tracking1 = pb1.track();
+  CellExplorer::explore(pb1.root(), exploration1.ops);
+  {
+    auto tracking2 = pb2.track();
+    CellExplorer::explore(pb2.root(), exploration2.ops);
+    // extracting a proof does not count as usage
+    pb2.extract_proof_boc().ensure();
+  }
+  size_t loaded = pb1.loaded_cells();
+  pb1.extract_proof_boc().ensure();
+  ASSERT_EQ(loaded, pb1.loaded_cells());
+
+  auto exploration = CellExplorer::explore(MerkleProof::virtualize(pb1.extract_proof().move_as_ok(), 1),
+                                           exploration1.ops);
+  ASSERT_EQ(exploration1.log, exploration.log);
+  exploration = CellExplorer::explore(MerkleProof::virtualize(pb2.extract_proof().move_as_ok(), 1), exploration2.ops);
+  ASSERT_EQ(exploration2.log, exploration.log);
+}
+
+// a dictionary of 1M accounts stands in for a shard state; a proof covers lookups of some of them
+class BenchMerkleProof : public td::Benchmark {
+ public:
+  BenchMerkleProof(bool precise, int lookups) : precise_(precise), lookups_(lookups) {
+    td::Random::Xorshift128plus rnd(123);
+    Dictionary dict{256};
+    for (int i = 0; i < 1000000; i++) {
+      td::Bits256 key;
+      for (int j = 0; j < 4; j++) {
+        (key.bits() + j * 64).store_uint(rnd(), 64);
+      }
+      CellBuilder cb;
+      cb.store_long(i, 64).store_long(rnd(), 64);
+      CHECK(dict.set_builder(key, cb));
+      if (i % (1000000 / lookups_) == 0) {
+        keys_.push_back(key);
+      }
+    }
+    root_ = dict.get_root_cell();
+  }
+  std::string get_description() const override {
+    return PSTRING() << "MerkleProof: " << lookups_ << " lookups in 1M keys ("
+                     << (precise_ ? "PreciseMerkleProofBuilder" : "MerkleProofBuilder") << ")";
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      Ref<Cell> proof;
+      if (precise_) {
+        PreciseMerkleProofBuilder pb{root_};
+        {
+          auto tracking = pb.track();
+          lookup_all(pb.root());
+        }
+        CHECK(pb.extract_proof_to(proof));
+      } else {
+        MerkleProofBuilder pb{root_};
+        lookup_all(pb.root());
+        CHECK(pb.extract_proof_to(proof));
+      }
+      CHECK(proof.not_null());
+    }
+  }
+
+ private:
+  bool precise_;
+  int lookups_;
+  Ref<Cell> root_;
+  std::vector<td::Bits256> keys_;
+
+  void lookup_all(Ref<Cell> root) {
+    Dictionary dict{std::move(root), 256};
+    for (auto &key : keys_) {
+      CHECK(dict.lookup(key).not_null());
+    }
+  }
+};
+
+TEST(Cell, BenchPreciseMerkleProof) {
+  for (int lookups : {10, 1000, 20000}) {
+    td::bench(BenchMerkleProof(false, lookups));
+    td::bench(BenchMerkleProof(true, lookups));
+  }
+}
+
 TEST(Cell, MerkleProofCombine) {
   td::Random::Xorshift128plus rnd{123};
   for (int t = 0; t < 1000; t++) {
@@ -1749,6 +1870,329 @@ TEST(TonDb, BenchBocDeserializerRocksDb) {
   td::bench(BenchBocDeserializer<vm::StaticBagOfCellsDbBaseline>("rockdb", config));
 }
 
+// extra = (number of leaves, sum of 32-bit values)
+struct BenchCountSumAugmentation : vm::dict::AugmentationData {
+  bool skip_extra(vm::CellSlice &cs) const override {
+    return cs.advance(96);
+  }
+  bool eval_leaf(vm::CellBuilder &cb, vm::CellSlice &val_cs) const override {
+    return cb.store_long_bool(1, 32) && cb.store_long_bool(val_cs.prefetch_ulong(32), 64);
+  }
+  bool eval_fork(vm::CellBuilder &cb, vm::CellSlice &left_cs, vm::CellSlice &right_cs) const override {
+    return cb.store_long_bool(left_cs.fetch_ulong(32) + right_cs.fetch_ulong(32), 32) &&
+           cb.store_long_bool(left_cs.fetch_ulong(64) + right_cs.fetch_ulong(64), 64);
+  }
+  bool eval_empty(vm::CellBuilder &cb) const override {
+    return cb.store_long_bool(0, 96);
+  }
+};
+
+static td::Ref<vm::CellSlice> make_bench_dict_value(td::uint32 x) {
+  vm::CellBuilder cb;
+  cb.store_long(x, 32);
+  return vm::load_cell_slice_ref(cb.finalize());
+}
+
+static td::Bits256 random_bits256(td::Random::Xorshift128plus &rnd) {
+  td::Bits256 key;
+  for (int j = 0; j < 4; j++) {
+    (key.bits() + j * 64).store_uint(rnd(), 64);
+  }
+  return key;
+}
+
+class BenchAugmentedDictUpdate : public td::Benchmark {
+ public:
+  explicit BenchAugmentedDictUpdate(bool bulk) : bulk_(bulk) {
+    td::Random::Xorshift128plus rnd(123);
+    std::vector<std::pair<td::Bits256, td::Ref<vm::CellSlice>>> init;
+    for (int i = 0; i < 1000000; i++) {
+      init.emplace_back(random_bits256(rnd), make_bench_dict_value(i));
+    }
+    std::sort(init.begin(), init.end(), [](const auto &x, const auto &y) { return x.first < y.first; });
+    init.erase(std::unique(init.begin(), init.end(), [](const auto &x, const auto &y) { return x.first == y.first; }),
+               init.end());
+    vm::AugmentedDictionary dict{256, aug_};
+    CHECK(dict.bulk_update(init));
+    root_ = dict.get_root_cell();
+    // half of the updates modify or delete (one in ten) existing keys, the other half add new ones
+    std::map<td::Bits256, td::Ref<vm::CellSlice>> updates;
+    for (int i = 0; i < 10000; i++) {
+      auto key = rnd.fast(0, 1) ? init[rnd.fast(0, (int)init.size() - 1)].first : random_bits256(rnd);
+      updates[key] = rnd.fast(0, 9) ? make_bench_dict_value((td::uint32)rnd()) : td::Ref<vm::CellSlice>{};
+    }
+    updates_.assign(updates.begin(), updates.end());
+  }
+  std::string get_description() const override {
+    return bulk_ ? "AugmentedDictionary: 10k updates of 1M keys (bulk_update)"
+                 : "AugmentedDictionary: 10k updates of 1M keys (set/lookup_delete)";
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      vm::AugmentedDictionary dict{root_, 256, aug_, false};
+      if (bulk_) {
+        CHECK(dict.bulk_update(updates_));
+      } else {
+        for (auto &upd : updates_) {
+          if (upd.second.is_null()) {
+            dict.lookup_delete(upd.first);
+          } else {
+            CHECK(dict.set(upd.first, upd.second));
+          }
+        }
+      }
+      CHECK(dict.get_root_cell().not_null());
+    }
+  }
+
+ private:
+  bool bulk_;
+  BenchCountSumAugmentation aug_;
+  td::Ref<vm::Cell> root_;
+  std::vector<std::pair<td::Bits256, td::Ref<vm::CellSlice>>> updates_;
+};
+
+TEST(TonDb, BenchAugmentedBulkUpdate) {
+  td::bench(BenchAugmentedDictUpdate(false));
+  td::bench(BenchAugmentedDictUpdate(true));
+}
+
+class BenchBocDeserialize : public td::Benchmark {
+ public:
+  BenchBocDeserialize(std::string description, td::Ref<vm::Cell> root, td::sha256_batch::Impl impl)
+      : description_(std::move(description)), data_(vm::std_boc_serialize(root, 31).move_as_ok()), impl_(impl) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BoC deserialize: " << description_ << " (" << data_.size() << " bytes, sha256 "
+                     << td::sha256_batch::impl_name(impl_) << ")";
+  }
+  void start_up() override {
+    saved_impl_ = td::sha256_batch::current_impl();
+    td::sha256_batch::set_impl(impl_);
+  }
+  void tear_down() override {
+    td::sha256_batch::set_impl(saved_impl_);
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      CHECK(vm::std_boc_deserialize(data_).is_ok());
+    }
+  }
+
+ private:
+  std::string description_;
+  td::BufferSlice data_;
+  td::sha256_batch::Impl impl_;
+  td::sha256_batch::Impl saved_impl_{};
+};
+
+// a dictionary of 100k accounts stands in for a shard state
+static td::Ref<vm::Cell> gen_bench_state_dict(td::Random::Xorshift128plus &rnd) {
+  vm::Dictionary state{256};
+  for (int i = 0; i < 100000; i++) {
+    vm::CellBuilder cb;
+    cb.store_long(i, 64).store_long(rnd(), 64);
+    CHECK(state.set_builder(random_bits256(rnd), cb));
+  }
+  return state.get_root_cell();
+}
+
+TEST(TonDb, BenchBocDeserialize) {
+  td::Random::Xorshift128plus rnd(123);
+  auto state = gen_bench_state_dict(rnd);
+  // a smaller dictionary with long values stands in for a block
+  vm::Dictionary block{64};
+  for (int i = 0; i < 3000; i++) {
+    vm::CellBuilder cb, value;
+    for (int j = 0; j < 15; j++) {
+      cb.store_long(rnd(), 64);
+    }
+    value.store_long(rnd(), 64).store_ref(cb.finalize());
+    td::BitArray<64> key;
+    key.bits().store_uint(rnd(), 64);
+    CHECK(block.set_builder(key, value));
+  }
+  for (auto impl : {td::sha256_batch::Impl::OpenSSL, td::sha256_batch::Impl::ShaNi, td::sha256_batch::Impl::Avx2}) {
+    if (!td::sha256_batch::is_supported(impl)) {
+      continue;
+    }
+    td::bench(BenchBocDeserialize("block-like dictionary", block.get_root_cell(), impl));
+    td::bench(BenchBocDeserialize("state-like dictionary", state, impl));
+  }
+}
+
+class BenchBocFrames : public td::Benchmark {
+ public:
+  enum class Mode { Compress, ServeFramed, ServePlain, Download };
+  BenchBocFrames(Mode mode, td::BufferSlice data) : mode_(mode), data_(std::move(data)) {
+  }
+  std::string get_description() const override {
+    static const char *names[] = {"compress", "serve 2MB slices (frames)", "serve 2MB slices (plain)",
+                                  "decode download"};
+    return PSTRING() << "BoC frames: " << names[static_cast<int>(mode_)] << ", " << data_.size() << " -> "
+                     << stored_size_ << " bytes";
+  }
+  void start_up() override {
+    write_frames();
+    stored_size_ = td::read_file(path_).move_as_ok().size();
+    if (mode_ == Mode::ServePlain) {
+      td::write_file(path_, data_.as_slice()).ensure();
+    }
+  }
+  void tear_down() override {
+    td::unlink(path_).ignore();
+  }
+  void run(int n) override {
+    if (mode_ == Mode::Compress) {
+      for (int i = 0; i < n; i++) {
+        write_frames();
+      }
+      return;
+    }
+    auto reader = vm::boc_frames::Reader::open(path_).move_as_ok();
+    if (mode_ == Mode::Download) {
+      auto stored = reader.read_stored(0, -1).move_as_ok();
+      for (int i = 0; i < n; i++) {
+        vm::boc_frames::StreamDecoder decoder;
+        for (size_t offset = 0; offset < stored.size(); offset += 1 << 21) {
+          decoder.feed(stored.as_slice().substr(offset).truncate(1 << 21)).ensure();
+        }
+        decoder.finish().ensure();
+      }
+      return;
+    }
+    for (int i = 0; i < n; i++) {
+      for (td::uint64 offset = 0; offset < reader.raw_size(); offset += 1 << 21) {
+        CHECK(reader.read(offset, 1 << 21).is_ok());
+      }
+    }
+  }
+
+ private:
+  Mode mode_;
+  td::BufferSlice data_;
+  size_t stored_size_ = 0;
+  std::string path_ = "boc-frames-bench";
+
+  void write_frames() {
+    td::unlink(path_).ignore();
+    auto fd = td::FileFd::open(path_, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+    vm::boc_frames::Writer writer{fd, vm::boc_frames::default_frame_size};
+    writer.append(data_.as_slice()).ensure();
+    writer.finalize().ensure();
+    fd.close();
+  }
+};
+
+TEST(TonDb, BenchBocFrames) {
+  td::Random::Xorshift128plus rnd(123);
+  auto data = vm::std_boc_serialize(gen_bench_state_dict(rnd), 31).move_as_ok();
+  for (auto mode : {BenchBocFrames::Mode::Compress, BenchBocFrames::Mode::ServeFramed,
+                    BenchBocFrames::Mode::ServePlain, BenchBocFrames::Mode::Download}) {
+    td::bench(BenchBocFrames(mode, data.clone()));
+  }
+}
+
+class BenchBitsKernel : public td::Benchmark {
+ public:
+  BenchBitsKernel(td::bitstring::SimdImpl impl, bool copy, std::size_t bits)
+      : impl_(impl), copy_(copy), bits_(bits) {
+    td::Random::Xorshift128plus rnd(123);
+    for (auto &x : data_) {
+      x = (unsigned char)rnd();
+    }
+    // bits 0..2047 are repeated 3 bits after the start of the second half
+    td::bitstring::bits_memcpy(data_ + 512, 3, data_, 0, 2048);
+  }
+  std::string get_description() const override {
+    return PSTRING() << (copy_ ? "bits_memcpy " : "bits_memcmp ") << bits_ << " bits, unaligned ("
+                     << td::bitstring::simd_impl_name(impl_) << ")";
+  }
+  void run(int n) override {
+    td::bitstring::set_simd_impl(impl_);
+    std::size_t sum = 0;
+    for (int i = 0; i < n; i++) {
+      // equal strings at different bit offsets, as in dictionary labels compared with keys
+      int offs = i & 7;
+      if (copy_) {
+        td::bitstring::bits_memcpy(data_ + 320, offs, data_, offs + 3, bits_);
+        sum += data_[320];
+      } else {
+        sum += td::bitstring::bits_common_prefix(data_, offs, data_ + 512, offs + 3, bits_);
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+
+ private:
+  td::bitstring::SimdImpl impl_;
+  bool copy_;
+  std::size_t bits_;
+  unsigned char data_[1024];
+};
+
+class BenchDictionaryBitsKernels : public td::Benchmark {
+ public:
+  BenchDictionaryBitsKernels(td::bitstring::SimdImpl impl, td::Ref<vm::Cell> root, const std::vector<td::Bits256> &keys,
+                             const std::vector<td::Bits256> &new_keys)
+      : impl_(impl), root_(std::move(root)), keys_(keys), new_keys_(new_keys) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "Dictionary: 1M lookups and 10k inserts, 1M keys (" << td::bitstring::simd_impl_name(impl_)
+                     << ")";
+  }
+  void run(int n) override {
+    td::bitstring::set_simd_impl(impl_);
+    for (int i = 0; i < n; i++) {
+      vm::Dictionary dict{root_, 256};
+      for (auto &key : keys_) {
+        CHECK(dict.lookup(key).not_null());
+      }
+      for (auto &key : new_keys_) {
+        CHECK(dict.set(key, make_bench_dict_value(0)));
+      }
+    }
+  }
+
+ private:
+  td::bitstring::SimdImpl impl_;
+  td::Ref<vm::Cell> root_;
+  const std::vector<td::Bits256> &keys_;
+  const std::vector<td::Bits256> &new_keys_;
+};
+
+TEST(TonDb, BenchBitsSimdKernels) {
+  std::vector<td::bitstring::SimdImpl> impls;
+  for (auto impl : {td::bitstring::SimdImpl::Scalar, td::bitstring::SimdImpl::Sse2, td::bitstring::SimdImpl::Avx2}) {
+    if (td::bitstring::is_supported(impl)) {
+      impls.push_back(impl);
+    }
+  }
+  auto saved_impl = td::bitstring::simd_impl();
+  for (auto impl : impls) {
+    for (std::size_t bits : {256, 1023}) {
+      td::bench(BenchBitsKernel(impl, true, bits));
+      td::bench(BenchBitsKernel(impl, false, bits));
+    }
+  }
+
+  td::Random::Xorshift128plus rnd(123);
+  std::vector<td::Bits256> keys(1000000), new_keys(10000);
+  for (auto *v : {&keys, &new_keys}) {
+    for (auto &key : *v) {
+      key = random_bits256(rnd);
+    }
+  }
+  vm::Dictionary dict{256};
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    CHECK(dict.set(keys[i], make_bench_dict_value((td::uint32)i)));
+  }
+  for (auto impl : impls) {
+    td::bench(BenchDictionaryBitsKernels(impl, dict.get_root_cell(), keys, new_keys));
+  }
+  td::bitstring::set_simd_impl(saved_impl);
+}
+
 TEST(TonDb, CompactArray) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   td::Slice db_path = "compact_array_db";
@@ -1972,6 +2416,73 @@ TEST(TonDb, DynamicBocRespectsUsageCell) {
   ASSERT_STREQ(serialization, serialization_of_virtualized_cell);
 }
 
+TEST(TonDb, CellCache) {
+  td::Random::Xorshift128plus rnd(123);
+  auto cell = vm::gen_random_cell(1000, rnd);
+  auto serialization = serialize_boc(cell);
+
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto dboc = vm::DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<vm::CellLoader>(kv));
+  dboc->inc(cell);
+  dboc->prepare_commit();
+  {
+    vm::CellStorer cell_storer(*kv);
+    dboc->commit(cell_storer);
+  }
+
+  auto cache = std::make_shared<vm::CellCache>(1 << 20, 2);
+  for (int i = 0; i < 3; i++) {
+    // each pass uses a new reader: cached cells must get its ext cells
+    dboc->set_loader(std::make_unique<vm::CellLoader>(kv, nullptr, cache));
+    auto root = dboc->get_cell_db_reader()->load_cell(cell->get_hash().as_slice()).move_as_ok();
+    ASSERT_EQ(serialization, serialize_boc(root));
+  }
+  auto stats = cache->get_stats();
+  ASSERT_TRUE(stats.hits >= 2 * stats.misses);
+  ASSERT_EQ(stats.misses, stats.inserts);
+
+  // a small cache stays within its size and keeps pinned cells
+  auto small_cache = std::make_shared<vm::CellCache>(1 << 14, 0);
+  dboc->set_loader(std::make_unique<vm::CellLoader>(kv, nullptr, small_cache));
+  auto reader = dboc->get_cell_db_reader();
+  reader->load_cell(cell->get_hash().as_slice()).ensure();
+  small_cache->set_pinned({cell->get_hash()});
+  ASSERT_EQ(1u, small_cache->get_stats().pinned_cells);
+  ASSERT_EQ(serialization, serialize_boc(reader->load_cell(cell->get_hash().as_slice()).move_as_ok()));
+  stats = small_cache->get_stats();
+  ASSERT_TRUE(stats.evictions > 0);
+  ASSERT_TRUE(stats.bytes <= small_cache->get_max_bytes());
+  ASSERT_EQ(1u, stats.pinned_cells);
+
+  // set_pinned() moves the pins to the new set
+  auto pin_cache = std::make_shared<vm::CellCache>(1 << 20, 2);
+  dboc->set_loader(std::make_unique<vm::CellLoader>(kv, nullptr, pin_cache));
+  reader = dboc->get_cell_db_reader();
+  std::vector<vm::CellHash> all;
+  std::set<vm::CellHash> seen;
+  std::vector<td::Ref<vm::Cell>> queue{reader->load_cell(cell->get_hash().as_slice()).move_as_ok()};
+  for (size_t i = 0; i < queue.size() && all.size() < 64; i++) {
+    auto data_cell = queue[i]->load_cell().move_as_ok().data_cell;
+    if (seen.insert(data_cell->get_hash()).second) {
+      all.push_back(data_cell->get_hash());
+    }
+    for (unsigned j = 0; j < data_cell->size_refs(); j++) {
+      queue.push_back(data_cell->get_ref(j));
+    }
+  }
+  ASSERT_EQ(64u, all.size());
+  std::vector<vm::CellHash> first(all.begin(), all.begin() + 40), second(all.begin() + 20, all.end());
+  pin_cache->set_pinned(first);
+  ASSERT_EQ(40u, pin_cache->get_stats().pinned_cells);
+  pin_cache->set_pinned(second);
+  ASSERT_EQ(44u, pin_cache->get_stats().pinned_cells);
+  pin_cache->set_pinned(second);
+  ASSERT_EQ(44u, pin_cache->get_stats().pinned_cells);
+  pin_cache->set_pinned({});
+  ASSERT_EQ(0u, pin_cache->get_stats().pinned_cells);
+}
+
 TEST(TonDb, DoNotMakeListsPrunned) {
   auto cell = vm::CellBuilder().store_bytes("abc").finalize();
   auto is_prunned = [&](const td::Ref<vm::Cell> &cell) { return true; };
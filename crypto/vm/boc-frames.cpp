@@ -0,0 +1,373 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/boc-frames.h"
+
+#include "td/utils/as.h"
+#include "td/utils/crypto.h"
+#include "td/utils/lz4.h"
+#include "td/utils/misc.h"
+#include "td/utils/ScopeGuard.h"
+
+namespace vm {
+namespace boc_frames {
+
+namespace {
+
+constexpr td::uint32 end_marker = 0xffffffff;
+
+size_t max_stored_frame_size(size_t frame_size) {
+  // LZ4_compressBound
+  return frame_size + frame_size / 255 + 16;
+}
+
+td::Result<td::BufferSlice> decode_frame(td::Slice frame, size_t expected_raw_size) {
+  if (frame.size() < frame_header_size) {
+    return td::Status::Error("truncated frame");
+  }
+  td::uint32 stored_size = td::as<td::uint32>(frame.data());
+  td::uint32 raw_size = td::as<td::uint32>(frame.data() + 4);
+  bool uncompressed = stored_size & flag_uncompressed;
+  stored_size &= ~flag_uncompressed;
+  frame.remove_prefix(frame_header_size);
+  if (stored_size != frame.size() || raw_size != expected_raw_size) {
+    return td::Status::Error("invalid frame header");
+  }
+  if (uncompressed) {
+    if (stored_size != raw_size) {
+      return td::Status::Error("invalid frame header");
+    }
+    return td::BufferSlice{frame};
+  }
+  TRY_RESULT(data, td::lz4_decompress(frame, td::narrow_cast<int>(raw_size)));
+  if (data.size() != raw_size) {
+    return td::Status::Error("frame decompressed to a wrong size");
+  }
+  return std::move(data);
+}
+
+}  // namespace
+
+bool is_framed(td::Slice data) {
+  return data.size() >= 4 && td::as<td::uint32>(data.data()) == magic;
+}
+
+Writer::Writer(td::FileFd &fd, size_t frame_size) : fd_(fd), frame_size_(frame_size) {
+  CHECK(frame_size_ > 0 && frame_size_ <= max_frame_size);
+  frame_.reserve(frame_size_);
+}
+
+td::Status Writer::write(td::Slice data) {
+  stored_size_ += data.size();
+  while (!data.empty()) {
+    TRY_RESULT(s, fd_.write(data));
+    data.remove_prefix(s);
+  }
+  return td::Status::OK();
+}
+
+td::Status Writer::append(td::Slice data) {
+  CHECK(!finalized_);
+  if (stored_size_ == 0) {
+    char header[header_size];
+    td::as<td::uint32>(header) = magic;
+    td::as<td::uint32>(header + 4) = version_lz4;
+    td::as<td::uint32>(header + 8) = td::narrow_cast<td::uint32>(frame_size_);
+    td::as<td::uint32>(header + 12) = 0;
+    TRY_STATUS(write(td::Slice(header, header_size)));
+  }
+  raw_size_ += data.size();
+  while (!data.empty()) {
+    auto s = std::min(data.size(), frame_size_ - frame_.size());
+    frame_.append(data.data(), s);
+    data.remove_prefix(s);
+    if (frame_.size() == frame_size_) {
+      TRY_STATUS(flush_frame());
+    }
+  }
+  return td::Status::OK();
+}
+
+td::Status Writer::flush_frame() {
+  if (frame_.empty()) {
+    return td::Status::OK();
+  }
+  frame_offsets_.push_back(stored_size_);
+  auto compressed = td::lz4_compress(frame_);
+  bool uncompressed = compressed.size() >= frame_.size();
+  td::Slice data = uncompressed ? td::Slice(frame_) : compressed.as_slice();
+  char header[frame_header_size];
+  td::as<td::uint32>(header) = td::narrow_cast<td::uint32>(data.size()) | (uncompressed ? flag_uncompressed : 0);
+  td::as<td::uint32>(header + 4) = td::narrow_cast<td::uint32>(frame_.size());
+  TRY_STATUS(write(td::Slice(header, frame_header_size)));
+  TRY_STATUS(write(data));
+  frame_.clear();
+  return td::Status::OK();
+}
+
+td::Status Writer::finalize() {
+  CHECK(!finalized_);
+  if (stored_size_ == 0) {
+    TRY_STATUS(append(td::Slice()));
+  }
+  TRY_STATUS(flush_frame());
+  finalized_ = true;
+
+  char end[frame_header_size];
+  td::as<td::uint32>(end) = end_marker;
+  td::as<td::uint32>(end + 4) = 0;
+  TRY_STATUS(write(td::Slice(end, frame_header_size)));
+
+  td::uint64 index_offset = stored_size_;
+  std::string index(frame_offsets_.size() * 8, '\0');
+  for (size_t i = 0; i < frame_offsets_.size(); i++) {
+    td::as<td::uint64>(&index[i * 8]) = frame_offsets_[i];
+  }
+  TRY_STATUS(write(index));
+
+  char footer[footer_size];
+  td::as<td::uint64>(footer) = index_offset;
+  td::as<td::uint64>(footer + 8) = raw_size_;
+  td::as<td::uint32>(footer + 16) = td::narrow_cast<td::uint32>(frame_offsets_.size());
+  td::as<td::uint32>(footer + 20) = td::crc32c(index);
+  td::as<td::uint32>(footer + 24) = 0;
+  td::as<td::uint32>(footer + 28) = magic;
+  return write(td::Slice(footer, footer_size));
+}
+
+td::Result<Reader> Reader::open(td::CSlice path) {
+  Reader res;
+  TRY_RESULT_ASSIGN(res.fd_, td::FileFd::open(path, td::FileFd::Read));
+  TRY_RESULT(file_size, res.fd_.get_size());
+  res.stored_size_ = res.raw_size_ = file_size;
+
+  char header[header_size];
+  if (file_size < (td::int64)(header_size + frame_header_size + footer_size)) {
+    return std::move(res);
+  }
+  TRY_STATUS(res.read_exact(td::MutableSlice(header, header_size), 0));
+  if (!boc_frames::is_framed(td::Slice(header, header_size))) {
+    return std::move(res);
+  }
+  if (td::as<td::uint32>(header + 4) != version_lz4) {
+    return td::Status::Error("unsupported frame format version");
+  }
+  size_t frame_size = td::as<td::uint32>(header + 8);
+  if (frame_size == 0 || frame_size > max_frame_size) {
+    return td::Status::Error("invalid frame size");
+  }
+
+  char footer[footer_size];
+  TRY_STATUS(res.read_exact(td::MutableSlice(footer, footer_size), file_size - footer_size));
+  td::uint64 index_offset = td::as<td::uint64>(footer);
+  td::uint64 raw_size = td::as<td::uint64>(footer + 8);
+  td::uint64 frame_count = td::as<td::uint32>(footer + 16);
+  if (td::as<td::uint32>(footer + 28) != magic || index_offset > (td::uint64)file_size ||
+      index_offset + frame_count * 8 + footer_size != (td::uint64)file_size ||
+      index_offset < header_size + frame_header_size || frame_count != (raw_size + frame_size - 1) / frame_size) {
+    return td::Status::Error("invalid frame index");
+  }
+  std::string index(frame_count * 8, '\0');
+  TRY_STATUS(res.read_exact(index, index_offset));
+  if (td::crc32c(index) != td::as<td::uint32>(footer + 20)) {
+    return td::Status::Error("frame index crc mismatch");
+  }
+  res.frame_offsets_.resize(frame_count + 1);
+  for (size_t i = 0; i < frame_count; i++) {
+    res.frame_offsets_[i] = td::as<td::uint64>(&index[i * 8]);
+  }
+  res.frame_offsets_[frame_count] = index_offset - frame_header_size;
+  td::uint64 expected = header_size;
+  for (size_t i = 0; i < frame_count; i++) {
+    auto size = res.frame_offsets_[i + 1] - res.frame_offsets_[i];
+    if (res.frame_offsets_[i] != expected || res.frame_offsets_[i + 1] < res.frame_offsets_[i] ||
+        size < frame_header_size || size > frame_header_size + max_stored_frame_size(frame_size)) {
+      return td::Status::Error("invalid frame index");
+    }
+    expected = res.frame_offsets_[i + 1];
+  }
+  if (expected != res.frame_offsets_[frame_count]) {
+    return td::Status::Error("invalid frame index");
+  }
+  res.frame_size_ = frame_size;
+  res.raw_size_ = raw_size;
+  return std::move(res);
+}
+
+td::Status Reader::read_exact(td::MutableSlice slice, td::uint64 offset) const {
+  while (!slice.empty()) {
+    TRY_RESULT(s, fd_.pread(slice, offset));
+    if (s == 0) {
+      return td::Status::Error("unexpected end of file");
+    }
+    offset += s;
+    slice.remove_prefix(s);
+  }
+  return td::Status::OK();
+}
+
+td::Result<td::BufferSlice> Reader::read_stored(td::int64 offset, td::int64 max_size) const {
+  if (offset < 0 || (td::uint64)offset > stored_size_ || max_size < -1) {
+    return td::Status::Error("invalid offset");
+  }
+  td::uint64 size = stored_size_ - offset;
+  if (max_size != -1 && (td::uint64)max_size < size) {
+    size = max_size;
+  }
+  td::BufferSlice res{td::narrow_cast<size_t>(size)};
+  TRY_STATUS(read_exact(res.as_slice(), offset));
+  return std::move(res);
+}
+
+td::Result<td::BufferSlice> Reader::read(td::int64 offset, td::int64 max_size) const {
+  if (!is_framed()) {
+    return read_stored(offset, max_size);
+  }
+  if (offset < 0 || (td::uint64)offset > raw_size_ || max_size < -1) {
+    return td::Status::Error("invalid offset");
+  }
+  td::uint64 size = raw_size_ - offset;
+  if (max_size != -1 && (td::uint64)max_size < size) {
+    size = max_size;
+  }
+  td::BufferSlice res{td::narrow_cast<size_t>(size)};
+  auto dest = res.as_slice();
+  td::uint64 pos = offset;
+  td::BufferSlice frame;
+  while (!dest.empty()) {
+    size_t i = td::narrow_cast<size_t>(pos / frame_size_);
+    td::uint64 frame_begin = (td::uint64)i * frame_size_;
+    size_t raw_size = td::narrow_cast<size_t>(std::min<td::uint64>(frame_size_, raw_size_ - frame_begin));
+    frame = td::BufferSlice{td::narrow_cast<size_t>(frame_offsets_[i + 1] - frame_offsets_[i])};
+    TRY_STATUS(read_exact(frame.as_slice(), frame_offsets_[i]));
+    TRY_RESULT(data, decode_frame(frame, raw_size));
+    auto part = data.as_slice().substr(td::narrow_cast<size_t>(pos - frame_begin));
+    part.truncate(dest.size());
+    dest.copy_from(part);
+    dest.remove_prefix(part.size());
+    pos += part.size();
+  }
+  return std::move(res);
+}
+
+td::Status StreamDecoder::feed(td::Slice data) {
+  if (state_ == State::Plain) {
+    raw_size_ += data.size();
+    decoded_.emplace_back(data);
+    return td::Status::OK();
+  }
+  pending_.append(data.data(), data.size());
+  return process();
+}
+
+td::Status StreamDecoder::process() {
+  td::Slice data = pending_;
+  SCOPE_EXIT {
+    pending_.erase(0, pending_.size() - data.size());
+  };
+  if (state_ == State::Header) {
+    if (data.size() < 4) {
+      return td::Status::OK();
+    }
+    if (!is_framed(data)) {
+      state_ = State::Plain;
+      raw_size_ += data.size();
+      decoded_.emplace_back(data);
+      data = td::Slice();
+      return td::Status::OK();
+    }
+    if (data.size() < header_size) {
+      return td::Status::OK();
+    }
+    if (td::as<td::uint32>(data.data() + 4) != version_lz4) {
+      return td::Status::Error("unsupported frame format version");
+    }
+    frame_size_ = td::as<td::uint32>(data.data() + 8);
+    if (frame_size_ == 0 || frame_size_ > max_frame_size) {
+      return td::Status::Error("invalid frame size");
+    }
+    data.remove_prefix(header_size);
+    state_ = State::Frames;
+  }
+  while (state_ == State::Frames && data.size() >= frame_header_size) {
+    td::uint32 stored_size = td::as<td::uint32>(data.data());
+    if (stored_size == end_marker) {
+      data.remove_prefix(frame_header_size);
+      state_ = State::Trailer;
+      break;
+    }
+    td::uint32 raw_size = td::as<td::uint32>(data.data() + 4);
+    stored_size &= ~flag_uncompressed;
+    if (raw_size == 0 || raw_size > frame_size_ || stored_size > max_stored_frame_size(frame_size_)) {
+      return td::Status::Error("invalid frame header");
+    }
+    if (raw_size_ % frame_size_ != 0) {
+      return td::Status::Error("short frame in the middle of the stream");
+    }
+    if (data.size() < frame_header_size + stored_size) {
+      break;
+    }
+    TRY_RESULT(frame, decode_frame(data.substr(0, frame_header_size + stored_size), raw_size));
+    data.remove_prefix(frame_header_size + stored_size);
+    raw_size_ += raw_size;
+    frame_count_++;
+    decoded_.push_back(std::move(frame));
+  }
+  if (state_ == State::Trailer && data.size() > frame_count_ * 8 + footer_size) {
+    return td::Status::Error("too much data after the last frame");
+  }
+  return td::Status::OK();
+}
+
+td::Status StreamDecoder::finish() {
+  if (state_ == State::Header && pending_.size() < 4) {
+    state_ = State::Plain;
+    raw_size_ += pending_.size();
+    decoded_.emplace_back(td::Slice(pending_));
+    pending_.clear();
+  }
+  if (state_ == State::Plain) {
+    return td::Status::OK();
+  }
+  if (state_ != State::Trailer || pending_.size() != frame_count_ * 8 + footer_size) {
+    return td::Status::Error("truncated frame stream");
+  }
+  td::Slice footer = td::Slice(pending_).substr(frame_count_ * 8);
+  if (td::as<td::uint32>(footer.data() + 28) != magic || td::as<td::uint64>(footer.data() + 8) != raw_size_ ||
+      td::as<td::uint32>(footer.data() + 16) != frame_count_) {
+    return td::Status::Error("invalid frame stream footer");
+  }
+  return td::Status::OK();
+}
+
+td::Result<td::BufferSlice> decompress(td::BufferSlice data) {
+  if (!is_framed(data)) {
+    return std::move(data);
+  }
+  StreamDecoder decoder;
+  TRY_STATUS(decoder.feed(data));
+  TRY_STATUS(decoder.finish());
+  td::BufferSlice res{td::narrow_cast<size_t>(decoder.raw_size())};
+  auto dest = res.as_slice();
+  for (auto &frame : decoder.extract_decoded()) {
+    dest.copy_from(frame);
+    dest.remove_prefix(frame.size());
+  }
+  return std::move(res);
+}
+
+}  // namespace boc_frames
+}  // namespace vm
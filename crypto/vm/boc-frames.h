@@ -0,0 +1,149 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/utils/buffer.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Status.h"
+
+#include <string>
+#include <vector>
+
+namespace vm {
+namespace boc_frames {
+
+/*
+ * Container for large bags of cells (persistent states): the BoC is split into frames of frame_size bytes,
+ * each frame is compressed with lz4 independently, and an index of frame offsets is appended, so that any range
+ * of the BoC can be read without decompressing the whole file.
+ *
+ *   header: magic:4 version:4 frame_size:4 reserved:4
+ *   frame:  stored_size:4 raw_size:4 data:stored_size   (stored_size has flag_uncompressed if data is not compressed)
+ *   end:    0xffffffff:4 0:4
+ *   index:  frame_offset:8 for each frame
+ *   footer: index_offset:8 raw_size:8 frame_count:4 index_crc32c:4 reserved:4 magic:4
+ *
+ * All numbers are little-endian. Frames carry their own sizes, so the file can also be decoded sequentially
+ * (see StreamDecoder) while it is being downloaded.
+ */
+constexpr td::uint32 magic = 0x3e5c46b1;
+constexpr td::uint32 version_lz4 = 1;
+constexpr td::uint32 flag_uncompressed = 1u << 31;
+constexpr size_t header_size = 16;
+constexpr size_t frame_header_size = 8;
+constexpr size_t footer_size = 32;
+constexpr size_t default_frame_size = 1 << 18;
+constexpr size_t max_frame_size = 1 << 24;
+
+bool is_framed(td::Slice data);
+
+class Writer {
+ public:
+  explicit Writer(td::FileFd &fd, size_t frame_size = default_frame_size);
+
+  td::Status append(td::Slice data);
+  td::Status finalize();
+
+  td::uint64 raw_size() const {
+    return raw_size_;
+  }
+  td::uint64 stored_size() const {
+    return stored_size_;
+  }
+
+ private:
+  td::FileFd &fd_;
+  size_t frame_size_;
+  std::string frame_;
+  std::vector<td::uint64> frame_offsets_;
+  td::uint64 raw_size_ = 0;
+  td::uint64 stored_size_ = 0;
+  bool finalized_ = false;
+
+  td::Status write(td::Slice data);
+  td::Status flush_frame();
+};
+
+/*
+ * Random access to a file written by Writer. A file without the frame header is treated as a plain BoC,
+ * so callers do not need to know how a state was stored. Reads use pread and are safe from several threads.
+ */
+class Reader {
+ public:
+  static td::Result<Reader> open(td::CSlice path);
+
+  bool is_framed() const {
+    return frame_size_ != 0;
+  }
+  // size of the bag of cells
+  td::uint64 raw_size() const {
+    return raw_size_;
+  }
+  // size of the file
+  td::uint64 stored_size() const {
+    return stored_size_;
+  }
+
+  // [offset, offset + max_size) of the bag of cells, max_size = -1 reads until the end
+  td::Result<td::BufferSlice> read(td::int64 offset, td::int64 max_size) const;
+  // [offset, offset + max_size) of the file as it is stored
+  td::Result<td::BufferSlice> read_stored(td::int64 offset, td::int64 max_size) const;
+
+ private:
+  td::FileFd fd_;
+  td::uint64 raw_size_ = 0;
+  td::uint64 stored_size_ = 0;
+  size_t frame_size_ = 0;
+  // frame_offsets_[frame_count] is the offset of the end marker
+  std::vector<td::uint64> frame_offsets_;
+
+  td::Status read_exact(td::MutableSlice slice, td::uint64 offset) const;
+};
+
+/*
+ * Sequential decoder: the file is fed in arbitrary pieces, decoded frames are available as they arrive.
+ * Data that does not start with the frame header is passed through unchanged.
+ */
+class StreamDecoder {
+ public:
+  td::Status feed(td::Slice data);
+  // checks that the whole file was received
+  td::Status finish();
+
+  td::uint64 raw_size() const {
+    return raw_size_;
+  }
+  std::vector<td::BufferSlice> extract_decoded() {
+    return std::move(decoded_);
+  }
+
+ private:
+  enum class State { Header, Frames, Trailer, Plain };
+  State state_ = State::Header;
+  std::string pending_;
+  std::vector<td::BufferSlice> decoded_;
+  size_t frame_size_ = 0;
+  td::uint64 raw_size_ = 0;
+  td::uint64 frame_count_ = 0;
+
+  td::Status process();
+};
+
+// decodes a whole file, plain BoC is returned as is
+td::Result<td::BufferSlice> decompress(td::BufferSlice data);
+
+}  // namespace boc_frames
+}  // namespace vm
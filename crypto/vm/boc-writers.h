@@ -17,6 +17,7 @@
 #pragma once
 #include "td/utils/port/FileFd.h"
 #include "td/utils/crypto.h"
+#include "vm/boc-frames.h"
 #include <vector>
 
 namespace vm {
@@ -63,8 +64,9 @@ struct BufferWriter {
 };
 
 struct FileWriter {
-  FileWriter(td::FileFd& fd, size_t expected_size)
-      : fd(fd), expected_size(expected_size) {}
+  // if frames is set, the data goes through it instead of being written to fd directly
+  FileWriter(td::FileFd& fd, size_t expected_size, boc_frames::Writer* frames = nullptr)
+      : fd(fd), expected_size(expected_size), frames(frames) {}
 
   ~FileWriter() {
     flush();
@@ -118,7 +120,9 @@ struct FileWriter {
     }
     flushed_size += end - start;
     current_crc32 = td::crc32c_extend(current_crc32, td::Slice(start, end));
-    if (res.is_ok()) {
+    if (res.is_ok() && frames) {
+      res = frames->append(td::Slice(start, end));
+    } else if (res.is_ok()) {
       while (end > start) {
         auto R = fd.write(td::Slice(start, end));
         if (R.is_error()) {
@@ -134,6 +138,7 @@ struct FileWriter {
 
   td::FileFd& fd;
   size_t expected_size;
+  boc_frames::Writer* frames;
   size_t flushed_size = 0;
   unsigned current_crc32 = td::crc32c(td::Slice());
 
@@ -87,8 +87,8 @@ td::Result<int> CellSerializationInfo::get_bits(td::Slice cell) const {
 }
 
 // TODO: check usage when result is empty
-td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell_slice,
-                                                                  td::Span<Ref<Cell>> refs) const {
+td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell_slice, td::Span<Ref<Cell>> refs,
+                                                                  DataCell::HashBatch* hash_batch) const {
   CellBuilder cb;
   TRY_RESULT(bits, get_bits(cell_slice));
   cb.store_bits(cell_slice.ubegin() + data_offset, bits);
@@ -96,7 +96,7 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   for (int k = 0; k < refs_cnt; k++) {
     cb.store_ref(std::move(refs[k]));
   }
-  TRY_RESULT(res, cb.finalize_novm_nothrow(special));
+  TRY_RESULT(res, cb.finalize_novm_nothrow(special, with_hashes ? nullptr : hash_batch));
   CHECK(!res.is_null());
   if (res->is_special() != special) {
     return td::Status::Error("is_special mismatch");
@@ -740,7 +740,8 @@ td::Result<td::Slice> BagOfCells::get_cell_slice(int idx, td::Slice data) {
 
 td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
                                                                td::Span<td::Ref<DataCell>> cells_span,
-                                                               std::vector<td::uint8>* cell_should_cache) {
+                                                               std::vector<td::uint8>* cell_should_cache,
+                                                               DataCell::HashBatch* hash_batch) {
   TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
   std::array<td::Ref<Cell>, 4> refs_buf;
 
@@ -763,6 +764,7 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
                                         << " cells are defined");
     }
     refs[k] = cells_span[cell_count - ref_idx - 1];
+    DCHECK(refs[k].not_null());
     if (cell_should_cache) {
       auto& cnt = (*cell_should_cache)[ref_idx];
       if (cnt < 2) {
@@ -771,7 +773,42 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
     }
   }
 
-  return cell_info.create_data_cell(cell_slice, refs);
+  return cell_info.create_data_cell(cell_slice, refs, hash_batch);
+}
+
+// Returns cell indices ordered by height (leaves first); layer_ends[h] is the end of the cells of height h.
+// References are not validated here, deserialize_cell() does it
+td::Result<std::vector<int>> BagOfCells::order_cells_by_height(td::Slice cells_slice, std::vector<int>& layer_ends) {
+  std::vector<int> height(cell_count, 0);
+  int max_height = 0;
+  for (int idx = cell_count - 1; idx >= 0; idx--) {
+    TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
+    CellSerializationInfo cell_info;
+    TRY_STATUS(cell_info.init(cell_slice, info.ref_byte_size));
+    for (int k = 0; k < cell_info.refs_cnt; k++) {
+      int ref_idx = (int)info.read_ref(cell_slice.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
+      if (ref_idx > idx && ref_idx < cell_count) {
+        height[idx] = std::max(height[idx], height[ref_idx] + 1);
+      }
+    }
+    max_height = std::max(max_height, height[idx]);
+  }
+  layer_ends.assign(max_height + 1, 0);
+  for (int h : height) {
+    layer_ends[h]++;
+  }
+  for (int h = 1; h <= max_height; h++) {
+    layer_ends[h] += layer_ends[h - 1];
+  }
+  std::vector<int> order(cell_count);
+  std::vector<int> pos(max_height + 1, 0);
+  for (int h = 1; h <= max_height; h++) {
+    pos[h] = layer_ends[h - 1];
+  }
+  for (int idx = cell_count - 1; idx >= 0; idx--) {
+    order[pos[height[idx]]++] = idx;
+  }
+  return std::move(order);
 }
 
 td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots) {
@@ -856,19 +893,30 @@ td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roo
     }
   }
   auto cells_slice = data.substr(info.data_offset, info.data_size);
-  std::vector<Ref<DataCell>> cell_list;
-  cell_list.reserve(cell_count);
-  std::array<td::Ref<Cell>, 4> refs_buf;
-  for (int i = 0; i < cell_count; i++) {
-    // reconstruct cell with index cell_count - 1 - i
-    int idx = cell_count - 1 - i;
-    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
+  // Cells are created layer by layer, starting from the leaves: hashes of all cells of a layer are computed
+  // together before the next layer refers to them
+  std::vector<int> layer_ends;
+  TRY_RESULT(order, order_cells_by_height(cells_slice, layer_ends));
+  // cell with index idx is stored at cell_count - 1 - idx
+  std::vector<Ref<DataCell>> cell_list(cell_count);
+  DataCell::HashBatch hash_batch;
+  constexpr size_t max_hash_batch_size = 4096;
+  for (size_t i = 0, layer = 0; i < order.size(); i++) {
+    int idx = order[i];
+    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr,
+                                   &hash_batch);
     if (r_cell.is_error()) {
       return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
                                         << r_cell.error());
     }
-    cell_list.push_back(r_cell.move_as_ok());
-    DCHECK(cell_list.back().not_null());
+    cell_list[cell_count - 1 - idx] = r_cell.move_as_ok();
+    DCHECK(cell_list[cell_count - 1 - idx].not_null());
+    if ((int)i + 1 == layer_ends[layer]) {
+      hash_batch.flush();
+      layer++;
+    } else if (hash_batch.size() >= max_hash_batch_size) {
+      hash_batch.flush();
+    }
   }
   if (info.has_cache_bits) {
     for (int idx = 0; idx < cell_count; idx++) {
@@ -952,7 +1000,8 @@ td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty, boo
   return std::move(root);
 }
 
-td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data, int max_roots) {
+td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data, int max_roots,
+                                                             bool allow_nonzero_level) {
   if (data.empty()) {
     return std::vector<Ref<Cell>>{};
   }
@@ -968,7 +1017,7 @@ td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data, int
     if (root.is_null()) {
       return td::Status::Error("bag of cells has a null root cell (?)");
     }
-    if (root->get_level() != 0) {
+    if (!allow_nonzero_level && root->get_level() != 0) {
       return td::Status::Error("bag of cells has a root with non-zero level");
     }
     roots.emplace_back(std::move(root));
@@ -184,7 +184,10 @@ struct CellSerializationInfo {
   td::Status init(td::uint8 d1, td::uint8 d2, int ref_byte_size);
   td::Result<int> get_bits(td::Slice cell) const;
 
-  td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  // With hash_batch the hash of the new cell is computed by hash_batch->flush() (unless the serialization
+  // carries hashes, which have to be checked right away)
+  td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs,
+                                             DataCell::HashBatch* hash_batch = nullptr) const;
 };
 
 class BagOfCells {
@@ -323,17 +326,22 @@ class BagOfCells {
   bool get_cache_entry(int index);
   td::Result<td::Slice> get_cell_slice(int index, td::Slice data);
   td::Result<td::Ref<vm::DataCell>> deserialize_cell(int index, td::Slice data, td::Span<td::Ref<DataCell>> cells,
-                                                     std::vector<td::uint8>* cell_should_cache);
+                                                     std::vector<td::uint8>* cell_should_cache,
+                                                     DataCell::HashBatch* hash_batch = nullptr);
+  td::Result<std::vector<int>> order_cells_by_height(td::Slice cells_slice, std::vector<int>& layer_ends);
 };
 
 td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, bool allow_nonzero_level = false);
 td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode = 0);
 
 td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data,
-                                                             int max_roots = BagOfCells::default_max_roots);
+                                                             int max_roots = BagOfCells::default_max_roots,
+                                                             bool allow_nonzero_level = false);
 td::Result<td::BufferSlice> std_boc_serialize_multi(std::vector<Ref<Cell>> root, int mode = 0);
 
+// compress = true writes lz4 frames with a seek index (see vm/boc-frames.h) instead of a plain bag of cells
 td::Status std_boc_serialize_to_file_large(std::shared_ptr<CellDbReader> reader, Cell::Hash root_hash, td::FileFd& fd,
-                                           int mode = 0, td::CancellationToken cancellation_token = {});
+                                           int mode = 0, td::CancellationToken cancellation_token = {},
+                                           bool compress = false);
 
 }  // namespace vm
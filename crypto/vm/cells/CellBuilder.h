@@ -177,7 +177,7 @@ class CellBuilder : public td::CntObject {
   Ref<DataCell> finalize_copy(bool special = false) const;
   Ref<DataCell> finalize(bool special = false);
   Ref<DataCell> finalize_novm(bool special = false);
-  td::Result<Ref<DataCell>> finalize_novm_nothrow(bool special = false);
+  td::Result<Ref<DataCell>> finalize_novm_nothrow(bool special = false, DataCell::HashBatch* hash_batch = nullptr);
   bool finalize_to(Ref<Cell>& res, bool special = false) {
     return (res = finalize(special)).not_null();
   }
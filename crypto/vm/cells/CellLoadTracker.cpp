@@ -0,0 +1,65 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "vm/cells/CellLoadTracker.h"
+
+namespace vm {
+
+void CellLoadTracker::on_load(const CellHash &hash) {
+  for (auto *tracker = get(); tracker != nullptr; tracker = tracker->parent_) {
+    tracker->insert(hash);
+  }
+}
+
+void CellLoadTracker::insert(const CellHash &hash) {
+  if (2 * (size_ + 1) > slots_.size()) {
+    grow();
+  }
+  for (size_t i = first_slot(hash);; i = (i + 1) & mask_) {
+    if (!used_[i]) {
+      slots_[i] = hash;
+      used_[i] = 1;
+      size_++;
+      return;
+    }
+    if (slots_[i] == hash) {
+      return;
+    }
+  }
+}
+
+void CellLoadTracker::grow() {
+  auto old_slots = std::move(slots_);
+  auto old_used = std::move(used_);
+  size_t new_capacity = old_slots.empty() ? 256 : old_slots.size() * 2;
+  slots_.assign(new_capacity, CellHash{});
+  used_.assign(new_capacity, 0);
+  mask_ = new_capacity - 1;
+  for (size_t j = 0; j < old_slots.size(); j++) {
+    if (!old_used[j]) {
+      continue;
+    }
+    size_t i = first_slot(old_slots[j]);
+    while (used_[i]) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = old_slots[j];
+    used_[i] = 1;
+  }
+}
+
+}  // namespace vm
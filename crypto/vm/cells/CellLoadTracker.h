@@ -0,0 +1,107 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#pragma once
+#include "vm/cells/CellHash.h"
+
+#include "td/utils/Context.h"
+#include "td/utils/as.h"
+
+#include <vector>
+
+namespace vm {
+
+// Records hashes of all cells loaded by the current thread while a Guard is alive.
+// Loads are reported by DataCell and ExtCell themselves, so no UsageCell wrappers are needed.
+// Guards may be nested: a load is recorded by every tracker that is active on the thread.
+class CellLoadTracker : public td::Context<CellLoadTracker> {
+ public:
+  class Guard {
+   public:
+    explicit Guard(CellLoadTracker *tracker) : guard_(link(tracker)) {
+    }
+
+   private:
+    td::Context<CellLoadTracker>::Guard guard_;
+
+    static CellLoadTracker *link(CellLoadTracker *tracker) {
+      tracker->parent_ = get();
+      return tracker;
+    }
+  };
+
+  // temporarily stops recording on the current thread, e.g. while a proof is generated
+  class Pause {
+   public:
+    Pause() : guard_(nullptr) {
+    }
+
+   private:
+    td::Context<CellLoadTracker>::Guard guard_;
+  };
+
+  static bool active() {
+    return get() != nullptr;
+  }
+  static void on_load(const CellHash &hash);
+
+  bool is_loaded(const CellHash &hash) const {
+    return find(hash) >= 0;
+  }
+  // index of the hash in the table (in [0, capacity())), or -1 if the cell was not loaded
+  td::int64 find(const CellHash &hash) const {
+    if (size_ == 0) {
+      return -1;
+    }
+    for (size_t i = first_slot(hash);; i = (i + 1) & mask_) {
+      if (!used_[i]) {
+        return -1;
+      }
+      if (slots_[i] == hash) {
+        return static_cast<td::int64>(i);
+      }
+    }
+  }
+  size_t size() const {
+    return size_;
+  }
+  size_t capacity() const {
+    return slots_.size();
+  }
+  void clear() {
+    slots_.clear();
+    used_.clear();
+    size_ = 0;
+    mask_ = 0;
+  }
+
+ private:
+  // open addressing with linear probing; cell hashes are uniform, so their first bytes are used as is
+  std::vector<CellHash> slots_;
+  std::vector<td::uint8> used_;
+  size_t size_{0};
+  size_t mask_{0};
+  CellLoadTracker *parent_{nullptr};
+
+  size_t first_slot(const CellHash &hash) const {
+    return td::as<td::uint64>(hash.as_slice().ubegin()) & mask_;
+  }
+  void insert(const CellHash &hash);
+  void grow();
+};
+
+}  // namespace vm
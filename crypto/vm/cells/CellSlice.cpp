@@ -912,9 +912,7 @@ bool CellSlice::is_proper_suffix_of(const CellSlice& cs2) const {
 }
 
 int CellSlice::common_prefix_len(const CellSlice& cs2) const {
-  std::size_t same_upto = 0;
-  td::bitstring::bits_memcmp(data_bits(), cs2.data_bits(), std::min(size(), cs2.size()), &same_upto);
-  return (int)same_upto;
+  return (int)td::bitstring::bits_common_prefix(data_bits(), cs2.data_bits(), std::min(size(), cs2.size()));
 }
 
 /*
@@ -924,9 +922,7 @@ int CellSlice::common_prefix_len(const td::BitSlice& bs, unsigned offs, unsigned
 */
 
 int CellSlice::common_prefix_len(td::ConstBitPtr bs, unsigned len) const {
-  std::size_t same_upto = 0;
-  td::bitstring::bits_memcmp(data_bits(), bs, std::min(size(), len), &same_upto);
-  return (int)same_upto;
+  return (int)td::bitstring::bits_common_prefix(data_bits(), bs, std::min(size(), len));
 }
 
 int CellSlice::count_leading(bool bit) const {
@@ -18,7 +18,7 @@
 */
 #include "vm/cells/DataCell.h"
 
-#include "openssl/digest.hpp"
+#include "common/sha256-batch.h"
 
 #include "td/utils/ScopeGuard.h"
 
@@ -61,7 +61,7 @@ DataCell::SpecialType DataCell::special_type() const {
 }
 
 td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
-                                           bool special) {
+                                           bool special, HashBatch* hash_batch) {
   for (auto& ref : refs) {
     if (ref.is_null()) {
       return td::Status::Error("Has null cell reference");
@@ -227,22 +227,20 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     if (hash_i < hash_i_offset) {
       continue;
     }
-    unsigned char tmp[2];
-    tmp[0] = info.d1(level_mask.apply(level_i));
-    tmp[1] = info.d2();
-
-    static TD_THREAD_LOCAL digest::SHA256* hasher;
-    td::init_thread_local<digest::SHA256>(hasher);
-    hasher->reset();
-
-    hasher->feed(td::Slice(tmp, 2));
+    unsigned char hash_input[max_hash_input_size];
+    size_t hash_input_size = 0;
+    hash_input[hash_input_size++] = info.d1(level_mask.apply(level_i));
+    hash_input[hash_input_size++] = info.d2();
 
     if (hash_i == hash_i_offset) {
       DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
-      hasher->feed(td::Slice(data_ptr, (bits + 7) >> 3));
+      auto data_size = (bits + 7) >> 3;
+      std::memcpy(hash_input + hash_input_size, data_ptr, data_size);
+      hash_input_size += data_size;
     } else {
       DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
-      hasher->feed(hashes_ptr[hash_i - hash_i_offset - 1].as_slice());
+      std::memcpy(hash_input + hash_input_size, hashes_ptr[hash_i - hash_i_offset - 1].as_slice().data(), hash_bytes);
+      hash_input_size += hash_bytes;
     }
 
     auto dest_i = hash_i - hash_i_offset;
@@ -258,9 +256,8 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
       }
 
       // add depth into hash
-      td::uint8 child_depth_buf[depth_bytes];
-      store_depth(child_depth_buf, child_depth);
-      hasher->feed(td::Slice(child_depth_buf, depth_bytes));
+      store_depth(hash_input + hash_input_size, child_depth);
+      hash_input_size += depth_bytes;
 
       depth = std::max(depth, child_depth);
     }
@@ -274,19 +271,69 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
 
     // children hash
     for (int i = 0; i < info.refs_count_; i++) {
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        hasher->feed(refs_ptr[i]->get_hash(level_i + 1).as_slice());
-      } else {
-        hasher->feed(refs_ptr[i]->get_hash(level_i).as_slice());
-      }
+      auto child_hash = type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate
+                            ? refs_ptr[i]->get_hash(level_i + 1)
+                            : refs_ptr[i]->get_hash(level_i);
+      std::memcpy(hash_input + hash_input_size, child_hash.as_slice().data(), hash_bytes);
+      hash_input_size += hash_bytes;
+    }
+    DCHECK(hash_input_size <= max_hash_input_size);
+    if (hash_batch && hash_count == 1) {
+      hash_batch->add(td::Slice(hash_input, hash_input_size), &hashes_ptr[dest_i]);
+    } else {
+      td::sha256_batch::hash_one(td::Slice(hash_input, hash_input_size), hashes_ptr[dest_i].as_slice().ubegin());
+    }
+  }
+
+  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+}
+
+td::Result<Ref<DataCell>> DataCell::with_refs(td::MutableSpan<Ref<Cell>> refs) const {
+  if (refs.size() != get_refs_cnt()) {
+    return td::Status::Error("Wrong references count");
+  }
+  for (size_t i = 0; i < refs.size(); i++) {
+    if (refs[i].is_null()) {
+      return td::Status::Error("Has null cell reference");
+    }
+    if (refs[i]->get_hash() != get_ref_raw_ptr(static_cast<unsigned>(i))->get_hash()) {
+      return td::Status::Error("Cell reference hash mismatch");
     }
-    auto extracted_size = hasher->extract(hashes_ptr[dest_i].as_slice());
-    DCHECK(extracted_size == hash_bytes);
   }
 
+  auto data_cell = create_empty_data_cell(info_);
+  auto* storage = data_cell->get_storage();
+  const auto* old_storage = get_storage();
+  auto* hashes_ptr = info_.get_hashes(storage);
+  auto* depth_ptr = info_.get_depth(storage);
+  for (size_t i = 0; i < info_.hash_count_; i++) {
+    hashes_ptr[i] = info_.get_hashes(old_storage)[i];
+    depth_ptr[i] = info_.get_depth(old_storage)[i];
+  }
+  std::memcpy(info_.get_data(storage), info_.get_data(old_storage), (info_.bits_ + 7) / 8);
+  auto refs_ptr = info_.get_refs(storage);
+  for (size_t i = 0; i < refs.size(); i++) {
+    refs_ptr[i] = refs[i].release();
+  }
   return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
 }
 
+void DataCell::HashBatch::add(td::Slice input, Hash* dest) {
+  items_.push_back(Item{inputs_.size(), input.size(), dest});
+  inputs_.insert(inputs_.end(), input.begin(), input.end());
+}
+
+void DataCell::HashBatch::flush() {
+  std::vector<td::sha256_batch::Message> messages;
+  messages.reserve(items_.size());
+  for (auto& item : items_) {
+    messages.push_back({inputs_.data() + item.offset, item.size, item.dest->as_slice().ubegin()});
+  }
+  td::sha256_batch::hash(messages);
+  inputs_.clear();
+  items_.clear();
+}
+
 const DataCell::Hash DataCell::do_get_hash(td::uint32 level) const {
   auto hash_i = get_level_mask().apply(level).get_hash_i();
   if (special_type() == SpecialType::PrunnedBranch) {
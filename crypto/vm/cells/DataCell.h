@@ -18,11 +18,14 @@
 */
 #pragma once
 #include "vm/cells/Cell.h"
+#include "vm/cells/CellLoadTracker.h"
 
 #include "td/utils/Span.h"
 
 #include "td/utils/ThreadSafeCounter.h"
 
+#include <vector>
+
 namespace vm {
 
 class DataCell : public Cell {
@@ -37,6 +40,35 @@ class DataCell : public Cell {
     return td::bitstring::bits_load_ulong(src, depth_bits) & 0xffff;
   }
 
+  // Largest hash input: d1, d2, data or the previous level hash, then depths and hashes of the children
+  static constexpr size_t max_hash_input_size = 2 + max_bytes + max_refs * (depth_bytes + hash_bytes);
+
+  // Postpones computing representation hashes of new cells, so that many cells are hashed at once
+  // (see td::sha256_batch). Only single-hash cells are postponed. Cells created with a batch
+  // have no valid hash until flush(), so they must not be used before it, even as references.
+  class HashBatch {
+   public:
+    bool empty() const {
+      return items_.empty();
+    }
+    size_t size() const {
+      return items_.size();
+    }
+    void flush();
+
+   private:
+    friend class DataCell;
+    struct Item {
+      size_t offset;
+      size_t size;
+      Hash* dest;
+    };
+    std::vector<unsigned char> inputs_;
+    std::vector<Item> items_;
+
+    void add(td::Slice input, Hash* dest);
+  };
+
  protected:
   struct Info {
     unsigned bits_;
@@ -128,6 +160,9 @@ class DataCell : public Cell {
 
  public:
   td::Result<LoadedCell> load_cell() const override {
+    if (CellLoadTracker::active()) {
+      CellLoadTracker::on_load(get_hash());
+    }
     return LoadedCell{Ref<DataCell>{this}, {}, {}};
   }
   unsigned get_refs_cnt() const {
@@ -176,6 +211,9 @@ class DataCell : public Cell {
   int serialize(unsigned char* buff, int buff_size, bool with_hashes = false) const;
   std::string serialize() const;
   std::string to_hex() const;
+  // Copy of this cell with other references with the same hashes (e.g. ext cells of another loader);
+  // hashes and depths are copied, not recomputed
+  td::Result<Ref<DataCell>> with_refs(td::MutableSpan<Ref<Cell>> refs) const;
   static td::int64 get_total_data_cells() {
     return get_thread_safe_counter().sum();
   }
@@ -203,7 +241,7 @@ class DataCell : public Cell {
   friend class CellBuilder;
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special);
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
-                                          bool special);
+                                          bool special, HashBatch* hash_batch = nullptr);
 };
 
 std::ostream& operator<<(std::ostream& os, const DataCell& c);
@@ -18,6 +18,7 @@
 */
 #pragma once
 #include "vm/cells/Cell.h"
+#include "vm/cells/CellLoadTracker.h"
 #include "vm/cells/PrunnedCell.h"
 #include "common/AtomicRef.h"
 
@@ -54,6 +55,9 @@ class ExtCell : public Cell {
 
   td::Result<LoadedCell> load_cell() const override {
     TRY_RESULT(data_cell, load_data_cell());
+    if (CellLoadTracker::active()) {
+      CellLoadTracker::on_load(data_cell->get_hash());
+    }
     return LoadedCell{std::move(data_cell), {}, {}};
   }
   td::uint32 get_virtualization() const override {
@@ -96,6 +96,55 @@ class MerkleProofImpl {
     return res;
   }
 };
+
+// Builds the proof in one pass over the cells recorded by a CellLoadTracker.
+// Copies of visited cells are memoized in a vector parallel to the tracker's table, so no hash map is needed.
+class PreciseMerkleProofImpl {
+ public:
+  explicit PreciseMerkleProofImpl(const CellLoadTracker &tracker)
+      : tracker_(tracker), copies_(tracker.capacity()), copy_merkle_depth_(tracker.capacity()) {
+  }
+
+  Ref<Cell> create_from(const Ref<Cell> &cell) {
+    try {
+      return dfs(cell, cell->get_level());
+    } catch (CellBuilder::CellWriteError &) {
+      return {};
+    } catch (CellBuilder::CellCreateError &) {
+      return {};
+    }
+  }
+
+ private:
+  const CellLoadTracker &tracker_;
+  std::vector<Ref<Cell>> copies_;
+  std::vector<int> copy_merkle_depth_;
+
+  Ref<Cell> dfs(const Ref<Cell> &cell, int merkle_depth) {
+    CHECK(cell.not_null());
+    auto slot = tracker_.find(cell->get_hash());
+    if (slot < 0) {
+      auto res = CellBuilder::create_pruned_branch(cell, merkle_depth + 1);
+      CHECK(res.not_null());
+      return res;
+    }
+    if (copies_[slot].not_null() && copy_merkle_depth_[slot] == merkle_depth) {
+      return copies_[slot];
+    }
+    CellSlice cs(NoVm(), cell);
+    int children_merkle_depth = cs.child_merkle_depth(merkle_depth);
+    CellBuilder cb;
+    cb.store_bits(cs.fetch_bits(cs.size()));
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      cb.store_ref(dfs(cs.prefetch_ref(i), children_merkle_depth));
+    }
+    auto res = cb.finalize(cs.is_special());
+    CHECK(res.not_null());
+    copies_[slot] = res;
+    copy_merkle_depth_[slot] = merkle_depth;
+    return res;
+  }
+};
 }  // namespace detail
 
 Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, IsPrunnedFunction is_prunned) {
@@ -106,6 +155,12 @@ Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree) {
   return detail::MerkleProofImpl(usage_tree).create_from(cell);
 }
 
+Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, const CellLoadTracker &tracker) {
+  // loads made while building the proof must not get into the tracker
+  CellLoadTracker::Pause pause;
+  return detail::PreciseMerkleProofImpl(tracker).create_from(cell);
+}
+
 Ref<Cell> MerkleProof::virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt) {
   return cell->virtualize(virt);
 }
@@ -131,6 +186,18 @@ Ref<Cell> MerkleProof::generate(Ref<Cell> cell, CellUsageTree *usage_tree) {
   return CellBuilder::create_merkle_proof(std::move(raw));
 }
 
+Ref<Cell> MerkleProof::generate(Ref<Cell> cell, const CellLoadTracker &tracker) {
+  int cell_level = cell->get_level();
+  if (cell_level != 0) {
+    return {};
+  }
+  auto raw = generate_raw(std::move(cell), tracker);
+  if (raw.is_null()) {
+    return {};
+  }
+  return CellBuilder::create_merkle_proof(std::move(raw));
+}
+
 td::Result<Ref<Cell>> unpack_proof(Ref<Cell> cell) {
   CHECK(cell.not_null());
   td::uint8 level = static_cast<td::uint8>(cell->get_level());
@@ -418,4 +485,30 @@ td::Result<td::BufferSlice> MerkleProofBuilder::extract_proof_boc() const {
   return std_boc_serialize(std::move(proof_root));
 }
 
+td::Result<Ref<Cell>> PreciseMerkleProofBuilder::extract_proof() const {
+  Ref<Cell> proof = MerkleProof::generate(root_, tracker_);
+  if (proof.is_null()) {
+    return td::Status::Error("cannot create Merkle proof");
+  }
+  return proof;
+}
+
+bool PreciseMerkleProofBuilder::extract_proof_to(Ref<Cell> &proof_root) const {
+  if (root_.is_null()) {
+    return false;
+  }
+  auto R = extract_proof();
+  if (R.is_error()) {
+    return false;
+  }
+  proof_root = R.move_as_ok();
+  return true;
+}
+
+td::Result<td::BufferSlice> PreciseMerkleProofBuilder::extract_proof_boc() const {
+  CellLoadTracker::Pause pause;
+  TRY_RESULT(proof_root, extract_proof());
+  return std_boc_serialize(std::move(proof_root));
+}
+
 }  // namespace vm
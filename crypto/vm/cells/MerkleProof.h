@@ -18,6 +18,7 @@
 */
 #pragma once
 #include "vm/cells/Cell.h"
+#include "vm/cells/CellLoadTracker.h"
 #include "td/utils/buffer.h"
 
 #include <utility>
@@ -33,6 +34,7 @@ class MerkleProof {
   // cells must have zero level
   static Ref<Cell> generate(Ref<Cell> cell, IsPrunnedFunction is_prunned);
   static Ref<Cell> generate(Ref<Cell> cell, CellUsageTree *usage_tree);
+  static Ref<Cell> generate(Ref<Cell> cell, const CellLoadTracker &tracker);
 
   // cell must have zero level and must be a MerkleProof
   static Ref<Cell> virtualize(Ref<Cell> cell, int virtualization);
@@ -46,6 +48,7 @@ class MerkleProof {
   // works fine with cell of non-zero level, but this is not supported (yet?) in MerkeProof special cell
   static Ref<Cell> generate_raw(Ref<Cell> cell, IsPrunnedFunction is_prunned);
   static Ref<Cell> generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree);
+  static Ref<Cell> generate_raw(Ref<Cell> cell, const CellLoadTracker &tracker);
   static Ref<Cell> virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt);
   static Ref<Cell> combine_raw(Ref<Cell> a, Ref<Cell> b);
   static Ref<Cell> combine_fast_raw(Ref<Cell> a, Ref<Cell> b);
@@ -68,4 +71,30 @@ class MerkleProofBuilder {
   td::Result<td::BufferSlice> extract_proof_boc() const;
 };
 
+// Same as MerkleProofBuilder, but root() is the original cell: loads are recorded by a CellLoadTracker
+// while the guard returned by track() is alive, and the proof contains every cell reachable from root
+// that was loaded by the current thread in that time. Cells are not wrapped into UsageCell and no usage
+// tree is built, which makes large proofs much cheaper.
+// Only for roots without virtualization (proofs of proofs need MerkleProofBuilder).
+class PreciseMerkleProofBuilder {
+  Ref<Cell> root_;
+  CellLoadTracker tracker_;
+
+ public:
+  explicit PreciseMerkleProofBuilder(Ref<Cell> root) : root_(std::move(root)) {
+  }
+  Ref<Cell> root() const {
+    return root_;
+  }
+  CellLoadTracker::Guard track() {
+    return CellLoadTracker::Guard{&tracker_};
+  }
+  size_t loaded_cells() const {
+    return tracker_.size();
+  }
+  td::Result<Ref<Cell>> extract_proof() const;
+  bool extract_proof_to(Ref<Cell> &proof_root) const;
+  td::Result<td::BufferSlice> extract_proof_boc() const;
+};
+
 }  // namespace vm
@@ -0,0 +1,257 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/db/CellCache.h"
+#include "vm/cells/PrunnedCell.h"
+
+#include "td/utils/as.h"
+
+#include <array>
+
+namespace vm {
+namespace {
+// hashes and depths of the significant levels of a cell, in the form used by ExtCellCreator
+class RefInfo {
+ public:
+  explicit RefInfo(const Cell &cell) : level_mask_(cell.get_level_mask()) {
+    for (unsigned level_i = 0, level = level_mask_.get_level(); level_i <= level; level_i++) {
+      if (!level_mask_.is_significant(level_i)) {
+        continue;
+      }
+      td::MutableSlice(hashes_ + n_ * Cell::hash_bytes, Cell::hash_bytes).copy_from(cell.get_hash(level_i).as_slice());
+      DataCell::store_depth(depths_ + n_ * Cell::depth_bytes, cell.get_depth(level_i));
+      n_++;
+    }
+  }
+  Cell::LevelMask level_mask() const {
+    return level_mask_;
+  }
+  td::Slice hash() const {
+    return td::Slice(hashes_, n_ * Cell::hash_bytes);
+  }
+  td::Slice depth() const {
+    return td::Slice(depths_, n_ * Cell::depth_bytes);
+  }
+
+ private:
+  Cell::LevelMask level_mask_;
+  size_t n_{0};
+  td::uint8 hashes_[(Cell::max_level + 1) * Cell::hash_bytes];
+  td::uint8 depths_[(Cell::max_level + 1) * Cell::depth_bytes];
+};
+
+td::Result<Ref<DataCell>> detach(const Ref<DataCell> &cell) {
+  if (cell->size_refs() == 0) {
+    return cell;
+  }
+  std::array<Ref<Cell>, Cell::max_refs> refs;
+  for (unsigned i = 0; i < cell->size_refs(); i++) {
+    RefInfo info(*cell->get_ref(i));
+    TRY_RESULT(ref, PrunnedCell<td::Unit>::create(PrunnedCellInfo{info.level_mask(), info.hash(), info.depth()},
+                                                  td::Unit()));
+    refs[i] = std::move(ref);
+  }
+  return cell->with_refs(td::MutableSpan<Ref<Cell>>(refs.data(), cell->size_refs()));
+}
+
+// memory taken by a detached cell, its references and its place in the shard, roughly
+size_t estimate_size(const DataCell &cell) {
+  constexpr size_t hash_size = Cell::hash_bytes + Cell::depth_bytes;
+  size_t res = 128 + (cell.get_bits() + 7) / 8 + cell.get_level_mask().get_hashes_count() * hash_size;
+  for (unsigned i = 0; i < cell.size_refs(); i++) {
+    res += sizeof(void *) + 32 + cell.get_ref(i)->get_level_mask().get_hashes_count() * hash_size;
+  }
+  return res;
+}
+}  // namespace
+
+CellCache::CellCache(size_t max_bytes, size_t shards_log)
+    : max_bytes_(max_bytes), max_shard_bytes_(max_bytes >> shards_log) {
+  shards_.resize(static_cast<size_t>(1) << shards_log);
+  for (auto &shard : shards_) {
+    shard = std::make_unique<Shard>();
+  }
+}
+
+size_t CellCache::get_shard_index(td::Slice hash) const {
+  // the first bytes of the hash are used by the index of the shard
+  return td::as<td::uint32>(hash.ubegin() + 8) & (shards_.size() - 1);
+}
+
+CellCache::Shard &CellCache::get_shard(td::Slice hash) const {
+  return *shards_[get_shard_index(hash)];
+}
+
+td::Result<Ref<DataCell>> CellCache::get(td::Slice hash, ExtCellCreator &ext_cell_creator) {
+  Ref<DataCell> cell;
+  {
+    auto &shard = get_shard(hash);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.index.find(CellHash::from_slice(hash));
+    if (it == shard.index.end()) {
+      shard.misses++;
+      return Ref<DataCell>();
+    }
+    shard.hits++;
+    auto &entry = shard.slots[it->second];
+    entry.referenced = true;
+    cell = entry.cell;
+  }
+  if (cell->size_refs() == 0) {
+    return cell;
+  }
+  std::array<Ref<Cell>, Cell::max_refs> refs;
+  for (unsigned i = 0; i < cell->size_refs(); i++) {
+    RefInfo info(*cell->get_ref(i));
+    TRY_RESULT_ASSIGN(refs[i], ext_cell_creator.ext_cell(info.level_mask(), info.hash(), info.depth()));
+  }
+  return cell->with_refs(td::MutableSpan<Ref<Cell>>(refs.data(), cell->size_refs()));
+}
+
+void CellCache::put(const Ref<DataCell> &cell) {
+  auto hash = cell->get_hash();
+  auto &shard = get_shard(hash.as_slice());
+  {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.index.find(hash);
+    if (it != shard.index.end()) {
+      shard.slots[it->second].referenced = true;
+      return;
+    }
+  }
+  auto size = estimate_size(*cell);
+  if (size > max_shard_bytes_) {
+    return;
+  }
+  auto r_detached = detach(cell);
+  if (r_detached.is_error()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  if (shard.index.count(hash)) {
+    return;
+  }
+  while (shard.bytes + size > max_shard_bytes_) {
+    if (!evict_one(shard)) {
+      return;
+    }
+  }
+  size_t slot;
+  if (!shard.free_slots.empty()) {
+    slot = shard.free_slots.back();
+    shard.free_slots.pop_back();
+  } else {
+    slot = shard.slots.size();
+    shard.slots.emplace_back();
+  }
+  // a new cell starts without the reference bit, so cells that are read once are the first to go
+  auto &entry = shard.slots[slot];
+  entry.cell = r_detached.move_as_ok();
+  entry.size = size;
+  shard.index.emplace(hash, slot);
+  shard.bytes += size;
+  shard.inserts++;
+}
+
+bool CellCache::evict_one(Shard &shard) {
+  // an unpinned entry is passed at most twice: the first time its reference bit is cleared
+  for (size_t steps = 0; steps <= 2 * shard.slots.size(); steps++) {
+    if (shard.hand >= shard.slots.size()) {
+      shard.hand = 0;
+    }
+    auto slot = shard.hand++;
+    auto &entry = shard.slots[slot];
+    if (entry.cell.is_null() || entry.pinned) {
+      continue;
+    }
+    if (entry.referenced) {
+      entry.referenced = false;
+      continue;
+    }
+    erase_slot(shard, slot);
+    shard.evictions++;
+    return true;
+  }
+  return false;
+}
+
+void CellCache::erase_slot(Shard &shard, size_t slot) {
+  auto &entry = shard.slots[slot];
+  shard.index.erase(entry.cell->get_hash());
+  shard.bytes -= entry.size;
+  entry = Entry{};
+  shard.free_slots.push_back(slot);
+}
+
+void CellCache::set_pinned(const std::vector<CellHash> &hashes) {
+  // consecutive sets mostly overlap (tops of recent states): the hashes are grouped by shard outside of the locks,
+  // and only the entries that change their state are touched under them
+  std::vector<std::vector<CellHash>> by_shard(shards_.size());
+  for (auto &hash : hashes) {
+    by_shard[get_shard_index(hash.as_slice())].push_back(hash);
+  }
+  for (size_t i = 0; i < shards_.size(); i++) {
+    auto &shard = *shards_[i];
+    std::unordered_set<CellHash> next(by_shard[i].begin(), by_shard[i].end());
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    for (auto it = shard.pinned.begin(); it != shard.pinned.end();) {
+      if (next.count(*it)) {
+        ++it;
+        continue;
+      }
+      // pinned entries are never evicted, so the entry is still there
+      auto &entry = shard.slots[shard.index.at(*it)];
+      entry.pinned = false;
+      shard.pinned_bytes -= entry.size;
+      it = shard.pinned.erase(it);
+    }
+    // the budget goes to the cells in the given order
+    for (auto &hash : by_shard[i]) {
+      if (shard.pinned.count(hash)) {
+        continue;
+      }
+      auto it = shard.index.find(hash);
+      if (it == shard.index.end()) {
+        continue;
+      }
+      auto &entry = shard.slots[it->second];
+      if (shard.pinned_bytes + entry.size > max_shard_bytes_ / 2) {
+        continue;
+      }
+      entry.pinned = true;
+      shard.pinned_bytes += entry.size;
+      shard.pinned.insert(hash);
+    }
+  }
+}
+
+CellCache::Stats CellCache::get_stats() const {
+  Stats stats;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    stats.hits += shard->hits;
+    stats.misses += shard->misses;
+    stats.inserts += shard->inserts;
+    stats.evictions += shard->evictions;
+    stats.cells += shard->index.size();
+    stats.bytes += shard->bytes;
+    stats.pinned_cells += shard->pinned.size();
+  }
+  return stats;
+}
+
+}  // namespace vm
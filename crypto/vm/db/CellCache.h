@@ -0,0 +1,101 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "vm/db/DynamicBagOfCellsDb.h"
+#include "vm/cells.h"
+
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vm {
+
+/*
+ * Decoded cells shared by the readers of a cell database, kept in front of the key-value store.
+ * Cells are stored detached from the loader that decoded them: their references are prunned cells that only carry
+ * hashes and depths, and are replaced with ext cells of the reader on each hit (see DataCell::with_refs). So a hit
+ * costs neither a key-value lookup nor hashing, and cached cells do not keep old snapshots alive.
+ * Only cell contents are cached, not refcnts, so the cache is for readers only (see CellLoader::load_cell).
+ *
+ * The cache is split into shards by hash, each with its own mutex and CLOCK eviction within its part of max_bytes.
+ * Pinned cells (e.g. the top of recent states) are not evicted and take at most half of the budget.
+ */
+class CellCache {
+ public:
+  struct Stats {
+    td::uint64 hits{0};
+    td::uint64 misses{0};
+    td::uint64 inserts{0};
+    td::uint64 evictions{0};
+    size_t cells{0};
+    size_t bytes{0};
+    size_t pinned_cells{0};
+  };
+
+  explicit CellCache(size_t max_bytes, size_t shards_log = 6);
+
+  // returns null if the cell is not cached
+  td::Result<Ref<DataCell>> get(td::Slice hash, ExtCellCreator &ext_cell_creator);
+  void put(const Ref<DataCell> &cell);
+  // pins the given cells that are cached and unpins the others; only the difference with the previous call is applied
+  void set_pinned(const std::vector<CellHash> &hashes);
+
+  Stats get_stats() const;
+  size_t get_max_bytes() const {
+    return max_bytes_;
+  }
+
+ private:
+  struct Entry {
+    Ref<DataCell> cell;
+    size_t size{0};
+    bool referenced{false};
+    bool pinned{false};
+  };
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<CellHash, size_t> index;
+    // the clock: empty entries are listed in free_slots
+    std::vector<Entry> slots;
+    std::vector<size_t> free_slots;
+    size_t hand{0};
+    size_t bytes{0};
+    // hashes of the pinned entries
+    std::unordered_set<CellHash> pinned;
+    size_t pinned_bytes{0};
+    td::uint64 hits{0};
+    td::uint64 misses{0};
+    td::uint64 inserts{0};
+    td::uint64 evictions{0};
+  };
+
+  size_t max_bytes_;
+  size_t max_shard_bytes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  size_t get_shard_index(td::Slice hash) const;
+  Shard &get_shard(td::Slice hash) const;
+  bool evict_one(Shard &shard);
+  void erase_slot(Shard &shard, size_t slot);
+};
+
+}  // namespace vm
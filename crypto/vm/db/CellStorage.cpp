@@ -144,8 +144,9 @@ class RefcntCellParser {
 };
 }  // namespace
 
-CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback)
-    : reader_(std::move(reader)), on_load_callback_(std::move(on_load_callback)) {
+CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback,
+                       std::shared_ptr<CellCache> cell_cache)
+    : reader_(std::move(reader)), on_load_callback_(std::move(on_load_callback)), cell_cache_(std::move(cell_cache)) {
   CHECK(reader_);
 }
 
@@ -177,6 +178,23 @@ td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_da
   return res;
 }
 
+td::Result<Ref<DataCell>> CellLoader::load_cell(td::Slice hash, ExtCellCreator &ext_cell_creator) {
+  if (cell_cache_) {
+    TRY_RESULT(cell, cell_cache_->get(hash, ext_cell_creator));
+    if (cell.not_null()) {
+      return std::move(cell);
+    }
+  }
+  TRY_RESULT(res, load(hash, true, ext_cell_creator));
+  if (res.status != LoadResult::Ok) {
+    return Ref<DataCell>();
+  }
+  if (cell_cache_) {
+    cell_cache_->put(res.cell());
+  }
+  return std::move(res.cell());
+}
+
 CellStorer::CellStorer(KeyValue &kv) : kv_(kv) {
 }
 
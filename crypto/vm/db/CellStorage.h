@@ -19,6 +19,7 @@
 #pragma once
 #include "td/db/KeyValue.h"
 #include "vm/db/DynamicBagOfCellsDb.h"
+#include "vm/db/CellCache.h"
 #include "vm/cells.h"
 
 #include "td/utils/Slice.h"
@@ -47,12 +48,17 @@ class CellLoader {
     td::int32 refcnt_{0};
     bool stored_boc_{false};
   };
-  CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback = {});
+  CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback = {},
+             std::shared_ptr<CellCache> cell_cache = {});
   td::Result<LoadResult> load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator);
+  // For readers that need only the cell, not its refcnt: goes through the cell cache, if there is one.
+  // Returns null if the cell is not found
+  td::Result<Ref<DataCell>> load_cell(td::Slice hash, ExtCellCreator &ext_cell_creator);
 
  private:
   std::shared_ptr<KeyValueReader> reader_;
   std::function<void(const LoadResult &)> on_load_callback_;
+  std::shared_ptr<CellCache> cell_cache_;
 };
 
 class CellStorer {
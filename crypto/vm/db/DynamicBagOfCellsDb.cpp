@@ -204,7 +204,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     loader_ = std::move(loader);
     //cell_db_reader_ = std::make_shared<CellDbReaderImpl>(this);
     // Temporary(?) fix to make ExtCell thread safe.
-    // Downside(?) - loaded cells won't be cached
+    // Downside(?) - loaded cells won't be cached (unless the loader has a CellCache)
     cell_db_reader_ = std::make_shared<CellDbReaderImpl>(std::make_unique<CellLoader>(*loader_));
     stats_diff_ = {};
     return td::Status::OK();
@@ -292,11 +292,11 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       if (db_) {
         return db_->load_cell(hash);
       }
-      TRY_RESULT(load_result, cell_loader_->load(hash, true, *this));
-      if (load_result.status != CellLoader::LoadResult::Ok) {
+      TRY_RESULT(cell, cell_loader_->load_cell(hash, *this));
+      if (cell.is_null()) {
         return td::Status::Error("cell not found");
       }
-      return std::move(load_result.cell());
+      return std::move(cell);
     }
 
    private:
@@ -25,6 +25,8 @@
 
 #include "td/utils/bits.h"
 
+#include <algorithm>
+
 namespace vm {
 
 /*
@@ -2869,6 +2871,210 @@ bool AugmentedDictionary::set_builder(td::ConstBitPtr key, int key_len, const Ce
   return set(key, key_len, load_cell_slice(value.finalize_copy()));
 }
 
+namespace {
+
+int keys_common_prefix_len(td::ConstBitPtr key1, td::ConstBitPtr key2, int n) {
+  return (int)td::bitstring::bits_common_prefix(key1, key2, n);
+}
+
+}  // namespace
+
+Ref<Cell> AugmentedDictionary::dict_merge_edge(td::ConstBitPtr prefix, int pfx_len, bool bit, Ref<Cell> child,
+                                               int n) const {
+  // creates the edge `prefix`.`bit` + label of `child` leading to the payload of `child`
+  unsigned char buffer[Dictionary::max_key_bytes];
+  td::BitPtr bw{buffer};
+  bw.concat(prefix, pfx_len);
+  bw.concat_same(bit, 1);
+  LabelParser label{std::move(child), n - pfx_len - 1, label_mode()};
+  bw += label.extract_label_to(bw);
+  assert(bw.offs >= 0 && bw.offs <= Dictionary::max_key_bits);
+  CellBuilder cb;
+  append_dict_label(cb, td::ConstBitPtr{buffer}, bw.offs, n);
+  if (!cell_builder_add_slice_bool(cb, *label.remainder)) {
+    throw VmError{Excno::cell_ov, "cannot change label of an old augmented dictionary cell while merging edges"};
+  }
+  return cb.finalize();
+}
+
+Ref<Cell> AugmentedDictionary::dict_bulk_build(int n, int offs, bulk_update_iter_t begin,
+                                               bulk_update_iter_t end) const {
+  // deletions of keys are no-ops in an empty subdictionary
+  while (begin < end && begin->second.is_null()) {
+    ++begin;
+  }
+  while (begin < end && end[-1].second.is_null()) {
+    --end;
+  }
+  if (begin == end) {
+    return {};
+  }
+  td::ConstBitPtr key = begin->first + offs;
+  CellBuilder cb;
+  if (end - begin == 1) {
+    append_dict_label(cb, key, n, n);
+    return finish_create_leaf(cb, *begin->second);
+  }
+  // the keys are sorted, so the common prefix of the first and of the last key is common to all of them
+  int pfx_len = keys_common_prefix_len(key, end[-1].first + offs, n);
+  assert(pfx_len < n);
+  auto mid = std::partition_point(begin, end, [&](const auto& upd) { return !upd.first[offs + pfx_len]; });
+  auto c1 = dict_bulk_build(n - pfx_len - 1, offs + pfx_len + 1, begin, mid);
+  auto c2 = dict_bulk_build(n - pfx_len - 1, offs + pfx_len + 1, mid, end);
+  append_dict_label(cb, key, pfx_len, n);
+  return finish_create_fork(cb, std::move(c1), std::move(c2), n - pfx_len);
+}
+
+void AugmentedDictionary::BulkUpdateModes::check_absent(bulk_update_iter_t begin, bulk_update_iter_t end) {
+  for (auto it = begin; it < end; ++it) {
+    if (modes[it - base] == SetMode::Replace) {
+      ok = false;
+    }
+  }
+}
+
+void AugmentedDictionary::BulkUpdateModes::check_present(bulk_update_iter_t it) {
+  if (modes[it - base] == SetMode::Add && it->second.not_null()) {
+    ok = false;
+  }
+}
+
+Ref<Cell> AugmentedDictionary::dict_bulk_update(Ref<Cell> dict, int n, int offs, bulk_update_iter_t begin,
+                                                bulk_update_iter_t end, BulkUpdateModes* modes) const {
+  if (begin == end) {
+    return dict;
+  }
+  if (dict.is_null()) {
+    if (modes) {
+      modes->check_absent(begin, end);
+    }
+    return dict_bulk_build(n, offs, begin, end);
+  }
+  LabelParser label{dict, n, label_mode()};
+  label.validate();
+  td::ConstBitPtr key = begin->first + offs;
+  int pfx_len = std::min(label.common_prefix_len(key, n), label.common_prefix_len(end[-1].first + offs, n));
+  assert(pfx_len >= 0 && pfx_len <= label.l_bits && label.l_bits <= n);
+  if (pfx_len < label.l_bits) {
+    // some keys leave the current edge at bit pfx_len, a new fork has to be inserted there
+    bool old_bit = label.l_same ? (label.l_same & 1) : label.remainder->data_bits()[pfx_len];
+    auto mid = std::partition_point(begin, end, [&](const auto& upd) { return !upd.first[offs + pfx_len]; });
+    auto old_begin = old_bit ? mid : begin, old_end = old_bit ? end : mid;
+    if (modes) {
+      // the keys leaving the edge are not in the dictionary
+      modes->check_absent(old_bit ? begin : mid, old_bit ? mid : end);
+    }
+    auto c_new = old_bit ? dict_bulk_build(n - pfx_len - 1, offs + pfx_len + 1, begin, mid)
+                         : dict_bulk_build(n - pfx_len - 1, offs + pfx_len + 1, mid, end);
+    if (c_new.is_null()) {
+      // only deletions of absent keys leave the edge, ignore them
+      label.clear();
+      return dict_bulk_update(std::move(dict), n, offs, old_begin, old_end, modes);
+    }
+    // the lower portion of the old edge becomes the other child of the new fork
+    int m = n - pfx_len - 1;
+    int t = label.l_bits - pfx_len - 1;
+    auto cs = std::move(label.remainder);
+    CellBuilder cb;
+    if (label.l_same) {
+      append_dict_label_same(cb, label.l_same & 1, t, m);
+    } else {
+      cs.write().advance(pfx_len + 1);
+      append_dict_label(cb, cs->data_bits(), t, m);
+      cs.unique_write().advance(t);
+    }
+    if (!cell_builder_add_slice_bool(cb, *cs)) {
+      throw VmError{Excno::cell_ov, "cannot change label of an old augmented dictionary cell (?)"};
+    }
+    cs.clear();
+    auto c_old = dict_bulk_update(cb.finalize(), m, offs + pfx_len + 1, old_begin, old_end, modes);
+    if (c_old.is_null()) {
+      return dict_merge_edge(key, pfx_len, !old_bit, std::move(c_new), n);
+    }
+    if (old_bit) {
+      c_old.swap(c_new);
+    }
+    append_dict_label(cb, key, pfx_len, n);
+    return finish_create_fork(cb, std::move(c_old), std::move(c_new), n - pfx_len);
+  }
+  if (label.l_bits == n) {
+    // the edge leads to a leaf node, the only key of the range matches it
+    assert(end - begin == 1);
+    if (modes) {
+      modes->check_present(begin);
+    }
+    if (begin->second.is_null()) {
+      return {};
+    }
+    CellBuilder cb;
+    append_dict_label(cb, key, n, n);
+    return finish_create_leaf(cb, *begin->second);
+  }
+  // main case: the edge leads to a fork, split the range between the two subtrees
+  int l = label.l_bits;
+  auto c1 = label.remainder->prefetch_ref(0);
+  auto c2 = label.remainder->prefetch_ref(1);
+  label.clear();
+  auto mid = std::partition_point(begin, end, [&](const auto& upd) { return !upd.first[offs + l]; });
+  auto r1 = dict_bulk_update(c1, n - l - 1, offs + l + 1, begin, mid, modes);
+  auto r2 = dict_bulk_update(c2, n - l - 1, offs + l + 1, mid, end, modes);
+  if (r1.get() == c1.get() && r2.get() == c2.get()) {
+    return dict;
+  }
+  if (r1.not_null() && r2.not_null()) {
+    CellBuilder cb;
+    append_dict_label(cb, key, l, n);
+    return finish_create_fork(cb, std::move(r1), std::move(r2), n - l);
+  }
+  if (r1.is_null() && r2.is_null()) {
+    return {};
+  }
+  // have to merge current edge with the edge leading to the remaining child
+  return r1.not_null() ? dict_merge_edge(key, l, false, std::move(r1), n)
+                       : dict_merge_edge(key, l, true, std::move(r2), n);
+}
+
+bool AugmentedDictionary::bulk_update(const std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>>& updates,
+                                      int key_len) {
+  force_validate();
+  if (key_len != get_key_bits()) {
+    return false;
+  }
+  for (std::size_t i = 1; i < updates.size(); i++) {
+    if (td::bitstring::bits_memcmp(updates[i - 1].first, updates[i].first, key_len) >= 0) {
+      return false;
+    }
+  }
+  if (updates.empty()) {
+    return true;
+  }
+  set_root_cell(dict_bulk_update(get_root_cell(), key_len, 0, updates.data(), updates.data() + updates.size()));
+  return true;
+}
+
+bool AugmentedDictionary::bulk_update(const std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>>& updates,
+                                      int key_len, const std::vector<SetMode>& modes) {
+  force_validate();
+  if (key_len != get_key_bits() || modes.size() != updates.size()) {
+    return false;
+  }
+  for (std::size_t i = 1; i < updates.size(); i++) {
+    if (td::bitstring::bits_memcmp(updates[i - 1].first, updates[i].first, key_len) >= 0) {
+      return false;
+    }
+  }
+  if (updates.empty()) {
+    return true;
+  }
+  BulkUpdateModes chk{updates.data(), modes.data()};
+  auto root = dict_bulk_update(get_root_cell(), key_len, 0, updates.data(), updates.data() + updates.size(), &chk);
+  if (!chk.ok) {
+    return false;
+  }
+  set_root_cell(std::move(root));
+  return true;
+}
+
 bool AugmentedDictionary::check_for_each_extra(const foreach_extra_func_t& foreach_extra_func, bool invert_first) {
   force_validate();
   const auto& augm = aug;
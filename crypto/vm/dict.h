@@ -588,6 +588,13 @@ class AugmentedDictionary final : public DictionaryFixed {
   bool set(td::ConstBitPtr key, int key_len, Ref<CellSlice> value, SetMode mode = SetMode::Set);
   bool set_ref(td::ConstBitPtr key, int key_len, Ref<Cell> val_ref, SetMode mode = SetMode::Set);
   bool set_builder(td::ConstBitPtr key, int key_len, const CellBuilder& value, SetMode mode = SetMode::Set);
+  // applies a batch of updates in one pass over the tree; keys must be sorted in increasing order without repetitions,
+  // a null value deletes the key. The result is the same as of applying set()/lookup_delete() one by one
+  bool bulk_update(const std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>>& updates, int key_len);
+  // the same, but the i-th update is checked against modes[i] as set() does; a deletion with SetMode::Replace
+  // requires the key to be present, other deletions are not checked. Nothing is changed if any of the checks fails
+  bool bulk_update(const std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>>& updates, int key_len,
+                   const std::vector<SetMode>& modes);
   bool check_for_each_extra(const foreach_extra_func_t& foreach_extra_func, bool invert_first = false);
   std::pair<Ref<CellSlice>, Ref<CellSlice>> traverse_extra(td::BitPtr key_buffer, int key_len,
                                                            const traverse_func_t& traverse_node);
@@ -625,6 +632,24 @@ class AugmentedDictionary final : public DictionaryFixed {
   Ref<Cell> lookup_delete_ref(const T& key) {
     return lookup_delete_ref(key.bits(), key.size());
   }
+  template <typename T>
+  bool bulk_update(const std::vector<std::pair<T, Ref<CellSlice>>>& updates) {
+    std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>> upd;
+    upd.reserve(updates.size());
+    for (const auto& x : updates) {
+      upd.emplace_back(x.first.bits(), x.second);
+    }
+    return bulk_update(upd, updates.empty() ? get_key_bits() : (int)updates[0].first.size());
+  }
+  template <typename T>
+  bool bulk_update(const std::vector<std::pair<T, Ref<CellSlice>>>& updates, const std::vector<SetMode>& modes) {
+    std::vector<std::pair<td::ConstBitPtr, Ref<CellSlice>>> upd;
+    upd.reserve(updates.size());
+    for (const auto& x : updates) {
+      upd.emplace_back(x.first.bits(), x.second);
+    }
+    return bulk_update(upd, updates.empty() ? get_key_bits() : (int)updates[0].first.size(), modes);
+  }
   auto range(bool rev = false, bool sgnd = false) {
     return dict_range(*this, rev, sgnd);
   }
@@ -644,6 +669,18 @@ class AugmentedDictionary final : public DictionaryFixed {
   Ref<Cell> finish_create_fork(CellBuilder& cb, Ref<Cell> c1, Ref<Cell> c2, int n) const override;
   std::pair<Ref<Cell>, bool> dict_set(Ref<Cell> dict, td::ConstBitPtr key, int n, const CellSlice& value,
                                       SetMode mode = SetMode::Set) const;
+  using bulk_update_iter_t = const std::pair<td::ConstBitPtr, Ref<CellSlice>>*;
+  struct BulkUpdateModes {
+    bulk_update_iter_t base;
+    const SetMode* modes;
+    bool ok{true};
+    void check_absent(bulk_update_iter_t begin, bulk_update_iter_t end);
+    void check_present(bulk_update_iter_t it);
+  };
+  Ref<Cell> dict_bulk_update(Ref<Cell> dict, int n, int offs, bulk_update_iter_t begin, bulk_update_iter_t end,
+                             BulkUpdateModes* modes = nullptr) const;
+  Ref<Cell> dict_bulk_build(int n, int offs, bulk_update_iter_t begin, bulk_update_iter_t end) const;
+  Ref<Cell> dict_merge_edge(td::ConstBitPtr prefix, int pfx_len, bool bit, Ref<Cell> child, int n) const;
   int label_mode() const override {
     return dict::LabelParser::chk_size;
   }
@@ -39,7 +39,7 @@ class LargeBocSerializer {
 
   void add_root(Hash root);
   td::Status import_cells();
-  td::Status serialize(td::FileFd& fd, int mode);
+  td::Status serialize(td::FileFd& fd, int mode, bool compress);
 
  private:
   std::shared_ptr<CellDbReader> reader;
@@ -305,7 +305,7 @@ td::uint64 LargeBocSerializer::compute_sizes(int mode, int& r_size, int& o_size)
   return data_bytes_adj;
 }
 
-td::Status LargeBocSerializer::serialize(td::FileFd& fd, int mode) {
+td::Status LargeBocSerializer::serialize(td::FileFd& fd, int mode, bool compress) {
   td::Timer timer;
   using Mode = BagOfCells::Mode;
   BagOfCells::Info info;
@@ -338,7 +338,11 @@ td::Status LargeBocSerializer::serialize(td::FileFd& fd, int mode) {
     return td::Status::Error("bag of cells is too large");
   }
 
-  boc_writers::FileWriter writer{fd, (size_t)info.total_size};
+  std::unique_ptr<boc_frames::Writer> frames;
+  if (compress) {
+    frames = std::make_unique<boc_frames::Writer>(fd);
+  }
+  boc_writers::FileWriter writer{fd, (size_t)info.total_size, frames.get()};
   auto store_ref = [&](unsigned long long value) { writer.store_uint(value, info.ref_byte_size); };
   auto store_offset = [&](unsigned long long value) { writer.store_uint(value, info.offset_byte_size); };
 
@@ -431,18 +435,22 @@ td::Status LargeBocSerializer::serialize(td::FileFd& fd, int mode) {
   TRY_STATUS(writer.finalize());
   LOG(ERROR) << "serializer: serialize took " << timer.elapsed() << "s, " << cell_count << " cells, "
              << writer.position() << " bytes";
+  if (frames) {
+    TRY_STATUS(frames->finalize());
+    LOG(ERROR) << "serializer: compressed to " << frames->stored_size() << " bytes";
+  }
   return td::Status::OK();
 }
 }  // namespace
 
 td::Status std_boc_serialize_to_file_large(std::shared_ptr<CellDbReader> reader, Cell::Hash root_hash, td::FileFd& fd,
-                                           int mode, td::CancellationToken cancellation_token) {
+                                           int mode, td::CancellationToken cancellation_token, bool compress) {
   td::Timer timer;
   CHECK(reader != nullptr)
   LargeBocSerializer serializer(reader, std::move(cancellation_token));
   serializer.add_root(root_hash);
   TRY_STATUS(serializer.import_cells());
-  TRY_STATUS(serializer.serialize(fd, mode));
+  TRY_STATUS(serializer.serialize(fd, mode, compress));
   LOG(ERROR) << "serialization took " << timer.elapsed() << "s";
   return td::Status::OK();
 }
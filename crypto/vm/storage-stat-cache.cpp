@@ -0,0 +1,183 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/storage-stat-cache.h"
+
+#include "vm/cellslice.h"
+
+namespace vm {
+
+td::Result<td::optional<StorageStatCache::Usage>> StorageStatCache::compute(const td::Bits256& account,
+                                                                          td::Span<Ref<Cell>> roots,
+                                                                          td::uint64 limit_cells,
+                                                                          td::uint64 limit_bits) {
+  auto it = entries_.find(account);
+  if (it == entries_.end()) {
+    stats_.misses++;
+    it = entries_.emplace(account, Entry{}).first;
+  } else {
+    stats_.hits++;
+  }
+  auto& entry = it->second;
+  entry.last_used = ++time_;
+
+  // new cells are added before the old roots are released, so that cells shared by both states are not visited
+  auto r_ok = add_refs(entry, roots, limit_cells, limit_bits);
+  if (r_ok.is_error() || !r_ok.ok()) {
+    erase(it);
+    if (r_ok.is_error()) {
+      return r_ok.move_as_error();
+    }
+    stats_.fallbacks++;
+    return td::optional<Usage>{};
+  }
+  remove_refs(entry, entry.roots);
+  entry.roots.clear();
+  for (const auto& root : roots) {
+    if (root.not_null()) {
+      entry.roots.push_back(root);
+    }
+  }
+
+  Usage usage = entry.usage;
+  evict();
+  if (usage.cells > limit_cells) {
+    return td::Status::Error("too many cells");
+  }
+  if (usage.bits > limit_bits) {
+    return td::Status::Error("too many bits");
+  }
+  return usage;
+}
+
+td::optional<StorageStatCache::Usage> StorageStatCache::compute_extra(const td::Bits256& account,
+                                                                     const Ref<Cell>& cell) {
+  auto it = entries_.find(account);
+  if (it == entries_.end()) {
+    return {};
+  }
+  const auto& cells = it->second.cells;
+  it->second.last_used = ++time_;
+  Usage usage;
+  td::HashSet<CellHash> visited;
+  std::vector<Ref<Cell>> stack;
+  auto add_ref = [&](const Ref<Cell>& ref) {
+    if (cells.count(ref->get_hash()) == 0 && visited.insert(ref->get_hash()).second) {
+      stack.push_back(ref);
+    }
+  };
+  add_ref(cell);
+  while (!stack.empty()) {
+    CellSlice cs{NoVm(), std::move(stack.back())};
+    stack.pop_back();
+    stats_.visited_cells++;
+    usage.cells++;
+    usage.bits += cs.size();
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      add_ref(cs.prefetch_ref(i));
+    }
+  }
+  return usage;
+}
+
+td::Result<bool> StorageStatCache::add_refs(Entry& entry, td::Span<Ref<Cell>> roots, td::uint64 limit_cells,
+                                            td::uint64 limit_bits) {
+  // every added cell belongs to the new state, so the limits may be checked before the old cells are released
+  td::uint64 added_cells = 0;
+  td::uint64 added_bits = 0;
+  std::vector<Ref<Cell>> stack;
+  auto add_ref = [&](const Ref<Cell>& cell) {
+    auto& node = entry.cells[cell->get_hash()];
+    if (node.refcnt++ == 0) {
+      node.cell = cell;
+      total_cells_++;
+      stack.push_back(cell);
+    }
+  };
+  for (const auto& root : roots) {
+    if (root.not_null()) {
+      add_ref(root);
+    }
+  }
+  while (!stack.empty()) {
+    CellSlice cs{NoVm(), std::move(stack.back())};
+    stack.pop_back();
+    stats_.visited_cells++;
+    if (cs.special_type() == CellTraits::SpecialType::MerkleProof ||
+        cs.special_type() == CellTraits::SpecialType::MerkleUpdate) {
+      return false;
+    }
+    if (++added_cells > limit_cells) {
+      return td::Status::Error("too many cells");
+    }
+    added_bits += cs.size();
+    if (added_bits > limit_bits) {
+      return td::Status::Error("too many bits");
+    }
+    entry.usage.cells++;
+    entry.usage.bits += cs.size();
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      add_ref(cs.prefetch_ref(i));
+    }
+  }
+  return true;
+}
+
+void StorageStatCache::remove_refs(Entry& entry, td::Span<Ref<Cell>> roots) {
+  std::vector<Ref<Cell>> stack;
+  auto remove_ref = [&](const Ref<Cell>& cell) {
+    auto it = entry.cells.find(cell->get_hash());
+    CHECK(it != entry.cells.end() && it->second.refcnt > 0);
+    if (--it->second.refcnt == 0) {
+      stack.push_back(std::move(it->second.cell));
+      entry.cells.erase(it);
+      total_cells_--;
+    }
+  };
+  for (const auto& root : roots) {
+    remove_ref(root);
+  }
+  while (!stack.empty()) {
+    CellSlice cs{NoVm(), std::move(stack.back())};
+    stack.pop_back();
+    stats_.visited_cells++;
+    entry.usage.cells--;
+    entry.usage.bits -= cs.size();
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      remove_ref(cs.prefetch_ref(i));
+    }
+  }
+}
+
+void StorageStatCache::erase(std::map<td::Bits256, Entry>::iterator it) {
+  total_cells_ -= it->second.cells.size();
+  entries_.erase(it);
+}
+
+void StorageStatCache::evict() {
+  while (total_cells_ > max_cells_) {
+    auto victim = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.last_used < victim->second.last_used) {
+        victim = it;
+      }
+    }
+    erase(victim);
+    stats_.evictions++;
+  }
+}
+
+}  // namespace vm
@@ -0,0 +1,100 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "vm/cells.h"
+
+#include "td/utils/HashMap.h"
+#include "td/utils/HashSet.h"
+#include "td/utils/optional.h"
+#include "td/utils/Span.h"
+#include "td/utils/Status.h"
+
+#include <map>
+#include <vector>
+
+namespace vm {
+
+/*
+ * Storage stat of account states (unique cells and bits reachable from code, data and library), the same numbers
+ * that CellStorageStat::add_used_storage gives, kept between the transactions of one block.
+ * For every account the cache holds the cells of its last computed state with the number of references to each
+ * of them, so a new state is accounted by visiting only the cells that appear in it or disappear from it.
+ * The total number of cells is bounded by max_cells, least recently used accounts are dropped.
+ * Not thread-safe: one cache per collated or validated block.
+ */
+class StorageStatCache {
+ public:
+  static constexpr td::uint64 default_max_cells = 1 << 20;
+
+  explicit StorageStatCache(td::uint64 max_cells = default_max_cells) : max_cells_(max_cells) {
+  }
+
+  struct Usage {
+    td::uint64 cells = 0;
+    td::uint64 bits = 0;
+  };
+  struct Stats {
+    td::uint64 hits = 0;
+    td::uint64 misses = 0;
+    td::uint64 fallbacks = 0;
+    td::uint64 visited_cells = 0;
+    td::uint64 evictions = 0;
+  };
+
+  // Usage of the state of account with the given roots (null roots are skipped).
+  // Fails with the same outcome as CellStorageStat with limit_cells and limit_bits.
+  // Returns an empty optional if the state has Merkle proofs or updates: their depth check in
+  // Transaction::check_state_limits depends on the traversal order, so the caller uses CellStorageStat.
+  td::Result<td::optional<Usage>> compute(const td::Bits256& account, td::Span<Ref<Cell>> roots,
+                                          td::uint64 limit_cells, td::uint64 limit_bits);
+  // Usage of the cells reachable from cell that are not in the last state computed for account, i.e. what the
+  // AccountStorage cell adds on top of its code, data and library. Empty if the account is no longer cached.
+  td::optional<Usage> compute_extra(const td::Bits256& account, const Ref<Cell>& cell);
+
+  td::uint64 size() const {
+    return total_cells_;
+  }
+  const Stats& get_stats() const {
+    return stats_;
+  }
+
+ private:
+  struct Node {
+    Ref<Cell> cell;
+    td::uint32 refcnt = 0;
+  };
+  struct Entry {
+    std::vector<Ref<Cell>> roots;
+    td::HashMap<CellHash, Node> cells;
+    Usage usage;
+    td::uint64 last_used = 0;
+  };
+
+  td::uint64 max_cells_;
+  td::uint64 total_cells_ = 0;
+  td::uint64 time_ = 0;
+  std::map<td::Bits256, Entry> entries_;
+  Stats stats_;
+
+  // false if a Merkle proof or update was met, the entry is left inconsistent then
+  td::Result<bool> add_refs(Entry& entry, td::Span<Ref<Cell>> roots, td::uint64 limit_cells, td::uint64 limit_bits);
+  void remove_refs(Entry& entry, td::Span<Ref<Cell>> roots);
+  void erase(std::map<td::Bits256, Entry>::iterator it);
+  void evict();
+};
+
+}  // namespace vm
@@ -722,7 +722,8 @@ void DhtServer::started_adnl() {
 
 void DhtServer::start_dht() {
   for (auto &dht : config_.dht_ids) {
-    auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{dht}, db_root_, dht_config_, keyring_.get(), adnl_.get());
+    auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{dht}, db_root_, dht_config_, keyring_.get(), adnl_.get(),
+                                   dht_lookup_cache_size_);
     D.ensure();
 
     dht_nodes_[dht] = D.move_as_ok();
@@ -830,8 +831,8 @@ void DhtServer::add_dht_node(ton::PublicKeyHash key_hash, td::Promise<td::Unit>
   }
 
   if (dht_nodes_.size() > 0) {
-    auto D =
-        ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{key_hash}, db_root_, dht_config_, keyring_.get(), adnl_.get());
+    auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{key_hash}, db_root_, dht_config_, keyring_.get(),
+                                   adnl_.get(), dht_lookup_cache_size_);
     D.ensure();
 
     dht_nodes_[key_hash] = D.move_as_ok();
@@ -1229,6 +1230,16 @@ int main(int argc, char *argv[]) {
     logger_ = td::TsFileLog::create(fname.str()).move_as_ok();
     td::log_interface = logger_.get();
   });
+  p.add_checked_option('L', "lookup-cache-size",
+                       PSTRING() << "number of DHT values found by lookups to cache (default="
+                                 << ton::dht::Dht::default_lookup_cache_size() << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint32>(arg));
+                         acts.push_back([&x, v]() {
+                           td::actor::send_closure(x, &DhtServer::set_dht_lookup_cache_size, v);
+                         });
+                         return td::Status::OK();
+                       });
   td::uint32 threads = 7;
   p.add_checked_option(
       't', "threads", PSTRING() << "number of threads (default=" << threads << ")", [&](td::Slice arg) {
@@ -114,6 +114,7 @@ class DhtServer : public td::actor::Actor {
   }
 
   std::string db_root_ = "/var/ton-work/db/";
+  td::uint32 dht_lookup_cache_size_ = ton::dht::Dht::default_lookup_cache_size();
 
   std::vector<td::IPAddress> addrs_;
   std::vector<td::IPAddress> proxy_addrs_;
@@ -148,6 +149,9 @@ class DhtServer : public td::actor::Actor {
   void set_local_config(std::string str);
   void set_global_config(std::string str);
   void set_db_root(std::string db_root);
+  void set_dht_lookup_cache_size(td::uint32 size) {
+    dht_lookup_cache_size_ = size;
+  }
   void add_ip(td::IPAddress addr) {
     addrs_.push_back(addr);
   }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "dht.hpp"
+#include "dht-value-store.hpp"
 #include "td/db/KeyValueAsync.h"
 
 #include <map>
@@ -32,15 +33,6 @@ class DhtBucket;
 
 class DhtMemberImpl : public DhtMember {
  private:
-  class DhtKeyValueLru : public td::ListNode {
-   public:
-    DhtKeyValueLru(DhtValue value) : kv_(std::move(value)) {
-    }
-    DhtValue kv_;
-    static inline DhtKeyValueLru *from_list_node(ListNode *node) {
-      return static_cast<DhtKeyValueLru *>(node);
-    }
-  };
   //std::unique_ptr<adnl::AdnlDecryptor> decryptor_;
   adnl::AdnlNodeIdShort id_;
   DhtKeyId key_;
@@ -48,7 +40,6 @@ class DhtMemberImpl : public DhtMember {
   td::uint32 a_;
   td::int32 network_id_{-1};
   td::uint32 max_cache_time_ = 60;
-  td::uint32 max_cache_size_ = 100;
 
   std::vector<DhtBucket> buckets_;
 
@@ -57,16 +48,14 @@ class DhtMemberImpl : public DhtMember {
   // to be republished once in a while
   std::map<DhtKeyId, DhtValue> our_values_;
 
-  std::map<DhtKeyId, DhtKeyValueLru> cached_values_;
-  td::ListNode cached_values_lru_;
+  DhtLookupCache cached_values_;
 
-  std::map<DhtKeyId, DhtValue> values_;
+  DhtValueStore values_;
 
   td::Timestamp fill_att_ = td::Timestamp::in(0);
   td::Timestamp republish_att_ = td::Timestamp::in(0);
 
   DhtKeyId last_republish_key_ = DhtKeyId::zero();
-  DhtKeyId last_check_key_ = DhtKeyId::zero();
   adnl::AdnlNodeIdShort last_check_reverse_conn_ = adnl::AdnlNodeIdShort::zero();
 
   struct ReverseConnection {
@@ -111,12 +100,20 @@ class DhtMemberImpl : public DhtMember {
   td::uint64 find_value_queries_{0};
   td::uint64 store_queries_{0};
   td::uint64 get_addr_list_queries_{0};
+  td::uint64 find_value_found_{0};
+
+  td::uint64 lookup_cache_hits_{0};
+  td::uint64 lookups_{0};
+  td::uint64 lookups_failed_{0};
+  double lookups_time_{0.0};
+  double lookups_max_time_{0.0};
 
   using DbType = td::KeyValueAsync<td::Bits256, td::BufferSlice>;
   DbType db_;
   td::Timestamp next_save_to_db_at_ = td::Timestamp::in(10.0);
 
   void save_to_db();
+  void load_values_from_db(td::KeyValue &kv);
 
   DhtNodesList get_nearest_nodes(DhtKeyId id, td::uint32 k);
   void check();
@@ -140,13 +137,14 @@ class DhtMemberImpl : public DhtMember {
  public:
   DhtMemberImpl(adnl::AdnlNodeIdShort id, std::string db_root, td::actor::ActorId<keyring::Keyring> keyring,
                 td::actor::ActorId<adnl::Adnl> adnl, td::int32 network_id, td::uint32 k, td::uint32 a = 3,
-                bool client_only = false)
+                bool client_only = false, td::uint32 lookup_cache_size = DhtMember::default_lookup_cache_size())
       : id_(id)
       , key_{id_}
       , k_(k)
       , a_(a)
       , network_id_(network_id)
       , db_root_(db_root)
+      , cached_values_(lookup_cache_size, max_cache_time_)
       , keyring_(keyring)
       , adnl_(adnl)
       , client_only_(client_only) {
@@ -176,6 +174,7 @@ class DhtMemberImpl : public DhtMember {
   void send_store(DhtValue value, td::Promise<td::Unit> promise);
 
   void get_value_in(DhtKeyId key, td::Promise<DhtValue> result) override;
+  void got_value(DhtKeyId key, double elapsed, td::Result<DhtValue> R, td::Promise<DhtValue> promise);
   void get_value(DhtKey key, td::Promise<DhtValue> result) override {
     get_value_in(key.compute_key_id(), std::move(result));
   }
@@ -188,6 +187,7 @@ class DhtMemberImpl : public DhtMember {
   void start_up() override;
   void tear_down() override;
   void dump(td::StringBuilder &sb) const override;
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
   PrintId print_id() const override {
     return PrintId{id_};
   }
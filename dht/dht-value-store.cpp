@@ -0,0 +1,139 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dht-value-store.hpp"
+
+namespace ton {
+
+namespace dht {
+
+const DhtValue *DhtValueStore::get(const DhtKeyId &key_id) {
+  auto it = values_.find(key_id);
+  if (it == values_.end()) {
+    return nullptr;
+  }
+  if (it->second->value.expired()) {
+    erase(it);
+    return nullptr;
+  }
+  return &it->second->value;
+}
+
+td::Status DhtValueStore::store(DhtValue value) {
+  auto key_id = value.key_id();
+  auto it = values_.find(key_id);
+  if (it == values_.end()) {
+    insert(key_id, std::move(value));
+  } else {
+    auto &entry = *it->second;
+    TRY_STATUS(entry.value.update(std::move(value)));
+    expire_heap_.fix(entry.value.ttl(), &entry);
+  }
+  changed_.insert(key_id);
+  return td::Status::OK();
+}
+
+void DhtValueStore::load(DhtValue value) {
+  auto key_id = value.key_id();
+  auto it = values_.find(key_id);
+  if (it == values_.end()) {
+    insert(key_id, std::move(value));
+  }
+}
+
+void DhtValueStore::insert(DhtKeyId key_id, DhtValue value) {
+  auto entry = std::make_unique<Entry>(key_id, std::move(value));
+  expire_heap_.insert(entry->value.ttl(), entry.get());
+  check_list_.put(entry.get());
+  values_.emplace(key_id, std::move(entry));
+}
+
+void DhtValueStore::erase(const DhtKeyId &key_id) {
+  auto it = values_.find(key_id);
+  if (it != values_.end()) {
+    erase(it);
+  }
+}
+
+void DhtValueStore::erase(std::unordered_map<DhtKeyId, std::unique_ptr<Entry>, DhtKeyIdHash>::iterator it) {
+  expire_heap_.erase(it->second.get());
+  changed_.insert(it->first);
+  values_.erase(it);
+}
+
+size_t DhtValueStore::erase_expired(td::uint32 now) {
+  size_t cnt = 0;
+  while (!expire_heap_.empty() && expire_heap_.top_key() < now) {
+    auto entry = static_cast<Entry *>(expire_heap_.top());
+    erase(entry->key_id);
+    ++cnt;
+  }
+  return cnt;
+}
+
+const DhtValue *DhtValueStore::next_to_check(DhtKeyId &key_id) {
+  auto node = check_list_.get();
+  if (node == nullptr) {
+    return nullptr;
+  }
+  check_list_.put(node);
+  auto entry = static_cast<Entry *>(node);
+  key_id = entry->key_id;
+  return &entry->value;
+}
+
+td::optional<DhtValue> DhtLookupCache::get(const DhtKeyId &key_id) {
+  auto it = values_.find(key_id);
+  if (it == values_.end()) {
+    return {};
+  }
+  auto &entry = *it->second;
+  if (entry.expire_at.is_in_past() || entry.value.expired()) {
+    values_.erase(it);
+    return {};
+  }
+  entry.remove();
+  lru_.put(&entry);
+  return entry.value.clone();
+}
+
+void DhtLookupCache::put(DhtKeyId key_id, const DhtValue &value) {
+  if (max_size_ == 0) {
+    return;
+  }
+  auto expire_at = td::Timestamp::in(std::min(max_cache_time_, value.ttl() - td::Clocks::system()));
+  auto it = values_.find(key_id);
+  if (it != values_.end()) {
+    auto &entry = *it->second;
+    entry.value = value.clone();
+    entry.expire_at = expire_at;
+    entry.remove();
+    lru_.put(&entry);
+    return;
+  }
+  while (values_.size() >= max_size_) {
+    auto entry = static_cast<Entry *>(lru_.get());
+    CHECK(entry);
+    values_.erase(entry->key_id);
+  }
+  auto entry = std::make_unique<Entry>(key_id, value.clone(), expire_at);
+  lru_.put(entry.get());
+  values_.emplace(key_id, std::move(entry));
+}
+
+}  // namespace dht
+
+}  // namespace ton
@@ -0,0 +1,131 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "dht-types.h"
+#include "td/utils/Heap.h"
+#include "td/utils/List.h"
+#include "td/utils/optional.h"
+#include "td/utils/Time.h"
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ton {
+
+namespace dht {
+
+struct DhtKeyIdHash {
+  std::size_t operator()(const DhtKeyId &key) const {
+    // key ids are sha256 hashes, so any of their bytes are uniformly distributed
+    std::size_t res;
+    auto bits = key.tl();
+    std::memcpy(&res, bits.data(), sizeof(res));
+    return res;
+  }
+};
+
+/*
+ * Values stored by this node on behalf of the network.
+ * Values are indexed by key id; expiration times are kept in a min-heap, so that expired values are dropped
+ * without scanning the whole store. Changed keys are tracked to write them to the database incrementally.
+ */
+class DhtValueStore {
+ public:
+  const DhtValue *get(const DhtKeyId &key_id);
+  td::Status store(DhtValue value);
+  // adds a value loaded from the database, does not mark it as changed
+  void load(DhtValue value);
+  void erase(const DhtKeyId &key_id);
+  size_t erase_expired(td::uint32 now);
+
+  // returns stored values one by one in a round-robin manner
+  const DhtValue *next_to_check(DhtKeyId &key_id);
+
+  // calls f(key_id, value) for every key changed since the last call, value is nullptr if the key was removed
+  template <class F>
+  void flush_changes(F &&f) {
+    for (auto &key_id : changed_) {
+      auto it = values_.find(key_id);
+      f(key_id, it == values_.end() ? nullptr : &it->second->value);
+    }
+    changed_.clear();
+  }
+  void drop_changes() {
+    changed_.clear();
+  }
+
+  size_t size() const {
+    return values_.size();
+  }
+  bool empty() const {
+    return values_.empty();
+  }
+  size_t changed_count() const {
+    return changed_.size();
+  }
+
+ private:
+  struct Entry : public td::HeapNode, public td::ListNode {
+    Entry(DhtKeyId key_id, DhtValue value) : key_id(key_id), value(std::move(value)) {
+    }
+    DhtKeyId key_id;
+    DhtValue value;
+  };
+  std::unordered_map<DhtKeyId, std::unique_ptr<Entry>, DhtKeyIdHash> values_;
+  std::unordered_set<DhtKeyId, DhtKeyIdHash> changed_;
+  td::KHeap<td::uint32> expire_heap_;
+  td::ListNode check_list_;
+
+  void insert(DhtKeyId key_id, DhtValue value);
+  void erase(std::unordered_map<DhtKeyId, std::unique_ptr<Entry>, DhtKeyIdHash>::iterator it);
+};
+
+/*
+ * LRU cache of values found by get_value() lookups.
+ */
+class DhtLookupCache {
+ public:
+  DhtLookupCache(size_t max_size, double max_cache_time) : max_size_(max_size), max_cache_time_(max_cache_time) {
+  }
+  td::optional<DhtValue> get(const DhtKeyId &key_id);
+  void put(DhtKeyId key_id, const DhtValue &value);
+
+  size_t size() const {
+    return values_.size();
+  }
+
+ private:
+  struct Entry : public td::ListNode {
+    Entry(DhtKeyId key_id, DhtValue value, td::Timestamp expire_at)
+        : key_id(key_id), value(std::move(value)), expire_at(expire_at) {
+    }
+    DhtKeyId key_id;
+    DhtValue value;
+    td::Timestamp expire_at;
+  };
+  size_t max_size_;
+  double max_cache_time_;
+  std::unordered_map<DhtKeyId, std::unique_ptr<Entry>, DhtKeyIdHash> values_;
+  td::ListNode lru_;
+};
+
+}  // namespace dht
+
+}  // namespace ton
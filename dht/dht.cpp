@@ -41,18 +41,21 @@ namespace dht {
 td::actor::ActorOwn<DhtMember> DhtMember::create(adnl::AdnlNodeIdShort id, std::string db_root,
                                                  td::actor::ActorId<keyring::Keyring> keyring,
                                                  td::actor::ActorId<adnl::Adnl> adnl, td::int32 network_id,
-                                                 td::uint32 k, td::uint32 a, bool client_only) {
-  return td::actor::create_actor<DhtMemberImpl>("dht", id, db_root, keyring, adnl, network_id, k, a, client_only);
+                                                 td::uint32 k, td::uint32 a, bool client_only,
+                                                 td::uint32 lookup_cache_size) {
+  return td::actor::create_actor<DhtMemberImpl>("dht", id, db_root, keyring, adnl, network_id, k, a, client_only,
+                                                lookup_cache_size);
 }
 
 td::Result<td::actor::ActorOwn<Dht>> Dht::create(adnl::AdnlNodeIdShort id, std::string db_root,
                                                  std::shared_ptr<DhtGlobalConfig> conf,
                                                  td::actor::ActorId<keyring::Keyring> keyring,
-                                                 td::actor::ActorId<adnl::Adnl> adnl) {
+                                                 td::actor::ActorId<adnl::Adnl> adnl, td::uint32 lookup_cache_size) {
   CHECK(conf->get_k() > 0);
   CHECK(conf->get_a() > 0);
 
-  auto D = DhtMember::create(id, db_root, keyring, adnl, conf->get_network_id(), conf->get_k(), conf->get_a());
+  auto D = DhtMember::create(id, db_root, keyring, adnl, conf->get_network_id(), conf->get_k(), conf->get_a(), false,
+                             lookup_cache_size);
   auto &nodes = conf->nodes();
 
   for (auto &node : nodes.list()) {
@@ -119,10 +122,46 @@ void DhtMemberImpl::start_up() {
         }
       }
     }
+    load_values_from_db(*kv);
     db_ = DbType{std::move(kv)};
   }
 }
 
+void DhtMemberImpl::load_values_from_db(td::KeyValue &kv) {
+  // stored values are kept under their key ids, other records (buckets) do not parse as dht.value
+  std::vector<td::Bits256> to_erase;
+  auto S = kv.for_each([&](td::Slice key, td::Slice value) {
+    if (key.size() != 32) {
+      return td::Status::OK();
+    }
+    auto F = fetch_tl_object<ton_api::dht_value>(value, true);
+    if (F.is_error()) {
+      return td::Status::OK();
+    }
+    // values were checked before they were stored
+    auto V = DhtValue::create(F.move_as_ok(), false);
+    if (V.is_error() || V.ok().expired() || V.ok().key_id().tl().as_slice() != key) {
+      td::Bits256 key_id;
+      key_id.as_slice().copy_from(key);
+      to_erase.push_back(key_id);
+      return td::Status::OK();
+    }
+    values_.load(V.move_as_ok());
+    return td::Status::OK();
+  });
+  if (S.is_error()) {
+    VLOG(DHT_WARNING) << this << ": failed to load stored values from db: " << S;
+  }
+  if (!to_erase.empty()) {
+    kv.begin_transaction().ensure();
+    for (auto &key : to_erase) {
+      kv.erase(key.as_slice());
+    }
+    kv.commit_transaction().ensure();
+  }
+  VLOG(DHT_INFO) << this << ": loaded " << values_.size() << " stored values from db, dropped " << to_erase.size();
+}
+
 void DhtMemberImpl::tear_down() {
   std::vector<td::int32> methods = {ton_api::dht_getSignedAddressList::ID,
                                     ton_api::dht_findNode::ID,
@@ -142,6 +181,7 @@ void DhtMemberImpl::tear_down() {
 
 void DhtMemberImpl::save_to_db() {
   if (db_root_.empty()) {
+    values_.drop_changes();
     return;
   }
   next_save_to_db_at_ = td::Timestamp::in(10.0);
@@ -156,6 +196,15 @@ void DhtMemberImpl::save_to_db() {
 
     db_.set(key, std::move(value));
   }
+
+  // only values changed since the last save are written
+  values_.flush_changes([&](const DhtKeyId &key_id, const DhtValue *value) {
+    if (value) {
+      db_.set(key_id.tl(), serialize_tl_object(value->tl(), true));
+    } else {
+      db_.erase(key_id.tl());
+    }
+  });
 }
 
 DhtNodesList DhtMemberImpl::get_nearest_nodes(DhtKeyId id, td::uint32 k) {
@@ -227,13 +276,10 @@ void DhtMemberImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::dht_findNo
 void DhtMemberImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::dht_findValue &query,
                                   td::Promise<td::BufferSlice> promise) {
   find_value_queries_++;
-  auto it = values_.find(DhtKeyId{query.key_});
-  if (it != values_.end() && it->second.expired()) {
-    values_.erase(it);
-    it = values_.end();
-  }
-  if (it != values_.end()) {
-    promise.set_value(create_serialize_tl_object<ton_api::dht_valueFound>(it->second.tl()));
+  auto value = values_.get(DhtKeyId{query.key_});
+  if (value) {
+    find_value_found_++;
+    promise.set_value(create_serialize_tl_object<ton_api::dht_valueFound>(value->tl()));
     return;
   }
 
@@ -257,12 +303,7 @@ td::Status DhtMemberImpl::store_in(DhtValue value) {
 
   auto dist = distance(key_id, k_ + 10);
   if (dist < k_ + 10) {
-    auto it = values_.find(key_id);
-    if (it != values_.end()) {
-      it->second.update(std::move(value));
-    } else {
-      values_.emplace(key_id, std::move(value));
-    }
+    values_.store(std::move(value)).ignore();
   } else {
     VLOG(DHT_INFO) << this << ": dropping too remote value: " << value.key_id() << " distance = " << dist;
   }
@@ -465,6 +506,17 @@ void DhtMemberImpl::set_value(DhtValue value, td::Promise<td::Unit> promise) {
 }
 
 void DhtMemberImpl::get_value_in(DhtKeyId key, td::Promise<DhtValue> result) {
+  auto cached = cached_values_.get(key);
+  if (cached) {
+    lookup_cache_hits_++;
+    result.set_value(cached.unwrap());
+    return;
+  }
+  auto start = td::Time::now();
+  result = [SelfId = actor_id(this), key, start, promise = std::move(result)](td::Result<DhtValue> R) mutable {
+    td::actor::send_closure(SelfId, &DhtMemberImpl::got_value, key, td::Time::now() - start, std::move(R),
+                            std::move(promise));
+  };
   auto P = td::PromiseCreator::lambda([key, promise = std::move(result), SelfId = actor_id(this), print_id = print_id(),
                                        adnl = adnl_, list = get_nearest_nodes(key, k_ * 2), k = k_, a = a_,
                                        network_id = network_id_, id = id_,
@@ -478,6 +530,18 @@ void DhtMemberImpl::get_value_in(DhtKeyId key, td::Promise<DhtValue> result) {
   get_self_node(std::move(P));
 }
 
+void DhtMemberImpl::got_value(DhtKeyId key, double elapsed, td::Result<DhtValue> R, td::Promise<DhtValue> promise) {
+  lookups_++;
+  lookups_time_ += elapsed;
+  lookups_max_time_ = std::max(lookups_max_time_, elapsed);
+  if (R.is_error()) {
+    lookups_failed_++;
+  } else {
+    cached_values_.put(key, R.ok());
+  }
+  promise.set_result(std::move(R));
+}
+
 void DhtMemberImpl::get_value_many(DhtKey key, std::function<void(DhtValue)> callback, td::Promise<td::Unit> promise) {
   DhtKeyId key_id = key.compute_key_id();
   auto P = td::PromiseCreator::lambda(
@@ -559,8 +623,10 @@ void DhtMemberImpl::request_reverse_ping_cont(adnl::AdnlNode target, td::BufferS
 
 void DhtMemberImpl::check() {
   VLOG(DHT_INFO) << this << ": ping=" << ping_queries_ << " fnode=" << find_node_queries_
-                 << " fvalue=" << find_value_queries_ << " store=" << store_queries_
-                 << " addrlist=" << get_addr_list_queries_;
+                 << " fvalue=" << find_value_queries_ << " (found " << find_value_found_ << ") store=" << store_queries_
+                 << " addrlist=" << get_addr_list_queries_ << " values=" << values_.size()
+                 << " lookups=" << lookups_ << " (failed " << lookups_failed_ << ", cached " << lookup_cache_hits_
+                 << ")";
   for (auto &bucket : buckets_) {
     bucket.check(client_only_, adnl_, actor_id(this), id_);
   }
@@ -568,50 +634,25 @@ void DhtMemberImpl::check() {
     save_to_db();
   }
 
-  if (values_.size() > 0) {
-    auto it = values_.lower_bound(last_check_key_);
-    if (it != values_.end() && it->first == last_check_key_) {
-      it++;
-    }
-    if (it == values_.end()) {
-      it = values_.begin();
-    }
-
-    td::uint32 cnt = 0;
-    auto s = last_check_key_;
-    while (values_.size() > 0 && cnt < 1 && it->first != s) {
-      last_check_key_ = it->first;
-      cnt++;
-      if (it->second.expired()) {
-        it = values_.erase(it);
-
-        // do not republish soon-to-be-expired values
-      } else if (it->second.ttl() > td::Clocks::system() + 60) {
-        auto dist = distance(it->first, k_ + 10);
-
-        if (dist == 0) {
-          if (it->second.key().update_rule()->need_republish()) {
-            auto P = td::PromiseCreator::lambda([print_id = print_id()](td::Result<td::Unit> R) {
-              if (R.is_error()) {
-                VLOG(DHT_INFO) << print_id << ": failed to store: " << R.move_as_error();
-              }
-            });
-            send_store(it->second.clone(), std::move(P));
-          }
-          it++;
-        } else if (dist >= k_ + 10) {
-          it = values_.erase(it);
-        } else {
-          it++;
+  values_.erase_expired(static_cast<td::uint32>(td::Clocks::system()));
+  if (!values_.empty()) {
+    DhtKeyId key_id;
+    auto value = values_.next_to_check(key_id);
+    // do not republish soon-to-be-expired values
+    if (value->ttl() > td::Clocks::system() + 60) {
+      auto dist = distance(key_id, k_ + 10);
+
+      if (dist == 0) {
+        if (value->key().update_rule()->need_republish()) {
+          auto P = td::PromiseCreator::lambda([print_id = print_id()](td::Result<td::Unit> R) {
+            if (R.is_error()) {
+              VLOG(DHT_INFO) << print_id << ": failed to store: " << R.move_as_error();
+            }
+          });
+          send_store(value->clone(), std::move(P));
         }
-      } else {
-        it++;
-      }
-      if (values_.size() == 0) {
-        break;
-      }
-      if (it == values_.end()) {
-        it = values_.begin();
+      } else if (dist >= k_ + 10) {
+        values_.erase(key_id);
       }
     }
   }
@@ -685,6 +726,24 @@ void DhtMemberImpl::dump(td::StringBuilder &sb) const {
   for (auto &B : buckets_) {
     B.dump(sb);
   }
+  sb << "stored values: " << values_.size() << ", found " << find_value_found_ << " of " << find_value_queries_
+     << " queries\n";
+  sb << "lookups: " << lookups_ << ", failed " << lookups_failed_ << ", avg time "
+     << (lookups_ ? lookups_time_ / (double)lookups_ : 0.0) << "s, max time " << lookups_max_time_ << "s; cache: "
+     << cached_values_.size() << " values, " << lookup_cache_hits_ << " hits\n";
+}
+
+void DhtMemberImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("queries", PSTRING() << "ping=" << ping_queries_ << " findnode=" << find_node_queries_
+                                        << " findvalue=" << find_value_queries_ << " (found " << find_value_found_
+                                        << ") store=" << store_queries_ << " addrlist=" << get_addr_list_queries_);
+  vec.emplace_back("storedvalues", td::to_string(values_.size()));
+  vec.emplace_back("lookups", PSTRING() << lookups_ << " (failed " << lookups_failed_ << ", avg time "
+                                        << (lookups_ ? lookups_time_ / (double)lookups_ : 0.0) << "s, max time "
+                                        << lookups_max_time_ << "s)");
+  vec.emplace_back("lookupcache", PSTRING() << cached_values_.size() << " values, " << lookup_cache_hits_ << " hits");
+  promise.set_value(std::move(vec));
 }
 
 void DhtMemberImpl::send_store(DhtValue value, td::Promise<td::Unit> promise) {
@@ -38,10 +38,15 @@ class DhtGlobalConfig;
 
 class Dht : public td::actor::Actor {
  public:
+  // values are at most a few KB each, so the default cache takes at most some tens of MB
+  static constexpr td::uint32 default_lookup_cache_size() {
+    return 10000;
+  }
   static td::Result<td::actor::ActorOwn<Dht>> create(adnl::AdnlNodeIdShort id, std::string db_root,
                                                      std::shared_ptr<DhtGlobalConfig> conf,
                                                      td::actor::ActorId<keyring::Keyring> keyring,
-                                                     td::actor::ActorId<adnl::Adnl> adnl);
+                                                     td::actor::ActorId<adnl::Adnl> adnl,
+                                                     td::uint32 lookup_cache_size = default_lookup_cache_size());
   static td::Result<td::actor::ActorOwn<Dht>> create_client(adnl::AdnlNodeIdShort id, std::string db_root,
                                                             std::shared_ptr<DhtGlobalConfig> conf,
                                                             td::actor::ActorId<keyring::Keyring> keyring,
@@ -60,6 +65,7 @@ class Dht : public td::actor::Actor {
                                     td::Promise<td::Unit> promise) = 0;
 
   virtual void dump(td::StringBuilder &sb) const = 0;
+  virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
 
   virtual ~Dht() = default;
 };
@@ -91,7 +91,8 @@ class DhtMember : public Dht {
   static td::actor::ActorOwn<DhtMember> create(adnl::AdnlNodeIdShort id, std::string db_root,
                                                td::actor::ActorId<keyring::Keyring> keyring,
                                                td::actor::ActorId<adnl::Adnl> adnl, td::int32 network_id,
-                                               td::uint32 k = 10, td::uint32 a = 3, bool client_only = false);
+                                               td::uint32 k = 10, td::uint32 a = 3, bool client_only = false,
+                                               td::uint32 lookup_cache_size = default_lookup_cache_size());
 
   //virtual void update_addr_list(tl_object_ptr<ton_api::adnl_addressList> addr_list) = 0;
   //virtual void add_node(adnl::AdnlNodeIdShort id) = 0;
@@ -0,0 +1,249 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "dht-value-store.hpp"
+
+#include "keys/encryptor.h"
+#include "td/db/MemoryKeyValue.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+namespace {
+const ton::PrivateKey &test_private_key() {
+  static ton::PrivateKey key{ton::privkeys::Ed25519::random()};
+  return key;
+}
+
+ton::dht::DhtValue make_value(td::uint32 idx, std::string data, td::uint32 ttl) {
+  auto pub = test_private_key().compute_public_key();
+  ton::dht::DhtKey key{pub.compute_short_id(), "test" + td::to_string(idx / 16), idx % 16};
+  ton::dht::DhtKeyDescription desc{std::move(key), pub, ton::dht::DhtUpdateRuleAnybody::create().move_as_ok(),
+                                   td::BufferSlice()};
+  // updates of stored values check the key signature
+  desc.update_signature(test_private_key().create_decryptor().move_as_ok()->sign(desc.to_sign()).move_as_ok());
+  return ton::dht::DhtValue{std::move(desc), td::BufferSlice(data), ttl, td::BufferSlice()};
+}
+
+td::uint32 now() {
+  return static_cast<td::uint32>(td::Clocks::system());
+}
+}  // namespace
+
+TEST(DhtValueStore, StoreGetErase) {
+  ton::dht::DhtValueStore store;
+  std::vector<ton::dht::DhtKeyId> keys;
+  for (td::uint32 i = 0; i < 100; i++) {
+    auto value = make_value(i, "value" + td::to_string(i), now() + 3600);
+    keys.push_back(value.key_id());
+    store.store(std::move(value)).ensure();
+  }
+  ASSERT_EQ(100u, store.size());
+  for (td::uint32 i = 0; i < 100; i++) {
+    auto value = store.get(keys[i]);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ("value" + td::to_string(i), value->value().as_slice().str());
+  }
+  ASSERT_TRUE(store.get(make_value(1000, "", now() + 3600).key_id()) == nullptr);
+
+  // an update replaces the value in place
+  store.store(make_value(5, "updated", now() + 3600)).ensure();
+  ASSERT_EQ(100u, store.size());
+  ASSERT_EQ("updated", store.get(keys[5])->value().as_slice().str());
+
+  store.erase(keys[5]);
+  ASSERT_EQ(99u, store.size());
+  ASSERT_TRUE(store.get(keys[5]) == nullptr);
+  store.erase(keys[5]);
+  ASSERT_EQ(99u, store.size());
+
+  // every value is visited once per round
+  std::set<ton::dht::DhtKeyId> visited;
+  for (td::uint32 i = 0; i < 99; i++) {
+    ton::dht::DhtKeyId key_id;
+    ASSERT_TRUE(store.next_to_check(key_id) != nullptr);
+    visited.insert(key_id);
+  }
+  ASSERT_EQ(99u, visited.size());
+  ASSERT_TRUE(visited.count(keys[5]) == 0);
+}
+
+TEST(DhtValueStore, ExpiryHeap) {
+  ton::dht::DhtValueStore store;
+  auto base = now();
+  std::vector<ton::dht::DhtKeyId> keys;
+  for (td::uint32 i = 0; i < 100; i++) {
+    // ttls are shuffled, so that the insertion order does not match the expiration order
+    auto value = make_value(i, "x", base + 100 + (i * 37) % 100);
+    keys.push_back(value.key_id());
+    store.store(std::move(value)).ensure();
+  }
+  ASSERT_EQ(0u, store.erase_expired(base));
+  ASSERT_EQ(0u, store.erase_expired(base + 100));
+  ASSERT_EQ(50u, store.erase_expired(base + 150));
+  ASSERT_EQ(50u, store.size());
+  for (td::uint32 i = 0; i < 100; i++) {
+    bool alive = (i * 37) % 100 >= 50;
+    ASSERT_EQ(alive, store.get(keys[i]) != nullptr);
+  }
+
+  // a prolonged value moves in the heap
+  td::uint32 first_alive = 0;
+  while ((first_alive * 37) % 100 != 50) {
+    first_alive++;
+  }
+  store.store(make_value(first_alive, "x", base + 1000)).ensure();
+  ASSERT_EQ(49u, store.erase_expired(base + 500));
+  ASSERT_EQ(1u, store.size());
+  ASSERT_TRUE(store.get(keys[first_alive]) != nullptr);
+
+  // erased values are removed from the heap too
+  store.erase(keys[first_alive]);
+  ASSERT_EQ(0u, store.erase_expired(base + 2000));
+  ASSERT_TRUE(store.empty());
+
+  ton::dht::DhtKeyId key_id;
+  ASSERT_TRUE(store.next_to_check(key_id) == nullptr);
+}
+
+TEST(DhtValueStore, IncrementalDbWrites) {
+  td::MemoryKeyValue kv;
+  auto flush = [&](ton::dht::DhtValueStore &store) {
+    size_t cnt = 0;
+    store.flush_changes([&](const ton::dht::DhtKeyId &key_id, const ton::dht::DhtValue *value) {
+      if (value) {
+        kv.set(key_id.tl().as_slice(), ton::serialize_tl_object(value->tl(), true)).ensure();
+      } else {
+        kv.erase(key_id.tl().as_slice()).ensure();
+      }
+      cnt++;
+    });
+    return cnt;
+  };
+  auto read = [&](const ton::dht::DhtKeyId &key_id) -> td::optional<ton::dht::DhtValue> {
+    std::string data;
+    if (kv.get(key_id.tl().as_slice(), data).move_as_ok() != td::KeyValue::GetStatus::Ok) {
+      return {};
+    }
+    auto F = ton::fetch_tl_object<ton::ton_api::dht_value>(td::Slice(data), true);
+    F.ensure();
+    return ton::dht::DhtValue::create(F.move_as_ok(), false).move_as_ok();
+  };
+
+  ton::dht::DhtValueStore store;
+  std::vector<ton::dht::DhtKeyId> keys;
+  for (td::uint32 i = 0; i < 10; i++) {
+    auto value = make_value(i, "v" + td::to_string(i), now() + 3600);
+    keys.push_back(value.key_id());
+    store.store(std::move(value)).ensure();
+  }
+  ASSERT_EQ(10u, store.changed_count());
+  ASSERT_EQ(10u, flush(store));
+  ASSERT_EQ(0u, store.changed_count());
+  ASSERT_EQ(10u, kv.count("").move_as_ok());
+
+  // only the changed keys are written again
+  ASSERT_EQ(0u, flush(store));
+  store.store(make_value(3, "new", now() + 3600)).ensure();
+  store.store(make_value(3, "newer", now() + 3600)).ensure();
+  store.erase(keys[7]);
+  ASSERT_EQ(2u, store.changed_count());
+  ASSERT_EQ(2u, flush(store));
+  ASSERT_EQ(9u, kv.count("").move_as_ok());
+  ASSERT_EQ("newer", read(keys[3]).unwrap().value().as_slice().str());
+  ASSERT_TRUE(!read(keys[7]));
+
+  // expired values are erased from the db on the next flush
+  store.store(make_value(20, "short", now() + 1)).ensure();
+  ASSERT_EQ(1u, flush(store));
+  ASSERT_EQ(1u, store.erase_expired(now() + 2));
+  ASSERT_EQ(1u, flush(store));
+  ASSERT_EQ(9u, kv.count("").move_as_ok());
+
+  // values loaded from the db are not written back
+  ton::dht::DhtValueStore loaded;
+  for (auto &key_id : keys) {
+    auto value = read(key_id);
+    if (value) {
+      loaded.load(value.unwrap());
+    }
+  }
+  ASSERT_EQ(9u, loaded.size());
+  ASSERT_EQ(0u, loaded.changed_count());
+  ASSERT_EQ("newer", loaded.get(keys[3])->value().as_slice().str());
+
+  // without a db changes are dropped
+  store.store(make_value(30, "x", now() + 3600)).ensure();
+  store.drop_changes();
+  ASSERT_EQ(0u, flush(store));
+}
+
+TEST(DhtLookupCache, Lru) {
+  ton::dht::DhtLookupCache cache(10, 3600.0);
+  std::vector<ton::dht::DhtKeyId> keys;
+  for (td::uint32 i = 0; i < 10; i++) {
+    auto value = make_value(i, "v" + td::to_string(i), now() + 3600);
+    keys.push_back(value.key_id());
+    cache.put(value.key_id(), value);
+  }
+  ASSERT_EQ(10u, cache.size());
+  for (td::uint32 i = 0; i < 10; i++) {
+    auto value = cache.get(keys[i]);
+    ASSERT_TRUE(value);
+    ASSERT_EQ("v" + td::to_string(i), value.value().value().as_slice().str());
+  }
+
+  // touch the first value, so that the second one is the least recently used
+  ASSERT_TRUE(cache.get(keys[0]));
+  auto extra = make_value(10, "extra", now() + 3600);
+  cache.put(extra.key_id(), extra);
+  ASSERT_EQ(10u, cache.size());
+  ASSERT_TRUE(!cache.get(keys[1]));
+  ASSERT_TRUE(cache.get(keys[0]));
+  ASSERT_TRUE(cache.get(extra.key_id()));
+
+  // putting an existing key updates it without eviction
+  auto updated = make_value(2, "updated", now() + 3600);
+  cache.put(updated.key_id(), updated);
+  ASSERT_EQ(10u, cache.size());
+  ASSERT_EQ("updated", cache.get(keys[2]).value().value().as_slice().str());
+
+  ton::dht::DhtLookupCache disabled(0, 3600.0);
+  disabled.put(extra.key_id(), extra);
+  ASSERT_EQ(0u, disabled.size());
+  ASSERT_TRUE(!disabled.get(extra.key_id()));
+}
+
+TEST(DhtLookupCache, Expiry) {
+  ton::dht::DhtLookupCache cache(10, 0.05);
+  auto value = make_value(0, "v", now() + 3600);
+  cache.put(value.key_id(), value);
+  ASSERT_TRUE(cache.get(value.key_id()));
+  td::usleep_for(60000);
+  // entries are dropped after the cache time even if the value itself is still valid
+  ASSERT_TRUE(!cache.get(value.key_id()));
+  ASSERT_EQ(0u, cache.size());
+
+  // and values are not served after their ttl
+  ton::dht::DhtLookupCache long_cache(10, 3600.0);
+  auto short_value = make_value(1, "v", now() + 1);
+  long_cache.put(short_value.key_id(), short_value);
+  ASSERT_TRUE(long_cache.get(short_value.key_id()));
+  td::usleep_for(2100000);
+  ASSERT_TRUE(!long_cache.get(short_value.key_id()));
+}
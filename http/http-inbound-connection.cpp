@@ -23,44 +23,35 @@ namespace ton {
 
 namespace http {
 
-void HttpInboundConnection::send_client_error() {
-  static const auto s =
-      "HTTP/1.0 400 Bad Request\r\n"
-      "Connection: Close\r\n"
-      "Content-length: 0\r\n"
-      "\r\n";
-  buffered_fd_.output_buffer().append(td::Slice(s, strlen(s)));
-  close_after_write_ = true;
-  loop();
+namespace {
+
+std::pair<std::unique_ptr<HttpResponse>, std::shared_ptr<HttpPayload>> create_error_answer(HttpStatusCode code,
+                                                                                          std::string reason,
+                                                                                          bool keep_alive) {
+  auto response = HttpResponse::create("HTTP/1.1", code, std::move(reason), false, keep_alive).move_as_ok();
+  response->set_keep_alive(keep_alive);
+  response->add_header(HttpHeader{"Content-Length", "0"});
+  response->complete_parse_header();
+  auto payload = response->create_empty_payload().move_as_ok();
+  return std::make_pair(std::move(response), std::move(payload));
 }
 
-void HttpInboundConnection::send_server_error() {
-  static const auto s =
-      "HTTP/1.1 502 Bad Gateway\r\n"
-      "Connection: keep-alive\r\n"
-      "Content-length: 0\r\n"
-      "\r\n";
-  buffered_fd_.output_buffer().append(td::Slice(s, strlen(s)));
-  loop();
+}  // namespace
+
+void HttpInboundConnection::send_client_error() {
+  // the rest of the input can not be parsed: answer the requests that are already in progress, then close
+  stop_reading_ = true;
+  auto a = create_error_answer(status_bad_request, "Bad Request", false);
+  answers_.emplace_back();
+  auto request_id = answers_.back().request_id = next_request_id_++;
+  answers_.back().close = true;
+  set_answer(request_id, std::move(a.first), std::move(a.second));
 }
 
-void HttpInboundConnection::send_proxy_error(td::Status error) {
-  if (error.code() == ErrorCode::timeout) {
-    static const auto s =
-        "HTTP/1.1 504 Gateway Timeout\r\n"
-        "Connection: keep-alive\r\n"
-        "Content-length: 0\r\n"
-        "\r\n";
-    buffered_fd_.output_buffer().append(td::Slice(s, strlen(s)));
-  } else {
-    static const auto s =
-        "HTTP/1.1 502 Bad Gateway\r\n"
-        "Connection: keep-alive\r\n"
-        "Content-length: 0\r\n"
-        "\r\n";
-    buffered_fd_.output_buffer().append(td::Slice(s, strlen(s)));
-  }
-  loop();
+void HttpInboundConnection::send_proxy_error(td::uint64 request_id, td::Status error) {
+  auto a = error.code() == ErrorCode::timeout ? create_error_answer(status_gateway_timeout, "Gateway Timeout", true)
+                                              : create_error_answer(status_bad_gateway, "Bad Gateway", true);
+  set_answer(request_id, std::move(a.first), std::move(a.second));
 }
 
 td::Status HttpInboundConnection::receive(td::ChainBufferReader &input) {
@@ -68,7 +59,7 @@ td::Status HttpInboundConnection::receive(td::ChainBufferReader &input) {
     return receive_payload(input);
   }
 
-  if (!cur_request_ && !read_next_request_) {
+  if (!cur_request_ && !can_read_next_request()) {
     return td::Status::OK();
   }
 
@@ -85,14 +76,27 @@ td::Status HttpInboundConnection::receive(td::ChainBufferReader &input) {
     }
   }
 
+  answers_.emplace_back();
+  auto request_id = answers_.back().request_id = next_request_id_++;
+  if (!cur_request_->keep_alive()) {
+    answers_.back().close = true;
+    stop_reading_ = true;
+  }
+  if (cur_request_->method() == "CONNECT") {
+    // the rest of the connection is the tunnel
+    stop_reading_ = true;
+  }
+
   auto payload = cur_request_->create_empty_payload().move_as_ok();
   auto P = td::PromiseCreator::lambda(
-      [SelfId = actor_id(this)](td::Result<std::pair<std::unique_ptr<HttpResponse>, std::shared_ptr<HttpPayload>>> R) {
+      [SelfId = actor_id(this),
+       request_id](td::Result<std::pair<std::unique_ptr<HttpResponse>, std::shared_ptr<HttpPayload>>> R) {
         if (R.is_ok()) {
           auto a = R.move_as_ok();
-          td::actor::send_closure(SelfId, &HttpInboundConnection::send_answer, std::move(a.first), std::move(a.second));
+          td::actor::send_closure(SelfId, &HttpInboundConnection::send_answer, request_id, std::move(a.first),
+                                  std::move(a.second));
         } else {
-          td::actor::send_closure(SelfId, &HttpInboundConnection::send_proxy_error, R.move_as_error());
+          td::actor::send_closure(SelfId, &HttpInboundConnection::send_proxy_error, request_id, R.move_as_error());
         }
       });
   http_callback_->receive_request(std::move(cur_request_), payload, std::move(P));
@@ -101,14 +105,56 @@ td::Status HttpInboundConnection::receive(td::ChainBufferReader &input) {
   return td::Status::OK();
 }
 
-void HttpInboundConnection::send_answer(std::unique_ptr<HttpResponse> response, std::shared_ptr<HttpPayload> payload) {
+void HttpInboundConnection::send_answer(td::uint64 request_id, std::unique_ptr<HttpResponse> response,
+                                        std::shared_ptr<HttpPayload> payload) {
   CHECK(payload);
-  response->store_http(buffered_fd_.output_buffer());
+  set_answer(request_id, std::move(response), std::move(payload));
+}
 
-  write_payload(std::move(payload));
+void HttpInboundConnection::set_answer(td::uint64 request_id, std::unique_ptr<HttpResponse> response,
+                                       std::shared_ptr<HttpPayload> payload) {
+  for (auto &a : answers_) {
+    if (a.request_id == request_id) {
+      CHECK(!a.ready);
+      a.ready = true;
+      a.response = std::move(response);
+      a.payload = std::move(payload);
+      break;
+    }
+  }
+  flush_answers();
   loop();
 }
 
+void HttpInboundConnection::flush_answers() {
+  while (!writing_payload_ && !close_after_write_ && !answers_.empty() && answers_.front().ready) {
+    auto a = std::move(answers_.front());
+    answers_.pop_front();
+    if (a.close) {
+      close_after_write_ = true;
+    }
+    a.response->store_http(buffered_fd_.output_buffer());
+    // may call payload_written() right away
+    write_payload(std::move(a.payload));
+  }
+}
+
+void HttpInboundConnection::payload_written() {
+  writing_payload_ = nullptr;
+  if (close_after_write_) {
+    return;
+  }
+  flush_answers();
+  if (found_eof_ && !reading_payload_ && answers_.empty() && !writing_payload_) {
+    stop();
+    return;
+  }
+  if (can_read_next_request() && buffered_fd_.left_unread() > 0) {
+    // pipelined requests may already be in the input buffer
+    notify();
+  }
+}
+
 }  // namespace http
 
 }  // namespace ton
@@ -26,6 +26,10 @@ namespace ton {
 
 namespace http {
 
+/*
+ * Requests may be pipelined: the next request is parsed as soon as the payload of the previous one is read,
+ * without waiting for its answer. Answers are queued and written in the order of requests.
+ */
 class HttpInboundConnection : public HttpConnection {
  public:
   HttpInboundConnection(td::SocketFd fd, std::shared_ptr<HttpServer::Callback> http_callback)
@@ -44,42 +48,48 @@ class HttpInboundConnection : public HttpConnection {
         return td::Status::OK();
       }
     } else {
-      if (read_next_request_) {
+      if (answers_.empty() && !writing_payload_) {
         stop();
-        return td::Status::OK();
       }
       return td::Status::OK();
     }
   }
 
   void send_client_error();
-  void send_server_error();
-  void send_proxy_error(td::Status error);
-
-  void payload_written() override {
-    writing_payload_ = nullptr;
-    if (!close_after_write_) {
-      read_next_request_ = true;
-      if (found_eof_) {
-        stop();
-        return;
-      }
-    }
-  }
+  void send_proxy_error(td::uint64 request_id, td::Status error);
+
+  void payload_written() override;
   void payload_read() override {
     reading_payload_ = nullptr;
-    read_next_request_ = false;
   }
 
   td::Status receive(td::ChainBufferReader &input) override;
-  void send_answer(std::unique_ptr<HttpResponse> response, std::shared_ptr<HttpPayload> payload);
+  void send_answer(td::uint64 request_id, std::unique_ptr<HttpResponse> response, std::shared_ptr<HttpPayload> payload);
 
  private:
   static constexpr size_t chunk_size() {
     return 1 << 14;
   }
+  static constexpr size_t max_pipelined_requests() {
+    return 16;
+  }
 
-  bool read_next_request_ = true;
+  struct Answer {
+    td::uint64 request_id = 0;
+    bool ready = false;
+    bool close = false;
+    std::unique_ptr<HttpResponse> response;
+    std::shared_ptr<HttpPayload> payload;
+  };
+  std::list<Answer> answers_;
+  td::uint64 next_request_id_ = 0;
+  bool stop_reading_ = false;
+
+  bool can_read_next_request() const {
+    return !stop_reading_ && !reading_payload_ && answers_.size() < max_pipelined_requests();
+  }
+  void set_answer(td::uint64 request_id, std::unique_ptr<HttpResponse> response, std::shared_ptr<HttpPayload> payload);
+  void flush_answers();
 
   std::shared_ptr<HttpServer::Callback> http_callback_;
   std::unique_ptr<HttpRequest> cur_request_;
@@ -72,6 +72,48 @@ td::Result<HttpHeader> get_header(std::string line) {
   return HttpHeader{line.substr(0, p), td::trim(line.substr(p + 1))};
 }
 
+td::Result<td::Slice> get_line(td::ChainBufferReader &input, std::string &cur_line, std::string &line_buf, bool &read,
+                               size_t max_line_size) {
+  if (cur_line.empty() && input.size() > 0) {
+    auto S = input.prepare_read();
+    auto f = S.find('\n');
+    if (f != td::Slice::npos) {
+      if (f > max_line_size) {
+        return td::Status::Error("too big http header");
+      }
+      auto line = S.truncate(f > 0 && S[f - 1] == '\r' ? f - 1 : f);
+      // the head of the input is not released until the next prepare_read(), so line stays valid
+      input.confirm_read(f + 1);
+      read = true;
+      return line;
+    }
+  }
+  TRY_RESULT_ASSIGN(line_buf, get_line(input, cur_line, read, max_line_size));
+  return td::Slice(line_buf);
+}
+
+td::Status split_header(td::Slice line, td::Slice &name, td::Slice &value) {
+  auto p = line.find(':');
+  if (p == td::Slice::npos) {
+    return td::Status::Error("failed to parse header");
+  }
+  name = line.substr(0, p);
+  value = td::trim(line.substr(p + 1));
+  return td::Status::OK();
+}
+
+bool equal_lowercase(td::Slice s, td::Slice lc) {
+  if (s.size() != lc.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < s.size(); i++) {
+    if (td::to_lower(s[i]) != lc[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace util
 
 void HttpHeader::store_http(td::ChainBufferWriter &output) {
@@ -89,9 +131,10 @@ td::Result<std::unique_ptr<HttpRequest>> HttpRequest::parse(std::unique_ptr<Http
                                                             bool &exit_loop, td::ChainBufferReader &input) {
   exit_loop = false;
   CHECK(!request || !request->check_parse_header_completed());
+  std::string line_buf;
   while (true) {
     bool read;
-    TRY_RESULT(line, util::get_line(input, cur_line, read, HttpRequest::max_one_header_size()));
+    TRY_RESULT(line, util::get_line(input, cur_line, line_buf, read, HttpRequest::max_one_header_size()));
     if (!read) {
       exit_loop = true;
       break;
@@ -102,14 +145,15 @@ td::Result<std::unique_ptr<HttpRequest>> HttpRequest::parse(std::unique_ptr<Http
       if (v.size() != 3) {
         return td::Status::Error("expected http header in form ");
       }
-      TRY_RESULT_ASSIGN(request, HttpRequest::create(v[0], v[1], v[2]));
+      TRY_RESULT_ASSIGN(request, HttpRequest::create(v[0].str(), v[1].str(), v[2].str()));
     } else {
       if (line.size() == 0) {
         TRY_STATUS(request->complete_parse_header());
         break;
       } else {
-        TRY_RESULT(h, util::get_header(std::move(line)));
-        TRY_STATUS(request->add_header(std::move(h)));
+        td::Slice name, value;
+        TRY_STATUS(util::split_header(line, name, value));
+        TRY_STATUS(request->add_header(name, value));
       }
     }
   }
@@ -181,46 +225,52 @@ bool HttpRequest::need_payload() const {
 }
 
 td::Status HttpRequest::add_header(HttpHeader header) {
-  auto lc_name = header.name;
-  auto lc_value = header.value;
-  std::transform(lc_name.begin(), lc_name.end(), lc_name.begin(), [](unsigned char c) { return std::tolower(c); });
-  std::transform(lc_value.begin(), lc_value.end(), lc_value.begin(), [](unsigned char c) { return std::tolower(c); });
+  TRY_RESULT(store, process_header(header.name, header.value));
+  if (store) {
+    options_.emplace_back(std::move(header));
+  }
+  return td::Status::OK();
+}
+
+td::Status HttpRequest::add_header(td::Slice name, td::Slice value) {
+  TRY_RESULT(store, process_header(name, value));
+  if (store) {
+    options_.push_back(HttpHeader{name.str(), value.str()});
+  }
+  return td::Status::OK();
+}
 
-  auto S = td::trim(td::Slice(lc_value));
+td::Result<bool> HttpRequest::process_header(td::Slice name, td::Slice value) {
+  auto S = td::trim(value);
 
-  if (lc_name == "content-length") {
+  if (util::equal_lowercase(name, "content-length")) {
     TRY_RESULT(len, td::to_integer_safe<td::uint32>(S));
     if (found_transfer_encoding_ || found_content_length_) {
       return td::Status::Error("duplicate Content-Length/Transfer-Encoding");
     }
     content_length_ = len;
     found_content_length_ = true;
-  } else if (lc_name == "transfer-encoding") {
+  } else if (util::equal_lowercase(name, "transfer-encoding")) {
     // expect chunked, don't event check
     if (found_transfer_encoding_ || found_content_length_) {
       return td::Status::Error("duplicate Content-Length/Transfer-Encoding");
     }
     found_transfer_encoding_ = true;
-  } else if (lc_name == "host") {
+  } else if (util::equal_lowercase(name, "host")) {
     if (host_.size() > 0) {
       return td::Status::Error("duplicate Host");
     }
-    host_ = S.str();
-  } else if (lc_name == "connection" && S == "keep-alive") {
-    keep_alive_ = true;
-    return td::Status::OK();
-  } else if (lc_name == "connection" && S == "close") {
-    keep_alive_ = false;
-    return td::Status::OK();
-  } else if (lc_name == "proxy-connection" && S == "keep-alive") {
-    keep_alive_ = true;
-    return td::Status::OK();
-  } else if (lc_name == "proxy-connection" && S == "close") {
-    keep_alive_ = false;
-    return td::Status::OK();
+    host_ = td::to_lower(S);
+  } else if (util::equal_lowercase(name, "connection") || util::equal_lowercase(name, "proxy-connection")) {
+    if (util::equal_lowercase(S, "keep-alive")) {
+      keep_alive_ = true;
+      return false;
+    } else if (util::equal_lowercase(S, "close")) {
+      keep_alive_ = false;
+      return false;
+    }
   }
-  options_.emplace_back(std::move(header));
-  return td::Status::OK();
+  return true;
 }
 
 void HttpRequest::store_http(td::ChainBufferWriter &output) {
@@ -253,6 +303,7 @@ tl_object_ptr<ton_api::http_request> HttpRequest::store_tl(td::Bits256 req_id) {
 
 td::Status HttpPayload::parse(td::ChainBufferReader &input) {
   CHECK(!parse_completed());
+  std::string line_buf;
   while (true) {
     if (high_watermark_reached()) {
       return td::Status::OK();
@@ -260,7 +311,7 @@ td::Status HttpPayload::parse(td::ChainBufferReader &input) {
     switch (state_) {
       case ParseState::reading_chunk_header: {
         bool read;
-        TRY_RESULT(l, util::get_line(input, tmp_, read, HttpRequest::max_one_header_size()));
+        TRY_RESULT(l, util::get_line(input, tmp_, line_buf, read, HttpRequest::max_one_header_size()));
         if (!read) {
           return td::Status::OK();
         }
@@ -297,6 +348,12 @@ td::Status HttpPayload::parse(td::ChainBufferReader &input) {
         if (input.size() == 0) {
           return td::Status::OK();
         }
+        if (input.prepare_read().size() >= min_zero_copy_size() && cur_chunk_size_ >= min_zero_copy_size()) {
+          // hand the piece of the input buffer over as is instead of copying it into our own chunk
+          auto B = input.read_as_buffer_slice(static_cast<size_t>(std::min<td::uint64>(cur_chunk_size_, chunk_size_)));
+          confirm_read_zero_copy(std::move(B));
+          break;
+        }
         auto S = get_read_slice();
         auto s = input.size();
         if (S.size() > s) {
@@ -307,7 +364,7 @@ td::Status HttpPayload::parse(td::ChainBufferReader &input) {
       } break;
       case ParseState::reading_trailer: {
         bool read;
-        TRY_RESULT(l, util::get_line(input, tmp_, read, HttpRequest::max_one_header_size()));
+        TRY_RESULT(l, util::get_line(input, tmp_, line_buf, read, HttpRequest::max_one_header_size()));
         if (!read) {
           return td::Status::OK();
         }
@@ -318,8 +375,9 @@ td::Status HttpPayload::parse(td::ChainBufferReader &input) {
           run_callbacks();
           return td::Status::OK();
         }
-        TRY_RESULT(h, util::get_header(std::move(l)));
-        add_trailer(std::move(h));
+        td::Slice name, value;
+        TRY_STATUS(util::split_header(l, name, value));
+        add_trailer(HttpHeader{name.str(), value.str()});
         if (trailer_size_ > HttpRequest::max_header_size()) {
           return td::Status::Error("too big trailer part");
         }
@@ -379,6 +437,10 @@ void HttpPayload::add_trailer(HttpHeader header) {
 
 void HttpPayload::add_chunk(td::BufferSlice data) {
   //LOG(INFO) << "payload: added " << data.size() << " bytes";
+  if (data.size() >= min_zero_copy_size()) {
+    add_chunk_zero_copy(std::move(data));
+    return;
+  }
   while (data.size() > 0) {
     if (!cur_chunk_size_) {
       cur_chunk_size_ = data.size();
@@ -394,6 +456,32 @@ void HttpPayload::add_chunk(td::BufferSlice data) {
   }
 }
 
+void HttpPayload::confirm_read_zero_copy(td::BufferSlice data) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  cur_chunk_size_ -= data.size();
+  append_chunk_zero_copy(std::move(data));
+}
+
+void HttpPayload::add_chunk_zero_copy(td::BufferSlice data) {
+  if (data.empty()) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock{mutex_};
+  append_chunk_zero_copy(std::move(data));
+}
+
+void HttpPayload::append_chunk_zero_copy(td::BufferSlice data) {
+  if (last_chunk_free_ > 0) {
+    // seal the partially filled chunk, later data goes after the adopted slice
+    auto &x = chunks_.back();
+    x.truncate(x.size() - last_chunk_free_);
+    last_chunk_free_ = 0;
+  }
+  ready_bytes_ += data.size();
+  chunks_.push_back(std::move(data));
+  run_callbacks();
+}
+
 void HttpPayload::slice_gc() {
   const std::lock_guard<std::mutex> lock{mutex_};
   while (chunks_.size() > 0) {
@@ -559,11 +647,25 @@ tl_object_ptr<ton_api::http_payloadPart> HttpPayload::store_tl(size_t max_size)
     b = max_size;
   }
   max_size = b;
-  td::BufferSlice x{b};
-  auto S = x.as_slice();
-  auto obj = create_tl_object<ton_api::http_payloadPart>(std::move(x),
+  auto obj = create_tl_object<ton_api::http_payloadPart>(td::BufferSlice(),
                                                          std::vector<tl_object_ptr<ton_api::http_header>>(), false);
 
+  // a part made of a single chunk is passed on without copying
+  std::vector<td::BufferSlice> parts;
+  size_t parts_size = 0;
+  auto flush_parts = [&] {
+    if (parts.size() == 1) {
+      obj->data_ = std::move(parts[0]);
+    } else if (parts.size() > 1) {
+      obj->data_ = td::BufferSlice{parts_size};
+      auto S = obj->data_.as_slice();
+      for (auto &p : parts) {
+        S.copy_from(p);
+        S.remove_prefix(p.size());
+      }
+    }
+  };
+
   slice_gc();
   while (chunks_.size() > 0 && max_size > 0) {
     auto cur_state = state_.load(std::memory_order_consume);
@@ -571,18 +673,18 @@ tl_object_ptr<ton_api::http_payloadPart> HttpPayload::store_tl(size_t max_size)
     if (s.size() == 0) {
       if (cur_state != ParseState::reading_trailer && cur_state != ParseState::completed) {
         LOG(INFO) << "state not trailer/completed";
-        obj->data_.truncate(obj->data_.size() - S.size());
+        flush_parts();
         return obj;
       } else {
         break;
       }
     }
     CHECK(s.size() <= max_size);
-    S.copy_from(s);
-    S.remove_prefix(s.size());
     max_size -= s.size();
+    parts_size += s.size();
+    parts.push_back(std::move(s));
   }
-  obj->data_.truncate(obj->data_.size() - S.size());
+  flush_parts();
   auto cur_state = state_.load(std::memory_order_consume);
   if (chunks_.size() != 0 || (cur_state != ParseState::reading_trailer && cur_state != ParseState::completed)) {
     return obj;
@@ -705,9 +807,10 @@ td::Result<std::unique_ptr<HttpResponse>> HttpResponse::parse(std::unique_ptr<Ht
                                                               td::ChainBufferReader &input) {
   exit_loop = false;
   CHECK(!response || !response->check_parse_header_completed());
+  std::string line_buf;
   while (true) {
     bool read;
-    TRY_RESULT(line, util::get_line(input, cur_line, read, HttpRequest::max_one_header_size()));
+    TRY_RESULT(line, util::get_line(input, cur_line, line_buf, read, HttpRequest::max_one_header_size()));
     if (!read) {
       exit_loop = true;
       break;
@@ -718,15 +821,17 @@ td::Result<std::unique_ptr<HttpResponse>> HttpResponse::parse(std::unique_ptr<Ht
       if (v.size() != 3) {
         return td::Status::Error("expected http header in form ");
       }
-      TRY_RESULT(code, td::to_integer_safe<td::uint32>(std::move(v[1])));
-      TRY_RESULT_ASSIGN(response, HttpResponse::create(v[0], code, v[2], force_no_payload, keep_alive));
+      TRY_RESULT(code, td::to_integer_safe<td::uint32>(v[1]));
+      TRY_RESULT_ASSIGN(response,
+                        HttpResponse::create(v[0].str(), code, v[2].str(), force_no_payload, keep_alive));
     } else {
       if (line.size() == 0) {
         TRY_STATUS(response->complete_parse_header());
         break;
       } else {
-        TRY_RESULT(h, util::get_header(std::move(line)));
-        TRY_STATUS(response->add_header(std::move(h)));
+        td::Slice name, value;
+        TRY_STATUS(util::split_header(line, name, value));
+        TRY_STATUS(response->add_header(name, value));
       }
     }
   }
@@ -791,41 +896,47 @@ bool HttpResponse::need_payload() const {
 }
 
 td::Status HttpResponse::add_header(HttpHeader header) {
-  auto lc_name = header.name;
-  auto lc_value = header.value;
-  std::transform(lc_name.begin(), lc_name.end(), lc_name.begin(), [](unsigned char c) { return std::tolower(c); });
-  std::transform(lc_value.begin(), lc_value.end(), lc_value.begin(), [](unsigned char c) { return std::tolower(c); });
+  TRY_RESULT(store, process_header(header.name, header.value));
+  if (store) {
+    options_.emplace_back(std::move(header));
+  }
+  return td::Status::OK();
+}
 
-  auto S = td::trim(td::Slice(lc_value));
+td::Status HttpResponse::add_header(td::Slice name, td::Slice value) {
+  TRY_RESULT(store, process_header(name, value));
+  if (store) {
+    options_.push_back(HttpHeader{name.str(), value.str()});
+  }
+  return td::Status::OK();
+}
 
-  if (lc_name == "content-length") {
+td::Result<bool> HttpResponse::process_header(td::Slice name, td::Slice value) {
+  auto S = td::trim(value);
+
+  if (util::equal_lowercase(name, "content-length")) {
     TRY_RESULT(len, td::to_integer_safe<td::uint32>(S));
     if (found_transfer_encoding_ || found_content_length_) {
       return td::Status::Error("duplicate Content-Length/Transfer-Encoding");
     }
     content_length_ = len;
     found_content_length_ = true;
-  } else if (lc_name == "transfer-encoding") {
+  } else if (util::equal_lowercase(name, "transfer-encoding")) {
     // expect chunked, don't event check
     if (found_transfer_encoding_ || found_content_length_) {
       return td::Status::Error("duplicate Content-Length/Transfer-Encoding");
     }
     found_transfer_encoding_ = true;
-  } else if (lc_name == "connection" && S == "keep-alive") {
-    keep_alive_ = true;
-    return td::Status::OK();
-  } else if (lc_name == "connection" && S == "close") {
-    keep_alive_ = false;
-    return td::Status::OK();
-  } else if (lc_name == "proxy-connection" && S == "keep-alive") {
-    keep_alive_ = true;
-    return td::Status::OK();
-  } else if (lc_name == "proxy-connection" && S == "close") {
-    keep_alive_ = false;
-    return td::Status::OK();
+  } else if (util::equal_lowercase(name, "connection") || util::equal_lowercase(name, "proxy-connection")) {
+    if (util::equal_lowercase(S, "keep-alive")) {
+      keep_alive_ = true;
+      return false;
+    } else if (util::equal_lowercase(S, "close")) {
+      keep_alive_ = false;
+      return false;
+    }
   }
-  options_.emplace_back(std::move(header));
-  return td::Status::OK();
+  return true;
 }
 
 void HttpResponse::store_http(td::ChainBufferWriter &output) {
@@ -60,6 +60,14 @@ namespace util {
 td::Result<std::string> get_line(td::ChainBufferReader &input, std::string &cur_line, bool &read, size_t max_line_size);
 td::Result<HttpHeader> get_header(std::string line);
 
+// Returns the next line without CRLF. When the line lies in one contiguous piece of the input, the result points
+// into the input buffer; otherwise the line is assembled in cur_line and moved to line_buf.
+// The result is valid until the next operation on input or line_buf.
+td::Result<td::Slice> get_line(td::ChainBufferReader &input, std::string &cur_line, std::string &line_buf, bool &read,
+                               size_t max_line_size);
+td::Status split_header(td::Slice line, td::Slice &name, td::Slice &value);
+bool equal_lowercase(td::Slice s, td::Slice lc);
+
 }  // namespace util
 
 class HttpPayload {
@@ -128,8 +136,11 @@ class HttpPayload {
   }
   td::MutableSlice get_read_slice();
   void confirm_read(size_t s);
+  // the same for a piece of input adopted as is
+  void confirm_read_zero_copy(td::BufferSlice data);
   void add_trailer(HttpHeader header);
   void add_chunk(td::BufferSlice data);
+  void add_chunk_zero_copy(td::BufferSlice data);
   td::BufferSlice get_slice(size_t max_size);
   void slice_gc();
   HttpHeader get_header();
@@ -154,6 +165,12 @@ class HttpPayload {
   td::uint64 cur_chunk_size_ = 0;
   size_t last_chunk_free_ = 0;
   size_t chunk_size_ = 1 << 14;
+  // smaller pieces are copied, so that tiny slices do not pin large input buffers
+  static constexpr size_t min_zero_copy_size() {
+    return 1 << 11;
+  }
+  // must be called with mutex_ held
+  void append_chunk_zero_copy(td::BufferSlice data);
   bool written_zero_chunk_ = false;
   bool written_trailer_ = false;
   bool error_ = false;
@@ -197,6 +214,7 @@ class HttpRequest {
 
   td::Status complete_parse_header();
   td::Status add_header(HttpHeader header);
+  td::Status add_header(td::Slice name, td::Slice value);
   td::Result<std::shared_ptr<HttpPayload>> create_empty_payload();
   bool need_payload() const;
 
@@ -241,6 +259,8 @@ class HttpRequest {
   bool keep_alive_ = false;
 
   std::vector<HttpHeader> options_;
+
+  td::Result<bool> process_header(td::Slice name, td::Slice value);
 };
 
 class HttpResponse {
@@ -278,6 +298,7 @@ class HttpResponse {
 
   td::Status complete_parse_header();
   td::Status add_header(HttpHeader header);
+  td::Status add_header(td::Slice name, td::Slice value);
   td::Result<std::shared_ptr<HttpPayload>> create_empty_payload();
   bool need_payload() const;
 
@@ -324,6 +345,8 @@ class HttpResponse {
 
   std::vector<HttpHeader> options_;
   bool is_tunnel_ = false;
+
+  td::Result<bool> process_header(td::Slice name, td::Slice value);
 };
 
 void answer_error(HttpStatusCode code, std::string reason,
@@ -0,0 +1,193 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "common/bitstring.h"
+
+#include "td/utils/as.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+namespace ton {
+
+namespace overlay {
+
+// Broadcast hashes are sha256 outputs, but they are chosen by remote peers: a random multiplier, common to all
+// hash tables of broadcasts in the process, keeps them from crafting hashes that fall into the same buckets
+inline td::uint64 broadcast_hash_multiplier() {
+  static const td::uint64 multiplier = td::Random::secure_uint64() | 1;
+  return multiplier;
+}
+
+struct BroadcastHashHasher {
+  std::size_t operator()(const td::Bits256 &hash) const {
+    auto x = td::as<td::uint64>(hash.data()) * broadcast_hash_multiplier();
+    return static_cast<std::size_t>(x ^ (x >> 32));
+  }
+};
+
+/*
+ * Set of recently delivered broadcasts.
+ * Hashes are kept in two generations, each an open addressing table of 64-bit fingerprints of hashes. A generation
+ * is current for generation_ttl seconds, then the previous one is dropped and the current one becomes previous, so
+ * a hash is remembered for at least generation_ttl seconds. Tables start small and grow with the number of
+ * delivered broadcasts, and a new generation is sized by the count of the last one, so memory follows the broadcast
+ * rate of the overlay. A generation that reaches max_generation_size is rotated early: memory is bounded by two
+ * tables of 2 * max_generation_size fingerprints, at the price of a shorter window under a flood.
+ * A fingerprint takes a quarter of a hash; a false positive needs a 64-bit collision with a recent broadcast.
+ */
+class BroadcastDedupFilter {
+ public:
+  BroadcastDedupFilter(std::size_t max_generation_size, double generation_ttl)
+      : max_generation_size_(max_generation_size), generation_ttl_(generation_ttl) {
+    for (auto &generation : generations_) {
+      generation.reset(min_capacity_log());
+    }
+    rotate_at_ = td::Timestamp::in(generation_ttl_);
+  }
+
+  bool contains(const td::Bits256 &hash) const {
+    auto key = fingerprint(hash);
+    return generations_[cur_].contains(key) || generations_[cur_ ^ 1].contains(key);
+  }
+
+  void insert(const td::Bits256 &hash) {
+    if (contains(hash)) {
+      return;
+    }
+    if (generations_[cur_].size >= max_generation_size_) {
+      rotate();
+      forced_rotations_++;
+    }
+    auto &generation = generations_[cur_];
+    if ((generation.size + 1) * 2 > generation.slots.size()) {
+      generation.grow();
+    }
+    generation.insert(fingerprint(hash));
+  }
+
+  void rotate_if_expired() {
+    if (rotate_at_.is_in_past()) {
+      rotate();
+    }
+  }
+
+  std::size_t size() const {
+    return generations_[0].size + generations_[1].size;
+  }
+  std::size_t memory_usage() const {
+    return (generations_[0].slots.capacity() + generations_[1].slots.capacity()) * sizeof(td::uint64);
+  }
+  td::uint64 forced_rotations() const {
+    return forced_rotations_;
+  }
+
+ private:
+  struct Generation {
+    // zero marks an empty slot, the zero fingerprint itself is stored in has_zero
+    std::vector<td::uint64> slots;
+    std::size_t size = 0;
+    int capacity_log = 0;
+    bool has_zero = false;
+
+    void reset(int new_capacity_log) {
+      capacity_log = new_capacity_log;
+      slots.assign(static_cast<std::size_t>(1) << capacity_log, 0);
+      slots.shrink_to_fit();
+      size = 0;
+      has_zero = false;
+    }
+    std::size_t first_slot(td::uint64 key) const {
+      return static_cast<std::size_t>((key * broadcast_hash_multiplier()) >> (64 - capacity_log));
+    }
+    bool contains(td::uint64 key) const {
+      if (key == 0) {
+        return has_zero;
+      }
+      auto mask = slots.size() - 1;
+      for (auto i = first_slot(key);; i = (i + 1) & mask) {
+        if (slots[i] == 0) {
+          return false;
+        }
+        if (slots[i] == key) {
+          return true;
+        }
+      }
+    }
+    void insert(td::uint64 key) {
+      size++;
+      if (key == 0) {
+        has_zero = true;
+        return;
+      }
+      auto mask = slots.size() - 1;
+      auto i = first_slot(key);
+      while (slots[i] != 0) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = key;
+    }
+    void grow() {
+      auto old_slots = std::move(slots);
+      auto old_size = size;
+      auto old_has_zero = has_zero;
+      reset(capacity_log + 1);
+      for (auto key : old_slots) {
+        if (key != 0) {
+          insert(key);
+        }
+      }
+      size = old_size;
+      has_zero = old_has_zero;
+    }
+  };
+
+  std::size_t max_generation_size_;
+  double generation_ttl_;
+  Generation generations_[2];
+  int cur_ = 0;
+  td::Timestamp rotate_at_;
+  td::uint64 forced_rotations_ = 0;
+
+  static int min_capacity_log() {
+    return 6;
+  }
+
+  static td::uint64 fingerprint(const td::Bits256 &hash) {
+    // folds the whole hash: hashes that differ only outside of the first word still get different fingerprints
+    return td::as<td::uint64>(hash.data() + 8) ^ td::as<td::uint64>(hash.data() + 16) ^
+           td::as<td::uint64>(hash.data() + 24) ^ td::as<td::uint64>(hash.data());
+  }
+
+  void rotate() {
+    // the new generation starts with room for as many hashes as the last one got
+    auto last_size = generations_[cur_].size;
+    int capacity_log = min_capacity_log();
+    while ((static_cast<std::size_t>(1) << capacity_log) < last_size * 2) {
+      capacity_log++;
+    }
+    cur_ ^= 1;
+    generations_[cur_].reset(capacity_log);
+    rotate_at_ = td::Timestamp::in(generation_ttl_);
+  }
+};
+
+}  // namespace overlay
+
+}  // namespace ton
@@ -116,7 +116,7 @@ void OverlayImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::overlay_getB
     promise.set_value(create_serialize_tl_object<ton_api::overlay_broadcastNotFound>());
     return;
   }
-  if (delivered_broadcasts_.find(query.hash_) != delivered_broadcasts_.end()) {
+  if (delivered_broadcasts_.contains(query.hash_)) {
     VLOG(OVERLAY_DEBUG) << this << ": received getBroadcastQuery(" << query.hash_ << ") from " << src
                         << " but broadcast already deleted";
     promise.set_value(create_serialize_tl_object<ton_api::overlay_broadcastNotFound>());
@@ -388,14 +388,13 @@ void OverlayImpl::update_dht_nodes(OverlayNode node) {
 }
 
 void OverlayImpl::bcast_gc() {
+  delivered_broadcasts_.rotate_if_expired();
   while (broadcasts_.size() > max_data_bcasts()) {
     auto bcast = BroadcastSimple::from_list_node(bcast_data_lru_.get());
     CHECK(bcast);
     auto hash = bcast->get_hash();
     broadcasts_.erase(hash);
-    if (delivered_broadcasts_.insert(hash).second) {
-      bcast_lru_.push(hash);
-    }
+    delivered_broadcasts_.insert(hash);
   }
   while (fec_broadcasts_.size() > 0) {
     auto bcast = BroadcastFec::from_list_node(bcast_fec_lru_.prev);
@@ -406,16 +405,8 @@ void OverlayImpl::bcast_gc() {
     auto hash = bcast->get_hash();
     CHECK(fec_broadcasts_.count(hash) == 1);
     fec_broadcasts_.erase(hash);
-    if (delivered_broadcasts_.insert(hash).second) {
-      bcast_lru_.push(hash);
-    }
-  }
-  while (bcast_lru_.size() > max_bcasts()) {
-    auto Id = bcast_lru_.front();
-    bcast_lru_.pop();
-    CHECK(delivered_broadcasts_.erase(Id));
+    delivered_broadcasts_.insert(hash);
   }
-  CHECK(delivered_broadcasts_.size() == bcast_lru_.size());
 }
 
 void OverlayImpl::send_message_to_neighbours(td::BufferSlice data) {
@@ -468,7 +459,9 @@ BroadcastCheckResult OverlayImpl::check_source_eligible(PublicKey source, const
 }
 
 td::Status OverlayImpl::check_delivered(BroadcastHash hash) {
-  if (delivered_broadcasts_.count(hash) == 1 || broadcasts_.count(hash) == 1) {
+  bcast_checks_++;
+  if (delivered_broadcasts_.contains(hash) || broadcasts_.count(hash) == 1) {
+    bcast_duplicates_++;
     return td::Status::Error(ErrorCode::notready, "duplicate broadcast");
   } else {
     return td::Status::OK();
@@ -652,6 +645,14 @@ void OverlayImpl::get_stats(td::Promise<tl_object_ptr<ton_api::engine_validator_
 
   res->stats_.push_back(
       create_tl_object<ton_api::engine_validator_oneStat>("neighbours_cnt", PSTRING() << neighbours_.size()));
+  res->stats_.push_back(create_tl_object<ton_api::engine_validator_oneStat>(
+      "bcast_duplicates", PSTRING() << bcast_duplicates_ << "/" << bcast_checks_));
+  res->stats_.push_back(create_tl_object<ton_api::engine_validator_oneStat>(
+      "bcast_in_flight", PSTRING() << broadcasts_.size() << " simple, " << fec_broadcasts_.size() << " fec"));
+  res->stats_.push_back(create_tl_object<ton_api::engine_validator_oneStat>(
+      "bcast_delivered", PSTRING() << delivered_broadcasts_.size() << " hashes, "
+                                   << delivered_broadcasts_.memory_usage() << " bytes, "
+                                   << delivered_broadcasts_.forced_rotations() << " forced rotations"));
 
   promise.set_value(std::move(res));
 }
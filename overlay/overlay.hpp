@@ -21,13 +21,14 @@
 #include <vector>
 #include <map>
 #include <set>
-#include <queue>
+#include <unordered_map>
 
 #include "overlay.h"
 #include "overlay-manager.h"
 #include "overlay-fec.hpp"
 #include "overlay-broadcast.hpp"
 #include "overlay-fec-broadcast.hpp"
+#include "overlay-broadcast-dedup.hpp"
 #include "overlay-id.hpp"
 
 #include "td/utils/DecTree.h"
@@ -333,14 +334,15 @@ class OverlayImpl : public Overlay {
 
   std::unique_ptr<Overlays::Callback> callback_;
 
-  std::map<BroadcastHash, std::unique_ptr<BroadcastSimple>> broadcasts_;
-  std::map<BroadcastHash, std::unique_ptr<BroadcastFec>> fec_broadcasts_;
-  std::set<BroadcastHash> delivered_broadcasts_;
+  std::unordered_map<BroadcastHash, std::unique_ptr<BroadcastSimple>, BroadcastHashHasher> broadcasts_;
+  std::unordered_map<BroadcastHash, std::unique_ptr<BroadcastFec>, BroadcastHashHasher> fec_broadcasts_;
+  BroadcastDedupFilter delivered_broadcasts_{max_delivered_bcasts(), delivered_bcasts_ttl()};
+  td::uint64 bcast_checks_ = 0;
+  td::uint64 bcast_duplicates_ = 0;
 
   std::vector<adnl::AdnlNodeIdShort> neighbours_;
   td::ListNode bcast_data_lru_;
   td::ListNode bcast_fec_lru_;
-  std::queue<BroadcastHash> bcast_lru_;
 
   std::map<BroadcastHash, td::actor::ActorOwn<OverlayOutboundFecBroadcast>> out_fec_bcasts_;
 
@@ -349,8 +351,13 @@ class OverlayImpl : public Overlay {
   static td::uint32 max_data_bcasts() {
     return 100;
   }
-  static td::uint32 max_bcasts() {
-    return 1000;
+  // per generation of delivered_broadcasts_, at most 1 MiB of fingerprints for both generations
+  static td::uint32 max_delivered_bcasts() {
+    return 1 << 15;
+  }
+  // broadcasts older than 20 seconds are rejected by check_date anyway
+  static double delivered_bcasts_ttl() {
+    return 60.0;
   }
   static td::uint32 max_fec_bcasts() {
     return 20;
@@ -0,0 +1,112 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "overlay-broadcast-dedup.hpp"
+
+#include "td/utils/port/sleep.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+namespace {
+td::Bits256 random_hash() {
+  td::Bits256 hash;
+  td::Random::secure_bytes(hash.as_slice());
+  return hash;
+}
+}  // namespace
+
+TEST(BroadcastDedup, RejectsDuplicates) {
+  ton::overlay::BroadcastDedupFilter filter(1 << 12, 3600.0);
+  std::vector<td::Bits256> hashes;
+  for (int i = 0; i < 1000; i++) {
+    hashes.push_back(random_hash());
+    ASSERT_TRUE(!filter.contains(hashes.back()));
+    filter.insert(hashes.back());
+  }
+  filter.insert(hashes[0]);
+  ASSERT_EQ(1000u, filter.size());
+  for (auto &hash : hashes) {
+    ASSERT_TRUE(filter.contains(hash));
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(!filter.contains(random_hash()));
+  }
+  ASSERT_TRUE(!filter.contains(td::Bits256::zero()));
+  filter.insert(td::Bits256::zero());
+  ASSERT_TRUE(filter.contains(td::Bits256::zero()));
+}
+
+TEST(BroadcastDedup, Expiry) {
+  ton::overlay::BroadcastDedupFilter filter(1 << 12, 0.05);
+  auto old_hash = random_hash();
+  filter.insert(old_hash);
+  td::usleep_for(60000);
+  filter.rotate_if_expired();
+  // the previous generation is still checked
+  ASSERT_TRUE(filter.contains(old_hash));
+  auto new_hash = random_hash();
+  filter.insert(new_hash);
+  td::usleep_for(60000);
+  filter.rotate_if_expired();
+  ASSERT_TRUE(!filter.contains(old_hash));
+  ASSERT_TRUE(filter.contains(new_hash));
+  ASSERT_EQ(0u, filter.forced_rotations());
+
+  // a flood rotates generations early, the memory stays bounded
+  ton::overlay::BroadcastDedupFilter small(100, 3600.0);
+  std::vector<td::Bits256> hashes;
+  for (int i = 0; i < 1000; i++) {
+    hashes.push_back(random_hash());
+    small.insert(hashes.back());
+    ASSERT_TRUE(small.size() <= 200);
+  }
+  ASSERT_TRUE(small.forced_rotations() >= 9);
+  ASSERT_TRUE(small.memory_usage() <= 2 * 256 * sizeof(td::uint64));
+  for (int i = 900; i < 1000; i++) {
+    ASSERT_TRUE(small.contains(hashes[i]));
+  }
+}
+
+TEST(BroadcastDedup, Collisions) {
+  // hashes that share the first word: the fingerprint folds in the other words too, so they get different
+  // fingerprints and slots, and none of them is mistaken for another
+  ton::overlay::BroadcastDedupFilter filter(1 << 12, 3600.0);
+  std::set<td::Bits256> inserted;
+  auto base = random_hash();
+  for (int i = 0; i < 500; i++) {
+    auto hash = base;
+    td::Random::secure_bytes(hash.as_slice().substr(8));
+    if (i % 2 == 0) {
+      filter.insert(hash);
+      inserted.insert(hash);
+    } else if (!inserted.count(hash)) {
+      ASSERT_TRUE(!filter.contains(hash));
+    }
+  }
+  for (auto &hash : inserted) {
+    ASSERT_TRUE(filter.contains(hash));
+  }
+  // the same for hashes that differ in a single byte of the last word
+  for (int i = 0; i < 256; i++) {
+    auto hash = base;
+    hash.as_slice()[31] = static_cast<char>(i);
+    ASSERT_EQ(inserted.count(hash) != 0, filter.contains(hash));
+    filter.insert(hash);
+    ASSERT_TRUE(filter.contains(hash));
+  }
+}
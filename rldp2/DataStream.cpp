@@ -0,0 +1,98 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DataStream.h"
+
+#include "td/utils/port/FileFd.h"
+
+namespace ton {
+namespace rldp2 {
+
+namespace {
+class BufferDataSource : public OutboundDataSource {
+ public:
+  explicit BufferDataSource(td::BufferSlice data) : data_(std::move(data)) {
+  }
+  td::uint64 size() const override {
+    return data_.size();
+  }
+  td::Result<td::BufferSlice> read(td::uint64 offset, size_t size) override {
+    if (offset > data_.size()) {
+      return td::Status::Error("offset is out of range");
+    }
+    return data_.from_slice(data_.as_slice().substr(static_cast<size_t>(offset)).truncate(size));
+  }
+
+ private:
+  td::BufferSlice data_;
+};
+
+class FileDataSource : public OutboundDataSource {
+ public:
+  FileDataSource(td::FileFd fd, td::uint64 offset, td::uint64 size)
+      : fd_(std::move(fd)), offset_(offset), size_(size) {
+  }
+  td::uint64 size() const override {
+    return size_;
+  }
+  bool is_blocking() const override {
+    return true;
+  }
+  td::Result<td::BufferSlice> read(td::uint64 offset, size_t size) override {
+    if (offset > size_) {
+      return td::Status::Error("offset is out of range");
+    }
+    size = static_cast<size_t>(std::min<td::uint64>(size, size_ - offset));
+    // read right into the buffer that the FEC encoder keeps
+    td::BufferSlice data(size);
+    auto slice = data.as_slice();
+    while (!slice.empty()) {
+      TRY_RESULT(read, fd_.pread(slice, static_cast<td::int64>(offset_ + offset + (size - slice.size()))));
+      if (read == 0) {
+        return td::Status::Error("unexpected end of file");
+      }
+      slice.remove_prefix(read);
+    }
+    return std::move(data);
+  }
+
+ private:
+  td::FileFd fd_;
+  td::uint64 offset_;
+  td::uint64 size_;
+};
+}  // namespace
+
+std::unique_ptr<OutboundDataSource> OutboundDataSource::from_buffer(td::BufferSlice data) {
+  return std::make_unique<BufferDataSource>(std::move(data));
+}
+
+td::Result<std::unique_ptr<OutboundDataSource>> OutboundDataSource::from_file(td::CSlice path, td::uint64 offset,
+                                                                              td::int64 size) {
+  TRY_RESULT(fd, td::FileFd::open(path, td::FileFd::Read));
+  TRY_RESULT(file_size, fd.get_size());
+  if (offset > static_cast<td::uint64>(file_size)) {
+    return td::Status::Error("offset is out of range");
+  }
+  td::uint64 available = static_cast<td::uint64>(file_size) - offset;
+  if (size >= 0 && static_cast<td::uint64>(size) < available) {
+    available = static_cast<td::uint64>(size);
+  }
+  return std::make_unique<FileDataSource>(std::move(fd), offset, available);
+}
+
+}  // namespace rldp2
+}  // namespace ton
@@ -0,0 +1,56 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <memory>
+
+namespace ton {
+namespace rldp2 {
+
+// Payload of an outbound transfer. Data is read one FEC part at a time, when the part is started, and released
+// when the peer confirms it, so at most a window of parts is kept in memory.
+class OutboundDataSource {
+ public:
+  virtual ~OutboundDataSource() = default;
+  virtual td::uint64 size() const = 0;
+  // reads of a blocking source are done outside of the connection actor, several of them at a time
+  virtual td::Result<td::BufferSlice> read(td::uint64 offset, size_t size) = 0;
+  virtual bool is_blocking() const {
+    return false;
+  }
+
+  // parts share the memory of data
+  static std::unique_ptr<OutboundDataSource> from_buffer(td::BufferSlice data);
+  // [offset, offset + size) of the file, size = -1 means until the end of the file
+  static td::Result<std::unique_ptr<OutboundDataSource>> from_file(td::CSlice path, td::uint64 offset = 0,
+                                                                   td::int64 size = -1);
+};
+
+// Receiver of an inbound transfer. Decoded data is appended in order, as soon as all the parts before it are
+// decoded; an error aborts the transfer.
+class InboundDataSink {
+ public:
+  virtual ~InboundDataSink() = default;
+  virtual td::Status append(td::BufferSlice data) = 0;
+};
+
+}  // namespace rldp2
+}  // namespace ton
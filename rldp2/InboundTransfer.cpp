@@ -24,7 +24,7 @@
 namespace ton {
 namespace rldp2 {
 size_t InboundTransfer::total_size() const {
-  return data_.size();
+  return total_size_;
 }
 
 std::map<td::uint32, InboundTransfer::Part> &InboundTransfer::parts() {
@@ -59,15 +59,31 @@ td::Result<InboundTransfer::Part *> InboundTransfer::get_part(td::uint32 part_i,
   return nullptr;
 }
 
-void InboundTransfer::finish_part(td::uint32 part_i, td::Slice data) {
+td::Status InboundTransfer::finish_part(td::uint32 part_i, td::BufferSlice data) {
   auto it = parts_.find(part_i);
   CHECK(it != parts_.end());
-  data_.as_slice().substr(it->second.offset).copy_from(data);
+  auto offset = it->second.offset;
   parts_.erase(it);
+  if (!sink_) {
+    data_.as_slice().substr(offset).copy_from(data.as_slice());
+    return td::Status::OK();
+  }
+  decoded_.emplace(offset, std::move(data));
+  while (!decoded_.empty() && decoded_.begin()->first == delivered_) {
+    auto part_data = std::move(decoded_.begin()->second);
+    decoded_.erase(decoded_.begin());
+    delivered_ += part_data.size();
+    TRY_STATUS(sink_->append(std::move(part_data)));
+  }
+  return td::Status::OK();
 }
 
 td::optional<td::Result<td::BufferSlice>> InboundTransfer::try_finish() {
-  if (parts_.empty() && offset_ == data_.size()) {
+  if (parts_.empty() && offset_ == total_size_) {
+    if (sink_) {
+      CHECK(delivered_ == total_size_);
+      return td::BufferSlice();
+    }
     return std::move(data_);
   }
   return {};
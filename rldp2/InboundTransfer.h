@@ -23,6 +23,7 @@
 
 #include "fec/fec.h"
 
+#include "DataStream.h"
 #include "RldpReceiver.h"
 
 #include <map>
@@ -36,21 +37,31 @@ struct InboundTransfer {
     size_t offset;
   };
 
-  explicit InboundTransfer(size_t total_size) : data_(total_size) {
+  explicit InboundTransfer(size_t total_size) : total_size_(total_size), data_(total_size) {
+  }
+  // the data is passed to sink instead of being collected: try_finish() returns an empty buffer
+  InboundTransfer(size_t total_size, std::unique_ptr<InboundDataSink> sink)
+      : total_size_(total_size), sink_(std::move(sink)) {
   }
 
   size_t total_size() const;
   std::map<td::uint32, Part> &parts();
   bool is_part_completed(td::uint32 part_i);
   td::Result<Part *> get_part(td::uint32 part_i, const ton::fec::FecType &fec_type);
-  void finish_part(td::uint32 part_i, td::Slice data);
+  td::Status finish_part(td::uint32 part_i, td::BufferSlice data);
   td::optional<td::Result<td::BufferSlice>> try_finish();
 
  private:
   std::map<td::uint32, Part> parts_;
   td::uint32 next_part_{0};
   size_t offset_{0};
+  size_t total_size_;
   td::BufferSlice data_;
+
+  std::unique_ptr<InboundDataSink> sink_;
+  // decoded parts that wait for the previous ones, by offset
+  std::map<size_t, td::BufferSlice> decoded_;
+  size_t delivered_{0};
 };
 }  // namespace rldp2
 }  // namespace ton
@@ -22,24 +22,63 @@
 namespace ton {
 namespace rldp2 {
 size_t OutboundTransfer::total_size() const {
-  return data_.size();
+  return static_cast<size_t>(source_->size());
 }
 std::map<td::uint32, OutboundTransfer::Part> &OutboundTransfer::parts(const RldpSender::Config &config) {
-  while (parts_.size() < 20) {
+  if (source_->is_blocking()) {
+    while (status_.is_ok() && parts_.size() + (next_read_ - next_part_) < 20) {
+      auto offset = static_cast<size_t>(next_read_) * part_size();
+      if (offset >= total_size()) {
+        break;
+      }
+      read_requests_.push_back(ReadRequest{next_read_, offset, std::min(part_size(), total_size() - offset)});
+      next_read_++;
+    }
+    // parts are started in order, the receiver does not accept the later ones first
+    for (auto it = ready_.begin(); status_.is_ok() && it != ready_.end() && it->first == next_part_;) {
+      start_part(std::move(it->second), config);
+      it = ready_.erase(it);
+    }
+    return parts_;
+  }
+  while (parts_.size() < 20 && status_.is_ok()) {
     auto offset = next_part_ * part_size();
-    if (offset >= data_.size()) {
+    if (offset >= total_size()) {
       break;
     }
-    td::BufferSlice D = data_.from_slice(data_.as_slice().substr(offset).truncate(part_size()));
-    ton::fec::FecType fec_type = td::fec::RaptorQEncoder::Parameters{D.size(), symbol_size(), 0};
-    auto encoder = fec_type.create_encoder(std::move(D)).move_as_ok();
-    auto symbols_count = fec_type.symbols_count();
-    parts_.emplace(next_part_, Part{std::move(encoder), RldpSender(config, symbols_count), std::move(fec_type)});
-    next_part_++;
+    auto r_data = source_->read(offset, part_size());
+    if (r_data.is_error()) {
+      status_ = r_data.move_as_error();
+      break;
+    }
+    start_part(r_data.move_as_ok(), config);
   }
   return parts_;
 }
 
+void OutboundTransfer::on_part_read(td::uint32 part_i, td::Result<td::BufferSlice> r_data) {
+  if (r_data.is_error()) {
+    if (status_.is_ok()) {
+      status_ = r_data.move_as_error();
+    }
+    return;
+  }
+  ready_.emplace(part_i, r_data.move_as_ok());
+}
+
+void OutboundTransfer::start_part(td::BufferSlice data, const RldpSender::Config &config) {
+  auto offset = next_part_ * part_size();
+  if (data.size() != std::min(part_size(), total_size() - offset)) {
+    status_ = td::Status::Error("data source returned a part of wrong size");
+    return;
+  }
+  ton::fec::FecType fec_type = td::fec::RaptorQEncoder::Parameters{data.size(), symbol_size(), 0};
+  auto encoder = fec_type.create_encoder(std::move(data)).move_as_ok();
+  auto symbols_count = fec_type.symbols_count();
+  parts_.emplace(next_part_, Part{std::move(encoder), RldpSender(config, symbols_count), std::move(fec_type)});
+  next_part_++;
+}
+
 void OutboundTransfer::drop_part(td::uint32 part_i) {
   parts_.erase(part_i);
 }
@@ -53,7 +92,7 @@ OutboundTransfer::Part *OutboundTransfer::get_part(td::uint32 part_i) {
 }
 
 bool OutboundTransfer::is_done() const {
-  return next_part_ * part_size() >= data_.size() && parts_.empty();
+  return next_part_ * part_size() >= total_size() && parts_.empty();
 }
 }  // namespace rldp2
 }  // namespace ton
@@ -19,10 +19,13 @@
 
 #pragma once
 
+#include "DataStream.h"
 #include "RldpSender.h"
 #include "fec/fec.h"
 
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace ton {
 namespace rldp2 {
@@ -34,20 +37,52 @@ struct OutboundTransfer {
     ton::fec::FecType fec_type;
   };
 
-  OutboundTransfer(td::BufferSlice data) : data_(std::move(data)) {
+  // read of a part of a blocking data source, done by the owner of the connection
+  struct ReadRequest {
+    td::uint32 part_i;
+    td::uint64 offset;
+    size_t size;
+  };
+
+  OutboundTransfer(td::BufferSlice data) : source_(OutboundDataSource::from_buffer(std::move(data))) {
+  }
+  explicit OutboundTransfer(std::unique_ptr<OutboundDataSource> source) : source_(std::move(source)) {
   }
 
   size_t total_size() const;
   std::map<td::uint32, Part> &parts(const RldpSender::Config &config);
+  const std::shared_ptr<OutboundDataSource> &source() const {
+    return source_;
+  }
+  std::vector<ReadRequest> take_read_requests() {
+    return std::move(read_requests_);
+  }
+  void on_part_read(td::uint32 part_i, td::Result<td::BufferSlice> r_data);
+  // parts that are already started, without starting new ones
+  std::map<td::uint32, Part> &active_parts() {
+    return parts_;
+  }
   void drop_part(td::uint32 part_i);
   Part *get_part(td::uint32 part_i);
   bool is_done() const;
+  // error of the data source, no new parts are started after it
+  const td::Status &status() const {
+    return status_;
+  }
 
  private:
-  td::BufferSlice data_;
+  std::shared_ptr<OutboundDataSource> source_;
+  td::Status status_;
   std::map<td::uint32, Part> parts_;
   td::uint32 next_part_{0};
 
+  // parts of a blocking source: requested are [next_part_, next_read_), the read ones wait in ready_
+  td::uint32 next_read_{0};
+  std::vector<ReadRequest> read_requests_;
+  std::map<td::uint32, td::BufferSlice> ready_;
+
+  void start_part(td::BufferSlice data, const RldpSender::Config &config);
+
   static size_t part_size() {
     return 2000000;
   }
@@ -61,6 +61,7 @@ void RldpConnection::drop_limits(TransferId id) {
 
 void RldpConnection::on_inbound_completed(TransferId transfer_id, td::Timestamp now) {
   inbound_transfers_.erase(transfer_id);
+  receive_sinks_.erase(transfer_id);
   completed_set_.insert(transfer_id);
   completed_queue_.push(CompletedId{transfer_id, now.in(20)});
   while (completed_queue_.size() > 128 && completed_queue_.front().timeout.is_in_past(now)) {
@@ -78,11 +79,7 @@ td::Timestamp RldpConnection::loop_limits(td::Timestamp now) {
     } else {
       auto it = outbound_transfers_.find(limit->transfer_id);
       if (it != outbound_transfers_.end()) {
-        for (auto &part : it->second.parts(RldpSender::Config{})) {
-          in_flight_count_ -= part.second.sender.get_inflight_symbols_count();
-        }
-        outbound_transfers_.erase(it);
-        to_on_sent_.emplace_back(limit->transfer_id, std::move(error));
+        on_outbound_failed(it, std::move(error));
       } else {
         VLOG(RLDP_WARNING) << "Timeout on unknown transfer " << limit->transfer_id.to_hex();
       }
@@ -93,8 +90,17 @@ td::Timestamp RldpConnection::loop_limits(td::Timestamp now) {
   return next_limit_expires_at();
 }
 
+void RldpConnection::on_outbound_failed(std::map<TransferId, OutboundTransfer>::iterator it, td::Status error) {
+  for (auto &part : it->second.active_parts()) {
+    in_flight_count_ -= part.second.sender.get_inflight_symbols_count();
+  }
+  to_on_sent_.emplace_back(it->first, std::move(error));
+  outbound_transfers_.erase(it);
+}
+
 void RldpConnection::set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size) {
   CHECK(timeout);
+  drop_limits(transfer_id);
   Limit limit;
   limit.transfer_id = transfer_id;
   limit.max_size = max_size;
@@ -109,7 +115,48 @@ RldpConnection::RldpConnection() {
   bdw_stats_.windowed_max_bdw = 10;
 }
 
+void RldpConnection::set_receive_sink(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size,
+                                      std::unique_ptr<InboundDataSink> sink) {
+  CHECK(sink);
+  if (inbound_transfers_.count(transfer_id) || completed_set_.count(transfer_id)) {
+    // the transfer was started before the sink and is collected into a buffer
+    VLOG(RLDP_INFO) << "Transfer " << transfer_id.to_hex() << " started before its sink was attached";
+    if (inbound_transfers_.count(transfer_id)) {
+      drop_limits(transfer_id);
+      on_inbound_completed(transfer_id, td::Timestamp::now());
+    }
+    to_receive_.emplace_back(transfer_id,
+                             td::Status::Error(ErrorCode::error, "transfer started before the sink was attached"));
+    return;
+  }
+  set_receive_limits(transfer_id, timeout, max_size);
+  receive_sinks_[transfer_id] = std::move(sink);
+}
+
+std::vector<RldpConnection::PartRead> RldpConnection::take_part_reads() {
+  std::vector<PartRead> res;
+  for (auto &it : outbound_transfers_) {
+    for (auto &request : it.second.take_read_requests()) {
+      res.push_back(PartRead{it.first, it.second.source(), request.part_i, request.offset, request.size});
+    }
+  }
+  return res;
+}
+
+void RldpConnection::on_part_read(const PartRead &read, td::Result<td::BufferSlice> r_data) {
+  auto it = outbound_transfers_.find(read.transfer_id);
+  if (it == outbound_transfers_.end() || it->second.source() != read.source) {
+    return;
+  }
+  it->second.on_part_read(read.part_i, std::move(r_data));
+}
+
 void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Timestamp timeout) {
+  send(transfer_id, OutboundDataSource::from_buffer(std::move(data)), timeout);
+}
+
+void RldpConnection::send(TransferId transfer_id, std::unique_ptr<OutboundDataSource> source,
+                          td::Timestamp timeout) {
   if (transfer_id.is_zero()) {
     td::Random::secure_bytes(transfer_id.as_slice());
   } else {
@@ -126,7 +173,7 @@ void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Time
     limit.is_inbound = false;
     add_limit(timeout, limit);
   }
-  outbound_transfers_.emplace(transfer_id, OutboundTransfer{std::move(data)});
+  outbound_transfers_.emplace(transfer_id, OutboundTransfer{std::move(source)});
 }
 
 void RldpConnection::receive_raw(td::BufferSlice packet) {
@@ -154,8 +201,16 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
 
   td::Timestamp alarm_timestamp;
   td::VectorQueue<std::pair<const TransferId, OutboundTransfer> *> queue;
-  for (auto &outbound : outbound_transfers_) {
-    queue.push(&outbound);
+  for (auto it = outbound_transfers_.begin(); it != outbound_transfers_.end();) {
+    auto cur = it++;
+    // starts new parts, reading them from the data source
+    cur->second.parts(RldpSender::Config{});
+    if (cur->second.status().is_error()) {
+      drop_limits(cur->first);
+      on_outbound_failed(cur, cur->second.status().clone());
+      continue;
+    }
+    queue.push(&*cur);
   }
   while (!queue.empty()) {
     auto outbound = queue.pop();
@@ -302,7 +357,13 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
       // TODO: other party stil may ddos us with small transfers
       set_receive_limits(transfer_id, td::Timestamp::in(10), max_size);
     }
-    it = inbound_transfers_.emplace(transfer_id, InboundTransfer{total_size}).first;
+    auto sink_it = receive_sinks_.find(transfer_id);
+    if (sink_it != receive_sinks_.end()) {
+      it = inbound_transfers_.emplace(transfer_id, InboundTransfer{total_size, std::move(sink_it->second)}).first;
+      receive_sinks_.erase(sink_it);
+    } else {
+      it = inbound_transfers_.emplace(transfer_id, InboundTransfer{total_size}).first;
+    }
   }
 
   auto &inbound = it->second;
@@ -320,7 +381,7 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
       if (in_part->decoder->may_try_decode()) {
         auto r_data = in_part->decoder->try_decode(false);
         if (r_data.is_ok()) {
-          inbound.finish_part(part.part_, r_data.move_as_ok().data);
+          TRY_STATUS(inbound.finish_part(part.part_, r_data.move_as_ok().data));
         }
       }
     }
@@ -52,7 +52,24 @@ class RldpConnection {
   RldpConnection(RldpConnection &&other) = delete;
   RldpConnection &operator=(RldpConnection &&other) = delete;
   void send(TransferId tranfer_id, td::BufferSlice data, td::Timestamp timeout = td::Timestamp::never());
+  void send(TransferId tranfer_id, std::unique_ptr<OutboundDataSource> source,
+            td::Timestamp timeout = td::Timestamp::never());
   void set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size);
+  // the transfer is reported to ConnectionCallback::receive with an empty buffer; it fails if its parts came
+  // before the sink
+  void set_receive_sink(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size,
+                        std::unique_ptr<InboundDataSink> sink);
+
+  // parts of blocking data sources are read by the owner of the connection, the result goes to on_part_read
+  struct PartRead {
+    TransferId transfer_id;
+    std::shared_ptr<OutboundDataSource> source;
+    td::uint32 part_i;
+    td::uint64 offset;
+    size_t size;
+  };
+  std::vector<PartRead> take_part_reads();
+  void on_part_read(const PartRead &read, td::Result<td::BufferSlice> r_data);
 
   void receive_raw(td::BufferSlice packet);
 
@@ -71,6 +88,7 @@ class RldpConnection {
   std::map<TransferId, OutboundTransfer> outbound_transfers_;
   td::uint32 in_flight_count_{0};
   std::map<TransferId, InboundTransfer> inbound_transfers_;
+  std::map<TransferId, std::unique_ptr<InboundDataSink>> receive_sinks_;
 
   struct Limit : public td::HeapNode {
     TransferId transfer_id;
@@ -94,6 +112,7 @@ class RldpConnection {
   td::Timestamp next_limit_expires_at();
   void drop_limits(TransferId id);
   void on_inbound_completed(TransferId transfer_id, td::Timestamp now);
+  void on_outbound_failed(std::map<TransferId, OutboundTransfer>::iterator it, td::Status error);
   td::Timestamp loop_limits(td::Timestamp now);
 
   void loop_bbr(td::Timestamp now);
@@ -77,6 +77,12 @@ class RldpIn : public RldpImpl {
   void answer_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::Timestamp timeout,
                     adnl::AdnlQueryId query_id, TransferId transfer_id, td::BufferSlice data);
 
+  void send_stream(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, TransferId transfer_id, td::Timestamp timeout,
+                   std::unique_ptr<OutboundDataSource> source, td::Promise<td::Unit> promise) override;
+  void receive_stream(adnl::AdnlNodeIdShort local_id, adnl::AdnlNodeIdShort peer, TransferId transfer_id,
+                      td::Timestamp timeout, td::uint64 max_size, std::unique_ptr<InboundDataSink> sink,
+                      td::Promise<td::Unit> promise) override;
+
   void receive_message_part(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, td::BufferSlice data);
 
   void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
@@ -106,6 +112,8 @@ class RldpIn : public RldpImpl {
       connections_;
 
   std::map<TransferId, td::Promise<td::BufferSlice>> queries_;
+  std::map<TransferId, td::Promise<td::Unit>> sent_streams_;
+  std::map<TransferId, td::Promise<td::Unit>> received_streams_;
 
   std::set<adnl::AdnlNodeIdShort> local_ids_;
 
@@ -27,6 +27,25 @@ namespace ton {
 
 namespace rldp2 {
 
+// reads a part of a blocking data source outside of the connection actor
+class ReadDataSourcePart : public td::actor::Actor {
+ public:
+  ReadDataSourcePart(std::shared_ptr<OutboundDataSource> source, td::uint64 offset, size_t size,
+                     td::Promise<td::BufferSlice> promise)
+      : source_(std::move(source)), offset_(offset), size_(size), promise_(std::move(promise)) {
+  }
+  void start_up() override {
+    promise_.set_result(source_->read(offset_, size_));
+    stop();
+  }
+
+ private:
+  std::shared_ptr<OutboundDataSource> source_;
+  td::uint64 offset_;
+  size_t size_;
+  td::Promise<td::BufferSlice> promise_;
+};
+
 class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback {
  public:
   RldpConnectionActor(td::actor::ActorId<RldpIn> rldp, adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst,
@@ -37,9 +56,22 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
     connection_.send(transfer_id, std::move(query), timeout);
     yield();
   }
+  void send_stream(TransferId transfer_id, std::unique_ptr<OutboundDataSource> source, td::Timestamp timeout) {
+    connection_.send(transfer_id, std::move(source), timeout);
+    yield();
+  }
   void set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size) {
     connection_.set_receive_limits(transfer_id, timeout, max_size);
   }
+  void set_receive_sink(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size,
+                        std::unique_ptr<InboundDataSink> sink) {
+    connection_.set_receive_sink(transfer_id, timeout, max_size, std::move(sink));
+    yield();
+  }
+  void on_part_read(RldpConnection::PartRead read, td::Result<td::BufferSlice> r_data) {
+    connection_.on_part_read(read, std::move(r_data));
+    yield();
+  }
   void receive_raw(td::BufferSlice data) {
     connection_.receive_raw(std::move(data));
     yield();
@@ -57,6 +89,14 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
 
   void loop() override {
     alarm_timestamp() = connection_.run(*this);
+    for (auto &read : connection_.take_part_reads()) {
+      td::actor::create_actor<ReadDataSourcePart>(
+          "ReadDataSourcePart", read.source, read.offset, read.size,
+          [SelfId = actor_id(this), read](td::Result<td::BufferSlice> R) mutable {
+            td::actor::send_closure(SelfId, &RldpConnectionActor::on_part_read, std::move(read), std::move(R));
+          })
+          .release();
+    }
   }
 
   void send_raw(td::BufferSlice data) override {
@@ -121,6 +161,30 @@ void RldpIn::answer_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst,
   send_closure(create_connection(src, dst), &RldpConnectionActor::send, transfer_id, std::move(B), timeout);
 }
 
+void RldpIn::send_stream(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, TransferId transfer_id,
+                         td::Timestamp timeout, std::unique_ptr<OutboundDataSource> source,
+                         td::Promise<td::Unit> promise) {
+  if (transfer_id.is_zero() || sent_streams_.count(transfer_id)) {
+    promise.set_error(td::Status::Error(ErrorCode::error, "bad transfer id"));
+    return;
+  }
+  sent_streams_.emplace(transfer_id, std::move(promise));
+  send_closure(create_connection(src, dst), &RldpConnectionActor::send_stream, transfer_id, std::move(source),
+               timeout);
+}
+
+void RldpIn::receive_stream(adnl::AdnlNodeIdShort local_id, adnl::AdnlNodeIdShort peer, TransferId transfer_id,
+                            td::Timestamp timeout, td::uint64 max_size, std::unique_ptr<InboundDataSink> sink,
+                            td::Promise<td::Unit> promise) {
+  if (received_streams_.count(transfer_id)) {
+    promise.set_error(td::Status::Error(ErrorCode::error, "duplicate transfer id"));
+    return;
+  }
+  received_streams_.emplace(transfer_id, std::move(promise));
+  send_closure(create_connection(local_id, peer), &RldpConnectionActor::set_receive_sink, transfer_id, timeout,
+               max_size, std::move(sink));
+}
+
 void RldpIn::receive_message_part(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, td::BufferSlice data) {
   send_closure(create_connection(local_id, source), &RldpConnectionActor::receive_raw, std::move(data));
 }
@@ -142,6 +206,20 @@ td::actor::ActorId<RldpConnectionActor> RldpIn::create_connection(adnl::AdnlNode
 
 void RldpIn::receive_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                              td::Result<td::BufferSlice> r_data) {
+  auto stream_it = received_streams_.find(transfer_id);
+  if (stream_it != received_streams_.end()) {
+    // the data is already in the sink, unless the transfer was collected into a buffer before the sink came
+    if (r_data.is_ok() && !r_data.ok().empty()) {
+      r_data = td::Status::Error(ErrorCode::error, "transfer started before the sink was attached");
+    }
+    if (r_data.is_error()) {
+      stream_it->second.set_error(r_data.move_as_error());
+    } else {
+      stream_it->second.set_value(td::Unit());
+    }
+    received_streams_.erase(stream_it);
+    return;
+  }
   if (r_data.is_error()) {
     auto it = queries_.find(transfer_id);
     if (it != queries_.end()) {
@@ -206,6 +284,11 @@ void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort
 
 void RldpIn::on_sent(TransferId transfer_id, td::Result<td::Unit> state) {
   //TODO: completed transfer
+  auto it = sent_streams_.find(transfer_id);
+  if (it != sent_streams_.end()) {
+    it->second.set_result(std::move(state));
+    sent_streams_.erase(it);
+  }
 }
 
 void RldpIn::add_id(adnl::AdnlNodeIdShort local_id) {
@@ -20,6 +20,8 @@
 
 #include "adnl/adnl.h"
 
+#include "DataStream.h"
+
 namespace ton {
 
 namespace rldp2 {
@@ -39,6 +41,17 @@ class Rldp : public adnl::AdnlSenderInterface {
 
   virtual void set_default_mtu(td::uint64 mtu) = 0;
 
+  // Streaming transfers carry raw data (not rldp.message), so the receiver must expect transfer_id in advance.
+  // The sender reads source part by part; promise is set when the peer has received everything.
+  virtual void send_stream(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::Bits256 transfer_id,
+                           td::Timestamp timeout, std::unique_ptr<OutboundDataSource> source,
+                           td::Promise<td::Unit> promise) = 0;
+  // Decoded data is appended to sink in order as it arrives; promise is set when the transfer is complete.
+  // Must be called before the sender starts: a transfer whose parts came before the sink fails
+  virtual void receive_stream(adnl::AdnlNodeIdShort local_id, adnl::AdnlNodeIdShort peer, td::Bits256 transfer_id,
+                              td::Timestamp timeout, td::uint64 max_size, std::unique_ptr<InboundDataSink> sink,
+                              td::Promise<td::Unit> promise) = 0;
+
   static td::actor::ActorOwn<Rldp> create(td::actor::ActorId<adnl::Adnl> adnl);
 };
 
@@ -852,17 +852,18 @@ void NodeActor::db_update_pieces_list() {
 
 void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, td::unique_ptr<Callback> callback,
                              td::unique_ptr<NodeCallback> node_callback, SpeedLimiters speed_limiters,
-                             td::Promise<td::actor::ActorOwn<NodeActor>> promise) {
+                             td::uint32 validate_threads, td::Promise<td::actor::ActorOwn<NodeActor>> promise) {
   class Loader : public td::actor::Actor {
    public:
     Loader(std::shared_ptr<db::DbType> db, td::Bits256 hash, td::unique_ptr<Callback> callback,
-           td::unique_ptr<NodeCallback> node_callback, SpeedLimiters speed_limiters,
+           td::unique_ptr<NodeCallback> node_callback, SpeedLimiters speed_limiters, td::uint32 validate_threads,
            td::Promise<td::actor::ActorOwn<NodeActor>> promise)
         : db_(std::move(db))
         , hash_(hash)
         , callback_(std::move(callback))
         , node_callback_(std::move(node_callback))
         , speed_limiters_(std::move(speed_limiters))
+        , validate_threads_(validate_threads)
         , promise_(std::move(promise)) {
     }
 
@@ -921,6 +922,7 @@ void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, t
         if (meta_str) {
           TRY_RESULT(meta, TorrentMeta::deserialize(meta_str.value().as_slice()));
           options.validate = true;
+          options.validate_threads = validate_threads_;
           return Torrent::open(std::move(options), std::move(meta));
         } else {
           return Torrent::open(std::move(options), hash_);
@@ -1032,6 +1034,7 @@ void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, t
     td::unique_ptr<Callback> callback_;
     td::unique_ptr<NodeCallback> node_callback_;
     SpeedLimiters speed_limiters_;
+    td::uint32 validate_threads_;
     td::Promise<td::actor::ActorOwn<NodeActor>> promise_;
 
     std::string root_dir_;
@@ -1044,7 +1047,7 @@ void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, t
     size_t remaining_pieces_in_db_ = 0;
   };
   td::actor::create_actor<Loader>("loader", std::move(db), hash, std::move(callback), std::move(node_callback),
-                                  std::move(speed_limiters), std::move(promise))
+                                  std::move(speed_limiters), validate_threads, std::move(promise))
       .release();
 }
 
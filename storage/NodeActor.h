@@ -103,7 +103,7 @@ class NodeActor : public td::actor::Actor {
 
   static void load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, td::unique_ptr<Callback> callback,
                            td::unique_ptr<NodeCallback> node_callback, SpeedLimiters speed_limiters,
-                           td::Promise<td::actor::ActorOwn<NodeActor>> promise);
+                           td::uint32 validate_threads, td::Promise<td::actor::ActorOwn<NodeActor>> promise);
   static void cleanup_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, td::Promise<td::Unit> promise);
 
  private:
@@ -0,0 +1,71 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PieceHasher.h"
+
+#include "td/utils/crypto.h"
+#include "td/utils/port/thread.h"
+
+#include <atomic>
+
+namespace ton {
+
+std::vector<td::optional<td::Bits256>> PieceHasher::run(const Options &options, td::uint64 pieces_count,
+                                                        ReadPiece read_piece) {
+  CHECK(options.piece_size > 0);
+  std::vector<td::optional<td::Bits256>> result(static_cast<size_t>(pieces_count));
+  td::uint64 batch = td::max<td::uint64>(1, options.batch_size / options.piece_size);
+  td::uint64 batches_count = (pieces_count + batch - 1) / batch;
+  size_t threads = static_cast<size_t>(td::max<td::uint64>(1, td::min<td::uint64>(options.threads, batches_count)));
+
+  std::atomic<td::uint64> next_batch{0};
+  auto worker = [&](size_t thread_id) {
+    td::BufferSlice buf(options.piece_size);
+    while (true) {
+      td::uint64 batch_i = next_batch.fetch_add(1, std::memory_order_relaxed);
+      if (batch_i >= batches_count) {
+        break;
+      }
+      td::uint64 end = td::min(pieces_count, (batch_i + 1) * batch);
+      for (td::uint64 piece_i = batch_i * batch; piece_i < end; piece_i++) {
+        auto r_size = read_piece(thread_id, piece_i, buf.as_slice());
+        if (r_size.is_error()) {
+          continue;
+        }
+        // each thread writes only the entries of its own batches
+        td::Bits256 hash;
+        td::sha256(buf.as_slice().truncate(r_size.ok()), hash.as_slice());
+        result[static_cast<size_t>(piece_i)] = hash;
+      }
+    }
+  };
+
+  if (threads == 1) {
+    worker(0);
+    return result;
+  }
+  std::vector<td::thread> workers;
+  for (size_t i = 0; i < threads; i++) {
+    workers.emplace_back(worker, i);
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+  return result;
+}
+
+}  // namespace ton
@@ -0,0 +1,52 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "common/bitstring.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/optional.h"
+#include "td/utils/Status.h"
+
+#include <functional>
+#include <vector>
+
+namespace ton {
+
+// Computes SHA-256 of pieces [0, pieces_count) on several threads.
+// Each thread takes a batch of consecutive pieces at a time, so reads within a batch stay sequential and up to
+// `threads` batches are read ahead in parallel. With one thread everything runs in the calling thread.
+class PieceHasher {
+ public:
+  struct Options {
+    size_t threads = 1;
+    td::uint32 piece_size = 0;
+    // bytes of consecutive pieces one thread reads at a time
+    td::uint64 batch_size = 8 << 20;
+  };
+
+  // Reads the piece into dest (piece_size bytes, the last piece may be shorter) and returns the size read.
+  // Called concurrently, thread_id is in [0, threads) and may be used to keep per-thread state.
+  using ReadPiece = std::function<td::Result<size_t>(size_t thread_id, td::uint64 piece_i, td::MutableSlice dest)>;
+
+  // Pieces that failed to be read are left empty
+  static std::vector<td::optional<td::Bits256>> run(const Options &options, td::uint64 pieces_count,
+                                                    ReadPiece read_piece);
+};
+
+}  // namespace ton
@@ -18,6 +18,7 @@
 */
 
 #include "Torrent.h"
+#include "PieceHasher.h"
 
 #include "td/utils/Status.h"
 #include "td/utils/crypto.h"
@@ -54,7 +55,7 @@ td::Result<Torrent> Torrent::open(Options options, TorrentMeta meta) {
     res.set_root_dir(options.root_dir);
   }
   if (options.validate) {
-    res.validate();
+    res.validate(options.validate_threads);
   }
   return std::move(res);
 }
@@ -189,7 +190,7 @@ std::string Torrent::get_stats_str() const {
   return sb.as_cslice().str();
 }
 
-void Torrent::validate() {
+void Torrent::validate(td::uint32 threads) {
   if (!inited_info_ || !header_) {
     return;
   }
@@ -230,34 +231,41 @@ void Torrent::validate() {
     pieces.clear();
   };
 
-  td::BufferSlice buf(info_.piece_size);
-  ChunkState::Cache cache;
-  cache.slice = td::BufferSlice(td::max(8u << 20, info_.piece_size));
-  for (size_t piece_i = 0; piece_i < info_.pieces_count(); piece_i++) {
-    auto piece = info_.get_piece_info(piece_i);
-    td::Sha256State sha256;
-    sha256.init();
-    bool skipped = false;
-    auto is_ok = iterate_piece(piece, [&](auto it, auto info) {
-      if (!it->data) {
-        skipped = true;
-        return td::Status::Error("No such file");
-      }
-      if (!it->has_piece(info.chunk_offset, info.size)) {
-        return td::Status::Error("Don't have piece");
-      }
-      auto dest = buf.as_slice().truncate(info.size);
-      TRY_STATUS(it->get_piece(dest, info.chunk_offset, &cache));
-      sha256.feed(dest);
-      return td::Status::OK();
-    });
-    if (is_ok.is_error()) {
-      LOG_IF(ERROR, !skipped) << "Failed: " << is_ok;
-      continue;
+  // chunks are only read here, every thread has its own read cache
+  std::vector<ChunkState::Cache> caches(td::max<td::uint32>(threads, 1));
+  for (auto &cache : caches) {
+    cache.slice = td::BufferSlice(td::max(8u << 20, info_.piece_size));
+  }
+  PieceHasher::Options hasher_options;
+  hasher_options.threads = threads;
+  hasher_options.piece_size = info_.piece_size;
+  hasher_options.batch_size = caches[0].slice.size();
+  auto piece_hashes = PieceHasher::run(
+      hasher_options, info_.pieces_count(),
+      [&](size_t thread_id, td::uint64 piece_i, td::MutableSlice dest) -> td::Result<size_t> {
+        auto piece = info_.get_piece_info(piece_i);
+        bool skipped = false;
+        auto is_ok = iterate_piece(piece, [&](auto it, auto info) {
+          if (!it->data) {
+            skipped = true;
+            return td::Status::Error("No such file");
+          }
+          if (!it->has_piece(info.chunk_offset, info.size)) {
+            return td::Status::Error("Don't have piece");
+          }
+          TRY_STATUS(it->get_piece(dest.substr(info.piece_offset, info.size), info.chunk_offset, &caches[thread_id]));
+          return td::Status::OK();
+        });
+        if (is_ok.is_error()) {
+          LOG_IF(ERROR, !skipped) << "Failed: " << is_ok;
+          return std::move(is_ok);
+        }
+        return piece.size;
+      });
+  for (size_t piece_i = 0; piece_i < piece_hashes.size(); piece_i++) {
+    if (piece_hashes[piece_i]) {
+      pieces.emplace_back(piece_i, piece_hashes[piece_i].value());
     }
-    td::Bits256 hash;
-    sha256.extract(hash.as_slice());
-    pieces.emplace_back(piece_i, hash);
   }
   flush();
 }
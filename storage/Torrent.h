@@ -38,13 +38,15 @@ class Torrent {
     std::string root_dir;
     bool in_memory{false};
     bool validate{false};
+    // threads reading and hashing pieces during validation
+    td::uint32 validate_threads{1};
   };
 
   // creation
   static td::Result<Torrent> open(Options options, td::Bits256 hash);
   static td::Result<Torrent> open(Options options, TorrentMeta meta);
   static td::Result<Torrent> open(Options options, td::Slice meta_str);
-  void validate();
+  void validate(td::uint32 threads = 1);
 
   std::string get_stats_str() const;
 
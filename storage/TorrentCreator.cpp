@@ -18,8 +18,7 @@
 */
 
 #include "TorrentCreator.h"
-
-#include "td/db/utils/CyclicBuffer.h"
+#include "PieceHasher.h"
 
 #include "td/utils/crypto.h"
 #include "td/utils/PathView.h"
@@ -28,6 +27,9 @@
 #include "MicrochunkTree.h"
 #include "TorrentHeader.hpp"
 
+#include <algorithm>
+#include <mutex>
+
 namespace ton {
 static bool is_dir_slash(char c) {
   return (c == TD_DIR_SLASH) | (c == '/');
@@ -135,49 +137,12 @@ td::Result<Torrent> Torrent::Creator::finalize() {
     header.dir_name = options_.dir_name.value();
   }
 
-  // Now we should stream all data to calculate sha256 of all pieces
-
-  std::string buffer;
-  td::CyclicBuffer::Options cb_options;
-  cb_options.chunk_size = td::max(options_.piece_size * 16, (1 << 20) / options_.piece_size * options_.piece_size);
-  cb_options.count = 2;
-
-  auto reader_writer = td::CyclicBuffer::create(cb_options);
-  auto reader = std::move(reader_writer.first);
-  auto writer = std::move(reader_writer.second);
-
   auto header_size = header.serialization_size();
   auto file_size = header_size + data_offset;
   auto pieces_count = (file_size + options_.piece_size - 1) / options_.piece_size;
   std::vector<Torrent::ChunkState> chunks;
-  std::vector<td::Bits256> pieces;
-  auto flush_reader = [&](bool force) {
-    while (true) {
-      auto slice = reader.prepare_read();
-      slice.truncate(options_.piece_size);
-      if (slice.empty() || (slice.size() != options_.piece_size && !force)) {
-        break;
-      }
-      td::Bits256 hash;
-      sha256(slice, hash.as_slice());
-      pieces.push_back(hash);
-      reader.confirm_read(slice.size());
-    }
-  };
   td::uint64 offset = 0;
-  auto add_blob = [&](auto data, td::Slice name) {
-    td::uint64 data_offset = 0;
-    while (data_offset < data.size()) {
-      auto dest = writer.prepare_write();
-      CHECK(dest.size() != 0);
-      dest.truncate(data.size() - data_offset);
-      TRY_RESULT(got_size, data.view_copy(dest, data_offset));
-      CHECK(got_size != 0);
-      data_offset += got_size;
-      writer.confirm_write(got_size);
-      flush_reader(false);
-    }
-
+  auto add_blob = [&](td::BlobView data, td::Slice name) {
     Torrent::ChunkState chunk;
     chunk.name = name.str();
     chunk.offset = offset;
@@ -187,7 +152,6 @@ td::Result<Torrent> Torrent::Creator::finalize() {
 
     offset += chunk.size;
     chunks.push_back(std::move(chunk));
-    return td::Status::OK();
   };
 
   Torrent::Info info;
@@ -196,13 +160,62 @@ td::Result<Torrent> Torrent::Creator::finalize() {
   info.header_size = header_str.size();
   td::sha256(header_str, info.header_hash.as_slice());
 
-  add_blob(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "").ensure();
+  add_blob(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "");
   for (auto& file : files_) {
-    add_blob(std::move(file.data), file.name).ensure();
+    add_blob(std::move(file.data), file.name);
   }
-  flush_reader(true);
-  CHECK(pieces.size() == pieces_count);
   CHECK(offset == file_size);
+
+  // Now we should read all data to calculate sha256 of all pieces
+  PieceHasher::Options hasher_options;
+  hasher_options.threads = options_.threads;
+  hasher_options.piece_size = options_.piece_size;
+  td::Status read_error;
+  std::mutex read_error_mutex;
+  auto hashes = PieceHasher::run(
+      hasher_options, pieces_count,
+      [&](size_t thread_id, td::uint64 piece_i, td::MutableSlice dest) -> td::Result<size_t> {
+        auto piece_offset = piece_i * options_.piece_size;
+        dest.truncate(td::min<td::uint64>(options_.piece_size, file_size - piece_offset));
+        auto status = [&]() -> td::Status {
+          // first chunk that ends after piece_offset
+          auto it = std::upper_bound(chunks.begin(), chunks.end(), piece_offset,
+                                     [](td::uint64 x, const Torrent::ChunkState& chunk) {
+                                       return x < chunk.offset + chunk.size;
+                                     });
+          size_t done = 0;
+          while (done < dest.size()) {
+            CHECK(it != chunks.end());
+            auto chunk_offset = piece_offset + done - it->offset;
+            auto part = dest.substr(done).truncate(it->size - chunk_offset);
+            while (!part.empty()) {
+              TRY_RESULT(got_size, it->data.view_copy(part, chunk_offset));
+              if (got_size == 0) {
+                return td::Status::Error(PSLICE() << "Failed to read file " << it->name);
+              }
+              part.remove_prefix(got_size);
+              chunk_offset += got_size;
+              done += got_size;
+            }
+            ++it;
+          }
+          return td::Status::OK();
+        }();
+        if (status.is_error()) {
+          std::lock_guard<std::mutex> guard(read_error_mutex);
+          if (read_error.is_ok()) {
+            read_error = std::move(status);
+          }
+          return td::Status::Error();
+        }
+        return dest.size();
+      });
+  TRY_STATUS(std::move(read_error));
+  std::vector<td::Bits256> pieces;
+  pieces.reserve(hashes.size());
+  for (auto& hash : hashes) {
+    pieces.push_back(hash.value());
+  }
   MerkleTree tree(std::move(pieces));
 
   info.header_size = header.serialization_size();
@@ -0,0 +1,96 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/benchmark.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Random.h"
+
+#include "Torrent.h"
+#include "TorrentCreator.h"
+
+class TorrentHashBench : public td::Benchmark {
+ public:
+  TorrentHashBench(td::uint32 threads, bool validate) : threads_(threads), validate_(validate) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << (validate_ ? "Torrent::validate" : "Torrent::Creator") << " 16MB, threads=" << threads_;
+  }
+  void start_up() override {
+    td::rmrf("bench_hash").ignore();
+    td::mkdir("bench_hash").ensure();
+    td::Random::Xorshift128plus rnd(123);
+    for (int i = 0; i < 4; i++) {
+      std::string data(4 << 20, '\0');
+      for (auto &c : data) {
+        c = static_cast<char>(rnd() & 0xff);
+      }
+      td::write_file(PSLICE() << "bench_hash/" << i, data).ensure();
+    }
+    meta_ = create(1).get_meta_str();
+  }
+  void tear_down() override {
+    td::rmrf("bench_hash").ignore();
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      if (validate_) {
+        ton::Torrent::Options options;
+        options.root_dir = ".";
+        options.validate = true;
+        options.validate_threads = threads_;
+        auto torrent = ton::Torrent::open(options, meta_).move_as_ok();
+        CHECK(torrent.get_ready_parts_count() == torrent.get_info().pieces_count());
+      } else {
+        create(threads_);
+      }
+    }
+  }
+
+ private:
+  td::uint32 threads_;
+  bool validate_;
+  std::string meta_;
+
+  ton::Torrent create(td::uint32 threads) {
+    ton::Torrent::Creator::Options options;
+    options.piece_size = 128 * 1024;
+    options.threads = threads;
+    return ton::Torrent::Creator::create_from_path(options, "bench_hash").move_as_ok();
+  }
+};
+
+int main(void) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  for (td::uint32 threads : {1, 2, 4, 8}) {
+    td::bench(TorrentHashBench(threads, false));
+    td::bench(TorrentHashBench(threads, true));
+  }
+  return 0;
+}
@@ -30,14 +30,16 @@ static overlay::OverlayIdFull get_overlay_id(td::Bits256 hash) {
 
 StorageManager::StorageManager(adnl::AdnlNodeIdShort local_id, std::string db_root, td::unique_ptr<Callback> callback,
                                bool client_mode, td::actor::ActorId<adnl::Adnl> adnl,
-                               td::actor::ActorId<ton_rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays)
+                               td::actor::ActorId<ton_rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays,
+                               td::uint32 validate_threads)
     : local_id_(local_id)
     , db_root_(std::move(db_root))
     , callback_(std::move(callback))
     , client_mode_(client_mode)
     , adnl_(std::move(adnl))
     , rldp_(std::move(rldp))
-    , overlays_(std::move(overlays)) {
+    , overlays_(std::move(overlays))
+    , validate_threads_(validate_threads) {
 }
 
 void StorageManager::start_up() {
@@ -102,7 +104,7 @@ void StorageManager::load_torrents_from_db(std::vector<td::Bits256> torrents) {
                                                               client_mode_, overlays_, adnl_, rldp_);
     NodeActor::load_from_db(
         db_, hash, create_callback(hash, entry.closing_state), PeerManager::create_callback(entry.peer_manager.get()),
-        SpeedLimiters{download_speed_limiter_.get(), upload_speed_limiter_.get()},
+        SpeedLimiters{download_speed_limiter_.get(), upload_speed_limiter_.get()}, validate_threads_,
         [SelfId = actor_id(this), hash,
          promise = ig.get_promise()](td::Result<td::actor::ActorOwn<NodeActor>> R) mutable {
           td::actor::send_closure(SelfId, &StorageManager::loaded_torrent_from_db, hash, std::move(R));
@@ -36,7 +36,7 @@ class StorageManager : public td::actor::Actor {
 
   StorageManager(adnl::AdnlNodeIdShort local_id, std::string db_root, td::unique_ptr<Callback> callback,
                  bool client_mode, td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<ton_rldp::Rldp> rldp,
-                 td::actor::ActorId<overlay::Overlays> overlays);
+                 td::actor::ActorId<overlay::Overlays> overlays, td::uint32 validate_threads = 1);
 
   void start_up() override;
 
@@ -76,6 +76,7 @@ class StorageManager : public td::actor::Actor {
   td::actor::ActorId<adnl::Adnl> adnl_;
   td::actor::ActorId<ton_rldp::Rldp> rldp_;
   td::actor::ActorId<overlay::Overlays> overlays_;
+  td::uint32 validate_threads_;
 
   std::shared_ptr<db::DbType> db_;
 
@@ -57,13 +57,14 @@ td::BufferSlice create_query_error(td::Status error) {
 class StorageDaemon : public td::actor::Actor {
  public:
   StorageDaemon(td::IPAddress ip_addr, bool client_mode, std::string global_config, std::string db_root,
-                td::uint16 control_port, bool enable_storage_provider)
+                td::uint16 control_port, bool enable_storage_provider, td::uint32 hash_threads)
       : ip_addr_(ip_addr)
       , client_mode_(client_mode)
       , global_config_(std::move(global_config))
       , db_root_(std::move(db_root))
       , control_port_(control_port)
-      , enable_storage_provider_(enable_storage_provider) {
+      , enable_storage_provider_(enable_storage_provider)
+      , hash_threads_(hash_threads) {
   }
 
   void start_up() override {
@@ -99,7 +100,7 @@ class StorageDaemon : public td::actor::Actor {
     };
     manager_ = td::actor::create_actor<StorageManager>("storage", local_id_, db_root_ + "/torrent",
                                                        td::make_unique<Callback>(actor_id(this)), client_mode_,
-                                                       adnl_.get(), rldp_.get(), overlays_.get());
+                                                       adnl_.get(), rldp_.get(), overlays_.get(), hash_threads_);
   }
 
   td::Status load_global_config() {
@@ -289,10 +290,11 @@ class StorageDaemon : public td::actor::Actor {
   void run_control_query(ton_api::storage_daemon_createTorrent &query, td::Promise<td::BufferSlice> promise) {
     // Run in a separate thread
     delay_action(
-        [promise = std::move(promise), manager = manager_.get(), db_root = db_root_,
+        [promise = std::move(promise), manager = manager_.get(), db_root = db_root_, hash_threads = hash_threads_,
          query = std::move(query)]() mutable {
           Torrent::Creator::Options options;
           options.piece_size = 128 * 1024;
+          options.threads = hash_threads;
           options.description = std::move(query.description_);
           TRY_RESULT_PROMISE(promise, torrent, Torrent::Creator::create_from_path(std::move(options), query.path_));
           td::Bits256 hash = torrent.get_hash();
@@ -901,6 +903,7 @@ class StorageDaemon : public td::actor::Actor {
   std::string db_root_;
   td::uint16 control_port_;
   bool enable_storage_provider_;
+  td::uint32 hash_threads_;
 
   tl_object_ptr<ton_api::storage_daemon_config> daemon_config_;
   std::shared_ptr<dht::DhtGlobalConfig> dht_config_;
@@ -956,6 +959,7 @@ int main(int argc, char *argv[]) {
   std::string global_config, db_root;
   td::uint16 control_port = 0;
   bool enable_storage_provider = false;
+  td::uint32 hash_threads = 1;
 
   td::OptionParser p;
   p.set_description("Server for seeding and downloading bags of files (torrents)\n");
@@ -1009,13 +1013,22 @@ int main(int argc, char *argv[]) {
     td::log_interface = logger_.get();
   });
   p.add_option('P', "storage-provider", "run storage provider", [&]() { enable_storage_provider = true; });
+  p.add_checked_option('H', "hash-threads",
+                       "number of threads reading and hashing pieces when creating and validating bags (default: 1)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(hash_threads, td::to_integer_safe<td::uint32>(arg));
+                         if (hash_threads == 0 || hash_threads > 64) {
+                           return td::Status::Error("hash-threads should be in range [1..64]");
+                         }
+                         return td::Status::OK();
+                       });
 
   td::actor::Scheduler scheduler({7});
 
   scheduler.run_in_context([&] {
     p.run(argc, argv).ensure();
     td::actor::create_actor<ton::StorageDaemon>("storage-daemon", ip_addr, client_mode, global_config, db_root,
-                                                control_port, enable_storage_provider)
+                                                control_port, enable_storage_provider, hash_threads)
         .release();
   });
   while (scheduler.run(1)) {
@@ -1045,6 +1045,45 @@ TEST(Torrent, OneFile) {
   }
 };
 
+TEST(Torrent, ParallelHashing) {
+  td::rmrf("hashing").ignore();
+  td::mkdir("hashing").ensure();
+  td::Random::Xorshift128plus rnd(123);
+  for (int i = 0; i < 20; i++) {
+    std::string data(static_cast<size_t>(rnd.fast(1, 100000)), '\0');
+    for (auto &c : data) {
+      c = static_cast<char>(rnd() & 0xff);
+    }
+    td::write_file(PSLICE() << "hashing/" << i, data).ensure();
+  }
+
+  ton::Torrent::Creator::Options options;
+  options.piece_size = 1024;
+  auto torrent = ton::Torrent::Creator::create_from_path(options, "hashing").move_as_ok();
+  auto meta = torrent.get_meta_str();
+  auto validate = [&](td::uint32 threads) {
+    ton::Torrent::Options open_options;
+    open_options.root_dir = ".";
+    open_options.validate = true;
+    open_options.validate_threads = threads;
+    return ton::Torrent::open(open_options, meta).move_as_ok().get_ready_parts_count();
+  };
+  for (td::uint32 threads : {2, 3, 8}) {
+    options.threads = threads;
+    auto other = ton::Torrent::Creator::create_from_path(options, "hashing").move_as_ok();
+    CHECK(torrent.get_hash() == other.get_hash());
+    ASSERT_EQ(torrent.get_info().pieces_count(), validate(threads));
+  }
+
+  // a corrupted piece is not accepted, the other ones are
+  auto data = td::read_file_str("hashing/7").move_as_ok();
+  data[data.size() / 2]++;
+  td::write_file("hashing/7", data).ensure();
+  ASSERT_EQ(torrent.get_info().pieces_count() - 1, validate(1));
+  ASSERT_EQ(torrent.get_info().pieces_count() - 1, validate(4));
+  td::rmrf("hashing").ignore();
+}
+
 TEST(Torrent, PartsHelper) {
   int parts_count = 100;
   ton::PartsHelper parts(parts_count);
@@ -44,6 +44,7 @@ extern "C" {
 
 #include "td/actor/core/ActorLocker.h"
 #include "td/actor/actor.h"
+#include "td/actor/TaskGroup.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/crypto.h"
@@ -653,6 +654,42 @@ class BlockSha256Actors {
   }
 };
 
+class BlockSha256ParallelFor {
+ public:
+  static std::string get_description() {
+    return "ParallelFor";
+  }
+  template <class Iterator, class F>
+  static void parallel_map(Iterator begin, Iterator end, F &&f) {
+    auto threads_count = std::max(td::thread::hardware_concurrency(), 1u) * 2;
+    using namespace td::actor;
+    Scheduler scheduler({threads_count});
+
+    scheduler.run_in_context([&] {
+      td::actor::ParallelForOptions options;
+      options.grain_size = 64;
+      td::actor::parallel_for(
+          0, static_cast<size_t>(end - begin),
+          [&](size_t chunk_begin, size_t chunk_end) {
+            for (auto it = begin + chunk_begin; it != begin + chunk_end; it++) {
+              f(*it);
+            }
+            return td::Status::OK();
+          },
+          [](td::Result<td::Unit> R) {
+            R.ensure();
+            td::actor::SchedulerContext::get()->stop();
+          },
+          std::move(options));
+    });
+    scheduler.run();
+  }
+  static void calc_hash(Block &block) {
+    parallel_map(block.cells.begin(), block.cells.end(),
+                 [](Cell &cell) { td::sha256(cell.data, as_slice(cell.hash)); });
+  }
+};
+
 class ActorLockerBenchmark : public td::Benchmark {
  public:
   explicit ActorLockerBenchmark(int threads_n) : threads_n_(threads_n) {
@@ -1686,6 +1723,7 @@ int main(int argc, char **argv) {
   bench(ActorQuery());
   bench(ActorTaskQuery());
   bench(CalcHashSha256Benchmark<BlockSha256Actors>());
+  bench(CalcHashSha256Benchmark<BlockSha256ParallelFor>());
   bench(CalcHashSha256Benchmark<BlockSha256Threads>());
   bench(CalcHashSha256Benchmark<BlockSha256Baseline>());
   bench(ActorLockerBenchmark(1));
@@ -0,0 +1,195 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/actor/TaskGroup.h"
+
+#include "td/actor/actor.h"
+
+#include <mutex>
+
+namespace td {
+namespace actor {
+namespace detail {
+
+StealingRanges::StealingRanges(size_t chunks, size_t runners) : ranges_(runners) {
+  CHECK(runners > 0);
+  CHECK(chunks < (static_cast<uint64>(1) << 32));
+  for (size_t i = 0; i < runners; i++) {
+    ranges_[i].value.store(pack(chunks * i / runners, chunks * (i + 1) / runners), std::memory_order_relaxed);
+  }
+}
+
+bool StealingRanges::pop(size_t runner, size_t &chunk) {
+  auto &range = ranges_[runner].value;
+  auto value = range.load(std::memory_order_acquire);
+  while (true) {
+    auto begin = value >> 32, end = value & 0xffffffff;
+    if (begin >= end) {
+      return steal(runner, chunk);
+    }
+    if (range.compare_exchange_weak(value, pack(begin + 1, end), std::memory_order_acq_rel)) {
+      chunk = static_cast<size_t>(begin);
+      return true;
+    }
+  }
+}
+
+bool StealingRanges::steal(size_t runner, size_t &chunk) {
+  while (true) {
+    size_t victim = 0;
+    uint64 victim_value = 0, victim_size = 0;
+    for (size_t i = 1; i < ranges_.size(); i++) {
+      auto pos = (runner + i) % ranges_.size();
+      auto value = ranges_[pos].value.load(std::memory_order_acquire);
+      auto begin = value >> 32, end = value & 0xffffffff;
+      if (begin < end && end - begin > victim_size) {
+        victim = pos;
+        victim_value = value;
+        victim_size = end - begin;
+      }
+    }
+    if (victim_size == 0) {
+      return false;
+    }
+    auto begin = victim_value >> 32, end = victim_value & 0xffffffff;
+    auto mid = begin + (end - begin) / 2;
+    // chunks are handed out only once, so a range value never repeats and there is no ABA problem
+    if (ranges_[victim].value.compare_exchange_strong(victim_value, pack(begin, mid), std::memory_order_acq_rel)) {
+      chunk = static_cast<size_t>(mid);
+      ranges_[runner].value.store(pack(mid + 1, end), std::memory_order_release);
+      return true;
+    }
+  }
+}
+
+class ParallelForState {
+ public:
+  ParallelForState(size_t begin, size_t end, size_t chunks, size_t runners, ParallelForOptions options,
+                   std::function<Status(size_t, size_t)> f, Promise<Unit> promise)
+      : begin_(begin)
+      , end_(end)
+      , grain_size_(options.grain_size)
+      , cancellation_token_(std::move(options.cancellation_token))
+      , f_(std::move(f))
+      , ranges_(chunks, runners)
+      , active_runners_(runners)
+      , promise_(std::move(promise)) {
+  }
+
+  void run(size_t runner) {
+    size_t chunk;
+    while (!failed_.load(std::memory_order_relaxed) && ranges_.pop(runner, chunk)) {
+      if (cancellation_token_) {
+        on_error(cancellation_token_.check());
+        break;
+      }
+      auto chunk_begin = begin_ + chunk * grain_size_;
+      auto status = f_(chunk_begin, std::min(end_, chunk_begin + grain_size_));
+      if (status.is_error()) {
+        on_error(std::move(status));
+        break;
+      }
+    }
+    if (active_runners_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (error_.is_error()) {
+        promise_.set_error(std::move(error_));
+      } else {
+        promise_.set_value(Unit());
+      }
+    }
+  }
+
+ private:
+  size_t begin_;
+  size_t end_;
+  size_t grain_size_;
+  CancellationToken cancellation_token_;
+  std::function<Status(size_t, size_t)> f_;
+  StealingRanges ranges_;
+
+  std::atomic<bool> failed_{false};
+  std::mutex mutex_;
+  Status error_;
+  std::atomic<size_t> active_runners_;
+  Promise<Unit> promise_;
+
+  void on_error(Status status) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (error_.is_ok()) {
+      error_ = std::move(status);
+      failed_.store(true, std::memory_order_relaxed);
+    }
+  }
+};
+
+class ParallelForRunner : public Actor {
+ public:
+  ParallelForRunner(std::shared_ptr<ParallelForState> state, size_t runner)
+      : state_(std::move(state)), runner_(runner) {
+  }
+  void start_up() override {
+    state_->run(runner_);
+    stop();
+  }
+
+ private:
+  std::shared_ptr<ParallelForState> state_;
+  size_t runner_;
+};
+
+}  // namespace detail
+
+void parallel_for(size_t begin, size_t end, std::function<Status(size_t, size_t)> f, Promise<Unit> promise,
+                  ParallelForOptions options) {
+  if (begin >= end) {
+    promise.set_value(Unit());
+    return;
+  }
+  if (options.grain_size == 0) {
+    options.grain_size = 1;
+  }
+  size_t chunks = (end - begin + options.grain_size - 1) / options.grain_size;
+  size_t runners = options.max_runners;
+  if (runners == 0) {
+    runners = std::max<size_t>(SchedulerContext::get()->get_cpu_threads_count(), 1);
+  }
+  runners = std::min(runners, chunks);
+  auto state = std::make_shared<detail::ParallelForState>(begin, end, chunks, runners, std::move(options),
+                                                          std::move(f), std::move(promise));
+  for (size_t i = 0; i < runners; i++) {
+    create_actor<detail::ParallelForRunner>("parallel_for", state, i).release();
+  }
+}
+
+void TaskGroup::join(Promise<Unit> promise, size_t max_runners) {
+  auto tasks = std::make_shared<std::vector<std::function<Status()>>>(std::move(tasks_));
+  tasks_.clear();
+  ParallelForOptions options;
+  options.max_runners = max_runners;
+  options.cancellation_token = cancellation_token_;
+  parallel_for(
+      0, tasks->size(),
+      [tasks](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          TRY_STATUS((*tasks)[i]());
+        }
+        return Status::OK();
+      },
+      std::move(promise), std::move(options));
+}
+
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,101 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/actor/PromiseFuture.h"
+
+#include "td/utils/CancellationToken.h"
+#include "td/utils/common.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace td {
+namespace actor {
+
+struct ParallelForOptions {
+  ParallelForOptions() {
+  }
+  // consecutive indices given to one call of f
+  size_t grain_size{1};
+  // 0 - one runner per CPU thread of the current scheduler
+  size_t max_runners{0};
+  CancellationToken cancellation_token;
+};
+
+/*
+ * Calls f(chunk_begin, chunk_end) for chunks of [begin, end) on the CPU workers of the current scheduler.
+ * Must be called from an actor (or a scheduler context); it never blocks: promise is set by the last runner,
+ * with the first error returned by f, or with error 653 if cancellation_token was cancelled.
+ * After an error or cancellation no new chunks are started. f is called concurrently from several threads.
+ *
+ * Each runner is a short-lived actor that starts with its own contiguous part of the chunks, takes them
+ * from the front, and when it runs out steals the back half of the largest remaining part of another runner.
+ */
+void parallel_for(size_t begin, size_t end, std::function<Status(size_t, size_t)> f, Promise<Unit> promise,
+                  ParallelForOptions options = {});
+
+/*
+ * Fork-join group of independent tasks:
+ *   TaskGroup group;
+ *   group.add_task([...] { ...; return Status::OK(); });
+ *   group.join(std::move(promise));
+ * join() runs the tasks with parallel_for and leaves the group empty.
+ */
+class TaskGroup {
+ public:
+  TaskGroup() = default;
+  explicit TaskGroup(CancellationToken cancellation_token) : cancellation_token_(std::move(cancellation_token)) {
+  }
+
+  void add_task(std::function<Status()> task) {
+    tasks_.push_back(std::move(task));
+  }
+  size_t size() const {
+    return tasks_.size();
+  }
+  void join(Promise<Unit> promise, size_t max_runners = 0);
+
+ private:
+  CancellationToken cancellation_token_;
+  std::vector<std::function<Status()>> tasks_;
+};
+
+namespace detail {
+// Chunks 0..n-1 split between runners; see parallel_for
+class StealingRanges {
+ public:
+  StealingRanges(size_t chunks, size_t runners);
+  bool pop(size_t runner, size_t &chunk);
+
+ private:
+  struct Range {
+    // begin in the high half, end in the low half
+    std::atomic<uint64> value{0};
+    char pad[TD_CONCURRENCY_PAD - sizeof(std::atomic<uint64>)];
+  };
+  std::vector<Range> ranges_;
+
+  static uint64 pack(uint64 begin, uint64 end) {
+    return (begin << 32) | end;
+  }
+  bool steal(size_t runner, size_t &chunk);
+};
+}  // namespace detail
+
+}  // namespace actor
+}  // namespace td
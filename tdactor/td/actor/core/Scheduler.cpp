@@ -200,6 +200,10 @@ Debug &Scheduler::ContextImpl::get_debug() {
   return *debug_;
 }
 
+size_t Scheduler::ContextImpl::get_cpu_threads_count() const {
+  return scheduler_group()->schedulers.at(scheduler_id_.value()).cpu_threads_count;
+}
+
 void Scheduler::ContextImpl::set_alarm_timestamp(const ActorInfoPtr &actor_info_ptr) {
   // Ideas for optimization
   // 1. Several cpu actors with separate heaps. They ask io worker to update timeout only when it has been changed
@@ -262,6 +262,8 @@ class Scheduler {
 
     Debug &get_debug() override;
 
+    size_t get_cpu_threads_count() const override;
+
     void set_alarm_timestamp(const ActorInfoPtr &actor_info_ptr) override;
 
     bool is_stop_requested() override;
@@ -53,6 +53,9 @@ class SchedulerContext : public Context<SchedulerContext>, public SchedulerDispa
   virtual bool has_heap() = 0;
   virtual KHeap<double> &get_heap() = 0;
 
+  // Number of CPU threads of the current scheduler (0 - everything runs on the io thread)
+  virtual size_t get_cpu_threads_count() const = 0;
+
   // Stop all schedulers
   virtual bool is_stop_requested() = 0;
   virtual void stop() = 0;
@@ -19,6 +19,7 @@
 #include "td/actor/core/ActorLocker.h"
 #include "td/actor/actor.h"
 #include "td/actor/PromiseFuture.h"
+#include "td/actor/TaskGroup.h"
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -29,6 +30,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <deque>
@@ -1102,4 +1104,150 @@ TEST(Actor2, send_vs_close2) {
     scheduler.run();
   }
 }
+
+TEST(Actor2, StealingRanges) {
+  // a single runner steals everything from the others
+  for (size_t chunks : {0, 1, 2, 5, 1000}) {
+    td::actor::detail::StealingRanges ranges(chunks, 4);
+    std::vector<int> taken(chunks, 0);
+    size_t chunk;
+    while (ranges.pop(1, chunk)) {
+      ASSERT_TRUE(chunk < chunks);
+      taken[chunk]++;
+    }
+    ASSERT_TRUE(std::all_of(taken.begin(), taken.end(), [](int x) { return x == 1; }));
+  }
+
+  size_t chunks = 1000000, threads_n = 4;
+  td::actor::detail::StealingRanges ranges(chunks, threads_n);
+  std::vector<std::atomic<int>> taken(chunks);
+  std::vector<td::thread> threads;
+  for (size_t i = 0; i < threads_n; i++) {
+    threads.emplace_back([&, i] {
+      size_t chunk;
+      // runner 0 is slow, so that others have to steal from it
+      while (ranges.pop(i, chunk)) {
+        taken[chunk]++;
+        if (i == 0) {
+          td::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &x : taken) {
+    ASSERT_EQ(1, x.load());
+  }
+}
+
+static td::Status run_parallel_for(size_t threads, size_t begin, size_t end, std::function<td::Status(size_t, size_t)> f,
+                                   ParallelForOptions options = {}) {
+  Scheduler scheduler({threads});
+  td::Status status = td::Status::Error("not finished");
+  scheduler.run_in_context([&] {
+    parallel_for(
+        begin, end, std::move(f),
+        [&](td::Result<td::Unit> R) {
+          status = R.is_ok() ? td::Status::OK() : R.move_as_error();
+          SchedulerContext::get()->stop();
+        },
+        std::move(options));
+  });
+  scheduler.run();
+  return status;
+}
+
+TEST(Actor2, parallel_for) {
+  for (size_t threads : {0, 1, 4}) {
+    for (size_t grain_size : {1, 7, 1000}) {
+      for (auto range : {std::make_pair(0, 0), std::make_pair(5, 6), std::make_pair(3, 10003)}) {
+        std::vector<std::atomic<int>> visits(range.second);
+        ParallelForOptions options;
+        options.grain_size = grain_size;
+        auto status = run_parallel_for(threads, range.first, range.second,
+                                       [&](size_t begin, size_t end) {
+                                         CHECK(begin < end && end - begin <= grain_size);
+                                         for (size_t i = begin; i < end; i++) {
+                                           visits[i]++;
+                                         }
+                                         return td::Status::OK();
+                                       },
+                                       std::move(options));
+        ASSERT_TRUE(status.is_ok());
+        for (size_t i = 0; i < visits.size(); i++) {
+          ASSERT_EQ(i < (size_t)range.first ? 0 : 1, visits[i].load());
+        }
+      }
+    }
+  }
+
+  // the first error is returned, no new chunks are started after it
+  std::atomic<size_t> calls{0};
+  auto status = run_parallel_for(4, 0, 100000, [&](size_t begin, size_t end) {
+    calls++;
+    return begin == 10 ? td::Status::Error(1, "error at 10") : td::Status::OK();
+  });
+  ASSERT_EQ(1, status.code());
+  ASSERT_TRUE(calls.load() < 100000);
+
+  // cancellation
+  td::CancellationTokenSource source;
+  ParallelForOptions options;
+  options.cancellation_token = source.get_cancellation_token();
+  status = run_parallel_for(
+      4, 0, 100000,
+      [&](size_t begin, size_t end) {
+        if (begin == 1000) {
+          source.cancel();
+        }
+        return td::Status::OK();
+      },
+      std::move(options));
+  ASSERT_EQ(653, status.code());
+}
+
+TEST(Actor2, TaskGroup) {
+  for (size_t threads : {0, 3}) {
+    for (int tasks_n : {0, 1, 100}) {
+      Scheduler scheduler({threads});
+      std::atomic<int> done{0};
+      bool finished = false;
+      scheduler.run_in_context([&] {
+        TaskGroup group;
+        for (int i = 0; i < tasks_n; i++) {
+          group.add_task([&] {
+            done++;
+            return td::Status::OK();
+          });
+        }
+        ASSERT_EQ((size_t)tasks_n, group.size());
+        group.join([&](td::Result<td::Unit> R) {
+          CHECK(R.is_ok());
+          finished = true;
+          SchedulerContext::get()->stop();
+        });
+        ASSERT_EQ(0u, group.size());
+      });
+      scheduler.run();
+      ASSERT_TRUE(finished);
+      ASSERT_EQ(tasks_n, done.load());
+    }
+  }
+
+  Scheduler scheduler({2});
+  td::Status status;
+  scheduler.run_in_context([&] {
+    TaskGroup group;
+    group.add_task([] { return td::Status::OK(); });
+    group.add_task([] { return td::Status::Error(2, "task failed"); });
+    group.join([&](td::Result<td::Unit> R) {
+      status = R.move_as_error();
+      SchedulerContext::get()->stop();
+    });
+  });
+  scheduler.run();
+  ASSERT_EQ(2, status.code());
+}
 #endif  //!TD_THREAD_UNSUPPORTED
@@ -39,6 +39,10 @@ class KeyValueAsync {
   KeyValueAsync(std::shared_ptr<KeyValue> key_value);
   void get(KeyT key, Promise<GetResult> promise = {});
   void set(KeyT key, ValueT value, Promise<Unit> promise = {}, double sync_delay = 0);
+  // writes all values in one transaction, in the given order
+  void set_batch(std::vector<std::pair<KeyT, ValueT>> values, Promise<Unit> promise = {}, double sync_delay = 0);
+  // the same, the promise gets the duration of the commit that made the values durable, in seconds
+  void set_batch_timed(std::vector<std::pair<KeyT, ValueT>> values, Promise<double> promise, double sync_delay = 0);
   void erase(KeyT key, Promise<Unit> promise = {}, double sync_delay = 0);
 
   KeyValueAsync();
@@ -74,6 +78,19 @@ class KeyValueActor : public actor::Actor {
     schedule_sync(std::move(promise), sync_delay);
     key_value_->set(as_slice(key), as_slice(value));
   }
+  void set_batch(std::vector<std::pair<KeyT, ValueT>> values, Promise<Unit> promise, double sync_delay) {
+    schedule_sync(std::move(promise), sync_delay);
+    for (auto &value : values) {
+      key_value_->set(as_slice(value.first), as_slice(value.second));
+    }
+  }
+  void set_batch_timed(std::vector<std::pair<KeyT, ValueT>> values, Promise<double> promise, double sync_delay) {
+    schedule_sync({}, sync_delay);
+    timed_promises_.push_back(std::move(promise));
+    for (auto &value : values) {
+      key_value_->set(as_slice(value.first), as_slice(value.second));
+    }
+  }
   void erase(KeyT key, Promise<Unit> promise, double sync_delay) {
     schedule_sync(std::move(promise), sync_delay);
     key_value_->erase(as_slice(key));
@@ -82,6 +99,7 @@ class KeyValueActor : public actor::Actor {
  private:
   std::shared_ptr<KeyValue> key_value_;
   std::vector<Promise<Unit>> pending_promises_;
+  std::vector<Promise<double>> timed_promises_;
   bool need_sync_ = false;
   bool sync_active_ = false;
 
@@ -94,11 +112,17 @@ class KeyValueActor : public actor::Actor {
     }
     need_sync_ = false;
     sync_active_ = false;
+    auto commit_started_at = Time::now();
     key_value_->commit_transaction();
+    auto commit_time = Time::now() - commit_started_at;
     for (auto &promise : pending_promises_) {
       promise.set_value(Unit());
     }
     pending_promises_.clear();
+    for (auto &promise : timed_promises_) {
+      promise.set_result(commit_time);
+    }
+    timed_promises_.clear();
   }
   void schedule_sync(Promise<Unit> promise, double sync_delay) {
     if (!need_sync_) {
@@ -151,6 +175,16 @@ void KeyValueAsync<KeyT, ValueT>::set(KeyT key, ValueT value, Promise<Unit> prom
   send_closure_later(actor_, &ActorType::set, std::move(key), std::move(value), std::move(promise), sync_delay);
 }
 template <class KeyT, class ValueT>
+void KeyValueAsync<KeyT, ValueT>::set_batch(std::vector<std::pair<KeyT, ValueT>> values, Promise<Unit> promise,
+                                            double sync_delay) {
+  send_closure_later(actor_, &ActorType::set_batch, std::move(values), std::move(promise), sync_delay);
+}
+template <class KeyT, class ValueT>
+void KeyValueAsync<KeyT, ValueT>::set_batch_timed(std::vector<std::pair<KeyT, ValueT>> values, Promise<double> promise,
+                                                  double sync_delay) {
+  send_closure_later(actor_, &ActorType::set_batch_timed, std::move(values), std::move(promise), sync_delay);
+}
+template <class KeyT, class ValueT>
 void KeyValueAsync<KeyT, ValueT>::erase(KeyT key, Promise<Unit> promise, double sync_delay) {
   send_closure_later(actor_, &ActorType::erase, std::move(key), std::move(promise), sync_delay);
 }
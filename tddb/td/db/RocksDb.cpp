@@ -39,6 +39,10 @@ static Slice from_rocksdb(rocksdb::Slice slice) {
 static rocksdb::Slice to_rocksdb(Slice slice) {
   return rocksdb::Slice(slice.data(), slice.size());
 }
+static std::shared_ptr<rocksdb::Cache> get_default_cache() {
+  static auto default_cache = rocksdb::NewLRUCache(1 << 30);
+  return default_cache;
+}
 }  // namespace
 
 Status RocksDb::destroy(Slice path) {
@@ -56,17 +60,19 @@ RocksDb::~RocksDb() {
 }
 
 RocksDb RocksDb::clone() const {
-  return RocksDb{db_, options_};
+  return RocksDb{db_, transaction_db_, options_};
 }
 
 Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options) {
+  if (!options.secondary_path.empty()) {
+    return open_secondary(std::move(path), std::move(options));
+  }
   rocksdb::OptimisticTransactionDB *db;
   {
     rocksdb::Options db_options;
 
-    static auto default_cache = rocksdb::NewLRUCache(1 << 30);
     if (options.block_cache == nullptr) {
-      options.block_cache = default_cache;
+      options.block_cache = get_default_cache();
     }
 
     rocksdb::BlockBasedTableOptions table_options;
@@ -94,7 +100,30 @@ Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options) {
     // default column family
     delete handles[0];
   }
-  return RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB>(db), std::move(options));
+  std::shared_ptr<rocksdb::OptimisticTransactionDB> transaction_db(db);
+  return RocksDb(transaction_db, transaction_db, std::move(options));
+}
+
+Result<RocksDb> RocksDb::open_secondary(std::string path, RocksDbOptions options) {
+  rocksdb::DB *db;
+  {
+    rocksdb::Options db_options;
+
+    if (options.block_cache == nullptr) {
+      options.block_cache = get_default_cache();
+    }
+
+    rocksdb::BlockBasedTableOptions table_options;
+    table_options.block_cache = options.block_cache;
+    db_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+
+    db_options.use_direct_reads = options.use_direct_reads;
+    // required for secondary instances: files of the primary one may be deleted after they are opened
+    db_options.max_open_files = -1;
+    db_options.statistics = options.statistics;
+    TRY_STATUS(from_rocksdb(rocksdb::DB::OpenAsSecondary(db_options, std::move(path), options.secondary_path, &db)));
+  }
+  return RocksDb(std::shared_ptr<rocksdb::DB>(db), nullptr, std::move(options));
 }
 
 std::shared_ptr<rocksdb::Statistics> RocksDb::create_statistics() {
@@ -220,9 +249,12 @@ Status RocksDb::begin_write_batch() {
 
 Status RocksDb::begin_transaction() {
   CHECK(!write_batch_);
+  if (!transaction_db_) {
+    return Status::Error("Transactions are not supported by a secondary instance");
+  }
   rocksdb::WriteOptions options;
   options.sync = true;
-  transaction_.reset(db_->BeginTransaction(options, {}));
+  transaction_.reset(transaction_db_->BeginTransaction(options, {}));
   return Status::OK();
 }
 
@@ -257,6 +289,10 @@ Status RocksDb::flush() {
 }
 
 Status RocksDb::begin_snapshot() {
+  if (is_secondary()) {
+    // the state of a secondary instance changes only in try_catch_up_with_primary
+    return td::Status::OK();
+  }
   snapshot_.reset(db_->GetSnapshot());
   if (options_.snapshot_statistics) {
     options_.snapshot_statistics->begin_snapshot(snapshot_.get());
@@ -274,8 +310,13 @@ Status RocksDb::end_snapshot() {
   return td::Status::OK();
 }
 
-RocksDb::RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options)
-    : db_(std::move(db)), options_(options) {
+Status RocksDb::try_catch_up_with_primary() {
+  return from_rocksdb(db_->TryCatchUpWithPrimary());
+}
+
+RocksDb::RocksDb(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<rocksdb::OptimisticTransactionDB> transaction_db,
+                 RocksDbOptions options)
+    : db_(std::move(db)), transaction_db_(std::move(transaction_db)), options_(options) {
 }
 
 void RocksDbSnapshotStatistics::begin_snapshot(const rocksdb::Snapshot *snapshot) {
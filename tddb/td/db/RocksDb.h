@@ -34,6 +34,7 @@
 
 namespace rocksdb {
 class Cache;
+class DB;
 class OptimisticTransactionDB;
 class Transaction;
 class WriteBatch;
@@ -59,6 +60,10 @@ struct RocksDbOptions {
   std::shared_ptr<rocksdb::Cache> block_cache;  // Default - one 1G cache for all RocksDb
   std::shared_ptr<RocksDbSnapshotStatistics> snapshot_statistics = nullptr;
   bool use_direct_reads = false;
+  // Non-empty - open the database read-only, as a secondary instance of a database opened elsewhere (possibly by
+  // another process). The instance keeps its own info files in secondary_path and sees new writes of the primary
+  // one only after try_catch_up_with_primary().
+  std::string secondary_path;
 };
 
 class RocksDb : public KeyValue {
@@ -85,6 +90,11 @@ class RocksDb : public KeyValue {
   Status begin_snapshot();
   Status end_snapshot();
 
+  bool is_secondary() const {
+    return !options_.secondary_path.empty();
+  }
+  Status try_catch_up_with_primary();
+
   std::unique_ptr<KeyValueReader> snapshot() override;
   std::string stats() const override;
 
@@ -98,12 +108,14 @@ class RocksDb : public KeyValue {
   RocksDb &operator=(RocksDb &&);
   ~RocksDb();
 
+  // null for a secondary instance
   std::shared_ptr<rocksdb::OptimisticTransactionDB> raw_db() const {
-    return db_;
+    return transaction_db_;
   };
 
  private:
-  std::shared_ptr<rocksdb::OptimisticTransactionDB> db_;
+  std::shared_ptr<rocksdb::DB> db_;
+  std::shared_ptr<rocksdb::OptimisticTransactionDB> transaction_db_;
   RocksDbOptions options_;
 
   std::unique_ptr<rocksdb::Transaction> transaction_;
@@ -117,6 +129,8 @@ class RocksDb : public KeyValue {
   };
   std::unique_ptr<const rocksdb::Snapshot, UnreachableDeleter> snapshot_;
 
-  explicit RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options);
+  static Result<RocksDb> open_secondary(std::string path, RocksDbOptions options);
+  RocksDb(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<rocksdb::OptimisticTransactionDB> transaction_db,
+          RocksDbOptions options);
 };
 }  // namespace td
@@ -25,6 +25,7 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/buffer.h"
 #include "td/utils/optional.h"
+#include "td/utils/port/path.h"
 #include "td/utils/UInt.h"
 
 TEST(KeyValue, simple) {
@@ -76,6 +77,43 @@ TEST(KeyValue, simple) {
   CHECK(!options.snapshot_statistics->oldest_snapshot_timestamp());
 };
 
+TEST(KeyValue, Secondary) {
+  td::Slice db_name = "testdb";
+  td::Slice secondary_name = "testdb-secondary";
+  td::RocksDb::destroy(db_name).ignore();
+  td::rmrf(secondary_name).ignore();
+
+  auto primary = td::RocksDb::open(db_name.str()).move_as_ok();
+  auto set_value = [&](td::Slice key, td::Slice value) {
+    primary.begin_write_batch().ensure();
+    primary.set(key, value).ensure();
+    primary.commit_write_batch().ensure();
+  };
+  set_value("A", "HELLO");
+
+  td::RocksDbOptions options;
+  options.secondary_path = secondary_name.str();
+  auto secondary = td::RocksDb::open(db_name.str(), options).move_as_ok();
+  ASSERT_TRUE(secondary.is_secondary());
+  auto get_status = [&](td::Slice key) {
+    std::string value;
+    return td::int32(secondary.get(key, value).move_as_ok());
+  };
+  ASSERT_EQ(td::int32(td::KeyValue::GetStatus::Ok), get_status("A"));
+
+  set_value("B", "WORLD");
+  auto snapshot = secondary.snapshot();
+  ASSERT_EQ(td::int32(td::KeyValue::GetStatus::NotFound), get_status("B"));
+  secondary.try_catch_up_with_primary().ensure();
+  ASSERT_EQ(td::int32(td::KeyValue::GetStatus::Ok), get_status("B"));
+  std::string value;
+  ASSERT_EQ(td::int32(td::KeyValue::GetStatus::Ok), td::int32(snapshot->get("B", value).move_as_ok()));
+  ASSERT_EQ("WORLD", value);
+
+  ASSERT_TRUE(secondary.set("C", "X").is_error());
+  ASSERT_TRUE(secondary.begin_transaction().is_error());
+}
+
 TEST(KeyValue, async_simple) {
   td::Slice db_name = "testdb";
   td::RocksDb::destroy(db_name).ignore();
@@ -87,6 +87,54 @@ int main(int argc, char *argv[]) {
     CHECK(!req->need_payload());
   }
 
+  {
+    // chunks of at least HttpPayload::min_zero_copy_size() are adopted from the input buffer without copying
+    const auto request =
+        "POST /upload HTTP/1.1\r\n"
+        "Host: www.example.org:8080\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n";
+    std::string body, data;
+    for (size_t size : {5000, 100, 20000, 3000}) {
+      std::string chunk(size, '\0');
+      for (auto &c : chunk) {
+        c = static_cast<char>('a' + td::Random::fast(0, 25));
+      }
+      std::ostringstream os;
+      os << std::hex << size << "\r\n" << chunk << "\r\n";
+      body += os.str();
+      data += chunk;
+    }
+    body += "0\r\n\r\n";
+
+    td::ChainBufferWriter w;
+    w.init(0);
+    auto r = w.extract_reader();
+    w.append(td::Slice(request, std::strlen(request)));
+    r.sync_with_writer();
+
+    bool exit_loop = false;
+    std::string cur_line = "";
+    auto req = ton::http::HttpRequest::parse(nullptr, cur_line, exit_loop, r).move_as_ok();
+    CHECK(req->check_parse_header_completed());
+    auto payload = req->create_empty_payload().move_as_ok();
+    std::string received;
+    for (size_t pos = 0; pos < body.size(); pos += 7000) {
+      w.append(td::Slice(body).substr(pos, 7000));
+      r.sync_with_writer();
+      payload->parse(r).ensure();
+      while (true) {
+        auto b = payload->get_slice(1 << 20);
+        if (b.empty()) {
+          break;
+        }
+        received += b.as_slice().str();
+      }
+    }
+    CHECK(payload->parse_completed());
+    CHECK(received == data);
+  }
+
   {
     const auto request =
         "GET /pub/WWW/TheProject.html HTTP/1.1\r\n"
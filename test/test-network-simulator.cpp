@@ -0,0 +1,415 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "adnl/adnl.h"
+#include "adnl/adnl-test-loopback-implementation.h"
+#include "adnl/adnl-test-network-simulator.h"
+#include "dht/dht.h"
+#include "overlay/overlays.h"
+#include "rldp2/rldp.h"
+
+#include "td/utils/OptionParser.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/signals.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+/*
+ * Transport benchmark on a simulated network: N nodes in one process exchange RLDP2 transfers and overlay FEC
+ * broadcasts over links with configured latency, jitter, loss, bandwidth and reordering.
+ * The scheduler skips idle time, so goodput and latency are measured in simulated seconds; the time spent on
+ * processing still passes, so they also depend on the speed of the build. CPU per byte is the CPU time of the
+ * whole process (all senders and receivers) divided by the delivered payload.
+ * Every scenario must complete within its simulated timeout, which makes the benchmark usable as a regression test.
+ */
+
+namespace {
+
+using LinkOptions = ton::adnl::SimulatedNetworkManager::LinkOptions;
+using LinkStats = ton::adnl::SimulatedNetworkManager::LinkStats;
+
+constexpr double kTimeout = 3600.0;
+
+struct Profile {
+  std::string name;
+  LinkOptions options;
+};
+
+std::vector<Profile> profiles() {
+  return {{"perfect", LinkOptions().with_latency(0.005)},
+          {"wan", LinkOptions().with_latency(0.05, 0.01).with_bandwidth(12.5e6, 512 << 10)},
+          {"lossy", LinkOptions().with_latency(0.05, 0.02).with_bandwidth(12.5e6, 512 << 10).with_loss(0.05)
+                        .with_reorder(0.01)},
+          {"congested", LinkOptions().with_latency(0.1).with_bandwidth(1.25e6, 128 << 10).with_loss(0.01)}};
+}
+
+struct Node {
+  ton::adnl::AdnlNodeIdShort adnl_id;
+  ton::adnl::AdnlNodeIdFull adnl_id_full;
+};
+
+struct Report {
+  td::uint64 bytes = 0;
+  double elapsed = 0;
+  double cpu = 0;
+  std::vector<double> latencies;
+  LinkStats link_stats;
+};
+
+double cpu_time() {
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+void print_report(td::Slice scenario, td::Slice profile, Report report) {
+  std::sort(report.latencies.begin(), report.latencies.end());
+  auto goodput = report.elapsed > 0 ? static_cast<double>(report.bytes) / report.elapsed : 0;
+  auto &stats = report.link_stats;
+  auto bytes = static_cast<double>(report.bytes);
+  std::cout << (PSTRING() << scenario << " " << profile << ": payload=" << td::format::as_size(report.bytes)
+            << " time=" << td::format::as_time(report.elapsed)
+            << " goodput=" << td::format::as_size(static_cast<td::uint64>(goodput)) << "/s"
+            << " latency p50=" << td::format::as_time(percentile(report.latencies, 0.5))
+            << " p90=" << td::format::as_time(percentile(report.latencies, 0.9))
+            << " p99=" << td::format::as_time(percentile(report.latencies, 0.99))
+            << " cpu/MB=" << td::format::as_time(bytes > 0 ? report.cpu * (1 << 20) / bytes : 0)
+            << " packets: sent=" << stats.sent_packets << " lost=" << stats.lost_packets
+            << " dropped=" << stats.dropped_packets << " reordered=" << stats.reordered_packets
+            << " overhead=" << (bytes > 0 ? static_cast<double>(stats.sent_bytes) / bytes : 0))
+            << std::endl;
+}
+
+LinkStats operator-(LinkStats a, const LinkStats &b) {
+  a.sent_packets -= b.sent_packets;
+  a.sent_bytes -= b.sent_bytes;
+  a.delivered_packets -= b.delivered_packets;
+  a.delivered_bytes -= b.delivered_bytes;
+  a.lost_packets -= b.lost_packets;
+  a.dropped_packets -= b.dropped_packets;
+  a.reordered_packets -= b.reordered_packets;
+  return a;
+}
+
+class ZeroDataSource : public ton::rldp2::OutboundDataSource {
+ public:
+  explicit ZeroDataSource(td::uint64 size) : size_(size) {
+  }
+  td::uint64 size() const override {
+    return size_;
+  }
+  td::Result<td::BufferSlice> read(td::uint64 offset, size_t size) override {
+    td::BufferSlice data(static_cast<size_t>(std::min<td::uint64>(size, size_ - offset)));
+    data.as_slice().fill('\0');
+    return std::move(data);
+  }
+
+ private:
+  td::uint64 size_;
+};
+
+class CountingDataSink : public ton::rldp2::InboundDataSink {
+ public:
+  explicit CountingDataSink(td::uint64 &received) : received_(received) {
+  }
+  td::Status append(td::BufferSlice data) override {
+    received_ += data.size();
+    return td::Status::OK();
+  }
+
+ private:
+  td::uint64 &received_;
+};
+
+class BroadcastCallback : public ton::overlay::Overlays::Callback {
+ public:
+  BroadcastCallback(bool is_source, std::vector<double> &sent_at, Report &report)
+      : is_source_(is_source), sent_at_(sent_at), report_(report) {
+  }
+  void receive_message(ton::adnl::AdnlNodeIdShort src, ton::overlay::OverlayIdShort overlay_id,
+                       td::BufferSlice data) override {
+  }
+  void receive_query(ton::adnl::AdnlNodeIdShort src, ton::overlay::OverlayIdShort overlay_id, td::BufferSlice data,
+                     td::Promise<td::BufferSlice> promise) override {
+    promise.set_error(td::Status::Error("unexpected query"));
+  }
+  void receive_broadcast(ton::PublicKeyHash src, ton::overlay::OverlayIdShort overlay_id,
+                         td::BufferSlice data) override {
+    if (is_source_) {
+      // the source gets its own broadcasts right away
+      return;
+    }
+    CHECK(data.size() >= 4);
+    td::uint32 idx;
+    std::memcpy(&idx, data.data(), 4);
+    CHECK(idx < sent_at_.size());
+    report_.bytes += data.size();
+    report_.latencies.push_back(td::Time::now() - sent_at_[idx]);
+  }
+
+ private:
+  bool is_source_;
+  std::vector<double> &sent_at_;
+  Report &report_;
+};
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(verbosity_ERROR);
+  td::set_default_failure_signal_handler().ensure();
+
+  td::uint32 total_nodes = 8;
+  td::uint64 transfer_size = 4 << 20;
+  td::uint32 broadcasts = 16;
+  td::uint64 broadcast_size = 256 << 10;
+  td::uint64 seed = 0;
+  std::string only_profile;
+
+  td::OptionParser p;
+  p.set_description("RLDP2 and overlay broadcast benchmark on a simulated network");
+  p.add_checked_option('n', "nodes", "number of nodes (default 8)", [&](td::Slice arg) -> td::Status {
+    TRY_RESULT_ASSIGN(total_nodes, td::to_integer_safe<td::uint32>(arg));
+    if (total_nodes < 2) {
+      return td::Status::Error("at least 2 nodes are needed");
+    }
+    return td::Status::OK();
+  });
+  p.add_checked_option('s', "transfer-size", "size of one RLDP2 transfer (default 4MB)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(transfer_size, td::to_integer_safe<td::uint64>(arg));
+    return td::Status::OK();
+  });
+  p.add_checked_option('b', "broadcasts", "number of FEC broadcasts (default 16)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(broadcasts, td::to_integer_safe<td::uint32>(arg));
+    return td::Status::OK();
+  });
+  p.add_checked_option('B', "broadcast-size", "size of one FEC broadcast (default 256KB)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(broadcast_size, td::to_integer_safe<td::uint64>(arg));
+    if (broadcast_size < 4 || broadcast_size > ton::overlay::Overlays::max_fec_broadcast_size()) {
+      return td::Status::Error("bad broadcast size");
+    }
+    return td::Status::OK();
+  });
+  p.add_checked_option('S', "seed", "seed of the simulated network (default 0)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(seed, td::to_integer_safe<td::uint64>(arg));
+    return td::Status::OK();
+  });
+  p.add_option('P', "profile", "run only the given network profile", [&](td::Slice arg) { only_profile = arg.str(); });
+  p.add_option('q', "quick", "small run for regression tests", [&]() {
+    total_nodes = 4;
+    transfer_size = 1 << 20;
+    broadcasts = 4;
+    broadcast_size = 64 << 10;
+  });
+  p.add_checked_option('v', "verbosity", "sets verbosity level", [&](td::Slice arg) {
+    TRY_RESULT(v, td::to_integer_safe<int>(arg));
+    SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + v);
+    return td::Status::OK();
+  });
+  p.add_option('h', "help", "prints a help message", [&]() {
+    std::cout << (PSLICE() << p).c_str();
+    std::exit(2);
+  });
+  p.run(argc, argv).ensure();
+
+  std::string db_root_ = "tmp-dir-test-network-simulator";
+  td::rmrf(db_root_).ignore();
+  td::mkdir(db_root_).ensure();
+
+  td::actor::ActorOwn<ton::keyring::Keyring> keyring;
+  td::actor::ActorOwn<ton::adnl::SimulatedNetworkManager> network_manager;
+  td::actor::ActorOwn<ton::adnl::Adnl> adnl;
+  td::actor::ActorOwn<ton::rldp2::Rldp> rldp;
+  td::actor::ActorOwn<ton::overlay::Overlays> overlays;
+  std::vector<Node> nodes(total_nodes);
+
+  // a single thread and skipped timeouts: packets are delivered in simulated time
+  td::actor::Scheduler scheduler({0}, true);
+
+  auto wait = [&](td::Slice what, std::function<bool()> done) {
+    auto t = td::Timestamp::in(kTimeout);
+    while (scheduler.run(1)) {
+      if (done()) {
+        return;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "timeout: " << what;
+      }
+    }
+  };
+  auto get_total_stats = [&] {
+    LinkStats stats;
+    bool ready = false;
+    scheduler.run_in_context([&] {
+      td::actor::send_closure(network_manager, &ton::adnl::SimulatedNetworkManager::get_total_stats,
+                              [&](td::Result<LinkStats> R) {
+                                stats = R.move_as_ok();
+                                ready = true;
+                              });
+    });
+    wait("stats", [&] { return ready; });
+    return stats;
+  };
+
+  scheduler.run_in_context([&] {
+    keyring = ton::keyring::Keyring::create(db_root_);
+    network_manager = td::actor::create_actor<ton::adnl::SimulatedNetworkManager>("simnet", seed);
+    adnl = ton::adnl::Adnl::create(db_root_, keyring.get());
+    rldp = ton::rldp2::Rldp::create(adnl.get());
+    overlays = ton::overlay::Overlays::create(db_root_, keyring.get(), adnl.get(), td::actor::ActorId<ton::dht::Dht>{});
+    td::actor::send_closure(adnl, &ton::adnl::Adnl::register_network_manager, network_manager.get());
+
+    auto addr = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
+    for (auto &n : nodes) {
+      auto pk = ton::PrivateKey{ton::privkeys::Ed25519::random()};
+      auto pub = pk.compute_public_key();
+      n.adnl_id_full = ton::adnl::AdnlNodeIdFull{pub};
+      n.adnl_id = ton::adnl::AdnlNodeIdShort{pub.compute_short_id()};
+      td::actor::send_closure(keyring, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
+      td::actor::send_closure(adnl, &ton::adnl::Adnl::add_id, n.adnl_id_full, addr, static_cast<td::uint8>(0));
+      td::actor::send_closure(rldp, &ton::rldp2::Rldp::add_id, n.adnl_id);
+      td::actor::send_closure(network_manager, &ton::adnl::SimulatedNetworkManager::add_node_id, n.adnl_id, true,
+                              true);
+    }
+    for (auto &n1 : nodes) {
+      for (auto &n2 : nodes) {
+        td::actor::send_closure(adnl, &ton::adnl::Adnl::add_peer, n1.adnl_id, n2.adnl_id_full, addr);
+      }
+    }
+  });
+
+  for (auto &profile : profiles()) {
+    if (!only_profile.empty() && profile.name != only_profile) {
+      continue;
+    }
+    scheduler.run_in_context([&] {
+      td::actor::send_closure(network_manager, &ton::adnl::SimulatedNetworkManager::set_default_link_options,
+                              profile.options);
+    });
+
+    {
+      // every node streams transfer_size bytes to the next one, all transfers at once
+      Report report;
+      std::vector<td::uint64> received(total_nodes, 0);
+      td::uint32 remaining = 2 * total_nodes;
+      auto stats_before = get_total_stats();
+      auto cpu_before = cpu_time();
+      auto start = td::Time::now();
+      scheduler.run_in_context([&] {
+        for (td::uint32 i = 0; i < total_nodes; i++) {
+          auto &src = nodes[i].adnl_id;
+          auto &dst = nodes[(i + 1) % total_nodes].adnl_id;
+          td::Bits256 transfer_id;
+          td::Random::secure_bytes(transfer_id.as_slice());
+          td::actor::send_closure(rldp, &ton::rldp2::Rldp::receive_stream, dst, src, transfer_id,
+                                  td::Timestamp::in(kTimeout), transfer_size,
+                                  std::make_unique<CountingDataSink>(received[i]),
+                                  [&, start](td::Result<td::Unit> R) {
+                                    R.ensure();
+                                    report.latencies.push_back(td::Time::now() - start);
+                                    remaining--;
+                                  });
+          td::actor::send_closure(rldp, &ton::rldp2::Rldp::send_stream, src, dst, transfer_id,
+                                  td::Timestamp::in(kTimeout), std::make_unique<ZeroDataSource>(transfer_size),
+                                  [&](td::Result<td::Unit> R) {
+                                    R.ensure();
+                                    remaining--;
+                                  });
+        }
+      });
+      wait("rldp2 transfers", [&] { return remaining == 0; });
+      report.elapsed = td::Time::now() - start;
+      report.cpu = cpu_time() - cpu_before;
+      for (auto x : received) {
+        CHECK(x == transfer_size);
+        report.bytes += x;
+      }
+      report.link_stats = get_total_stats() - stats_before;
+      print_report("rldp2", profile.name, std::move(report));
+    }
+
+    {
+      // node 0 broadcasts to a private overlay of all nodes, one broadcast after another
+      Report report;
+      std::vector<double> sent_at(broadcasts, 0);
+      td::BufferSlice name(32);
+      td::Random::secure_bytes(name.as_slice());
+      auto overlay_id_full = ton::overlay::OverlayIdFull{std::move(name)};
+      auto overlay_id = overlay_id_full.compute_short_id();
+      std::vector<ton::adnl::AdnlNodeIdShort> members;
+      for (auto &n : nodes) {
+        members.push_back(n.adnl_id);
+      }
+      scheduler.run_in_context([&] {
+        for (auto &n : nodes) {
+          td::actor::send_closure(
+              overlays, &ton::overlay::Overlays::create_private_overlay, n.adnl_id, overlay_id_full.clone(), members,
+              std::make_unique<BroadcastCallback>(n.adnl_id == nodes[0].adnl_id, sent_at, report),
+              ton::overlay::OverlayPrivacyRules{ton::overlay::Overlays::max_fec_broadcast_size(),
+                                                ton::overlay::CertificateFlags::AllowFec |
+                                                    ton::overlay::CertificateFlags::Trusted,
+                                                {}},
+              R"({ "type": "bench" })");
+        }
+      });
+
+      auto stats_before = get_total_stats();
+      auto cpu_before = cpu_time();
+      auto start = td::Time::now();
+      size_t expected = 0;
+      for (td::uint32 i = 0; i < broadcasts; i++) {
+        td::BufferSlice data(static_cast<size_t>(broadcast_size));
+        td::Random::secure_bytes(data.as_slice());
+        std::memcpy(data.data(), &i, 4);
+        sent_at[i] = td::Time::now();
+        scheduler.run_in_context([&] {
+          td::actor::send_closure(overlays, &ton::overlay::Overlays::send_broadcast_fec, nodes[0].adnl_id, overlay_id,
+                                  std::move(data));
+        });
+        expected += total_nodes - 1;
+        wait("fec broadcast", [&] { return report.latencies.size() == expected; });
+      }
+      report.elapsed = td::Time::now() - start;
+      report.cpu = cpu_time() - cpu_before;
+      report.link_stats = get_total_stats() - stats_before;
+
+      scheduler.run_in_context([&] {
+        for (auto &n : nodes) {
+          td::actor::send_closure(overlays, &ton::overlay::Overlays::delete_overlay, n.adnl_id, overlay_id);
+        }
+      });
+      print_report("fec-broadcast", profile.name, std::move(report));
+    }
+  }
+
+  td::rmrf(db_root_).ensure();
+  std::_Exit(0);
+  return 0;
+}
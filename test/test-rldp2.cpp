@@ -29,14 +29,180 @@
 #include "adnl/adnl-test-loopback-implementation.h"
 #include "adnl/adnl.h"
 #include "rldp2/rldp.h"
+#include "rldp2/RldpConnection.h"
 
 #include "td/utils/port/signals.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/Random.h"
 
 #include <memory>
 #include <set>
 
+namespace {
+// payload of streamed transfers, generated on the fly so that the test itself does not hold it in memory
+td::uint8 stream_byte(td::uint64 offset) {
+  return static_cast<td::uint8>((offset * 2654435761ull) >> 13);
+}
+
+class GeneratedDataSource : public ton::rldp2::OutboundDataSource {
+ public:
+  explicit GeneratedDataSource(td::uint64 size) : size_(size) {
+  }
+  td::uint64 size() const override {
+    return size_;
+  }
+  td::Result<td::BufferSlice> read(td::uint64 offset, size_t size) override {
+    size = static_cast<size_t>(std::min<td::uint64>(size, size_ - offset));
+    td::BufferSlice data(size);
+    for (size_t i = 0; i < size; i++) {
+      data.as_slice()[i] = static_cast<char>(stream_byte(offset + i));
+    }
+    return std::move(data);
+  }
+
+ private:
+  td::uint64 size_;
+};
+
+class CheckingDataSink : public ton::rldp2::InboundDataSink {
+ public:
+  explicit CheckingDataSink(std::atomic<td::uint64> &received) : received_(received) {
+  }
+  td::Status append(td::BufferSlice data) override {
+    td::uint64 offset = received_;
+    for (size_t i = 0; i < data.size(); i++) {
+      if (static_cast<td::uint8>(data.as_slice()[i]) != stream_byte(offset + i)) {
+        return td::Status::Error(PSLICE() << "data mismatch at offset " << offset + i);
+      }
+    }
+    received_ += data.size();
+    return td::Status::OK();
+  }
+
+ private:
+  std::atomic<td::uint64> &received_;
+};
+class StringDataSink : public ton::rldp2::InboundDataSink {
+ public:
+  explicit StringDataSink(std::string &data) : data_(data) {
+  }
+  td::Status append(td::BufferSlice data) override {
+    data_ += data.as_slice().str();
+    return td::Status::OK();
+  }
+
+ private:
+  std::string &data_;
+};
+
+// two connections that pass packets to each other directly and read blocking data sources in place
+struct ConnectionPair : public ton::rldp2::ConnectionCallback {
+  ton::rldp2::RldpConnection sender;
+  ton::rldp2::RldpConnection receiver;
+  std::vector<td::BufferSlice> packets;
+  std::map<ton::rldp2::TransferId, td::Result<td::BufferSlice>> received;
+  std::map<ton::rldp2::TransferId, td::Result<td::Unit>> sent;
+
+  void send_raw(td::BufferSlice small_datagram) override {
+    packets.push_back(std::move(small_datagram));
+  }
+  void receive(ton::rldp2::TransferId transfer_id, td::Result<td::BufferSlice> r_data) override {
+    received.emplace(transfer_id, std::move(r_data));
+  }
+  void on_sent(ton::rldp2::TransferId transfer_id, td::Result<td::Unit> state) override {
+    sent.emplace(transfer_id, std::move(state));
+  }
+
+  template <class F>
+  void run_until(F &&done) {
+    auto timeout = td::Timestamp::in(60.0);
+    while (!done()) {
+      LOG_CHECK(!timeout.is_in_past()) << "connection test timed out";
+      sender.run(*this);
+      for (auto &read : sender.take_part_reads()) {
+        sender.on_part_read(read, read.source->read(read.offset, read.size));
+      }
+      for (auto &packet : std::move(packets)) {
+        receiver.receive_raw(std::move(packet));
+      }
+      packets.clear();
+      receiver.run(*this);
+      for (auto &packet : std::move(packets)) {
+        sender.receive_raw(std::move(packet));
+      }
+      packets.clear();
+      td::usleep_for(100);
+    }
+  }
+};
+
+void test_connection_streams() {
+  auto random_id = [] {
+    ton::rldp2::TransferId transfer_id;
+    td::Random::secure_bytes(transfer_id.as_slice());
+    return transfer_id;
+  };
+
+  // a small transfer completed into a buffer before its sink is attached fails the stream
+  {
+    ConnectionPair pair;
+    auto transfer_id = random_id();
+    pair.sender.send(transfer_id, td::BufferSlice(1000));
+    pair.run_until([&] { return pair.received.count(transfer_id) > 0; });
+    CHECK(pair.received.at(transfer_id).is_ok());
+    pair.received.clear();
+    std::string data;
+    pair.receiver.set_receive_sink(transfer_id, td::Timestamp::in(10.0), 1000, std::make_unique<StringDataSink>(data));
+    pair.run_until([&] { return pair.received.count(transfer_id) > 0; });
+    CHECK(pair.received.at(transfer_id).is_error());
+  }
+
+  // so does a transfer that is being collected into a buffer
+  {
+    ConnectionPair pair;
+    pair.receiver.set_default_mtu(8 << 20);
+    auto transfer_id = random_id();
+    pair.sender.send(transfer_id, td::BufferSlice(8 << 20));
+    int steps = 0;
+    pair.run_until([&] { return ++steps > 3; });
+    CHECK(pair.received.empty());
+    std::string data;
+    pair.receiver.set_receive_sink(transfer_id, td::Timestamp::in(10.0), 8 << 20,
+                                   std::make_unique<StringDataSink>(data));
+    pair.run_until([&] { return pair.received.count(transfer_id) > 0; });
+    CHECK(pair.received.at(transfer_id).is_error());
+    CHECK(data.empty());
+  }
+
+  // parts of a blocking source are read by the owner of the connection
+  {
+    ConnectionPair pair;
+    auto transfer_id = random_id();
+    std::string data;
+    pair.receiver.set_receive_sink(transfer_id, td::Timestamp::in(60.0), 5 << 20,
+                                   std::make_unique<StringDataSink>(data));
+    class BlockingDataSource : public GeneratedDataSource {
+     public:
+      using GeneratedDataSource::GeneratedDataSource;
+      bool is_blocking() const override {
+        return true;
+      }
+    };
+    pair.sender.send(transfer_id, std::make_unique<BlockingDataSource>(5 << 20));
+    pair.run_until([&] { return pair.received.count(transfer_id) > 0 && pair.sent.count(transfer_id) > 0; });
+    CHECK(pair.received.at(transfer_id).is_ok());
+    CHECK(pair.sent.at(transfer_id).is_ok());
+    CHECK(data.size() == 5 << 20);
+    for (size_t i = 0; i < data.size(); i++) {
+      CHECK(static_cast<td::uint8>(data[i]) == stream_byte(i));
+    }
+  }
+}
+}  // namespace
+
 int main() {
   SET_VERBOSITY_LEVEL(verbosity_INFO);
 
@@ -46,6 +212,10 @@ int main() {
 
   td::set_default_failure_signal_handler().ensure();
 
+  LOG(ERROR) << "testing streaming transfers on a connection";
+  test_connection_streams();
+  LOG(ERROR) << "success";
+
   td::actor::ActorOwn<ton::keyring::Keyring> keyring;
   td::actor::ActorOwn<ton::adnl::TestLoopbackNetworkManager> network_manager;
   td::actor::ActorOwn<ton::adnl::Adnl> adnl;
@@ -197,6 +367,67 @@ int main() {
     LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
   }
 
+  scheduler.run_in_context([&] {
+    td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::set_loss_probability, 0.0);
+  });
+  LOG(ERROR) << "testing streaming transfers";
+
+  auto peak_rss = [] {
+    auto r_stat = td::mem_stat();
+    return r_stat.is_ok() ? r_stat.ok().resident_size_peak_ : 0;
+  };
+  auto run_stream = [&](std::string name, std::unique_ptr<ton::rldp2::OutboundDataSource> source, bool check_rss) {
+    td::uint64 size = source->size();
+    std::atomic<td::uint64> received{0};
+    auto peak_rss_before = peak_rss();
+    auto f = td::Clocks::system();
+    scheduler.run_in_context([&] {
+      td::Bits256 transfer_id;
+      td::Random::secure_bytes(transfer_id.as_slice());
+      remaining += 2;
+      td::actor::send_closure(rldp, &ton::rldp2::Rldp::receive_stream, dst, src, transfer_id, td::Timestamp::in(1024.0),
+                              size, std::make_unique<CheckingDataSink>(received),
+                              td::PromiseCreator::lambda([&](td::Result<td::Unit> R) {
+                                R.ensure();
+                                remaining--;
+                              }));
+      td::actor::send_closure(rldp, &ton::rldp2::Rldp::send_stream, src, dst, transfer_id, td::Timestamp::in(1024.0),
+                              std::move(source), td::PromiseCreator::lambda([&](td::Result<td::Unit> R) {
+                                R.ensure();
+                                remaining--;
+                              }));
+    });
+
+    auto t = td::Timestamp::in(1024.0);
+    while (scheduler.run(16)) {
+      if (!remaining) {
+        break;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "failed to receive stream: remaining=" << remaining;
+      }
+    }
+    CHECK(received == size);
+    auto elapsed = td::Clocks::system() - f;
+    auto peak_rss_growth = peak_rss() - peak_rss_before;
+    LOG(ERROR) << "success: " << name << " of size " << size << ". Time=" << elapsed
+               << " Throughput=" << td::format::as_size(static_cast<td::uint64>(static_cast<double>(size) / elapsed))
+               << "/s Peak RSS growth=" << td::format::as_size(peak_rss_growth);
+    if (check_rss && peak_rss_before != 0) {
+      // a buffered transfer would hold the whole payload on both sides
+      CHECK(peak_rss_growth < size);
+    }
+  };
+
+  run_stream("generated stream", std::make_unique<GeneratedDataSource>(256 << 20), true);
+
+  {
+    auto path = db_root_ + "/stream";
+    auto source = std::make_unique<GeneratedDataSource>(24 << 20);
+    td::write_file(path, source->read(0, 24 << 20).move_as_ok()).ensure();
+    run_stream("file stream", ton::rldp2::OutboundDataSource::from_file(path).move_as_ok(), false);
+  }
+
   td::rmrf(db_root_).ensure();
   std::_Exit(0);
   return 0;
@@ -57,6 +57,23 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   void clear_temp_memory() override {
     mem_temp_.clear();
   }
+  bool need_compaction() const override {
+    return false;
+  }
+  void start_compaction() override {
+    UNREACHABLE();
+  }
+  void finish_compaction() override {
+    UNREACHABLE();
+  }
+  const RootObject *get_moved(const RootObject *obj) const override {
+    return nullptr;
+  }
+  void set_moved(const RootObject *obj, const RootObject *copy) override {
+  }
+  MemoryStats get_memory_stats() const override {
+    return {};
+  }
 
   ton::PublicKeyHash get_source_id(td::uint32 idx) const override {
     CHECK(idx < total_nodes_);
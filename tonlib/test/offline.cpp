@@ -28,11 +28,14 @@
 #include "tonlib/utils.h"
 #include "tonlib/TonlibClient.h"
 #include "tonlib/Client.h"
+#include "tonlib/Config.h"
+#include "tonlib/ExtClientLazy.h"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
 
 #include "td/utils/benchmark.h"
+#include "td/utils/Destructor.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
@@ -337,6 +340,303 @@ TEST(Tonlib, ConfigParseBug) {
   block::Config::do_get_gas_limits_prices(vm::load_cell_slice(cell), 21).ensure();
 }
 
+TEST(Tonlib, ConfigLiteServerPool) {
+  auto config = [](td::Slice pool) {
+    return PSTRING() << R"abc({
+    "liteservers": [],)abc" << pool << R"abc(
+    "validator": {
+      "@type": "validator.config.global",
+      "zero_state": {
+        "workchain": -1,
+        "shard": -9223372036854775808,
+        "seqno": 0,
+        "root_hash": "F6OpKZKqvqeFp6CQmFomXNMfMj2EnaUSOXN+Mh+wVWk=",
+        "file_hash": "XplPz01CXAps5qeSWUtxcyBfdAo5zVb1N979KLSKD24="
+      }
+    }
+  })abc";
+  };
+  auto pool = tonlib::Config::parse(config("")).move_as_ok().lite_server_pool;
+  ASSERT_EQ(1, pool.connections);
+  ASSERT_TRUE(!pool.hedge);
+
+  pool = tonlib::Config::parse(config(R"abc("liteserver_pool": {"connections": 3, "hedge": true,
+                                             "hedge_percentile": 0.9},)abc"))
+             .move_as_ok()
+             .lite_server_pool;
+  ASSERT_EQ(3, pool.connections);
+  ASSERT_TRUE(pool.hedge);
+  ASSERT_EQ(0.9, pool.hedge_percentile);
+  ASSERT_EQ(0.05, pool.hedge_min_delay);
+
+  ASSERT_TRUE(tonlib::Config::parse(config(R"abc("liteserver_pool": {"connections": 0},)abc")).is_error());
+  ASSERT_TRUE(tonlib::Config::parse(config(R"abc("liteserver_pool": {"hedge_percentile": 2},)abc")).is_error());
+}
+
+namespace {
+// liteserver behind a test connection of ExtClientLazy, answers every query with its name after the latency
+struct TestLiteServer {
+  std::string name;
+  double latency;
+  bool fail = false;  // answer with a timeout error at once
+};
+
+class TestLiteServerClient : public ton::adnl::AdnlExtClient {
+ public:
+  TestLiteServerClient(std::shared_ptr<TestLiteServer> server, std::unique_ptr<Callback> callback)
+      : server_(std::move(server)), callback_(std::move(callback)) {
+  }
+  void start_up() override {
+    callback_->on_ready();
+  }
+  void check_ready(td::Promise<td::Unit> promise) override {
+    promise.set_value(td::Unit());
+  }
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    if (server_->fail) {
+      return promise.set_error(td::Status::Error(ton::ErrorCode::timeout, "timeout"));
+    }
+    answers_.emplace(td::Timestamp::in(server_->latency).at(), std::move(promise));
+    alarm_timestamp() = td::Timestamp::at(answers_.begin()->first);
+  }
+  void alarm() override {
+    while (!answers_.empty() && answers_.begin()->first <= td::Time::now()) {
+      answers_.begin()->second.set_value(td::BufferSlice(server_->name));
+      answers_.erase(answers_.begin());
+    }
+    alarm_timestamp() = answers_.empty() ? td::Timestamp::never() : td::Timestamp::at(answers_.begin()->first);
+  }
+
+ private:
+  std::shared_ptr<TestLiteServer> server_;
+  std::unique_ptr<Callback> callback_;
+  std::multimap<double, td::Promise<td::BufferSlice>> answers_;
+};
+
+// runs the steps one after another against an ExtClientLazy connected to the test servers
+class ExtClientLazyTester : public td::actor::Actor {
+ public:
+  using Step = std::function<void(ExtClientLazyTester &, td::Promise<td::Unit>)>;
+
+  ExtClientLazyTester(std::vector<std::shared_ptr<TestLiteServer>> servers, ExtClientLazy::Options options,
+                      std::vector<Step> steps, std::shared_ptr<td::Destructor> watcher)
+      : servers_(std::move(servers))
+      , options_(std::move(options))
+      , steps_(std::move(steps))
+      , watcher_(std::move(watcher)) {
+  }
+
+  void start_up() override {
+    std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> ids;
+    for (size_t i = 0; i < servers_.size(); i++) {
+      td::IPAddress addr;
+      addr.init_ipv4_port("127.0.0.1", static_cast<int>(FIRST_PORT + i)).ensure();
+      ids.emplace_back(ton::adnl::AdnlNodeIdFull{ton::PublicKey{ton::pubkeys::Ed25519{td::Bits256::zero()}}}, addr);
+    }
+    options_.create_client = [servers = servers_](ton::adnl::AdnlNodeIdFull, td::IPAddress addr,
+                                                  std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback) {
+      return td::actor::create_actor<TestLiteServerClient>("TestLiteServerClient",
+                                                           servers.at(addr.get_port() - FIRST_PORT),
+                                                           std::move(callback));
+    };
+    client_ = ExtClientLazy::create(std::move(ids), options_, td::make_unique<ExtClientLazy::Callback>());
+    run_next();
+  }
+
+  // sends n queries one after another, appends the name of the server that answered each of them or "error" to
+  // answers
+  void send_queries(size_t n, bool read_only, td::Promise<td::Unit> promise) {
+    if (n == 0) {
+      return promise.set_value(td::Unit());
+    }
+    auto P = [SelfId = actor_id(this), n, read_only, promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+      td::actor::send_closure(SelfId, &ExtClientLazyTester::on_answer, std::move(R), n - 1, read_only,
+                              std::move(promise));
+    };
+    if (read_only) {
+      td::actor::send_closure(client_, &ExtClientLazy::send_read_only_query, "query", td::BufferSlice("query"),
+                              td::Timestamp::in(30.0), std::move(P));
+    } else {
+      td::actor::send_closure(client_, &ExtClientLazy::send_query, "query", td::BufferSlice("query"),
+                              td::Timestamp::in(30.0), std::move(P));
+    }
+  }
+
+  void fetch_stats(td::Promise<td::Unit> promise) {
+    td::actor::send_closure(
+        client_, &ExtClientLazy::get_stats,
+        [SelfId = actor_id(this), promise = std::move(promise)](td::Result<std::vector<ExtClientLazy::ServerStats>> R) mutable {
+          td::actor::send_closure(SelfId, &ExtClientLazyTester::on_stats, R.move_as_ok(), std::move(promise));
+        });
+  }
+
+  // stats of the i-th test server as of the last fetch_stats
+  const ExtClientLazy::ServerStats &stats(size_t i) const {
+    for (auto &s : stats_) {
+      if (s.address.get_port() == static_cast<int>(FIRST_PORT + i)) {
+        return s;
+      }
+    }
+    UNREACHABLE();
+  }
+
+  std::vector<std::string> answers;
+
+ private:
+  static constexpr size_t FIRST_PORT = 10000;
+
+  std::vector<std::shared_ptr<TestLiteServer>> servers_;
+  ExtClientLazy::Options options_;
+  std::vector<Step> steps_;
+  size_t next_step_ = 0;
+  td::actor::ActorOwn<ExtClientLazy> client_;
+  std::vector<ExtClientLazy::ServerStats> stats_;
+  std::shared_ptr<td::Destructor> watcher_;
+
+  void run_next() {
+    if (next_step_ == steps_.size()) {
+      client_.reset();
+      stop();
+      return;
+    }
+    steps_[next_step_++](*this, [SelfId = actor_id(this)](td::Result<td::Unit> R) {
+      R.ensure();
+      td::actor::send_closure(SelfId, &ExtClientLazyTester::run_next);
+    });
+  }
+
+  void on_answer(td::Result<td::BufferSlice> R, size_t n, bool read_only, td::Promise<td::Unit> promise) {
+    answers.push_back(R.is_ok() ? R.ok().as_slice().str() : "error");
+    send_queries(n, read_only, std::move(promise));
+  }
+
+  void on_stats(std::vector<ExtClientLazy::ServerStats> stats, td::Promise<td::Unit> promise) {
+    stats_ = std::move(stats);
+    promise.set_value(td::Unit());
+  }
+};
+
+ExtClientLazyTester::Step send_queries(size_t n, bool read_only = false) {
+  return [n, read_only](ExtClientLazyTester &t, td::Promise<td::Unit> promise) {
+    t.send_queries(n, read_only, std::move(promise));
+  };
+}
+
+ExtClientLazyTester::Step fetch_stats() {
+  return [](ExtClientLazyTester &t, td::Promise<td::Unit> promise) { t.fetch_stats(std::move(promise)); };
+}
+
+ExtClientLazyTester::Step check(std::function<void(ExtClientLazyTester &)> f) {
+  return [f = std::move(f)](ExtClientLazyTester &t, td::Promise<td::Unit> promise) {
+    f(t);
+    promise.set_value(td::Unit());
+  };
+}
+
+std::vector<std::shared_ptr<TestLiteServer>> test_lite_servers(std::vector<double> latencies) {
+  std::vector<std::shared_ptr<TestLiteServer>> servers;
+  for (auto latency : latencies) {
+    servers.push_back(std::make_shared<TestLiteServer>(TestLiteServer{std::to_string(servers.size()), latency}));
+  }
+  return servers;
+}
+
+// the scheduler has a single worker thread, so the steps change the test servers without locks
+void run_ext_client_test(std::vector<std::shared_ptr<TestLiteServer>> servers, ExtClientLazy::Options options,
+                         std::vector<ExtClientLazyTester::Step> steps) {
+  td::actor::Scheduler scheduler({1});
+  auto watcher = td::create_shared_destructor([] { td::actor::SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([&] {
+    td::actor::create_actor<ExtClientLazyTester>("ExtClientLazyTester", std::move(servers), std::move(options),
+                                                 std::move(steps), std::move(watcher))
+        .release();
+  });
+  scheduler.run();
+}
+}  // namespace
+
+TEST(Tonlib, ExtClientLazyRouting) {
+  ExtClientLazy::Options options;
+  options.connections = 3;
+  run_ext_client_test(test_lite_servers({0.05, 0.01, 0.1}), options,
+                      {send_queries(12), fetch_stats(), check([](ExtClientLazyTester &t) {
+                         // every server is tried once, then the queries go to the fastest one
+                         ASSERT_EQ(12u, t.answers.size());
+                         for (size_t i = 4; i < t.answers.size(); i++) {
+                           ASSERT_EQ("1", t.answers[i]);
+                         }
+                         td::uint64 queries = 0;
+                         for (size_t i = 0; i < 3; i++) {
+                           ASSERT_TRUE(t.stats(i).connected);
+                           ASSERT_EQ(0u, t.stats(i).errors);
+                           ASSERT_TRUE(t.stats(i).queries >= 1);
+                           queries += t.stats(i).queries;
+                         }
+                         ASSERT_EQ(12u, queries);
+                         ASSERT_TRUE(t.stats(1).latency < t.stats(0).latency);
+                         ASSERT_TRUE(t.stats(0).latency < t.stats(2).latency);
+                       })});
+}
+
+TEST(Tonlib, ExtClientLazyFailover) {
+  auto servers = test_lite_servers({0.01, 0.01});
+  size_t first = 0;
+  run_ext_client_test(servers, ExtClientLazy::Options(),
+                      {send_queries(1), check([&](ExtClientLazyTester &t) {
+                         // only one connection is kept, make its server time out
+                         first = t.answers[0] == "0" ? 0 : 1;
+                         servers[first]->fail = true;
+                       }),
+                       send_queries(1), check([&](ExtClientLazyTester &t) { ASSERT_EQ("error", t.answers[1]); }),
+                       send_queries(3), fetch_stats(), check([&](ExtClientLazyTester &t) {
+                         // the server that timed out is dropped, the next queries go to the other one
+                         for (size_t i = 2; i < t.answers.size(); i++) {
+                           ASSERT_EQ(servers[1 - first]->name, t.answers[i]);
+                         }
+                         ASSERT_TRUE(!t.stats(first).connected);
+                         ASSERT_EQ(2u, t.stats(first).queries);
+                         ASSERT_EQ(1u, t.stats(first).errors);
+                         ASSERT_TRUE(t.stats(1 - first).connected);
+                         ASSERT_EQ(3u, t.stats(1 - first).queries);
+                         ASSERT_EQ(0u, t.stats(1 - first).errors);
+                       })});
+}
+
+TEST(Tonlib, ExtClientLazyHedging) {
+  auto servers = test_lite_servers({0.02, 0.2});
+  ExtClientLazy::Options options;
+  options.connections = 2;
+  options.hedge = true;
+  options.hedge_min_delay = 0.05;
+  double started_at = 0;
+  run_ext_client_test(servers, options,
+                      {// collect enough latency samples of the fast server to hedge its queries
+                       send_queries(12, true), check([&](ExtClientLazyTester &t) {
+                         ASSERT_EQ("0", t.answers.back());
+                         // the fast server stalls, the duplicate sent to the slow one answers first
+                         servers[0]->latency = 10;
+                         started_at = td::Time::now();
+                       }),
+                       send_queries(1, true), fetch_stats(), check([&](ExtClientLazyTester &t) {
+                         ASSERT_EQ("1", t.answers.back());
+                         ASSERT_TRUE(td::Time::now() - started_at < 5);
+                         ASSERT_EQ(1u, t.stats(0).hedged);
+                         ASSERT_EQ(1u, t.stats(1).hedge_wins);
+                         // the copy that lost the race is still pending, both servers stay connected
+                         ASSERT_EQ(0u, t.stats(0).errors);
+                         ASSERT_TRUE(t.stats(0).connected);
+                         ASSERT_TRUE(t.stats(1).connected);
+                         servers[0]->latency = 0.02;
+                       }),
+                       // plain queries are never duplicated
+                       send_queries(3), fetch_stats(), check([&](ExtClientLazyTester &t) {
+                         ASSERT_EQ("0", t.answers.back());
+                         ASSERT_EQ(1u, t.stats(0).hedged);
+                         ASSERT_EQ(1u, t.stats(1).hedge_wins);
+                       })});
+}
+
 TEST(Tonlib, EncryptionApi) {
   using tonlib_api::make_object;
   Client client;
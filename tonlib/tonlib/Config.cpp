@@ -105,6 +105,24 @@ td::Result<Config> Config::parse(std::string str) {
     res.lite_clients.push_back(std::move(client));
   }
 
+  auto r_pool_obj = td::get_json_object_field(json.get_object(), "liteserver_pool", td::JsonValue::Type::Object, false);
+  if (r_pool_obj.is_ok()) {
+    auto pool_obj = r_pool_obj.move_as_ok();
+    auto &pool = pool_obj.get_object();
+    auto &res_pool = res.lite_server_pool;
+    TRY_RESULT_ASSIGN(res_pool.connections,
+                      td::get_json_object_int_field(pool, "connections", true, res_pool.connections));
+    TRY_RESULT_ASSIGN(res_pool.hedge, td::get_json_object_bool_field(pool, "hedge", true, res_pool.hedge));
+    TRY_RESULT_ASSIGN(res_pool.hedge_percentile,
+                      td::get_json_object_double_field(pool, "hedge_percentile", true, res_pool.hedge_percentile));
+    TRY_RESULT_ASSIGN(res_pool.hedge_min_delay,
+                      td::get_json_object_double_field(pool, "hedge_min_delay", true, res_pool.hedge_min_delay));
+    if (res_pool.connections < 1 || !(res_pool.hedge_percentile >= 0 && res_pool.hedge_percentile <= 1) ||
+        !(res_pool.hedge_min_delay >= 0)) {
+      return td::Status::Error("Invalid config (10)");
+    }
+  }
+
   TRY_RESULT(validator_obj,
              td::get_json_object_field(json.get_object(), "validator", td::JsonValue::Type::Object, false));
   auto &validator = validator_obj.get_object();
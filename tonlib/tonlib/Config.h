@@ -31,6 +31,14 @@ struct Config {
   ton::BlockIdExt init_block_id;
   std::vector<ton::BlockIdExt> hardforks;
   std::vector<LiteClient> lite_clients;
+  // optional "liteserver_pool" object, see ExtClientLazy::Options
+  struct LiteServerPool {
+    td::int32 connections = 1;
+    bool hedge = false;
+    double hedge_percentile = 0.95;
+    double hedge_min_delay = 0.05;
+  };
+  LiteServerPool lite_server_pool;
   std::string name;
   static td::Result<Config> parse(std::string str);
 };
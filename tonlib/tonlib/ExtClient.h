@@ -76,8 +76,10 @@ class ExtClient {
     td::BufferSlice liteserver_query =
         ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_query>(std::move(raw_query)), true);
 
+    // everything but sendMessage only reads the state, so it may be sent to more than one liteserver
+    constexpr bool read_only = !std::is_same<QueryT, ton::lite_api::liteServer_sendMessage>::value;
     send_raw_query(
-        std::move(liteserver_query), [promise = std::move(promise), tag](td::Result<td::BufferSlice> R) mutable {
+        std::move(liteserver_query), read_only, [promise = std::move(promise), tag](td::Result<td::BufferSlice> R) mutable {
           auto res = [&]() -> td::Result<typename QueryT::ReturnType> {
             TRY_RESULT_PREFIX(data, std::move(R), TonlibError::LiteServerNetwork());
             auto r_error = ton::fetch_tl_object<ton::lite_api::liteServer_error>(data.clone(), true);
@@ -101,12 +103,19 @@ class ExtClient {
     }
   }
 
+  void get_liteserver_stats(td::Promise<std::vector<ExtClientLazy::ServerStats>> promise) {
+    if (client_.adnl_ext_client_.empty()) {
+      return promise.set_error(TonlibError::NoLiteServers());
+    }
+    td::actor::send_closure(client_.adnl_ext_client_, &ExtClientLazy::get_stats, std::move(promise));
+  }
+
  private:
   ExtClientRef client_;
   td::Container<td::Promise<td::BufferSlice>> queries_;
   td::Container<td::Promise<LastBlockState>> last_block_queries_;
   td::Container<td::Promise<LastConfigState>> last_config_queries_;
 
-  void send_raw_query(td::BufferSlice query, td::Promise<td::BufferSlice> promise);
+  void send_raw_query(td::BufferSlice query, bool read_only, td::Promise<td::BufferSlice> promise);
 };
 }  // namespace tonlib
@@ -19,14 +19,24 @@
 #include "ExtClientLazy.h"
 #include "TonlibError.h"
 #include "td/utils/Random.h"
+
+#include <algorithm>
+#include <map>
+
 namespace tonlib {
 
 class ExtClientLazyImp : public ExtClientLazy {
  public:
-  ExtClientLazyImp(std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers,
+  ExtClientLazyImp(std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, Options options,
                    td::unique_ptr<ExtClientLazy::Callback> callback)
-      : servers_(std::move(servers)), callback_(std::move(callback)) {
-    CHECK(!servers_.empty());
+      : options_(std::move(options)), callback_(std::move(callback)) {
+    CHECK(!servers.empty());
+    for (auto& s : servers) {
+      servers_.emplace_back();
+      servers_.back().id = std::move(s.first);
+      servers_.back().addr = s.second;
+    }
+    options_.connections = std::max<size_t>(1, std::min(options_.connections, servers_.size()));
   }
 
   void start_up() override {
@@ -36,92 +46,321 @@ class ExtClientLazyImp : public ExtClientLazy {
 
   void check_ready(td::Promise<td::Unit> promise) override {
     before_query();
-    if (client_.empty()) {
+    auto idx = choose_server();
+    if (idx == NONE) {
       return promise.set_error(TonlibError::Cancelled());
     }
-    send_closure(client_, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
+    send_closure(servers_[idx].client, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
   }
 
   void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
                   td::Promise<td::BufferSlice> promise) override {
+    do_send_query(std::move(name), std::move(data), timeout, std::move(promise), false);
+  }
+
+  void send_read_only_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                            td::Promise<td::BufferSlice> promise) override {
+    do_send_query(std::move(name), std::move(data), timeout, std::move(promise), options_.hedge);
+  }
+
+  void force_change_liteserver() override {
+    if (servers_.size() == 1) {
+      return;
+    }
+    for (auto& s : servers_) {
+      if (!s.client.empty()) {
+        s.bad = s.bad_force = true;
+      }
+    }
+  }
+
+  void get_stats(td::Promise<std::vector<ExtClientLazy::ServerStats>> promise) override {
+    std::vector<ExtClientLazy::ServerStats> res;
+    for (const auto& s : servers_) {
+      res.emplace_back(s.stats);
+      res.back().address = s.addr;
+      res.back().connected = !s.client.empty() && s.ready;
+    }
+    promise.set_value(std::move(res));
+  }
+
+ private:
+  static constexpr size_t NONE = static_cast<size_t>(-1);
+  static constexpr double MAX_NO_QUERIES_TIMEOUT = 100;
+  static constexpr double LATENCY_EWMA_FACTOR = 0.2;
+  static constexpr double ERROR_EWMA_FACTOR = 0.1;
+  static constexpr size_t LATENCY_SAMPLES = 64;
+  static constexpr size_t MIN_HEDGE_SAMPLES = 8;
+
+  struct Server {
+    ton::adnl::AdnlNodeIdFull id;
+    td::IPAddress addr;
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client;
+    td::uint32 generation = 0;
+    bool ready = false;
+    bool bad = false;
+    bool bad_force = false;
+    ExtClientLazy::ServerStats stats;
+    std::vector<double> latencies;  // ring buffer of the last LATENCY_SAMPLES latencies
+    size_t latencies_pos = 0;
+  };
+
+  // read-only query that may be hedged; other queries are not stored
+  struct Query {
+    std::string name;
+    td::BufferSlice data;
+    td::Timestamp timeout;
+    td::Promise<td::BufferSlice> promise;
+    size_t server;
+    td::Timestamp hedge_at;
+    size_t pending = 1;
+  };
+
+  std::vector<Server> servers_;
+  Options options_;
+  size_t next_server_idx_ = 0;
+  std::map<td::uint64, Query> queries_;
+  td::uint64 next_query_id_ = 0;
+  td::Timestamp idle_at_;
+
+  td::unique_ptr<ExtClientLazy::Callback> callback_;
+
+  bool is_closing_{false};
+  td::uint32 ref_cnt_{1};
+
+  void do_send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                     td::Promise<td::BufferSlice> promise, bool hedge) {
     before_query();
-    if (client_.empty()) {
+    auto idx = choose_server();
+    if (idx == NONE) {
       return promise.set_error(TonlibError::Cancelled());
     }
-    td::Promise<td::BufferSlice> P = [SelfId = actor_id(this), idx = cur_server_idx_,
+    auto delay = hedge ? hedge_delay(idx) : -1.0;
+    if (delay < 0 || td::Timestamp::in(delay).at() >= timeout.at()) {
+      return send_to_server(idx, std::move(name), std::move(data), timeout, std::move(promise), false);
+    }
+    auto query_id = next_query_id_++;
+    auto& q = queries_[query_id];
+    q.name = name;
+    q.data = data.clone();
+    q.timeout = timeout;
+    q.promise = std::move(promise);
+    q.server = idx;
+    q.hedge_at = td::Timestamp::in(delay);
+    send_to_server(idx, std::move(name), std::move(data), timeout, wrap_hedged(query_id, false), false);
+    update_alarm();
+  }
+
+  td::Promise<td::BufferSlice> wrap_hedged(td::uint64 query_id, bool is_hedge) {
+    return [SelfId = actor_id(this), query_id, is_hedge](td::Result<td::BufferSlice> R) {
+      td::actor::send_closure(SelfId, &ExtClientLazyImp::on_hedged_result, query_id, is_hedge, std::move(R));
+    };
+  }
+
+  void send_to_server(size_t idx, std::string name, td::BufferSlice data, td::Timestamp timeout,
+                      td::Promise<td::BufferSlice> promise, bool is_hedge) {
+    auto& s = servers_[idx];
+    s.stats.queries++;
+    td::Promise<td::BufferSlice> P = [SelfId = actor_id(this), idx, generation = s.generation, is_hedge,
+                                      started_at = td::Time::now(),
                                       promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
-      if (R.is_error() &&
-          (R.error().code() == ton::ErrorCode::timeout || R.error().code() == ton::ErrorCode::cancelled)) {
-        td::actor::send_closure(SelfId, &ExtClientLazyImp::set_server_bad, idx, true);
-      }
+      td::actor::send_closure(SelfId, &ExtClientLazyImp::on_server_result, idx, generation,
+                              td::Time::now() - started_at, R.is_ok() ? td::Status::OK() : R.error().clone(),
+                              is_hedge);
       promise.set_result(std::move(R));
     };
-    send_closure(client_, &ton::adnl::AdnlExtClient::send_query, std::move(name), std::move(data), timeout,
+    send_closure(s.client, &ton::adnl::AdnlExtClient::send_query, std::move(name), std::move(data), timeout,
                  std::move(P));
   }
 
-  void force_change_liteserver() override {
-    if (servers_.size() == 1) {
+  void on_server_result(size_t idx, td::uint32 generation, double latency, td::Status status, bool is_hedge) {
+    auto& s = servers_[idx];
+    if (status.is_ok()) {
+      s.stats.latency = s.stats.latency == 0 ? latency
+                                             : s.stats.latency + (latency - s.stats.latency) * LATENCY_EWMA_FACTOR;
+      s.stats.error_rate -= s.stats.error_rate * ERROR_EWMA_FACTOR;
+      if (s.latencies.size() < LATENCY_SAMPLES) {
+        s.latencies.push_back(latency);
+      } else {
+        s.latencies[s.latencies_pos] = latency;
+        s.latencies_pos = (s.latencies_pos + 1) % LATENCY_SAMPLES;
+      }
       return;
     }
-    cur_server_bad_ = cur_server_bad_force_ = true;
+    s.stats.errors++;
+    s.stats.error_rate += (1.0 - s.stats.error_rate) * ERROR_EWMA_FACTOR;
+    // a duplicate is sent later than the original but with the same timeout, so its timeout says nothing about the
+    // server; the copy that lost the race is not cancelled, its answer is just dropped in on_hedged_result
+    if (!is_hedge && (status.code() == ton::ErrorCode::timeout || status.code() == ton::ErrorCode::cancelled)) {
+      set_server_bad(idx, generation, true);
+    }
+  }
+
+  void on_hedged_result(td::uint64 query_id, bool is_hedge, td::Result<td::BufferSlice> R) {
+    auto it = queries_.find(query_id);
+    if (it == queries_.end()) {
+      return;
+    }
+    auto& q = it->second;
+    q.pending--;
+    if (R.is_error() && q.pending > 0) {
+      // the other copy may still succeed
+      return;
+    }
+    if (R.is_ok() && is_hedge) {
+      servers_[q.server].stats.hedge_wins++;
+    }
+    q.promise.set_result(std::move(R));
+    queries_.erase(it);
+    update_alarm();
+  }
+
+  void send_hedge(td::uint64 query_id, Query& q) {
+    q.hedge_at = td::Timestamp::never();
+    auto idx = choose_server(q.server);
+    if (idx == NONE || q.timeout.is_in_past()) {
+      return;
+    }
+    servers_[q.server].stats.hedged++;
+    q.server = idx;
+    q.pending++;
+    send_to_server(idx, q.name, q.data.clone(), q.timeout, wrap_hedged(query_id, true), true);
+  }
+
+  // delay after which a read-only query to the server is duplicated, negative if it is not
+  double hedge_delay(size_t idx) const {
+    const auto& s = servers_[idx];
+    if (options_.connections < 2 || s.latencies.size() < MIN_HEDGE_SAMPLES) {
+      return -1;
+    }
+    auto latencies = s.latencies;
+    auto k = static_cast<size_t>(options_.hedge_percentile * static_cast<double>(latencies.size() - 1));
+    k = std::min(k, latencies.size() - 1);
+    std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+    return std::max(latencies[k], options_.hedge_min_delay);
+  }
+
+  // connected server with the lowest expected latency, servers that are not ready yet are used only if there is
+  // nothing else
+  size_t choose_server(size_t except = NONE) const {
+    size_t best = NONE;
+    double best_score = 0;
+    for (size_t i = 0; i < servers_.size(); i++) {
+      const auto& s = servers_[i];
+      if (i == except || s.client.empty() || s.bad) {
+        continue;
+      }
+      // servers without samples yet score 0 and so get tried first
+      double score = s.stats.latency / (1.0 - std::min(s.stats.error_rate, 0.9));
+      if (!s.ready) {
+        score += 1e9;
+      }
+      if (best == NONE || score < best_score) {
+        best = i;
+        best_score = score;
+      }
+    }
+    return best;
   }
 
- private:
   void before_query() {
     if (is_closing_) {
       return;
     }
-    alarm_timestamp() = td::Timestamp::in(MAX_NO_QUERIES_TIMEOUT);
-    if (cur_server_bad_) {
-      ++cur_server_idx_;
-    } else if (!client_.empty()) {
-      return;
+    idle_at_ = td::Timestamp::in(MAX_NO_QUERIES_TIMEOUT);
+    update_alarm();
+    size_t connected = 0;
+    for (size_t i = 0; i < servers_.size(); i++) {
+      auto& s = servers_[i];
+      if (s.client.empty()) {
+        continue;
+      }
+      if (s.bad) {
+        LOG(INFO) << "Disconnecting from liteserver " << s.addr;
+        s.client.reset();
+        s.ready = false;
+        continue;
+      }
+      connected++;
+    }
+    for (size_t attempts = 0; connected < options_.connections && attempts < servers_.size(); attempts++) {
+      auto idx = next_server_idx_++ % servers_.size();
+      if (servers_[idx].client.empty()) {
+        connect(idx);
+        connected++;
+      }
     }
+  }
+
+  void connect(size_t idx) {
     class Callback : public ton::adnl::AdnlExtClient::Callback {
      public:
-      explicit Callback(td::actor::ActorShared<ExtClientLazyImp> parent, size_t idx)
-          : parent_(std::move(parent)), idx_(idx) {
+      explicit Callback(td::actor::ActorShared<ExtClientLazyImp> parent, size_t idx, td::uint32 generation)
+          : parent_(std::move(parent)), idx_(idx), generation_(generation) {
       }
       void on_ready() override {
-        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_bad, idx_, false);
+        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_ready, idx_, generation_, true);
       }
       void on_stop_ready() override {
-        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_bad, idx_, true);
+        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_ready, idx_, generation_, false);
       }
 
      private:
       td::actor::ActorShared<ExtClientLazyImp> parent_;
       size_t idx_;
+      td::uint32 generation_;
     };
     ref_cnt_++;
-    cur_server_bad_ = false;
-    cur_server_bad_force_ = false;
-    const auto& s = servers_[cur_server_idx_ % servers_.size()];
-    LOG(INFO) << "Connecting to liteserver " << s.second;
-    client_ = ton::adnl::AdnlExtClient::create(
-        s.first, s.second, std::make_unique<Callback>(td::actor::actor_shared(this), cur_server_idx_));
+    auto& s = servers_[idx];
+    s.generation++;
+    s.ready = false;
+    s.bad = false;
+    s.bad_force = false;
+    LOG(INFO) << "Connecting to liteserver " << s.addr;
+    auto callback = std::make_unique<Callback>(td::actor::actor_shared(this), idx, s.generation);
+    if (options_.create_client) {
+      s.client = options_.create_client(s.id, s.addr, std::move(callback));
+    } else {
+      s.client = ton::adnl::AdnlExtClient::create(s.id, s.addr, std::move(callback));
+    }
   }
 
-  std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers_;
-  size_t cur_server_idx_ = 0;
-  bool cur_server_bad_ = false;
-  bool cur_server_bad_force_ = false;
-
-  td::actor::ActorOwn<ton::adnl::AdnlExtClient> client_;
-  td::unique_ptr<ExtClientLazy::Callback> callback_;
-  static constexpr double MAX_NO_QUERIES_TIMEOUT = 100;
-
-  bool is_closing_{false};
-  td::uint32 ref_cnt_{1};
+  void set_server_ready(size_t idx, td::uint32 generation, bool ready) {
+    auto& s = servers_[idx];
+    if (s.generation != generation || s.client.empty()) {
+      return;
+    }
+    s.ready = ready;
+    set_server_bad(idx, generation, !ready);
+  }
+  void set_server_bad(size_t idx, td::uint32 generation, bool bad) {
+    auto& s = servers_[idx];
+    if (s.generation == generation && servers_.size() > 1 && !s.bad_force) {
+      s.bad = bad;
+    }
+  }
 
-  void set_server_bad(size_t idx, bool bad) {
-    if (idx == cur_server_idx_ && servers_.size() > 1 && !cur_server_bad_force_) {
-      cur_server_bad_ = bad;
+  void update_alarm() {
+    alarm_timestamp() = idle_at_;
+    for (auto& it : queries_) {
+      alarm_timestamp().relax(it.second.hedge_at);
     }
   }
+
   void alarm() override {
-    client_.reset();
+    for (auto& it : queries_) {
+      if (it.second.hedge_at && it.second.hedge_at.is_in_past()) {
+        send_hedge(it.first, it.second);
+      }
+    }
+    if (idle_at_ && idle_at_.is_in_past()) {
+      idle_at_ = td::Timestamp::never();
+      for (auto& s : servers_) {
+        s.client.reset();
+        s.ready = false;
+      }
+    }
+    update_alarm();
   }
   void hangup_shared() override {
     ref_cnt_--;
@@ -130,7 +369,13 @@ class ExtClientLazyImp : public ExtClientLazy {
   void hangup() override {
     is_closing_ = true;
     ref_cnt_--;
-    client_.reset();
+    for (auto& s : servers_) {
+      s.client.reset();
+    }
+    for (auto& it : queries_) {
+      it.second.promise.set_error(TonlibError::Cancelled());
+    }
+    queries_.clear();
     try_stop();
   }
   void try_stop() {
@@ -147,6 +392,13 @@ td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(ton::adnl::AdnlNodeIdFu
 
 td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(
     std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback) {
-  return td::actor::create_actor<ExtClientLazyImp>("ExtClientLazy", std::move(servers), std::move(callback));
+  return create(std::move(servers), Options(), std::move(callback));
+}
+
+td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(
+    std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, Options options,
+    td::unique_ptr<Callback> callback) {
+  return td::actor::create_actor<ExtClientLazyImp>("ExtClientLazy", std::move(servers), std::move(options),
+                                                   std::move(callback));
 }
 }  // namespace tonlib
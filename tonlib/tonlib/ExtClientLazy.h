@@ -21,6 +21,8 @@
 
 #include "adnl/adnl-ext-client.h"
 
+#include <functional>
+
 namespace tonlib {
 class ExtClientLazy : public ton::adnl::AdnlExtClient {
  public:
@@ -30,12 +32,46 @@ class ExtClientLazy : public ton::adnl::AdnlExtClient {
     }
   };
 
+  struct Options {
+    // number of liteservers to keep connections to, each query goes to the best of them
+    size_t connections = 1;
+    // read-only queries not answered in time are duplicated to the second best server, first answer wins
+    bool hedge = false;
+    // the duplicate is sent when the query takes longer than this percentile of recent latencies of the server
+    double hedge_percentile = 0.95;
+    double hedge_min_delay = 0.05;
+    // creates the connection to a liteserver, AdnlExtClient::create if empty
+    std::function<td::actor::ActorOwn<ton::adnl::AdnlExtClient>(
+        ton::adnl::AdnlNodeIdFull, td::IPAddress, std::unique_ptr<ton::adnl::AdnlExtClient::Callback>)>
+        create_client;
+  };
+
+  struct ServerStats {
+    td::IPAddress address;
+    bool connected = false;
+    double latency = 0;     // EWMA of successful queries, seconds
+    double error_rate = 0;  // EWMA of failed queries, 0..1
+    td::uint64 queries = 0;
+    td::uint64 errors = 0;
+    td::uint64 hedged = 0;      // queries to this server that were duplicated to another one
+    td::uint64 hedge_wins = 0;  // duplicates sent to this server that were answered first
+  };
+
   virtual void force_change_liteserver() = 0;
+  // query without side effects, it may be sent to several servers at once
+  virtual void send_read_only_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                                    td::Promise<td::BufferSlice> promise) {
+    send_query(std::move(name), std::move(data), timeout, std::move(promise));
+  }
+  virtual void get_stats(td::Promise<std::vector<ServerStats>> promise) = 0;
 
   static td::actor::ActorOwn<ExtClientLazy> create(ton::adnl::AdnlNodeIdFull dst, td::IPAddress dst_addr,
                                                    td::unique_ptr<Callback> callback);
   static td::actor::ActorOwn<ExtClientLazy> create(
       std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback);
+  static td::actor::ActorOwn<ExtClientLazy> create(
+      std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, Options options,
+      td::unique_ptr<Callback> callback);
 };
 
 }  // namespace tonlib
@@ -41,6 +41,10 @@ class ExtClientOutboundImp : public ExtClientOutbound {
   void force_change_liteserver() override {
   }
 
+  void get_stats(td::Promise<std::vector<ExtClientLazy::ServerStats>> promise) override {
+    promise.set_value({});
+  }
+
   void on_query_result(td::int64 id, td::Result<td::BufferSlice> r_data, td::Promise<td::Unit> promise) override {
     auto it = queries_.find(id);
     if (it == queries_.end()) {
@@ -2120,7 +2120,13 @@ void TonlibClient::init_ext_client() {
     };
     ext_client_outbound_ = {};
     ref_cnt_++;
-    raw_client_ = ExtClientLazy::create(std::move(servers), td::make_unique<Callback>(td::actor::actor_shared()));
+    ExtClientLazy::Options options;
+    options.connections = static_cast<size_t>(config_.lite_server_pool.connections);
+    options.hedge = config_.lite_server_pool.hedge;
+    options.hedge_percentile = config_.lite_server_pool.hedge_percentile;
+    options.hedge_min_delay = config_.lite_server_pool.hedge_min_delay;
+    raw_client_ = ExtClientLazy::create(std::move(servers), std::move(options),
+                                        td::make_unique<Callback>(td::actor::actor_shared()));
   }
 }
 
@@ -5366,6 +5372,20 @@ td::Status TonlibClient::do_request(const tonlib_api::liteServer_getInfo& reques
   return td::Status::OK();
 }
 
+td::Status TonlibClient::do_request(const tonlib_api::liteServer_getStats& request,
+                                    td::Promise<object_ptr<tonlib_api::liteServer_stats>>&& promise) {
+  client_.get_liteserver_stats(promise.wrap([](std::vector<ExtClientLazy::ServerStats> stats) {
+    std::vector<object_ptr<tonlib_api::liteServer_serverStats>> servers;
+    for (auto& s : stats) {
+      servers.push_back(tonlib_api::make_object<tonlib_api::liteServer_serverStats>(
+          PSTRING() << s.address, s.connected, s.latency, s.error_rate, static_cast<td::int64>(s.queries),
+          static_cast<td::int64>(s.errors), static_cast<td::int64>(s.hedged), static_cast<td::int64>(s.hedge_wins)));
+    }
+    return tonlib_api::make_object<tonlib_api::liteServer_stats>(std::move(servers));
+  }));
+  return td::Status::OK();
+}
+
 auto to_bits256(td::Slice data, td::Slice name) -> td::Result<td::Bits256> {
   if (data.size() != 32) {
     return TonlibError::InvalidField(name, "wrong length (not 32 bytes)");
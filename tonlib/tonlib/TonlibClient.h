@@ -373,6 +373,8 @@ class TonlibClient : public td::actor::Actor {
 
   td::Status do_request(const tonlib_api::liteServer_getInfo& request,
                         td::Promise<object_ptr<tonlib_api::liteServer_info>>&& promise);
+  td::Status do_request(const tonlib_api::liteServer_getStats& request,
+                        td::Promise<object_ptr<tonlib_api::liteServer_stats>>&& promise);
 
   td::Status do_request(tonlib_api::withBlock& request, td::Promise<object_ptr<tonlib_api::Object>>&& promise);
 
@@ -74,6 +74,7 @@
 #include "common/delay.h"
 #include "block/precompiled-smc/PrecompiledSmartContract.h"
 #include "interfaces/validator-manager.h"
+#include "validator/stats-merger.h"
 
 #if TON_USE_JEMALLOC
 #include <jemalloc/jemalloc.h>
@@ -1445,6 +1446,9 @@ td::Status ValidatorEngine::load_global_config() {
   }
   validator_options_.write().set_celldb_direct_io(celldb_direct_io_);
   validator_options_.write().set_celldb_preload_all(celldb_preload_all_);
+  validator_options_.write().set_celldb_cell_cache_size(celldb_cell_cache_size_);
+  validator_options_.write().set_celldb_replicas(celldb_replicas_);
+  validator_options_.write().set_celldb_replica_cache_size(celldb_replica_cache_size_);
   if (catchain_max_block_delay_) {
     validator_options_.write().set_catchain_max_block_delay(catchain_max_block_delay_.value());
   }
@@ -1482,6 +1486,11 @@ td::Status ValidatorEngine::load_global_config() {
     }
   }
   validator_options_.write().set_fast_state_serializer_enabled(fast_state_serializer_enabled_);
+  validator_options_.write().set_sync_archive_window(sync_archive_window_);
+  validator_options_.write().set_sync_archive_temp_limit(sync_archive_temp_limit_);
+  validator_options_.write().set_archive_import_parallelism(archive_import_parallelism_);
+  validator_options_.write().set_persistent_state_compression(persistent_state_compression_);
+  validator_options_.write().set_archive_group_commit_window(archive_group_commit_window_);
 
   return td::Status::OK();
 }
@@ -1842,7 +1851,8 @@ void ValidatorEngine::started_adnl() {
 }
 
 void ValidatorEngine::add_dht(ton::PublicKeyHash id) {
-  auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{id}, db_root_, dht_config_, keyring_.get(), adnl_.get());
+  auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{id}, db_root_, dht_config_, keyring_.get(), adnl_.get(),
+                                 dht_lookup_cache_size_);
   D.ensure();
 
   dht_nodes_[id] = D.move_as_ok();
@@ -1940,6 +1950,9 @@ void ValidatorEngine::start_full_node() {
         config_.full_node_config, keyring_.get(), adnl_.get(), rldp_.get(), rldp2_.get(),
         default_dht_node_.is_zero() ? td::actor::ActorId<ton::dht::Dht>{} : dht_nodes_[default_dht_node_].get(),
         overlay_manager_.get(), validator_manager_.get(), full_node_client_.get(), db_root_);
+    if (broadcast_cell_delta_) {
+      td::actor::send_closure(full_node_, &ton::validator::fullnode::FullNode::set_broadcast_cell_delta, true);
+    }
     load_custom_overlays_config();
   }
 
@@ -3295,7 +3308,13 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getStats
           promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_stats>(std::move(vec)));
         }
       });
-  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_stats, std::move(P));
+  auto merger = ton::validator::StatsMerger::create(std::move(P));
+  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_stats,
+                          merger.make_promise(""));
+  auto it = dht_nodes_.find(default_dht_node_);
+  if (it != dht_nodes_.end()) {
+    td::actor::send_closure(it->second, &ton::dht::Dht::prepare_stats, merger.make_promise("dht."));
+  }
 }
 
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_createElectionBid &query, td::BufferSlice data,
@@ -4265,6 +4284,36 @@ int main(int argc, char *argv[]) {
       '\0', "celldb-preload-all",
       "preload all cells from CellDb on startup (recommended to use with big enough celldb-cache-size and celldb-direct-io)",
       [&]() { acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_preload_all, true); }); });
+  p.add_checked_option(
+      '\0', "celldb-cell-cache-size",
+      "size of the cache of decoded cells in front of RocksDb in CellDb, in bytes (default: 0 - disabled)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint64>(s));
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_cell_cache_size, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "celldb-replicas",
+      "number of read-only replicas of CellDb (RocksDb secondary instances) for liteserver queries (default: 0)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+        if (v > 16) {
+          return td::Status::Error("celldb-replicas should be at most 16");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_replicas, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "celldb-replica-cache-size",
+      "block cache size for RocksDb shared by CellDb replicas, in bytes (default: 1G)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint64>(s));
+        if (v == 0) {
+          return td::Status::Error("celldb-replica-cache-size should be positive");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_replica_cache_size, v); });
+        return td::Status::OK();
+      });
   p.add_checked_option(
       '\0', "catchain-max-block-delay", "delay before creating a new catchain block, in seconds (default: 0.4)",
       [&](td::Slice s) -> td::Status {
@@ -4292,6 +4341,71 @@ int main(int argc, char *argv[]) {
         acts.push_back(
             [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_fast_state_serializer_enabled, true); });
       });
+  p.add_checked_option(
+      '\0', "sync-archive-window",
+      "number of archive slices downloaded ahead of the importer during initial sync (default: 4)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<size_t>(s));
+        if (v == 0) {
+          return td::Status::Error("sync-archive-window should be positive");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_sync_archive_window, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "sync-archive-temp-limit",
+      "limit on disk space taken by archive slices downloaded ahead during initial sync, in bytes (default: 4G)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint64>(s));
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_sync_archive_temp_limit, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "archive-import-parallelism",
+      "number of shard blocks applied concurrently when importing archive slices (default: 8)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<size_t>(s));
+        if (v == 0) {
+          return td::Status::Error("archive-import-parallelism should be positive");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_archive_import_parallelism, v); });
+        return td::Status::OK();
+      });
+  p.add_option(
+      '\0', "persistent-state-compression",
+      "store new persistent states as lz4 frames with a seek index (smaller on disk and in transfer to new nodes)",
+      [&]() {
+        acts.push_back(
+            [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_persistent_state_compression, true); });
+      });
+  p.add_checked_option(
+      '\0', "archive-group-commit-window",
+      "commit archive index updates of many blocks together, at most this many seconds after the first one "
+      "(default: 0 - commit each update separately)",
+      [&](td::Slice s) -> td::Status {
+        auto v = td::to_double(s);
+        if (v < 0 || v > 1) {
+          return td::Status::Error("archive-group-commit-window should be in [0, 1]");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_archive_group_commit_window, v); });
+        return td::Status::OK();
+      });
+  p.add_option(
+      '\0', "broadcast-cell-delta",
+      "send blocks in validators' private overlays with cells of the previous state replaced with their hashes "
+      "(all validators of the overlay must support it)",
+      [&]() {
+        acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_broadcast_cell_delta, true); });
+      });
+  p.add_checked_option(
+      '\0', "dht-lookup-cache-size",
+      PSTRING() << "number of DHT values found by lookups to cache (default: "
+                << ton::dht::Dht::default_lookup_cache_size() << ")",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_dht_lookup_cache_size, v); });
+        return td::Status::OK();
+      });
   auto S = p.run(argc, argv);
   if (S.is_error()) {
     LOG(ERROR) << "failed to parse options: " << S.move_as_error();
@@ -214,6 +214,9 @@ class ValidatorEngine : public td::actor::Actor {
   td::optional<td::uint64> celldb_cache_size_ = 1LL << 30;
   bool celldb_direct_io_ = false;
   bool celldb_preload_all_ = false;
+  td::uint64 celldb_cell_cache_size_ = 0;
+  td::uint32 celldb_replicas_ = 0;
+  td::uint64 celldb_replica_cache_size_ = 1 << 30;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool read_config_ = false;
   bool started_keyring_ = false;
@@ -221,6 +224,13 @@ class ValidatorEngine : public td::actor::Actor {
   ton::BlockSeqno truncate_seqno_{0};
   std::string session_logs_file_;
   bool fast_state_serializer_enabled_ = false;
+  size_t sync_archive_window_ = 4;
+  td::uint64 sync_archive_temp_limit_ = 4ULL << 30;
+  size_t archive_import_parallelism_ = 8;
+  bool persistent_state_compression_ = false;
+  double archive_group_commit_window_ = 0.0;
+  bool broadcast_cell_delta_ = false;
+  td::uint32 dht_lookup_cache_size_ = ton::dht::Dht::default_lookup_cache_size();
 
   std::set<ton::CatchainSeqno> unsafe_catchains_;
   std::map<ton::BlockSeqno, std::pair<ton::CatchainSeqno, td::uint32>> unsafe_catchain_rotations_;
@@ -297,6 +307,15 @@ class ValidatorEngine : public td::actor::Actor {
   void set_celldb_preload_all(bool value) {
     celldb_preload_all_ = value;
   }
+  void set_celldb_cell_cache_size(td::uint64 value) {
+    celldb_cell_cache_size_ = value;
+  }
+  void set_celldb_replicas(td::uint32 value) {
+    celldb_replicas_ = value;
+  }
+  void set_celldb_replica_cache_size(td::uint64 value) {
+    celldb_replica_cache_size_ = value;
+  }
   void set_catchain_max_block_delay(double value) {
     catchain_max_block_delay_ = value;
   }
@@ -306,6 +325,27 @@ class ValidatorEngine : public td::actor::Actor {
   void set_fast_state_serializer_enabled(bool value) {
     fast_state_serializer_enabled_ = value;
   }
+  void set_sync_archive_window(size_t value) {
+    sync_archive_window_ = value;
+  }
+  void set_sync_archive_temp_limit(td::uint64 value) {
+    sync_archive_temp_limit_ = value;
+  }
+  void set_archive_import_parallelism(size_t value) {
+    archive_import_parallelism_ = value;
+  }
+  void set_persistent_state_compression(bool value) {
+    persistent_state_compression_ = value;
+  }
+  void set_archive_group_commit_window(double value) {
+    archive_group_commit_window_ = value;
+  }
+  void set_broadcast_cell_delta(bool value) {
+    broadcast_cell_delta_ = value;
+  }
+  void set_dht_lookup_cache_size(td::uint32 value) {
+    dht_lookup_cache_size_ = value;
+  }
   void start_up() override;
   ValidatorEngine() {
   }
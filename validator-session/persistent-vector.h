@@ -100,7 +100,17 @@ inline td::uint64 move_to_persistent(ValidatorSessionDescription& desc, td::uint
 
 template <typename T>
 inline const T* move_to_persistent(ValidatorSessionDescription& desc, const T* v) {
-  return T::move_to_persistent(desc, v);
+  if (desc.is_persistent(v)) {
+    return v;
+  }
+  // states share most of their subobjects, copy each of them only once per compaction
+  auto moved = desc.get_moved(v);
+  if (moved) {
+    return static_cast<const T*>(moved);
+  }
+  auto r = T::move_to_persistent(desc, v);
+  desc.set_moved(v, r);
+  return r;
 }
 
 template <typename T>
@@ -0,0 +1,358 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "validator-session-description.hpp"
+#include "validator-session-state.h"
+#include "validator-session-block-states.h"
+
+#include "keys/keys.hpp"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+#include <map>
+
+namespace {
+
+using namespace ton;
+using namespace ton::validatorsession;
+
+std::unique_ptr<ValidatorSessionDescriptionImpl> create_description(td::uint32 total_nodes) {
+  std::vector<ValidatorSessionNode> nodes;
+  for (td::uint32 i = 0; i < total_nodes; i++) {
+    auto pub_key = PrivateKey{privkeys::Ed25519::random()}.compute_public_key();
+    nodes.push_back(ValidatorSessionNode{pub_key, adnl::AdnlNodeIdShort{pub_key.compute_short_id()}, 1});
+  }
+  auto local_id = nodes[0].pub_key.compute_short_id();
+  return std::make_unique<ValidatorSessionDescriptionImpl>(ValidatorSessionOptions{}, nodes, local_id);
+}
+
+const td::uint32 ATTEMPT = 1000000000;
+
+// states after each candidate of the first round is submitted, so that later states share the earlier candidates
+std::vector<const ValidatorSessionState *> gen_states(ValidatorSessionDescription &desc) {
+  std::vector<const ValidatorSessionState *> states;
+  auto s = ValidatorSessionState::move_to_persistent(desc, ValidatorSessionState::create(desc));
+  for (td::uint32 i = 0; i < desc.get_total_nodes(); i++) {
+    if (desc.get_node_priority(i, 0) < 0) {
+      continue;
+    }
+    td::Bits256 root_hash = td::Bits256::zero();
+    root_hash.as_array()[0] = static_cast<td::uint8>(i + 1);
+    auto act = create_tl_object<ton_api::validatorSession_message_submittedBlock>(0, root_hash, td::Bits256::zero(),
+                                                                                  td::Bits256::zero());
+    s = ValidatorSessionState::action(desc, s, i, ATTEMPT, act.get());
+    for (td::uint32 j = 0; j < desc.get_total_nodes(); j++) {
+      s = ValidatorSessionState::make_all(desc, s, j, ATTEMPT);
+    }
+    s = ValidatorSessionState::move_to_persistent(desc, s);
+    desc.clear_temp_memory();
+    states.push_back(s);
+  }
+  return states;
+}
+
+std::vector<const SessionBlockCandidate *> sent_blocks(const ValidatorSessionState *s) {
+  std::vector<const SessionBlockCandidate *> blocks;
+  s->for_each_cur_round_sent_block([&](const SessionBlockCandidate *b) { blocks.push_back(b); });
+  return blocks;
+}
+
+std::vector<td::int32> actions(ValidatorSessionDescription &desc, const ValidatorSessionState *s) {
+  std::vector<td::int32> ids;
+  for (td::uint32 i = 0; i < desc.get_total_nodes(); i++) {
+    auto act = s->create_action(desc, i, ATTEMPT);
+    ids.push_back(act ? act->get_id() : 0);
+  }
+  return ids;
+}
+
+std::vector<ValidatorSessionCandidateId> blocks_to_approve(ValidatorSessionDescription &desc,
+                                                           const ValidatorSessionState *s) {
+  std::vector<ValidatorSessionCandidateId> ids;
+  for (td::uint32 i = 0; i < desc.get_total_nodes(); i++) {
+    for (auto b : s->choose_blocks_to_approve(desc, i)) {
+      ids.push_back(SentBlock::get_block_id(b));
+    }
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(ValidatorSessionState, ForcedCompaction) {
+  auto desc = create_description(10);
+  desc->set_min_compaction_size(1);
+  auto states = gen_states(*desc);
+  ASSERT_TRUE(states.size() > 1);
+  ASSERT_TRUE(desc->need_compaction());
+
+  std::vector<ValidatorSessionDescription::HashType> hashes;
+  std::vector<std::vector<td::int32>> old_actions;
+  std::vector<std::vector<ValidatorSessionCandidateId>> old_to_approve;
+  std::vector<size_t> old_blocks;
+  for (auto s : states) {
+    hashes.push_back(s->get_hash(*desc));
+    old_actions.push_back(actions(*desc, s));
+    old_to_approve.push_back(blocks_to_approve(*desc, s));
+    old_blocks.push_back(sent_blocks(s).size());
+  }
+  auto used = desc->get_memory_stats().persistent_used;
+
+  desc->start_compaction();
+  std::vector<const ValidatorSessionState *> moved;
+  for (auto s : states) {
+    moved.push_back(move_to_persistent(*desc, s));
+  }
+  desc->finish_compaction();
+  desc->clear_temp_memory();
+
+  auto stats = desc->get_memory_stats();
+  ASSERT_EQ(1u, stats.compactions);
+  ASSERT_TRUE(stats.live_bytes > 0);
+  ASSERT_TRUE(stats.live_bytes <= used);
+  ASSERT_EQ(stats.live_bytes, stats.persistent_used);
+  // the next compaction waits until the live size doubles
+  ASSERT_TRUE(!desc->need_compaction());
+
+  for (size_t i = 0; i < states.size(); i++) {
+    ASSERT_TRUE(moved[i] != states[i]);
+    ASSERT_TRUE(desc->is_persistent(moved[i]));
+    ASSERT_EQ(hashes[i], moved[i]->get_hash(*desc));
+    ASSERT_TRUE(old_actions[i] == actions(*desc, moved[i]));
+    ASSERT_TRUE(old_to_approve[i] == blocks_to_approve(*desc, moved[i]));
+    ASSERT_EQ(old_blocks[i], sent_blocks(moved[i]).size());
+  }
+
+  // the compacted state is used as before: new states are built on top of it and hash-consed with it
+  auto s = ValidatorSessionState::make_all(*desc, moved.back(), 0, ATTEMPT);
+  s = ValidatorSessionState::move_to_persistent(*desc, s);
+  ASSERT_TRUE(desc->is_persistent(s));
+  ASSERT_TRUE(ValidatorSessionState::merge(*desc, moved.back(), moved.back()) == moved.back());
+}
+
+TEST(ValidatorSessionState, CompactionKeepsSharing) {
+  auto desc = create_description(10);
+  auto states = gen_states(*desc);
+  ASSERT_TRUE(states.size() > 1);
+  auto first = sent_blocks(states[0]);
+  auto last = sent_blocks(states.back());
+  ASSERT_EQ(1u, first.size());
+  // the candidate submitted first is the same object in every later state
+  ASSERT_TRUE(std::find(last.begin(), last.end(), first[0]) != last.end());
+
+  desc->start_compaction();
+  std::vector<const ValidatorSessionState *> moved;
+  for (auto s : states) {
+    moved.push_back(move_to_persistent(*desc, s));
+  }
+  // moving a state again gives the same copy
+  ASSERT_TRUE(move_to_persistent(*desc, states[0]) == moved[0]);
+  desc->finish_compaction();
+
+  auto moved_first = sent_blocks(moved[0]);
+  ASSERT_EQ(1u, moved_first.size());
+  ASSERT_TRUE(moved_first[0] != first[0]);
+  ASSERT_TRUE(desc->is_persistent(moved_first[0]));
+  for (auto s : moved) {
+    auto blocks = sent_blocks(s);
+    ASSERT_TRUE(std::find(blocks.begin(), blocks.end(), moved_first[0]) != blocks.end());
+    for (auto b : blocks) {
+      ASSERT_TRUE(desc->is_persistent(b));
+    }
+  }
+}
+
+TEST(ValidatorSessionState, CacheGrowth) {
+  auto desc = create_description(10);
+  auto initial_size = desc->get_memory_stats().cache_size;
+
+  std::vector<std::pair<const CntVector<td::uint32> *, ValidatorSessionDescription::HashType>> objects;
+  for (td::uint32 i = 0; i < 8 * initial_size; i++) {
+    auto v = CntVector<td::uint32>::create(*desc, std::vector<td::uint32>{i, i * 7 + 1});
+    v = move_to_persistent(*desc, v);
+    objects.emplace_back(v, v->get_hash(*desc));
+    if (i % 1024 == 0) {
+      desc->clear_temp_memory();
+    }
+  }
+  ASSERT_TRUE(desc->get_memory_stats().cache_size > initial_size);
+
+  td::uint32 found = 0;
+  for (auto &p : objects) {
+    auto r = desc->get_by_hash(p.second, false);
+    if (r) {
+      // never an object with another hash, even right after a growth
+      ASSERT_EQ(p.second, static_cast<const CntVector<td::uint32> *>(r)->get_hash(*desc));
+      found += r == p.first;
+    }
+  }
+  ASSERT_TRUE(found > 0);
+  // the most recent object is always found, so equal vectors are reused
+  auto last = objects.back();
+  ASSERT_TRUE(desc->get_by_hash(last.second, false) == last.first);
+  td::uint32 i = 8 * initial_size - 1;
+  auto v = CntVector<td::uint32>::create(*desc, std::vector<td::uint32>{i, i * 7 + 1});
+  ASSERT_TRUE(move_to_persistent(*desc, v) == last.first);
+
+  td::Random::Xorshift128plus rnd(123);
+  for (int j = 0; j < 100000; j++) {
+    auto hash = static_cast<ValidatorSessionDescription::HashType>(rnd());
+    auto r = desc->get_by_hash(hash, false);
+    if (r) {
+      ASSERT_EQ(hash, static_cast<const CntVector<td::uint32> *>(r)->get_hash(*desc));
+    }
+  }
+}
+
+namespace {
+
+class TestExtra : public catchain::CatChainBlock::Extra {};
+
+// catchain with n sources, every block refers to its prev and to blocks of other sources its prev does not know of
+class TestCatChain {
+ public:
+  explicit TestCatChain(td::uint32 n) : forks_(n) {
+  }
+
+  catchain::CatChainBlock *add_block(td::uint32 src, td::Random::Xorshift128plus &rnd, td::uint32 fork = 0) {
+    auto prev = top(src);
+    std::vector<catchain::CatChainBlockHeight> vt = prev ? prev->vt() : std::vector<catchain::CatChainBlockHeight>();
+    vt.resize(forks_.size(), 0);
+    if (fork != 0 && fork >= forks_.size()) {
+      forks_.resize(fork + 1);
+      vt.resize(forks_.size(), 0);
+    }
+    auto f = fork ? fork : src;
+    std::vector<catchain::CatChainBlock *> deps;
+    for (td::uint32 g = 0; g < forks_.size(); g++) {
+      auto &blocks = forks_[g];
+      if (g == f || blocks.size() <= vt[g] || rnd.fast(0, 1) == 0) {
+        continue;
+      }
+      // the lowest possible dependency is right above the height known to prev
+      auto dep = blocks[rnd.fast(static_cast<int>(vt[g]), static_cast<int>(blocks.size()) - 1)];
+      deps.push_back(dep);
+      for (size_t i = 0; i < vt.size(); i++) {
+        vt[i] = std::max(vt[i], i < dep->vt().size() ? dep->vt()[i] : 0);
+      }
+    }
+    auto height = static_cast<catchain::CatChainBlockHeight>(forks_[f].size() + 1);
+    vt[f] = height;
+    td::Bits256 hash;
+    rnd.bytes(hash.as_slice());
+    auto block = catchain::CatChainBlock::create(src, f, PublicKeyHash::zero(), height, hash, td::SharedSlice(), prev,
+                                                 std::move(deps), std::move(vt));
+    auto ptr = block.get();
+    forks_[f].push_back(ptr);
+    top_[src] = ptr;
+    blocks_.push_back(std::move(block));
+    return ptr;
+  }
+
+  catchain::CatChainBlock *top(td::uint32 src) {
+    auto it = top_.find(src);
+    return it == top_.end() ? nullptr : it->second;
+  }
+
+  const std::vector<std::unique_ptr<catchain::CatChainBlock>> &blocks() const {
+    return blocks_;
+  }
+
+ private:
+  std::vector<std::vector<catchain::CatChainBlock *>> forks_;
+  std::map<td::uint32, catchain::CatChainBlock *> top_;
+  std::vector<std::unique_ptr<catchain::CatChainBlock>> blocks_;
+};
+
+// what preprocess_block needs: the states of prev and of all deps
+bool has_parent_states(catchain::CatChainBlock *block) {
+  if (block->prev() && !block->prev()->extra()) {
+    return false;
+  }
+  for (auto dep : block->deps()) {
+    if (!dep->extra()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(ValidatorSessionBlockStates, ParentsKept) {
+  const td::uint32 n = 7;
+  td::Random::Xorshift128plus rnd(123);
+  TestCatChain catchain{n};
+  ValidatorSessionBlockStates states{n};
+  size_t dropped = 0;
+  for (int step = 0; step < 3000; step++) {
+    // source 0 is slow, so its prev is often at the frontier
+    auto src = static_cast<td::uint32>(step % 10 == 0 ? 0 : rnd.fast(1, n - 1));
+    auto block = catchain.add_block(src, rnd);
+    ASSERT_TRUE(has_parent_states(block));
+    block->set_extra(std::make_unique<TestExtra>());
+    states.add(block);
+    block->set_processed();
+    if (step % 16 == 0) {
+      auto frontier = states.frontier();
+      dropped += states.compact([](catchain::CatChainBlock *block) { CHECK(block->extra()); });
+      for (auto &b : catchain.blocks()) {
+        auto below = b->fork() < frontier.size() && b->height() < frontier[b->fork()];
+        ASSERT_EQ(below, b->extra() == nullptr);
+      }
+    }
+  }
+  ASSERT_TRUE(!states.forks_seen());
+  ASSERT_TRUE(dropped > 0);
+  ASSERT_EQ(catchain.blocks().size(), dropped + states.size());
+}
+
+TEST(ValidatorSessionBlockStates, NothingDroppedAfterFork) {
+  const td::uint32 n = 4;
+  td::Random::Xorshift128plus rnd(123);
+  TestCatChain catchain{n};
+  ValidatorSessionBlockStates states{n};
+  auto add = [&](td::uint32 src, td::uint32 fork) {
+    auto block = catchain.add_block(src, rnd, fork);
+    block->set_extra(std::make_unique<TestExtra>());
+    states.add(block);
+    block->set_processed();
+  };
+
+  // nothing is dropped until every source has a block
+  for (int i = 0; i < 20; i++) {
+    add(static_cast<td::uint32>(rnd.fast(0, n - 2)), 0);
+  }
+  ASSERT_TRUE(states.frontier().empty());
+  ASSERT_EQ(0u, states.compact([](catchain::CatChainBlock *) {}));
+
+  for (int i = 0; i < 100; i++) {
+    add(static_cast<td::uint32>(rnd.fast(0, n - 1)), 0);
+  }
+  ASSERT_TRUE(states.compact([](catchain::CatChainBlock *) {}) > 0);
+
+  // source 1 forks
+  add(1, n);
+  ASSERT_TRUE(states.forks_seen());
+  for (int i = 0; i < 100; i++) {
+    add(static_cast<td::uint32>(rnd.fast(0, n - 1)), 0);
+  }
+  ASSERT_TRUE(states.frontier().empty());
+  auto size = states.size();
+  ASSERT_EQ(0u, states.compact([](catchain::CatChainBlock *block) { CHECK(block->extra()); }));
+  ASSERT_EQ(size, states.size());
+}
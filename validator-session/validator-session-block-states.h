@@ -0,0 +1,105 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "catchain/catchain.h"
+
+#include <vector>
+
+namespace ton {
+
+namespace validatorsession {
+
+// Catchain blocks that keep a session state in their extra.
+// A block state is not needed anymore when every source has already built on top of the block: a new block can
+// reference only blocks above the ones its prev knows of (see CatChainReceivedBlock), and only top blocks are given
+// to process_blocks. With forks this does not hold, so nothing is dropped once a fork is seen.
+class ValidatorSessionBlockStates {
+ public:
+  ValidatorSessionBlockStates() = default;
+  explicit ValidatorSessionBlockStates(td::uint32 total_nodes) : source_top_(total_nodes, nullptr) {
+  }
+
+  // called for each preprocessed block, in the order of preprocessing
+  void add(catchain::CatChainBlock *block) {
+    blocks_.push_back(block);
+    auto &top = source_top_[block->source()];
+    if (top && top->fork() != block->fork()) {
+      forks_seen_ = true;
+    }
+    top = block;
+  }
+
+  // frontier[fork] is the minimal height of fork known to every source, empty if no state can be dropped
+  std::vector<catchain::CatChainBlockHeight> frontier() const {
+    std::vector<catchain::CatChainBlockHeight> frontier;
+    if (forks_seen_) {
+      return frontier;
+    }
+    for (auto top : source_top_) {
+      if (!top) {
+        return {};
+      }
+      auto &vt = top->vt();
+      if (frontier.empty()) {
+        frontier = vt;
+      } else {
+        frontier.resize(std::min(frontier.size(), vt.size()));
+        for (size_t i = 0; i < frontier.size(); i++) {
+          frontier[i] = std::min(frontier[i], vt[i]);
+        }
+      }
+    }
+    return frontier;
+  }
+
+  // drops the states of processed blocks below the frontier, calls keep(block) for the other blocks;
+  // returns the number of dropped states
+  template <class F>
+  size_t compact(F &&keep) {
+    auto frontier = this->frontier();
+    std::vector<catchain::CatChainBlock *> blocks;
+    for (auto block : blocks_) {
+      if (block->is_processed() && block->fork() < frontier.size() && block->height() < frontier[block->fork()]) {
+        block->set_extra(nullptr);
+        continue;
+      }
+      keep(block);
+      blocks.push_back(block);
+    }
+    auto dropped = blocks_.size() - blocks.size();
+    blocks_ = std::move(blocks);
+    return dropped;
+  }
+
+  size_t size() const {
+    return blocks_.size();
+  }
+  bool forks_seen() const {
+    return forks_seen_;
+  }
+
+ private:
+  std::vector<catchain::CatChainBlock *> blocks_;
+  // last preprocessed block of each source
+  std::vector<catchain::CatChainBlock *> source_top_;
+  bool forks_seen_ = false;
+};
+
+}  // namespace validatorsession
+
+}  // namespace ton
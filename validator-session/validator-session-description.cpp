@@ -51,10 +51,54 @@ ValidatorSessionDescriptionImpl::ValidatorSessionDescriptionImpl(ValidatorSessio
   CHECK(it != rev_sources_.end());
   self_idx_ = it->second;
 
-  for (auto &el : cache_) {
-    Cached v{nullptr};
-    el.store(v, std::memory_order_relaxed);
+  // roughly 2k cached objects per validator, same as the old fixed table for the largest sessions
+  base_cache_size_ = static_cast<td::uint32>(
+      td::clamp<td::uint64>(td::uint64(size) << 11, min_cache_size, max_cache_size));
+  init_cache(base_cache_size_);
+}
+
+void ValidatorSessionDescriptionImpl::init_cache(td::uint32 size) {
+  td::uint32 s = min_cache_size;
+  while (s < size && s < max_cache_size) {
+    s <<= 1;
+  }
+  if (s != cache_size_) {
+    cache_ = std::make_unique<std::atomic<Cached>[]>(s);
+    cache_hashes_ = std::make_unique<std::atomic<HashType>[]>(s);
+    cache_size_ = s;
+  }
+  for (td::uint32 i = 0; i < cache_size_; i++) {
+    cache_[i].store(Cached{nullptr}, std::memory_order_relaxed);
+    cache_hashes_[i].store(0, std::memory_order_relaxed);
   }
+  cache_stores_ = 0;
+}
+
+void ValidatorSessionDescriptionImpl::grow_cache() {
+  // an entry in slot i of the old table belongs to slot i or i + old_size of the new one, chosen by its hash
+  auto old_size = cache_size_;
+  auto new_size = old_size * 2;
+  auto cache = std::make_unique<std::atomic<Cached>[]>(new_size);
+  auto cache_hashes = std::make_unique<std::atomic<HashType>[]>(new_size);
+  for (td::uint32 i = 0; i < new_size; i++) {
+    cache[i].store(Cached{nullptr}, std::memory_order_relaxed);
+    cache_hashes[i].store(0, std::memory_order_relaxed);
+  }
+  for (td::uint32 i = 0; i < old_size; i++) {
+    auto v = cache_[i].load(std::memory_order_relaxed);
+    if (!v.ptr) {
+      continue;
+    }
+    auto hash = cache_hashes_[i].load(std::memory_order_relaxed);
+    auto x = hash & (new_size - 1);
+    cache[x].store(v, std::memory_order_relaxed);
+    cache_hashes[x].store(hash, std::memory_order_relaxed);
+  }
+  cache_ = std::move(cache);
+  cache_hashes_ = std::move(cache_hashes);
+  cache_size_ = new_size;
+  cache_stores_ = 0;
+  VLOG(VALIDATOR_SESSION_INFO) << "grown state cache to " << cache_size_ << " entries";
 }
 
 td::int32 ValidatorSessionDescriptionImpl::get_node_priority(td::uint32 src_idx, td::uint32 round) const {
@@ -136,8 +180,11 @@ td::uint32 ValidatorSessionDescriptionImpl::get_vote_for_author(td::uint32 attem
 
 const ValidatorSessionDescription::RootObject *ValidatorSessionDescriptionImpl::get_by_hash(HashType hash,
                                                                                             bool allow_temp) const {
-  auto x = hash % cache_size;
-
+  lookups_.fetch_add(1, std::memory_order_relaxed);
+  auto x = hash & (cache_size_ - 1);
+  if (cache_hashes_[x].load(std::memory_order_relaxed) != hash) {
+    return nullptr;
+  }
   return cache_[x].load(std::memory_order_relaxed).ptr;
 }
 
@@ -149,17 +196,90 @@ void ValidatorSessionDescriptionImpl::update_hash(const RootObject *obj, HashTyp
   if (!is_persistent(obj)) {
     return;
   }
-  auto x = hash % cache_size;
+  auto x = hash & (cache_size_ - 1);
   Cached p{obj};
   cache_[x].store(p, std::memory_order_relaxed);
+  cache_hashes_[x].store(hash, std::memory_order_relaxed);
+  // the working set does not fit: most stores evict something still in use
+  if (++cache_stores_ > 2 * static_cast<td::uint64>(cache_size_) && cache_size_ < max_cache_size) {
+    grow_cache();
+  }
 }
 
 void *ValidatorSessionDescriptionImpl::alloc(size_t size, size_t align, bool temp) {
-  return (temp ? mem_temp_ : mem_perm_).alloc(size, align);
+  return (temp ? mem_temp_ : *mem_perm_).alloc(size, align);
 }
 
 bool ValidatorSessionDescriptionImpl::is_persistent(const void *ptr) const {
-  return mem_perm_.contains(ptr);
+  return mem_perm_->contains(ptr);
+}
+
+void ValidatorSessionDescriptionImpl::clear_temp_memory() {
+  mem_temp_.clear();
+  // every processing step is an epoch: nothing obtained during it outlives the step,
+  // so retired generations are freed after a few steps
+  mem_reclamation_locker_.lock();
+  mem_reclamation_locker_.unlock();
+}
+
+bool ValidatorSessionDescriptionImpl::need_compaction() const {
+  return mem_perm_->used() >= std::max(min_compaction_size_, 2 * live_bytes_);
+}
+
+void ValidatorSessionDescriptionImpl::start_compaction() {
+  CHECK(!mem_perm_old_);
+  mem_perm_old_ = std::move(mem_perm_);
+  mem_perm_ = std::make_unique<MemPool>(mem_chunk_size_perm);
+  // all cached objects belong to the old generation now, start again from the base size
+  init_cache(base_cache_size_);
+}
+
+void ValidatorSessionDescriptionImpl::finish_compaction() {
+  CHECK(mem_perm_old_);
+  live_bytes_ = mem_perm_->used();
+  auto old_used = mem_perm_old_->used();
+  if (old_used > live_bytes_) {
+    reclaimed_bytes_ += old_used - live_bytes_;
+  }
+  compactions_++;
+  // fit the live objects, the cache grows further if the working set does
+  while (cache_size_ < 2 * moved_.size() && cache_size_ < max_cache_size) {
+    grow_cache();
+  }
+  moved_.clear();
+  mem_reclamation_locker_.retire(mem_perm_old_.release());
+  VLOG(VALIDATOR_SESSION_NOTICE) << "compacted session state: " << old_used << " -> " << live_bytes_
+                                 << " bytes, cache size " << cache_size_;
+}
+
+const ValidatorSessionDescription::RootObject *ValidatorSessionDescriptionImpl::get_moved(
+    const RootObject *obj) const {
+  if (!mem_perm_old_) {
+    return nullptr;
+  }
+  auto it = moved_.find(obj);
+  return it == moved_.end() ? nullptr : it->second;
+}
+
+void ValidatorSessionDescriptionImpl::set_moved(const RootObject *obj, const RootObject *copy) {
+  if (mem_perm_old_ && obj != copy) {
+    moved_.emplace(obj, copy);
+  }
+}
+
+ValidatorSessionDescription::MemoryStats ValidatorSessionDescriptionImpl::get_memory_stats() const {
+  MemoryStats stats;
+  stats.persistent_used = mem_perm_->used();
+  stats.persistent_reserved = mem_perm_->reserved();
+  stats.temp_reserved = mem_temp_.reserved();
+  stats.retired_generations = mem_reclamation_.to_delete_size_unsafe();
+  stats.live_bytes = live_bytes_;
+  stats.compactions = compactions_;
+  stats.reclaimed_bytes = reclaimed_bytes_;
+  stats.cache_size = cache_size_;
+  stats.cache_lookups = lookups_.load(std::memory_order_relaxed);
+  stats.cache_hits = reuse_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 std::unique_ptr<ValidatorSessionDescription> ValidatorSessionDescription::create(
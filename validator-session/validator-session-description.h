@@ -73,6 +73,29 @@ class ValidatorSessionDescription {
   }
   virtual void clear_temp_memory() = 0;
 
+  // Persistent objects are allocated in generations. Compaction starts a new generation: live states are moved
+  // into it with move_to_persistent(), then the previous generation is retired and freed a few epochs later.
+  virtual bool need_compaction() const = 0;
+  virtual void start_compaction() = 0;
+  virtual void finish_compaction() = 0;
+  // copy of an object of the previous generation made during the current compaction, or nullptr
+  virtual const RootObject *get_moved(const RootObject *obj) const = 0;
+  virtual void set_moved(const RootObject *obj, const RootObject *copy) = 0;
+
+  struct MemoryStats {
+    size_t persistent_used = 0;      // bytes allocated in the current generation
+    size_t persistent_reserved = 0;  // chunks of the current generation
+    size_t temp_reserved = 0;
+    size_t retired_generations = 0;  // generations waiting to be freed
+    size_t live_bytes = 0;  // size of the current generation right after the last compaction
+    td::uint64 compactions = 0;
+    td::uint64 reclaimed_bytes = 0;
+    td::uint32 cache_size = 0;
+    td::uint64 cache_lookups = 0;
+    td::uint64 cache_hits = 0;
+  };
+  virtual MemoryStats get_memory_stats() const = 0;
+
   virtual ~ValidatorSessionDescription() = default;
 
   virtual PublicKeyHash get_source_id(td::uint32 idx) const = 0;
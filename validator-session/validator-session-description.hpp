@@ -20,11 +20,13 @@
 
 #include <set>
 #include <map>
+#include <unordered_map>
 
 #include "validator-session.h"
 #include "validator-session-state.h"
 
 #include "keys/encryptor.h"
+#include "td/utils/EpochBasedMemoryReclamation.h"
 
 namespace ton {
 
@@ -49,14 +51,25 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
   ValidatorWeight total_weight_;
   td::uint32 self_idx_;
 
-  static constexpr td::uint32 cache_size = (1 << 20);
+  static constexpr td::uint32 min_cache_size = (1 << 16);
+  static constexpr td::uint32 max_cache_size = (1 << 22);
   static constexpr size_t mem_chunk_size_perm = (1 << 27);
   static constexpr size_t mem_chunk_size_temp = (1 << 27);
+  static constexpr size_t default_min_compaction_size = (1 << 28);
+  size_t min_compaction_size_ = default_min_compaction_size;
 
   struct Cached {
     const RootObject *ptr;
   };
-  std::array<std::atomic<Cached>, cache_size> cache_;
+  // direct-mapped, size is a power of two; cache_hashes_[i] is the hash of the object in cache_[i]
+  std::unique_ptr<std::atomic<Cached>[]> cache_;
+  std::unique_ptr<std::atomic<HashType>[]> cache_hashes_;
+  td::uint32 cache_size_ = 0;
+  td::uint32 base_cache_size_ = 0;
+  td::uint64 cache_stores_ = 0;  // since last resize
+
+  void init_cache(td::uint32 size);
+  void grow_cache();
 
  public:
   class MemPool {
@@ -66,6 +79,12 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     void *alloc(size_t size, size_t align);
     void clear();
     bool contains(const void* ptr) const;
+    size_t used() const {
+      return ptr_;
+    }
+    size_t reserved() const {
+      return data_.size() * chunk_size_;
+    }
 
    private:
     size_t chunk_size_;
@@ -74,9 +93,20 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
   };
 
  private:
-  MemPool mem_perm_ = MemPool(mem_chunk_size_perm);
+  // current generation of persistent memory, older generations are retired through mem_reclamation_
+  std::unique_ptr<MemPool> mem_perm_ = std::make_unique<MemPool>(mem_chunk_size_perm);
   MemPool mem_temp_ = MemPool(mem_chunk_size_temp);
 
+  std::unique_ptr<MemPool> mem_perm_old_;
+  std::unordered_map<const RootObject *, const RootObject *> moved_;
+  td::EpochBasedMemoryReclamation<MemPool> mem_reclamation_{1};
+  td::EpochBasedMemoryReclamation<MemPool>::Locker mem_reclamation_locker_ = mem_reclamation_.get_locker(0);
+
+  size_t live_bytes_ = 0;
+  td::uint64 compactions_ = 0;
+  td::uint64 reclaimed_bytes_ = 0;
+
+  mutable std::atomic<td::uint64> lookups_{0};
   std::atomic<td::uint64> reuse_{0};
 
  public:
@@ -123,13 +153,21 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
   const RootObject *get_by_hash(HashType hash, bool allow_temp) const override;
   void on_reuse() override {
     if (reuse_++ % (1 << 17) == 0) {
-      LOG(INFO) << "reused " << reuse_ << " times";
+      LOG(INFO) << "reused " << reuse_ << " times, " << lookups_ << " lookups, cache size " << cache_size_;
     }
   }
   void update_hash(const RootObject *obj, HashType hash) override;
   void *alloc(size_t size, size_t align, bool temp) override;
-  void clear_temp_memory() override {
-    mem_temp_.clear();
+  void clear_temp_memory() override;
+  bool need_compaction() const override;
+  void start_compaction() override;
+  void finish_compaction() override;
+  const RootObject *get_moved(const RootObject *obj) const override;
+  void set_moved(const RootObject *obj, const RootObject *copy) override;
+  MemoryStats get_memory_stats() const override;
+  // compaction starts once the current generation has at least this size (and twice the live size)
+  void set_min_compaction_size(size_t size) {
+    min_compaction_size_ = size;
   }
   bool is_persistent(const void *ptr) const override;
   HashType compute_hash(td::Slice data) const override;
@@ -72,12 +72,20 @@ struct SessionBlockCandidateSignature : public ValidatorSessionDescription::Root
     if (desc.is_persistent(b)) {
       return b;
     }
-    CHECK(desc.is_persistent(b->data_.ubegin()));
-    auto r = lookup(desc, b->data_, b->hash_, false);
-    if (r) {
-      return r;
-    }
-    return new (desc, false) SessionBlockCandidateSignature{desc, b->data_, b->hash_};
+    td::Slice data = b->data_;
+    if (!desc.is_persistent(data.ubegin())) {
+      // the signature belongs to an older generation of persistent memory
+      auto d = static_cast<td::uint8*>(desc.alloc(data.size(), 8, false));
+      td::MutableSlice s{d, data.size()};
+      s.copy_from(data);
+      data = s;
+    } else {
+      auto r = lookup(desc, data, b->hash_, false);
+      if (r) {
+        return r;
+      }
+    }
+    return new (desc, false) SessionBlockCandidateSignature{desc, data, b->hash_};
   }
   static const SessionBlockCandidateSignature* merge(ValidatorSessionDescription& desc,
                                                      const SessionBlockCandidateSignature* l,
@@ -273,8 +281,8 @@ class SessionBlockCandidate : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto block = SentBlock::move_to_persistent(desc, b->block_);
-    auto approved = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->approved_by_);
+    auto block = ton::validatorsession::move_to_persistent(desc, b->block_);
+    auto approved = ton::validatorsession::move_to_persistent(desc, b->approved_by_);
     auto r = lookup(desc, block, approved, b->hash_, false);
     if (r) {
       return r;
@@ -374,8 +382,8 @@ class SessionVoteCandidate : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto block = SentBlock::move_to_persistent(desc, b->block_);
-    auto voted = CntVector<bool>::move_to_persistent(desc, b->voted_by_);
+    auto block = ton::validatorsession::move_to_persistent(desc, b->block_);
+    auto voted = ton::validatorsession::move_to_persistent(desc, b->voted_by_);
     auto r = lookup(desc, block, voted, b->hash_, false);
     if (r) {
       return r;
@@ -467,9 +475,9 @@ class ValidatorSessionRoundAttemptState : public ValidatorSessionDescription::Ro
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto votes = VoteVector::move_to_persistent(desc, b->votes_);
-    auto precommitted = CntVector<bool>::move_to_persistent(desc, b->precommitted_);
-    auto vote_for = SentBlock::move_to_persistent(desc, b->vote_for_);
+    auto votes = ton::validatorsession::move_to_persistent(desc, b->votes_);
+    auto precommitted = ton::validatorsession::move_to_persistent(desc, b->precommitted_);
+    auto vote_for = ton::validatorsession::move_to_persistent(desc, b->vote_for_);
 
     auto r = lookup(desc, b->seqno_, votes, precommitted, vote_for, b->vote_for_inited_, b->hash_, false);
     if (r) {
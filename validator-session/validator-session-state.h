@@ -74,9 +74,9 @@ class ValidatorSessionOldRoundState : public ValidatorSessionDescription::RootOb
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto signatures = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->signatures_);
-    auto approve_signatures = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->approve_signatures_);
-    auto block = SentBlock::move_to_persistent(desc, b->block_);
+    auto signatures = ton::validatorsession::move_to_persistent(desc, b->signatures_);
+    auto approve_signatures = ton::validatorsession::move_to_persistent(desc, b->approve_signatures_);
+    auto block = ton::validatorsession::move_to_persistent(desc, b->block_);
     auto r = lookup(desc, b->seqno_, block, signatures, approve_signatures, b->hash_, false);
     if (r) {
       return r;
@@ -256,12 +256,12 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto precommitted_block = SentBlock::move_to_persistent(desc, b->precommitted_block_);
-    auto first_attempt = CntVector<td::uint32>::move_to_persistent(desc, b->first_attempt_);
-    auto last_precommit = CntVector<td::uint32>::move_to_persistent(desc, b->last_precommit_);
-    auto sent = ApproveVector::move_to_persistent(desc, b->sent_blocks_);
-    auto signatures = CntVector<const SessionBlockCandidateSignature*>::move_to_persistent(desc, b->signatures_);
-    auto attempts = AttemptVector::move_to_persistent(desc, b->attempts_);
+    auto precommitted_block = ton::validatorsession::move_to_persistent(desc, b->precommitted_block_);
+    auto first_attempt = ton::validatorsession::move_to_persistent(desc, b->first_attempt_);
+    auto last_precommit = ton::validatorsession::move_to_persistent(desc, b->last_precommit_);
+    auto sent = ton::validatorsession::move_to_persistent(desc, b->sent_blocks_);
+    auto signatures = ton::validatorsession::move_to_persistent(desc, b->signatures_);
+    auto attempts = ton::validatorsession::move_to_persistent(desc, b->attempts_);
     auto r = lookup(desc, precommitted_block, b->seqno_, b->precommitted_, first_attempt, last_precommit, sent,
                     signatures, attempts, b->hash_, false);
     if (r) {
@@ -448,9 +448,9 @@ class ValidatorSessionState : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
-    auto ts = CntVector<td::uint32>::move_to_persistent(desc, b->att_);
-    auto old_rounds = CntVector<const ValidatorSessionOldRoundState*>::move_to_persistent(desc, b->old_rounds_);
-    auto cur_round = ValidatorSessionRoundState::move_to_persistent(desc, b->cur_round_);
+    auto ts = ton::validatorsession::move_to_persistent(desc, b->att_);
+    auto old_rounds = ton::validatorsession::move_to_persistent(desc, b->old_rounds_);
+    auto cur_round = ton::validatorsession::move_to_persistent(desc, b->cur_round_);
     auto r = lookup(desc, ts, old_rounds, cur_round, b->hash_, false);
     if (r) {
       return r;
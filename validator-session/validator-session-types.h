@@ -22,6 +22,7 @@
 #include "crypto/common/bitstring.h"
 #include "adnl/adnl-node-id.hpp"
 #include "ton/ton-types.h"
+#include "catchain/catchain-types.h"
 
 namespace ton {
 
@@ -150,6 +151,8 @@ struct ValidatorSessionStats {
   ValidatorWeight signatures_weight = 0;
   td::uint32 approve_signatures = 0;
   ValidatorWeight approve_signatures_weight = 0;
+
+  catchain::CatChainDbStats catchain_db;
 };
 
 struct NewValidatorGroupStats {
@@ -130,6 +130,7 @@ void ValidatorSessionImpl::process_blocks(std::vector<catchain::CatChainBlock *>
   virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, real_state_);
   virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
   description().clear_temp_memory();
+  compact_state();
 }
 
 void ValidatorSessionImpl::finished_processing() {
@@ -192,12 +193,14 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
   q_timer.reset();
   state = ValidatorSessionState::move_to_persistent(description(), state);
   block->set_extra(std::make_unique<BlockExtra>(state));
+  block_states_.add(block);
   if (block->source() == local_idx() && !catchain_started_) {
     real_state_ = state;
   }
   virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, state);
   virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
   description().clear_temp_memory();
+  compact_state();
   if (real_state_->cur_round_seqno() != cur_round_) {
     on_new_round(real_state_->cur_round_seqno());
   }
@@ -207,6 +210,27 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
                                 << "ms: state=" << state->get_hash(description());
 }
 
+void ValidatorSessionImpl::compact_state() {
+  if (!description().need_compaction()) {
+    return;
+  }
+  auto start_time = td::Timestamp::now();
+
+  description().start_compaction();
+  auto dropped = block_states_.compact([&](catchain::CatChainBlock *block) {
+    auto e = dynamic_cast<const BlockExtra *>(block->extra());
+    CHECK(e != nullptr);
+    block->set_extra(std::make_unique<BlockExtra>(move_to_persistent(description(), e->get_ref())));
+  });
+  real_state_ = move_to_persistent(description(), real_state_);
+  virtual_state_ = move_to_persistent(description(), virtual_state_);
+  description().finish_compaction();
+
+  VLOG(VALIDATOR_SESSION_NOTICE) << this << ": compacted state in "
+                                 << static_cast<td::uint32>(1000 * (td::Timestamp::now().at() - start_time.at()))
+                                 << "ms: kept " << block_states_.size() << " block states, dropped " << dropped;
+}
+
 bool ValidatorSessionImpl::ensure_candidate_unique(td::uint32 src_idx, td::uint32 round,
                                                   ValidatorSessionCandidateId block_id) {
   auto it = src_round_candidate_[src_idx].find(round);
@@ -787,6 +811,13 @@ void ValidatorSessionImpl::check_all() {
       }
     }
     LOG(ERROR) << sb.as_cslice();
+    auto mem = description().get_memory_stats();
+    VLOG(VALIDATOR_SESSION_NOTICE) << this << ": state memory: persistent=" << mem.persistent_used << "/"
+                                   << mem.persistent_reserved << " live=" << mem.live_bytes
+                                   << " temp=" << mem.temp_reserved << " retired=" << mem.retired_generations
+                                   << " compactions=" << mem.compactions << " reclaimed=" << mem.reclaimed_bytes
+                                   << " cache=" << mem.cache_size << " hits=" << mem.cache_hits << "/"
+                                   << mem.cache_lookups;
     round_debug_at_ = td::Timestamp::in(60.0);
   }
   auto att = description().get_attempt_seqno(description().get_ts());
@@ -895,6 +926,7 @@ void ValidatorSessionImpl::on_new_round(td::uint32 round) {
       cur_stats_.approve_signatures = (td::uint32)export_approve_sigs.size();
       cur_stats_.approve_signatures_weight = approve_signatures_weight;
       cur_stats_.creator = description().get_source_id(block->get_src_idx());
+      cur_stats_.catchain_db = catchain_db_stats_;
       auto stat = stats_get_candidate_stat(cur_round_, cur_stats_.creator);
       if (stat) {
         stat->is_accepted = true;
@@ -924,6 +956,7 @@ void ValidatorSessionImpl::on_new_round(td::uint32 round) {
       }
       cur_stats_.rounds[round_idx].timestamp = td::Clocks::system();
     }
+    stats_update_catchain_db();
     auto it2 = blocks_.begin();
     while (it2 != blocks_.end()) {
       if (it2->second->round_ < (td::int32)cur_round_ - MAX_PAST_ROUND_BLOCK) {
@@ -988,6 +1021,7 @@ ValidatorSessionImpl::ValidatorSessionImpl(catchain::CatChainSessionId session_i
   compress_block_candidates_ = opts.proto_version >= 4;
   description_ = ValidatorSessionDescription::create(std::move(opts), nodes, local_id);
   src_round_candidate_.resize(description_->get_total_nodes());
+  block_states_ = ValidatorSessionBlockStates{description_->get_total_nodes()};
 }
 
 void ValidatorSessionImpl::start() {
@@ -1012,7 +1046,9 @@ void ValidatorSessionImpl::destroy() {
 }
 
 void ValidatorSessionImpl::get_current_stats(td::Promise<ValidatorSessionStats> promise) {
-  promise.set_result(cur_stats_);
+  auto stats = cur_stats_;
+  stats.catchain_db = catchain_db_stats_;
+  promise.set_result(std::move(stats));
 }
 
 void ValidatorSessionImpl::get_end_stats(td::Promise<EndValidatorGroupStats> promise) {
@@ -1100,6 +1136,16 @@ void ValidatorSessionImpl::start_up() {
   stats_init();
 }
 
+void ValidatorSessionImpl::stats_update_catchain_db() {
+  td::actor::send_closure(catchain_, &catchain::CatChain::get_db_stats,
+                          [SelfId = actor_id(this)](td::Result<catchain::CatChainDbStats> R) {
+                            if (R.is_ok()) {
+                              td::actor::send_closure(SelfId, &ValidatorSessionImpl::stats_got_catchain_db,
+                                                      R.move_as_ok());
+                            }
+                          });
+}
+
 void ValidatorSessionImpl::stats_init() {
   auto old_rounds = std::move(cur_stats_.rounds);
   if (stats_inited_ && cur_stats_.first_round + old_rounds.size() > cur_round_) {
@@ -25,6 +25,7 @@
 
 #include "validator-session.h"
 #include "validator-session-state.h"
+#include "validator-session-block-states.h"
 
 #include "keys/encryptor.h"
 
@@ -53,6 +54,9 @@ class ValidatorSessionImpl : public ValidatorSession {
   const ValidatorSessionState *real_state_ = nullptr;
   const ValidatorSessionState *virtual_state_ = nullptr;
 
+  // blocks that keep a state in their extra, moved to the new generation on compaction
+  ValidatorSessionBlockStates block_states_;
+
   td::uint32 cur_round_ = 0;
   td::Timestamp round_started_at_ = td::Timestamp::never();
   td::Timestamp round_debug_at_ = td::Timestamp::never();
@@ -101,6 +105,7 @@ class ValidatorSessionImpl : public ValidatorSession {
   void check_approve();
   void check_action(td::uint32 att);
   void check_all();
+  void compact_state();
 
   std::unique_ptr<catchain::CatChain::Callback> make_catchain_callback() {
     class cb : public catchain::CatChain::Callback {
@@ -164,6 +169,7 @@ class ValidatorSessionImpl : public ValidatorSession {
 
   ValidatorSessionStats cur_stats_;
   bool stats_inited_ = false;
+  catchain::CatChainDbStats catchain_db_stats_;  // last snapshot received from catchain_
   std::map<std::pair<td::uint32, ValidatorSessionCandidateId>, std::vector<td::uint32>>
       stats_pending_approve_;  // round, candidate_id -> approvers
   std::map<std::pair<td::uint32, ValidatorSessionCandidateId>, std::vector<td::uint32>>
@@ -176,6 +182,10 @@ class ValidatorSessionImpl : public ValidatorSession {
   ValidatorSessionStats::Producer *stats_get_candidate_stat_by_id(td::uint32 round,
                                                                   ValidatorSessionCandidateId candidate_id);
   void stats_process_action(td::uint32 node_id, ton_api::validatorSession_round_Message &action);
+  void stats_update_catchain_db();
+  void stats_got_catchain_db(catchain::CatChainDbStats stats) {
+    catchain_db_stats_ = stats;
+  }
 
  public:
   ValidatorSessionImpl(catchain::CatChainSessionId session_id, ValidatorSessionOptions opts, PublicKeyHash local_id,
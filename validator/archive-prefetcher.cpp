@@ -0,0 +1,159 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "archive-prefetcher.hpp"
+
+namespace ton::validator {
+
+std::vector<std::string> ArchivePrefetcher::set_next(BlockSeqno seqno) {
+  std::vector<std::string> dropped;
+  // the same slice is asked again after a failed import, so it has to be downloaded again
+  next_taken_ = false;
+  if (seqno == next_) {
+    return dropped;
+  }
+  if (next_ != 0 && seqno > next_) {
+    // archive slices are at least 100 masterchain blocks long
+    step_ = std::max<BlockSeqno>(seqno - next_, 100);
+  }
+  next_ = seqno;
+  next_waited_ = false;
+  for (auto it = ready_.begin(); it != ready_.end();) {
+    if (useful(it->first)) {
+      ++it;
+      continue;
+    }
+    ++stats_dropped_;
+    ready_size_ -= it->second.size;
+    dropped.push_back(std::move(it->second.name));
+    it = ready_.erase(it);
+  }
+  for (auto it = failures_.begin(); it != failures_.end();) {
+    it = useful(it->first) ? std::next(it) : failures_.erase(it);
+  }
+  return dropped;
+}
+
+td::optional<std::string> ArchivePrefetcher::take_next() {
+  auto it = ready_.find(next_);
+  if (it == ready_.end()) {
+    next_waited_ = true;
+    return {};
+  }
+  if (next_waited_) {
+    ++stats_misses_;
+  } else {
+    ++stats_hits_;
+  }
+  next_taken_ = true;
+  auto name = std::move(it->second.name);
+  ready_size_ -= it->second.size;
+  ready_.erase(it);
+  return std::move(name);
+}
+
+std::vector<BlockSeqno> ArchivePrefetcher::start_downloads(td::Timestamp now) {
+  std::vector<BlockSeqno> res;
+  if (next_ == 0) {
+    return res;
+  }
+  BlockSeqno seqno = next_;
+  for (size_t k = 0; k < window_; k++, seqno += step_) {
+    if (k > 0) {
+      if (step_ == 0) {
+        // the length of a slice is not known before the first import
+        break;
+      }
+      // the next slice is downloaded even above the limit, otherwise the sync could not proceed
+      if (ready_size_ >= temp_limit_ || downloading_.size() + ready_.size() + next_taken_ >= window_) {
+        break;
+      }
+    }
+    if ((k == 0 && next_taken_) || ready_.count(seqno) || downloading_.count(seqno)) {
+      continue;
+    }
+    auto it = failures_.find(seqno);
+    if (it != failures_.end() && !it->second.retry_at.is_in_past(now)) {
+      continue;
+    }
+    downloading_.insert(seqno);
+    res.push_back(seqno);
+  }
+  return res;
+}
+
+bool ArchivePrefetcher::download_finished(BlockSeqno seqno, std::string name, td::uint64 size) {
+  downloading_.erase(seqno);
+  failures_.erase(seqno);
+  if (!useful(seqno) || (seqno == next_ && next_taken_)) {
+    ++stats_dropped_;
+    return false;
+  }
+  ready_size_ += size;
+  ready_[seqno] = Slice{std::move(name), size};
+  return true;
+}
+
+void ArchivePrefetcher::download_failed(BlockSeqno seqno, td::Timestamp now) {
+  downloading_.erase(seqno);
+  ++stats_failed_;
+  if (!useful(seqno)) {
+    return;
+  }
+  auto &failure = failures_[seqno];
+  double delay = RETRY_DELAY;
+  for (td::uint32 i = 0; i < failure.attempts && delay < MAX_RETRY_DELAY; i++) {
+    delay *= 2;
+  }
+  failure.attempts++;
+  failure.retry_at = td::Timestamp::in(std::min(delay, MAX_RETRY_DELAY), now);
+}
+
+std::vector<std::string> ArchivePrefetcher::clear() {
+  std::vector<std::string> res;
+  for (auto &it : ready_) {
+    res.push_back(std::move(it.second.name));
+  }
+  ready_.clear();
+  ready_size_ = 0;
+  downloading_.clear();
+  failures_.clear();
+  next_ = step_ = 0;
+  next_taken_ = next_waited_ = false;
+  return res;
+}
+
+td::Timestamp ArchivePrefetcher::next_retry(td::Timestamp now) const {
+  td::Timestamp res = td::Timestamp::never();
+  for (auto &it : failures_) {
+    if (!it.second.retry_at.is_in_past(now)) {
+      res.relax(it.second.retry_at);
+    }
+  }
+  return res;
+}
+
+bool ArchivePrefetcher::useful(BlockSeqno seqno) const {
+  if (next_ == 0 || seqno < next_) {
+    return false;
+  }
+  if (seqno == next_) {
+    return true;
+  }
+  return step_ != 0 && (seqno - next_) % step_ == 0;
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,113 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ton/ton-types.h"
+#include "td/utils/optional.h"
+#include "td/utils/Time.h"
+
+#include <map>
+#include <set>
+
+namespace ton::validator {
+
+/*
+ * Bookkeeping of archive slices downloaded ahead of the importer during initial sync.
+ * Slices are requested at next + k * step (k < window), where next is the first masterchain seqno the importer needs
+ * and step is the length of the last imported slice. Downloads that do not match the next slice after an import are
+ * dropped. A failed download is retried with exponential backoff.
+ * The class does no I/O: the caller starts the downloads it returns and deletes the files of dropped slices.
+ */
+class ArchivePrefetcher {
+ public:
+  static constexpr double RETRY_DELAY = 2.0;
+  static constexpr double MAX_RETRY_DELAY = 60.0;
+
+  ArchivePrefetcher(size_t window, td::uint64 temp_limit)
+      : window_(std::max<size_t>(window, 1)), temp_limit_(temp_limit) {
+  }
+
+  // The importer needs the slice that starts at seqno. Returns the files of the downloads that became useless.
+  std::vector<std::string> set_next(BlockSeqno seqno);
+  // Takes the downloaded next slice, if it is ready
+  td::optional<std::string> take_next();
+  // Seqnos of the slices to download now, the next slice first; they are marked as being downloaded
+  std::vector<BlockSeqno> start_downloads(td::Timestamp now);
+  // Returns false if the slice is not needed anymore and the file should be deleted
+  bool download_finished(BlockSeqno seqno, std::string name, td::uint64 size);
+  void download_failed(BlockSeqno seqno, td::Timestamp now);
+  // Returns the files of all downloaded slices and forgets about the sync
+  std::vector<std::string> clear();
+
+  BlockSeqno next() const {
+    return next_;
+  }
+  // The earliest retry of a failed download that is due after now
+  td::Timestamp next_retry(td::Timestamp now) const;
+
+  size_t downloading() const {
+    return downloading_.size();
+  }
+  size_t ready() const {
+    return ready_.size();
+  }
+  td::uint64 ready_size() const {
+    return ready_size_;
+  }
+  td::uint64 stats_hits() const {
+    return stats_hits_;
+  }
+  td::uint64 stats_misses() const {
+    return stats_misses_;
+  }
+  td::uint64 stats_dropped() const {
+    return stats_dropped_;
+  }
+  td::uint64 stats_failed() const {
+    return stats_failed_;
+  }
+
+ private:
+  struct Slice {
+    std::string name;
+    td::uint64 size = 0;
+  };
+  struct Failure {
+    td::uint32 attempts = 0;
+    td::Timestamp retry_at;
+  };
+
+  size_t window_;
+  td::uint64 temp_limit_;
+  BlockSeqno next_ = 0;
+  BlockSeqno step_ = 0;
+  // the next slice was handed to the importer, it is not downloaded again
+  bool next_taken_ = false;
+  // the importer asked for the next slice before it was downloaded
+  bool next_waited_ = false;
+
+  std::map<BlockSeqno, Slice> ready_;
+  std::set<BlockSeqno> downloading_;
+  std::map<BlockSeqno, Failure> failures_;
+  td::uint64 ready_size_ = 0;
+
+  td::uint64 stats_hits_ = 0, stats_misses_ = 0, stats_dropped_ = 0, stats_failed_ = 0;
+
+  bool useful(BlockSeqno seqno) const;
+};
+
+}  // namespace ton::validator
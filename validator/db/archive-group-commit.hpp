@@ -0,0 +1,91 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/actor/PromiseFuture.h"
+#include "td/db/KeyValue.h"
+
+#include <vector>
+
+namespace ton {
+
+namespace validator {
+
+// Group commit of archive slice index updates.
+// While a group is open, the updates of all queries go to one transaction of the index, and the promises of the
+// queries are resolved only after that transaction is committed, in the order of the queries. The owner commits the
+// group when end_query() reports that it is full, or when its time window expires.
+class ArchiveIndexGroupCommit {
+ public:
+  static constexpr td::uint32 MAX_SIZE = 256;
+
+  bool started() const {
+    return started_;
+  }
+  td::uint32 size() const {
+    return size_;
+  }
+
+  // starts the group transaction if there is none, returns true if it was started now
+  bool begin(td::KeyValue &kv) {
+    if (started_) {
+      return false;
+    }
+    kv.begin_transaction().ensure();
+    started_ = true;
+    return true;
+  }
+
+  // ends the updates of one query, returns true if the group is full and should be committed now
+  bool end_query() {
+    CHECK(started_);
+    return ++size_ >= MAX_SIZE;
+  }
+
+  // resolves the promise after the commit of the current group, or at once if there is no group
+  void after_commit(td::Promise<td::Unit> promise) {
+    if (started_) {
+      promises_.push_back(std::move(promise));
+    } else {
+      promise.set_value(td::Unit());
+    }
+  }
+
+  // commits the group and resolves the promises of its queries, returns the number of queries in it
+  td::uint32 commit(td::KeyValue &kv) {
+    CHECK(started_);
+    kv.commit_transaction().ensure();
+    auto size = size_;
+    started_ = false;
+    size_ = 0;
+    auto promises = std::move(promises_);
+    promises_.clear();
+    for (auto &promise : promises) {
+      promise.set_value(td::Unit());
+    }
+    return size;
+  }
+
+ private:
+  bool started_ = false;
+  td::uint32 size_ = 0;
+  std::vector<td::Promise<td::Unit>> promises_;
+};
+
+}  // namespace validator
+
+}  // namespace ton
@@ -436,20 +436,56 @@ void ArchiveManager::get_persistent_state(BlockIdExt block_id, BlockIdExt master
   }
 
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, 0, -1, 0, std::move(promise)).release();
+  // decompression runs in the reading actor
+  td::actor::create_actor<db::ReadFile>(
+      "readfile", path, 0, -1, 0,
+      promise.wrap([](td::BufferSlice data) { return vm::boc_frames::decompress(std::move(data)); }))
+      .release();
 }
 
 void ArchiveManager::get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                                td::int64 max_size, td::Promise<td::BufferSlice> promise) {
+                                                td::int64 max_size, bool stored_format,
+                                                td::Promise<td::BufferSlice> promise) {
   auto id = FileReference{fileref::PersistentState{block_id, masterchain_block_id}};
-  auto hash = id.hash();
-  if (perm_states_.find({masterchain_block_id.seqno(), hash}) == perm_states_.end()) {
+  auto key = std::make_pair(masterchain_block_id.seqno(), id.hash());
+  if (perm_states_.find(key) == perm_states_.end()) {
     promise.set_error(td::Status::Error(ErrorCode::notready, "state file not in db"));
     return;
   }
 
+  std::shared_ptr<const vm::boc_frames::Reader> reader;
+  auto it = perm_state_readers_.find(key);
+  if (it != perm_state_readers_.end()) {
+    reader = it->second;
+  }
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), key, cached = reader != nullptr, promise = std::move(promise)](
+          td::Result<std::pair<std::shared_ptr<const vm::boc_frames::Reader>, td::BufferSlice>> R) mutable {
+        if (R.is_error()) {
+          promise.set_error(R.move_as_error());
+          return;
+        }
+        auto res = R.move_as_ok();
+        if (!cached) {
+          td::actor::send_closure(SelfId, &ArchiveManager::add_perm_state_reader, key, std::move(res.first));
+        }
+        promise.set_value(std::move(res.second));
+      });
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, offset, max_size, 0, std::move(promise)).release();
+  td::actor::create_actor<db::ReadStateFileSlice>("readstateslice", path, std::move(reader), offset, max_size,
+                                                  stored_format, std::move(P))
+      .release();
+}
+
+void ArchiveManager::add_perm_state_reader(std::pair<BlockSeqno, FileHash> key,
+                                           std::shared_ptr<const vm::boc_frames::Reader> reader) {
+  if (perm_states_.count(key) == 0) {
+    return;
+  }
+  perm_state_readers_.emplace(key, std::move(reader));
+  if (perm_state_readers_.size() > max_perm_state_readers) {
+    perm_state_readers_.erase(perm_state_readers_.begin());
+  }
 }
 
 void ArchiveManager::check_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
@@ -625,7 +661,8 @@ void ArchiveManager::load_package(PackageId id) {
   }
 
   desc.file =
-      td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, archive_lru_.get(), statistics_);
+      td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, archive_lru_.get(),
+                                            statistics_, opts_->get_archive_group_commit_window());
 
   m.emplace(id, std::move(desc));
   update_permanent_slices();
@@ -660,7 +697,8 @@ const ArchiveManager::FileDescription *ArchiveManager::add_file_desc(ShardIdFull
   td::mkdir(db_root_ + id.path()).ensure();
   std::string prefix = PSTRING() << db_root_ << id.path() << id.name();
   new_desc.file =
-      td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, archive_lru_.get(), statistics_);
+      td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, archive_lru_.get(),
+                                            statistics_, opts_->get_archive_group_commit_window());
   const FileDescription &desc = f.emplace(id, std::move(new_desc));
   if (!id.temp) {
     update_desc(f, desc, shard, seqno, ts, lt);
@@ -1081,6 +1119,7 @@ void ArchiveManager::got_gc_masterchain_handle(ConstBlockHandle handle, std::pai
   if (to_del) {
     td::unlink(db_root_ + "/archive/states/" + F.filename_short()).ignore();
     perm_states_.erase(it);
+    perm_state_readers_.erase(key);
   }
   delay_action([key, SelfId = actor_id(
                           this)]() { td::actor::send_closure(SelfId, &ArchiveManager::persistent_state_gc, key); },
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "archive-slice.hpp"
+#include "vm/boc-frames.h"
 
 namespace ton {
 
@@ -51,7 +52,7 @@ class ArchiveManager : public td::actor::Actor {
   void get_zero_state(BlockIdExt block_id, td::Promise<td::BufferSlice> promise);
   void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::BufferSlice> promise);
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                  td::int64 max_size, td::Promise<td::BufferSlice> promise);
+                                  td::int64 max_size, bool stored_format, td::Promise<td::BufferSlice> promise);
   void check_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<bool> promise);
   void check_zero_state(BlockIdExt block_id, td::Promise<bool> promise);
   void get_previous_persistent_state_files(BlockSeqno cur_mc_seqno,
@@ -183,6 +184,9 @@ class ArchiveManager : public td::actor::Actor {
   }
 
   std::map<std::pair<BlockSeqno, FileHash>, FileReferenceShort> perm_states_;  // Mc block seqno, hash -> state
+  // open state files with parsed frame indices, for serving slices
+  std::map<std::pair<BlockSeqno, FileHash>, std::shared_ptr<const vm::boc_frames::Reader>> perm_state_readers_;
+  static constexpr size_t max_perm_state_readers = 16;
 
   void load_package(PackageId seqno);
   void delete_package(PackageId seqno, td::Promise<td::Unit> promise);
@@ -210,6 +214,7 @@ class ArchiveManager : public td::actor::Actor {
   void add_persistent_state_impl(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::Unit> promise,
                                  std::function<void(std::string, td::Promise<std::string>)> create_writer);
   void register_perm_state(FileReferenceShort id);
+  void add_perm_state_reader(std::pair<BlockSeqno, FileHash> key, std::shared_ptr<const vm::boc_frames::Reader> reader);
 
   void persistent_state_gc(std::pair<BlockSeqno, FileHash> last);
   void got_gc_masterchain_handle(ConstBlockHandle handle, std::pair<BlockSeqno, FileHash> key);
@@ -52,6 +52,12 @@ class PackageStatistics {
     write_time.insert(time);
   }
 
+  void record_index_commit(double time, uint64_t batch_size) {
+    std::lock_guard guard(index_commit_mutex);
+    index_commit_time.insert(time);
+    index_commit_batch.insert(static_cast<double>(batch_size));
+  }
+
   std::string to_string_and_reset() {
     std::stringstream ss;
     ss.setf(std::ios::fixed);
@@ -79,6 +85,17 @@ class PackageStatistics {
     }
     ss << "ton.pack.write.micros " << temp_write_time.to_string() << "\n";
 
+    PercentileStats temp_index_commit_time, temp_index_commit_batch;
+    {
+      std::lock_guard guard(index_commit_mutex);
+      temp_index_commit_time = std::move(index_commit_time);
+      temp_index_commit_batch = std::move(index_commit_batch);
+      index_commit_time.clear();
+      index_commit_batch.clear();
+    }
+    ss << "ton.index.commit.micros " << temp_index_commit_time.to_string() << "\n";
+    ss << "ton.index.commit.batch " << temp_index_commit_batch.to_string() << "\n";
+
     return ss.str();
   }
 
@@ -90,8 +107,13 @@ class PackageStatistics {
   PercentileStats write_time;
   std::atomic_uint64_t write_bytes{0};
 
+  // group commits of archive slice indexes
+  PercentileStats index_commit_time;
+  PercentileStats index_commit_batch;
+
   mutable std::mutex read_mutex;
   mutable std::mutex write_mutex;
+  mutable std::mutex index_commit_mutex;
 };
 
 void DbStatistics::init() {
@@ -231,7 +253,7 @@ void ArchiveSlice::add_handle(BlockHandle handle, td::Promise<td::Unit> promise)
   if (handle->need_flush()) {
     update_handle(std::move(handle), std::move(promise));
   } else {
-    promise.set_value(td::Unit());
+    after_commit(std::move(promise));
   }
 }
 
@@ -258,7 +280,7 @@ void ArchiveSlice::update_handle(BlockHandle handle, td::Promise<td::Unit> promi
     handle->set_handle_moved_to_archive();
   }
 
-  promise.set_value(td::Unit());
+  after_commit(std::move(promise));
 }
 
 void ArchiveSlice::add_file(BlockHandle handle, FileReference ref_id, td::BufferSlice data,
@@ -276,7 +298,8 @@ void ArchiveSlice::add_file(BlockHandle handle, FileReference ref_id, td::Buffer
   auto R = kv_->get(ref_id.hash().to_hex(), value);
   R.ensure();
   if (R.move_as_ok() == td::KeyValue::GetStatus::Ok) {
-    promise.set_value(td::Unit());
+    // the offset may come from the open group transaction
+    after_commit(std::move(promise));
     return;
   }
   promise = begin_async_query(std::move(promise));
@@ -310,7 +333,7 @@ void ArchiveSlice::add_file_cont(size_t idx, FileReference ref_id, td::uint64 of
     kv_->set(ref_id.hash().to_hex(), td::to_string(offset)).ensure();
   }
   commit_transaction();
-  promise.set_value(td::Unit());
+  after_commit(std::move(promise));
 }
 
 void ArchiveSlice::get_handle(BlockIdExt block_id, td::Promise<BlockHandle> promise) {
@@ -662,6 +685,14 @@ void ArchiveSlice::end_async_query() {
 }
 
 void ArchiveSlice::begin_transaction() {
+  if (group_commit_window_ > 0.0 && !async_mode_) {
+    if (group_commit_.begin(*kv_)) {
+      // keeps the index open until the commit
+      ++active_queries_;
+      alarm_timestamp() = td::Timestamp::in(group_commit_window_);
+    }
+    return;
+  }
   if (!async_mode_ || !huge_transaction_started_) {
     kv_->begin_transaction().ensure();
     if (async_mode_) {
@@ -671,8 +702,18 @@ void ArchiveSlice::begin_transaction() {
 }
 
 void ArchiveSlice::commit_transaction() {
+  if (group_commit_.started()) {
+    if (group_commit_.end_query()) {
+      flush_group_commit();
+    }
+    return;
+  }
   if (!async_mode_ || huge_transaction_size_++ >= 100) {
+    auto start = td::Timestamp::now();
     kv_->commit_transaction().ensure();
+    if (statistics_.pack_statistics && !async_mode_) {
+      statistics_.pack_statistics->record_index_commit((td::Timestamp::now().at() - start.at()) * 1e6, 1);
+    }
     if (async_mode_) {
       huge_transaction_size_ = 0;
       huge_transaction_started_ = false;
@@ -680,7 +721,32 @@ void ArchiveSlice::commit_transaction() {
   }
 }
 
+void ArchiveSlice::after_commit(td::Promise<td::Unit> promise) {
+  group_commit_.after_commit(std::move(promise));
+}
+
+void ArchiveSlice::flush_group_commit() {
+  if (!group_commit_.started()) {
+    return;
+  }
+  auto start = td::Timestamp::now();
+  auto size = group_commit_.commit(*kv_);
+  if (statistics_.pack_statistics) {
+    statistics_.pack_statistics->record_index_commit((td::Timestamp::now().at() - start.at()) * 1e6, size);
+  }
+  end_async_query();
+}
+
+void ArchiveSlice::alarm() {
+  flush_group_commit();
+}
+
+void ArchiveSlice::tear_down() {
+  flush_group_commit();
+}
+
 void ArchiveSlice::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
+  flush_group_commit();
   async_mode_ = mode;
   if (!async_mode_ && huge_transaction_started_ && kv_) {
     kv_->commit_transaction().ensure();
@@ -698,12 +764,14 @@ void ArchiveSlice::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
 }
 
 ArchiveSlice::ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, std::string db_root,
-                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics)
+                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics,
+                           double group_commit_window)
     : archive_id_(archive_id)
     , key_blocks_only_(key_blocks_only)
     , temp_(temp)
     , finalized_(finalized)
     , p_id_(archive_id_, key_blocks_only_, temp_)
+    , group_commit_window_(group_commit_window)
     , db_root_(std::move(db_root))
     , archive_lru_(std::move(archive_lru))
     , statistics_(statistics) {
@@ -781,6 +849,7 @@ void destroy_db(std::string name, td::uint32 attempt, td::Promise<td::Unit> prom
 
 void ArchiveSlice::destroy(td::Promise<td::Unit> promise) {
   before_query();
+  flush_group_commit();
   td::MultiPromise mp;
   auto ig = mp.init_guard();
   ig.add_promise(std::move(promise));
@@ -936,6 +1005,7 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle handl
     return;
   }
   before_query();
+  flush_group_commit();
   LOG(INFO) << "TRUNCATE: slice " << archive_id_ << " maxseqno= " << max_masterchain_seqno()
             << " truncate_upto=" << masterchain_seqno;
   if (max_masterchain_seqno() <= masterchain_seqno) {
@@ -21,6 +21,7 @@
 #include "validator/interfaces/db.h"
 #include "package.hpp"
 #include "fileref.hpp"
+#include "archive-group-commit.hpp"
 #include "td/db/RocksDb.h"
 #include <map>
 
@@ -97,7 +98,8 @@ class ArchiveLru;
 class ArchiveSlice : public td::actor::Actor {
  public:
   ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, std::string db_root,
-               td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {});
+               td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {},
+               double group_commit_window = 0.0);
 
   void get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise);
 
@@ -136,6 +138,11 @@ class ArchiveSlice : public td::actor::Actor {
 
   void begin_transaction();
   void commit_transaction();
+  // resolves promise once the updates made by the query are committed
+  void after_commit(td::Promise<td::Unit> promise);
+  void flush_group_commit();
+  void alarm() override;
+  void tear_down() override;
 
   void add_file_cont(size_t idx, FileReference ref_id, td::uint64 offset, td::uint64 size,
                      td::Promise<td::Unit> promise);
@@ -160,6 +167,11 @@ class ArchiveSlice : public td::actor::Actor {
   td::uint32 huge_transaction_size_ = 0;
   td::uint32 slice_size_{100};
 
+  // Group commit (group_commit_window_ > 0, not in async mode): index updates of all queries go to one transaction,
+  // which is committed group_commit_window_ seconds after the first update or when the group is full.
+  double group_commit_window_ = 0.0;
+  ArchiveIndexGroupCommit group_commit_;
+
   enum Status {
     st_closed, st_open, st_want_close
   } status_ = st_closed;
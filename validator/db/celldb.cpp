@@ -21,6 +21,7 @@
 
 #include "td/db/RocksDb.h"
 #include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
 
 #include "ton/ton-tl.hpp"
 #include "ton/ton-io.hpp"
@@ -65,8 +66,8 @@ void CellDbBase::execute_sync(std::function<void()> f) {
 }
 
 CellDbIn::CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path,
-                   td::Ref<ValidatorManagerOptions> opts)
-    : root_db_(root_db), parent_(parent), path_(std::move(path)), opts_(opts) {
+                   td::Ref<ValidatorManagerOptions> opts, std::shared_ptr<vm::CellCache> cell_cache)
+    : root_db_(root_db), parent_(parent), path_(std::move(path)), opts_(opts), cell_cache_(std::move(cell_cache)) {
 }
 
 void CellDbIn::start_up() {
@@ -102,7 +103,7 @@ void CellDbIn::start_up() {
 
   boc_ = vm::DynamicBagOfCellsDb::create();
   boc_->set_celldb_compress_depth(opts_->get_celldb_compress_depth());
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+  boc_->set_loader(create_loader()).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   alarm_timestamp() = td::Timestamp::in(10.0);
@@ -181,9 +182,11 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
   set_block(key_hash, std::move(D));
   cell_db_->commit_write_batch().ensure();
 
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+  boc_->set_loader(create_loader()).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
+  pin_state_top(cell);
+
   promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
   if (!opts_->get_disable_rocksdb_stats()) {
     cell_db_statistics_.store_cell_time_.insert(timer.elapsed() * 1e6);
@@ -191,6 +194,45 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
   LOG(DEBUG) << "Stored state " << block_id.to_str();
 }
 
+std::unique_ptr<vm::CellLoader> CellDbIn::create_loader() {
+  return std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_, cell_cache_);
+}
+
+void CellDbIn::pin_state_top(td::Ref<vm::Cell> root) {
+  if (!cell_cache_) {
+    return;
+  }
+  // cells of the first levels of a new state are read by almost every query to it
+  const size_t max_pinned_states = 16;
+  const size_t max_cells_per_state = 4096;
+  std::vector<vm::CellHash> hashes;
+  std::vector<td::Ref<vm::Cell>> queue{std::move(root)};
+  for (size_t i = 0; i < queue.size() && hashes.size() < max_cells_per_state; i++) {
+    if (!queue[i]->is_loaded()) {
+      continue;
+    }
+    auto R = queue[i]->load_cell();
+    if (R.is_error()) {
+      continue;
+    }
+    auto data_cell = R.move_as_ok().data_cell;
+    cell_cache_->put(data_cell);
+    hashes.push_back(data_cell->get_hash());
+    for (unsigned j = 0; j < data_cell->size_refs() && queue.size() < max_cells_per_state; j++) {
+      queue.push_back(data_cell->get_ref(j));
+    }
+  }
+  pinned_states_.push_back(std::move(hashes));
+  if (pinned_states_.size() > max_pinned_states) {
+    pinned_states_.pop_front();
+  }
+  std::vector<vm::CellHash> pinned;
+  for (auto& state : pinned_states_) {
+    pinned.insert(pinned.end(), state.begin(), state.end());
+  }
+  cell_cache_->set_pinned(pinned);
+}
+
 void CellDbIn::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
   promise.set_result(boc_->get_cell_db_reader());
 }
@@ -203,6 +245,16 @@ void CellDbIn::flush_db_stats() {
   if (opts_->get_disable_rocksdb_stats()) {
     return;
   }
+  if (cell_cache_) {
+    auto cache_stats = cell_cache_->get_stats();
+    auto period_stats = cache_stats;
+    period_stats.hits -= last_cell_cache_stats_.hits;
+    period_stats.misses -= last_cell_cache_stats_.misses;
+    period_stats.inserts -= last_cell_cache_stats_.inserts;
+    period_stats.evictions -= last_cell_cache_stats_.evictions;
+    cell_db_statistics_.cell_cache_ = period_stats;
+    last_cell_cache_stats_ = cache_stats;
+  }
   auto stats = td::RocksDb::statistics_to_string(statistics_) + snapshot_statistics_->to_string() +
                cell_db_statistics_.to_string();
   auto to_file_r =
@@ -318,7 +370,7 @@ void CellDbIn::gc_cont2(BlockHandle handle) {
   cell_db_->commit_write_batch().ensure();
   alarm_timestamp() = td::Timestamp::now();
 
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+  boc_->set_loader(create_loader()).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   DCHECK(get_block(key_hash).is_error());
@@ -420,7 +472,7 @@ void CellDbIn::migrate_cells() {
     }
   }
   cell_db_->commit_write_batch().ensure();
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+  boc_->set_loader(create_loader()).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   double time = timer.elapsed();
@@ -470,7 +522,11 @@ void CellDb::start_up() {
   CellDbBase::start_up();
   boc_ = vm::DynamicBagOfCellsDb::create();
   boc_->set_celldb_compress_depth(opts_->get_celldb_compress_depth());
-  cell_db_ = td::actor::create_actor<CellDbIn>("celldbin", root_db_, actor_id(this), path_, opts_);
+  if (opts_->get_celldb_cell_cache_size() > 0) {
+    cell_cache_ = std::make_shared<vm::CellCache>(opts_->get_celldb_cell_cache_size());
+    LOG(WARNING) << "Set CellDb cell cache size to " << td::format::as_size(opts_->get_celldb_cell_cache_size());
+  }
+  cell_db_ = td::actor::create_actor<CellDbIn>("celldbin", root_db_, actor_id(this), path_, opts_, cell_cache_);
   on_load_callback_ = [actor = std::make_shared<td::actor::ActorOwn<CellDbIn::MigrationProxy>>(
                            td::actor::create_actor<CellDbIn::MigrationProxy>("celldbmigration", cell_db_.get())),
                        compress_depth = opts_->get_celldb_compress_depth()](const vm::CellLoader::LoadResult& res) {
@@ -485,6 +541,57 @@ void CellDb::start_up() {
   };
 }
 
+void CellDbReplica::start_up() {
+  CellDbBase::start_up();
+  boc_ = vm::DynamicBagOfCellsDb::create();
+  boc_->set_celldb_compress_depth(opts_->get_celldb_compress_depth());
+  try_open();
+}
+
+void CellDbReplica::try_open() {
+  auto S = [&]() -> td::Status {
+    TRY_STATUS(td::mkpath(secondary_path_));
+    td::RocksDbOptions db_options;
+    db_options.block_cache = block_cache_;
+    db_options.use_direct_reads = opts_->get_celldb_direct_io();
+    db_options.secondary_path = secondary_path_;
+    TRY_RESULT(db, td::RocksDb::open(path_, std::move(db_options)));
+    cell_db_ = std::make_shared<td::RocksDb>(std::move(db));
+    return td::Status::OK();
+  }();
+  if (S.is_error()) {
+    // the primary instance creates the database on the first start
+    LOG(WARNING) << "Failed to open CellDb replica " << secondary_path_ << ": " << S;
+    alarm_timestamp() = td::Timestamp::in(10.0);
+    return;
+  }
+  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot())).ensure();
+  alarm_timestamp() = td::Timestamp::in(1.0);
+}
+
+void CellDbReplica::alarm() {
+  if (!cell_db_) {
+    try_open();
+    return;
+  }
+  td::PerfWarningTimer timer{"celldbreplicacatchup", 0.5};
+  auto S = cell_db_->try_catch_up_with_primary();
+  if (S.is_error()) {
+    LOG(WARNING) << "CellDb replica " << secondary_path_ << " failed to catch up: " << S;
+  } else {
+    boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot())).ensure();
+  }
+  alarm_timestamp() = td::Timestamp::in(1.0);
+}
+
+void CellDbReplica::load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise) {
+  if (!cell_db_) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "CellDb replica is not opened"));
+    return;
+  }
+  boc_->load_cell_async(hash.as_slice(), async_executor, std::move(promise));
+}
+
 CellDbIn::DbEntry::DbEntry(tl_object_ptr<ton_api::db_celldb_value> entry)
     : block_id(create_block_id(entry->block_id_))
     , prev(entry->prev_)
@@ -501,6 +608,18 @@ std::string CellDbIn::CellDbStatistics::to_string() {
   ss << "ton.celldb.store_cell.micros " << store_cell_time_.to_string() << "\n";
   ss << "ton.celldb.gc_cell.micros " << gc_cell_time_.to_string() << "\n";
   ss << "ton.celldb.total_time.micros : " << (td::Timestamp::now().at() - stats_start_time_.at()) * 1e6 << "\n";
+  if (cell_cache_) {
+    auto& c = cell_cache_.value();
+    auto lookups = c.hits + c.misses;
+    ss << "ton.celldb.cell_cache.hits COUNT : " << c.hits << "\n";
+    ss << "ton.celldb.cell_cache.misses COUNT : " << c.misses << "\n";
+    ss << "ton.celldb.cell_cache.hit_rate : " << (lookups ? (double)c.hits / (double)lookups : 0.0) << "\n";
+    ss << "ton.celldb.cell_cache.inserts COUNT : " << c.inserts << "\n";
+    ss << "ton.celldb.cell_cache.evictions COUNT : " << c.evictions << "\n";
+    ss << "ton.celldb.cell_cache.cells : " << c.cells << "\n";
+    ss << "ton.celldb.cell_cache.bytes : " << c.bytes << "\n";
+    ss << "ton.celldb.cell_cache.pinned_cells : " << c.pinned_cells << "\n";
+  }
   return ss.as_cslice().str();
 }
 
@@ -21,6 +21,7 @@
 #include "td/actor/actor.h"
 #include "crypto/vm/db/DynamicBagOfCellsDb.h"
 #include "crypto/vm/db/CellStorage.h"
+#include "crypto/vm/db/CellCache.h"
 #include "td/db/KeyValue.h"
 #include "ton/ton-types.h"
 #include "interfaces/block-handle.h"
@@ -28,8 +29,12 @@
 #include "validator.h"
 #include "db-utils.h"
 #include "td/db/RocksDb.h"
+#include "td/utils/optional.h"
+
+#include <deque>
 
 namespace rocksdb {
+class Cache;
 class Statistics;
 }
 
@@ -68,7 +73,7 @@ class CellDbIn : public CellDbBase {
   void flush_db_stats();
 
   CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path,
-           td::Ref<ValidatorManagerOptions> opts);
+           td::Ref<ValidatorManagerOptions> opts, std::shared_ptr<vm::CellCache> cell_cache);
 
   void start_up() override;
   void alarm() override;
@@ -105,6 +110,9 @@ class CellDbIn : public CellDbBase {
 
   void migrate_cells();
 
+  std::unique_ptr<vm::CellLoader> create_loader();
+  void pin_state_top(td::Ref<vm::Cell> root);
+
   td::actor::ActorId<RootDb> root_db_;
   td::actor::ActorId<CellDb> parent_;
 
@@ -115,6 +123,10 @@ class CellDbIn : public CellDbBase {
   std::shared_ptr<vm::KeyValue> cell_db_;
 
   std::function<void(const vm::CellLoader::LoadResult&)> on_load_callback_;
+  std::shared_ptr<vm::CellCache> cell_cache_;
+  // top cells of the last stored states, pinned in cell_cache_
+  std::deque<std::vector<vm::CellHash>> pinned_states_;
+  vm::CellCache::Stats last_cell_cache_stats_;
   std::set<td::Bits256> cells_to_migrate_;
   td::Timestamp migrate_after_ = td::Timestamp::never();
   bool migration_active_ = false;
@@ -133,6 +145,8 @@ class CellDbIn : public CellDbBase {
     PercentileStats store_cell_time_;
     PercentileStats gc_cell_time_;
     td::Timestamp stats_start_time_ = td::Timestamp::now();
+    // counters are for the current period, sizes are current
+    td::optional<vm::CellCache::Stats> cell_cache_;
 
     std::string to_string();
     void clear() {
@@ -166,7 +180,7 @@ class CellDb : public CellDbBase {
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
   void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
     started_ = true;
-    boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot), on_load_callback_)).ensure();
+    boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot), on_load_callback_, cell_cache_)).ensure();
   }
   void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise);
   void get_last_deleted_mc_state(td::Promise<BlockSeqno> promise);
@@ -185,11 +199,46 @@ class CellDb : public CellDbBase {
   td::actor::ActorOwn<CellDbIn> cell_db_;
 
   std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
+  std::shared_ptr<vm::CellCache> cell_cache_;
   bool started_ = false;
 
   std::function<void(const vm::CellLoader::LoadResult&)> on_load_callback_;
 };
 
+/*
+ * Read-only replica of CellDb for lite queries: a secondary instance of the RocksDb of CellDbIn, with its own block
+ * cache, that catches up with the primary instance every second. Cells are read directly from the caught-up state,
+ * without snapshots, so a state deleted by gc may disappear under a running query (as with the primary instance).
+ * The replica only separates the block cache and the actor queue from the primary CellDb: it runs in the same
+ * process, so heavy lite queries still compete with collation and validation for CPU, memory and disk bandwidth.
+ */
+class CellDbReplica : public CellDbBase {
+ public:
+  CellDbReplica(std::string path, std::string secondary_path, std::shared_ptr<rocksdb::Cache> block_cache,
+                td::Ref<ValidatorManagerOptions> opts)
+      : path_(std::move(path))
+      , secondary_path_(std::move(secondary_path))
+      , block_cache_(std::move(block_cache))
+      , opts_(std::move(opts)) {
+  }
+
+  void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
+
+  void start_up() override;
+  void alarm() override;
+
+ private:
+  std::string path_;
+  std::string secondary_path_;
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  td::Ref<ValidatorManagerOptions> opts_;
+
+  std::shared_ptr<td::RocksDb> cell_db_;
+  std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
+
+  void try_open();
+};
+
 }  // namespace validator
 
 }  // namespace ton
@@ -24,6 +24,7 @@
 #include "td/utils/buffer.h"
 
 #include "common/errorcode.h"
+#include "vm/boc-frames.h"
 
 namespace ton {
 
@@ -129,6 +130,51 @@ class ReadFile : public td::actor::Actor {
   td::Promise<td::BufferSlice> promise_;
 };
 
+// Reads a slice of a persistent state file, which may be stored as lz4 frames.
+// The reader (with the parsed frame index) is returned with the data, so that the caller can reuse it
+class ReadStateFileSlice : public td::actor::Actor {
+ public:
+  using Reader = vm::boc_frames::Reader;
+  void start_up() override {
+    if (!reader_) {
+      auto R = Reader::open(file_name_);
+      if (R.is_error()) {
+        auto error = R.move_as_error_prefix(PSTRING() << "failed to open state file " << file_name_ << ": ");
+        LOG(WARNING) << error;
+        promise_.set_error(std::move(error));
+        stop();
+        return;
+      }
+      reader_ = std::make_shared<Reader>(R.move_as_ok());
+    }
+    auto R = stored_format_ ? reader_->read_stored(offset_, max_length_) : reader_->read(offset_, max_length_);
+    if (R.is_error()) {
+      promise_.set_error(R.move_as_error_prefix(PSTRING() << "failed to read " << file_name_ << ": "));
+    } else {
+      promise_.set_value(std::make_pair(std::move(reader_), R.move_as_ok()));
+    }
+    stop();
+  }
+  ReadStateFileSlice(std::string file_name, std::shared_ptr<const Reader> reader, td::int64 offset,
+                     td::int64 max_length, bool stored_format,
+                     td::Promise<std::pair<std::shared_ptr<const Reader>, td::BufferSlice>> promise)
+      : file_name_(std::move(file_name))
+      , reader_(std::move(reader))
+      , offset_(offset)
+      , max_length_(max_length)
+      , stored_format_(stored_format)
+      , promise_(std::move(promise)) {
+  }
+
+ private:
+  std::string file_name_;
+  std::shared_ptr<const Reader> reader_;
+  td::int64 offset_;
+  td::int64 max_length_;
+  bool stored_format_;
+  td::Promise<std::pair<std::shared_ptr<const Reader>, td::BufferSlice>> promise_;
+};
+
 }  // namespace db
 
 }  // namespace validator
@@ -231,7 +231,10 @@ void RootDb::store_block_state(BlockHandle handle, td::Ref<ShardState> state,
         handle->set_state_boc();
 
         auto S = create_shard_state(handle->id(), R.move_as_ok());
-        S.ensure();
+        if (S.is_error()) {
+          promise.set_error(S.move_as_error());
+          return;
+        }
 
         auto P = td::PromiseCreator::lambda(
             [promise = std::move(promise), state = S.move_as_ok()](td::Result<td::Unit> R) mutable {
@@ -259,9 +262,7 @@ void RootDb::get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardS
           if (R.is_error()) {
             promise.set_error(R.move_as_error());
           } else {
-            auto S = create_shard_state(handle->id(), R.move_as_ok());
-            S.ensure();
-            promise.set_value(S.move_as_ok());
+            promise.set_result(create_shard_state(handle->id(), R.move_as_ok()));
           }
         });
     td::actor::send_closure(cell_db_, &CellDb::load_cell, handle->state(), std::move(P));
@@ -270,6 +271,24 @@ void RootDb::get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardS
   }
 }
 
+void RootDb::get_block_state_for_litequery(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) {
+  if (cell_db_replicas_.empty() || !handle->inited_state_boc() || handle->deleted_state_boc()) {
+    get_block_state(std::move(handle), std::move(promise));
+    return;
+  }
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), handle, promise = std::move(promise)](td::Result<td::Ref<vm::DataCell>> R) mutable {
+        if (R.is_error()) {
+          // the replica may not have caught up with the state yet
+          td::actor::send_closure(SelfId, &RootDb::get_block_state, std::move(handle), std::move(promise));
+        } else {
+          promise.set_result(create_shard_state(handle->id(), R.move_as_ok()));
+        }
+      });
+  auto& replica = cell_db_replicas_[next_cell_db_replica_++ % cell_db_replicas_.size()];
+  td::actor::send_closure(replica, &CellDbReplica::load_cell, handle->state(), std::move(P));
+}
+
 void RootDb::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
   td::actor::send_closure(cell_db_, &CellDb::get_cell_db_reader, std::move(promise));
 }
@@ -298,9 +317,10 @@ void RootDb::get_persistent_state_file(BlockIdExt block_id, BlockIdExt mastercha
 }
 
 void RootDb::get_persistent_state_file_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                             td::int64 max_size, td::Promise<td::BufferSlice> promise) {
+                                             td::int64 max_size, bool stored_format,
+                                             td::Promise<td::BufferSlice> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::get_persistent_state_slice, block_id, masterchain_block_id,
-                          offset, max_size, std::move(promise));
+                          offset, max_size, stored_format, std::move(promise));
 }
 
 void RootDb::check_persistent_state_file_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
@@ -408,6 +428,14 @@ void RootDb::get_hardforks(td::Promise<std::vector<BlockIdExt>> promise) {
 
 void RootDb::start_up() {
   cell_db_ = td::actor::create_actor<CellDb>("celldb", actor_id(this), root_path_ + "/celldb/", opts_);
+  if (opts_->get_celldb_replicas() > 0) {
+    auto block_cache = td::RocksDb::create_cache(opts_->get_celldb_replica_cache_size());
+    for (td::uint32 i = 0; i < opts_->get_celldb_replicas(); i++) {
+      auto secondary_path = PSTRING() << root_path_ << "/celldb-replica/" << i;
+      cell_db_replicas_.push_back(td::actor::create_actor<CellDbReplica>(
+          PSTRING() << "celldbreplica" << i, root_path_ + "/celldb/", std::move(secondary_path), block_cache, opts_));
+    }
+  }
   state_db_ = td::actor::create_actor<StateDb>("statedb", actor_id(this), root_path_ + "/state/");
   static_files_db_ = td::actor::create_actor<StaticFilesDb>("staticfilesdb", actor_id(this), root_path_ + "/static/");
   archive_db_ = td::actor::create_actor<ArchiveManager>("archive", actor_id(this), root_path_, opts_);
@@ -62,6 +62,7 @@ class RootDb : public Db {
   void store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                          td::Promise<td::Ref<ShardState>> promise) override;
   void get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) override;
+  void get_block_state_for_litequery(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) override;
   void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) override;
   void get_last_deleted_mc_state(td::Promise<BlockSeqno> promise) override;
 
@@ -79,7 +80,8 @@ class RootDb : public Db {
   void get_persistent_state_file(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                  td::Promise<td::BufferSlice> promise) override;
   void get_persistent_state_file_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                       td::int64 max_length, td::Promise<td::BufferSlice> promise) override;
+                                       td::int64 max_length, bool stored_format,
+                                       td::Promise<td::BufferSlice> promise) override;
   void check_persistent_state_file_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                           td::Promise<bool> promise) override;
   void store_zero_state_file(BlockIdExt block_id, td::BufferSlice state, td::Promise<td::Unit> promise) override;
@@ -145,6 +147,8 @@ class RootDb : public Db {
   td::Ref<ValidatorManagerOptions> opts_;
 
   td::actor::ActorOwn<CellDb> cell_db_;
+  std::vector<td::actor::ActorOwn<CellDbReplica>> cell_db_replicas_;
+  size_t next_cell_db_replica_ = 0;
   td::actor::ActorOwn<StateDb> state_db_;
   td::actor::ActorOwn<StaticFilesDb> static_files_db_;
   td::actor::ActorOwn<ArchiveManager> archive_db_;
@@ -354,6 +354,21 @@ void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNo
 
 void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSlice &query,
                                        td::Promise<td::BufferSlice> promise) {
+  get_persistent_state_slice(src, create_block_id(query.block_), create_block_id(query.masterchain_block_),
+                             query.offset_, query.max_size_, false, std::move(promise));
+}
+
+void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src,
+                                       ton_api::tonNode_downloadPersistentStateSliceStored &query,
+                                       td::Promise<td::BufferSlice> promise) {
+  get_persistent_state_slice(src, create_block_id(query.block_), create_block_id(query.masterchain_block_),
+                             query.offset_, query.max_size_, true, std::move(promise));
+}
+
+void FullNodeMasterImpl::get_persistent_state_slice(adnl::AdnlNodeIdShort src, BlockIdExt block_id,
+                                                    BlockIdExt masterchain_block_id, td::int64 offset,
+                                                    td::int64 max_size, bool stored_format,
+                                                    td::Promise<td::BufferSlice> promise) {
   auto P = td::PromiseCreator::lambda(
       [SelfId = actor_id(this), promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
         if (R.is_error()) {
@@ -363,10 +378,8 @@ void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNo
 
         promise.set_value(R.move_as_ok());
       });
-  auto block_id = create_block_id(query.block_);
-  auto masterchain_block_id = create_block_id(query.masterchain_block_);
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_persistent_state_slice, block_id,
-                          masterchain_block_id, query.offset_, query.max_size_, std::move(P));
+                          masterchain_block_id, offset, max_size, stored_format, std::move(P));
 }
 
 void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getCapabilities &query,
@@ -32,7 +32,7 @@ class FullNodeMasterImpl : public FullNodeMaster {
     return 1;
   }
   static constexpr td::uint64 proto_capabilities() {
-    return 0;
+    return FullNode::capability_persistent_state_stored();
   }
   void start_up() override;
 
@@ -74,6 +74,11 @@ class FullNodeMasterImpl : public FullNodeMaster {
                      td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSlice &query,
                      td::Promise<td::BufferSlice> promise);
+  void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSliceStored &query,
+                     td::Promise<td::BufferSlice> promise);
+  void get_persistent_state_slice(adnl::AdnlNodeIdShort src, BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                  td::int64 offset, td::int64 max_size, bool stored_format,
+                                  td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getCapabilities &query,
                      td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_slave_sendExtMessage &query,
@@ -22,6 +22,76 @@
 
 namespace ton::validator::fullnode {
 
+namespace {
+
+// Decodes a cell delta broadcast, loading the replaced cells from celldb
+class CellDeltaBroadcastDecoder : public td::actor::Actor {
+ public:
+  CellDeltaBroadcastDecoder(PublicKeyHash src, tl_object_ptr<ton_api::tonNode_Broadcast> broadcast,
+                            std::shared_ptr<vm::CellDbReader> cell_db,
+                            td::actor::ActorId<FullNodePrivateBlockOverlay> parent)
+      : src_(src), broadcast_(std::move(broadcast)), cell_db_(std::move(cell_db)), parent_(parent) {
+  }
+
+  void start_up() override {
+    bool cells_missing = false;
+    if (broadcast_->get_id() == ton_api::tonNode_blockBroadcastCompressed::ID) {
+      auto B = deserialize_block_broadcast(*broadcast_, overlay::Overlays::max_fec_broadcast_size(), cell_db_.get(),
+                                           &cells_missing);
+      if (B.is_error()) {
+        LOG(DEBUG) << "dropped broadcast: " << B.move_as_error();
+      } else {
+        td::actor::send_closure(parent_, &FullNodePrivateBlockOverlay::got_block_broadcast, src_, B.move_as_ok(),
+                                cells_missing);
+      }
+    } else {
+      BlockIdExt block_id;
+      CatchainSeqno cc_seqno;
+      td::uint32 validator_set_hash;
+      td::BufferSlice data;
+      auto S = deserialize_block_candidate_broadcast(*broadcast_, block_id, cc_seqno, validator_set_hash, data,
+                                                     overlay::Overlays::max_fec_broadcast_size(), cell_db_.get(),
+                                                     &cells_missing);
+      if (S.is_error()) {
+        LOG(DEBUG) << "dropped broadcast: " << S;
+      } else {
+        td::actor::send_closure(parent_, &FullNodePrivateBlockOverlay::got_block_candidate_broadcast, src_, block_id,
+                                cc_seqno, validator_set_hash, std::move(data), cells_missing);
+      }
+    }
+    stop();
+  }
+
+ private:
+  PublicKeyHash src_;
+  tl_object_ptr<ton_api::tonNode_Broadcast> broadcast_;
+  std::shared_ptr<vm::CellDbReader> cell_db_;
+  td::actor::ActorId<FullNodePrivateBlockOverlay> parent_;
+};
+
+// drops expired entries and, if the map is full, the one that expires first
+template <class Map>
+void trim_sent_blocks(Map &sent, size_t max_size) {
+  for (auto it = sent.begin(); it != sent.end();) {
+    if (it->second.expire_at.is_in_past()) {
+      it = sent.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (sent.size() >= max_size) {
+    auto oldest = sent.begin();
+    for (auto it = sent.begin(); it != sent.end(); ++it) {
+      if (it->second.expire_at < oldest->second.expire_at) {
+        oldest = it;
+      }
+    }
+    sent.erase(oldest);
+  }
+}
+
+}  // namespace
+
 void FullNodePrivateBlockOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNode_blockBroadcast &query) {
   process_block_broadcast(src, query);
 }
@@ -37,9 +107,18 @@ void FullNodePrivateBlockOverlay::process_block_broadcast(PublicKeyHash src, ton
     LOG(DEBUG) << "dropped broadcast: " << B.move_as_error();
     return;
   }
+  got_block_broadcast(src, B.move_as_ok(), false);
+}
+
+void FullNodePrivateBlockOverlay::got_block_broadcast(PublicKeyHash src, BlockBroadcast broadcast,
+                                                      bool cells_missing) {
+  if (cells_missing) {
+    download_block_broadcast(src, std::move(broadcast));
+    return;
+  }
   VLOG(FULL_NODE_DEBUG) << "Received block broadcast in private overlay from " << src << ": "
-                        << B.ok().block_id.to_str();
-  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok());
+                        << broadcast.block_id.to_str();
+  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, std::move(broadcast));
 }
 
 void FullNodePrivateBlockOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNode_newShardBlockBroadcast &query) {
@@ -72,6 +151,21 @@ void FullNodePrivateBlockOverlay::process_block_candidate_broadcast(PublicKeyHas
     LOG(DEBUG) << "dropped broadcast: " << S;
     return;
   }
+  got_block_candidate(src, block_id, cc_seqno, validator_set_hash, std::move(data));
+}
+
+void FullNodePrivateBlockOverlay::got_block_candidate_broadcast(PublicKeyHash src, BlockIdExt block_id,
+                                                                CatchainSeqno cc_seqno, td::uint32 validator_set_hash,
+                                                                td::BufferSlice data, bool cells_missing) {
+  if (cells_missing) {
+    download_block_candidate(src, block_id, cc_seqno, validator_set_hash);
+    return;
+  }
+  got_block_candidate(src, block_id, cc_seqno, validator_set_hash, std::move(data));
+}
+
+void FullNodePrivateBlockOverlay::got_block_candidate(PublicKeyHash src, BlockIdExt block_id, CatchainSeqno cc_seqno,
+                                                      td::uint32 validator_set_hash, td::BufferSlice data) {
   if (data.size() > FullNode::max_block_size()) {
     VLOG(FULL_NODE_WARNING) << "received block candidate with too big size from " << src;
     return;
@@ -93,9 +187,134 @@ void FullNodePrivateBlockOverlay::receive_broadcast(PublicKeyHash src, td::Buffe
   if (B.is_error()) {
     return;
   }
+  if (is_cell_delta_broadcast(*B.ok())) {
+    td::actor::create_actor<CellDeltaBroadcastDecoder>("decodebroadcast", src, B.move_as_ok(), cell_db_reader_,
+                                                       actor_id(this))
+        .release();
+    return;
+  }
   ton_api::downcast_call(*B.move_as_ok(), [src, Self = this](auto &obj) { Self->process_broadcast(src, obj); });
 }
 
+void FullNodePrivateBlockOverlay::receive_query(adnl::AdnlNodeIdShort src, td::BufferSlice query,
+                                                td::Promise<td::BufferSlice> promise) {
+  auto F = fetch_tl_object<ton_api::Function>(std::move(query), true);
+  if (F.is_error()) {
+    promise.set_error(td::Status::Error(ErrorCode::protoviolation, "cannot parse tonnode query"));
+    return;
+  }
+  ton_api::downcast_call(*F.move_as_ok(), [&](auto &obj) { this->process_query(src, obj, std::move(promise)); });
+}
+
+void FullNodePrivateBlockOverlay::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadBlockFull &query,
+                                                td::Promise<td::BufferSlice> promise) {
+  BlockIdExt block_id = create_block_id(query.block_);
+  auto it = sent_blocks_.find(block_id);
+  if (it == sent_blocks_.end()) {
+    promise.set_value(create_serialize_tl_object<ton_api::tonNode_dataFullEmpty>());
+    return;
+  }
+  VLOG(FULL_NODE_DEBUG) << "Sending block " << block_id.to_str() << " to " << src << " in private overlay";
+  promise.set_result(serialize_block_full(block_id, it->second.proof, it->second.data, false, true));
+}
+
+void FullNodePrivateBlockOverlay::process_query(adnl::AdnlNodeIdShort src,
+                                                ton_api::tonNode_downloadBlockCandidate &query,
+                                                td::Promise<td::BufferSlice> promise) {
+  BlockIdExt block_id = create_block_id(query.id_);
+  auto it = sent_candidates_.find({block_id, query.catchain_seqno_, (td::uint32)query.validator_set_hash_});
+  if (it == sent_candidates_.end()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "unknown block candidate"));
+    return;
+  }
+  VLOG(FULL_NODE_DEBUG) << "Sending block candidate " << block_id.to_str() << " to " << src << " in private overlay";
+  promise.set_result(serialize_block_candidate_broadcast(block_id, query.catchain_seqno_,
+                                                         (td::uint32)query.validator_set_hash_, it->second.data, true));
+}
+
+void FullNodePrivateBlockOverlay::download_block_broadcast(PublicKeyHash src, BlockBroadcast broadcast) {
+  VLOG(FULL_NODE_DEBUG) << "Cells of block broadcast " << broadcast.block_id.to_str()
+                        << " are not in celldb, downloading the block from " << src;
+  BlockIdExt block_id = broadcast.block_id;
+  auto P = td::PromiseCreator::lambda([full_node = full_node_, broadcast = std::move(broadcast)](
+                                          td::Result<td::BufferSlice> R) mutable {
+    auto S = [&]() -> td::Status {
+      TRY_RESULT(data, std::move(R));
+      TRY_RESULT(f, fetch_tl_object<ton_api::tonNode_DataFull>(std::move(data), true));
+      if (f->get_id() == ton_api::tonNode_dataFullEmpty::ID) {
+        return td::Status::Error(ErrorCode::notready, "sender doesn't have this block");
+      }
+      BlockIdExt id;
+      bool is_link;
+      TRY_STATUS(deserialize_block_full(*f, id, broadcast.proof, broadcast.data, is_link,
+                                        overlay::Overlays::max_fec_broadcast_size()));
+      if (id != broadcast.block_id) {
+        return td::Status::Error(ErrorCode::protoviolation, "received data for wrong block");
+      }
+      return td::Status::OK();
+    }();
+    if (S.is_error()) {
+      VLOG(FULL_NODE_DEBUG) << "Failed to download block " << broadcast.block_id.to_str() << ": " << S;
+      return;
+    }
+    td::actor::send_closure(full_node, &FullNode::process_block_broadcast, std::move(broadcast));
+  });
+  td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, adnl::AdnlNodeIdShort{src}, local_id_,
+                          overlay_id_, "get_block", std::move(P), td::Timestamp::in(5.0),
+                          create_serialize_tl_object<ton_api::tonNode_downloadBlockFull>(create_tl_block_id(block_id)),
+                          FullNode::max_proof_size() + FullNode::max_block_size() + 128, rldp_);
+}
+
+void FullNodePrivateBlockOverlay::download_block_candidate(PublicKeyHash src, BlockIdExt block_id,
+                                                           CatchainSeqno cc_seqno, td::uint32 validator_set_hash) {
+  VLOG(FULL_NODE_DEBUG) << "Cells of block candidate " << block_id.to_str()
+                        << " are not in celldb, downloading it from " << src;
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), src, block_id, cc_seqno, validator_set_hash](td::Result<td::BufferSlice> R) {
+        auto S = [&]() -> td::Result<td::BufferSlice> {
+          TRY_RESULT(data, std::move(R));
+          TRY_RESULT(f, fetch_tl_object<ton_api::tonNode_Broadcast>(std::move(data), true));
+          if (is_cell_delta_broadcast(*f)) {
+            return td::Status::Error(ErrorCode::protoviolation, "received cell delta block candidate");
+          }
+          BlockIdExt id;
+          CatchainSeqno id_cc_seqno;
+          td::uint32 id_validator_set_hash;
+          td::BufferSlice block_data;
+          TRY_STATUS(deserialize_block_candidate_broadcast(*f, id, id_cc_seqno, id_validator_set_hash, block_data,
+                                                           overlay::Overlays::max_fec_broadcast_size()));
+          if (id != block_id || id_cc_seqno != cc_seqno || id_validator_set_hash != validator_set_hash) {
+            return td::Status::Error(ErrorCode::protoviolation, "received data for wrong block candidate");
+          }
+          return std::move(block_data);
+        }();
+        if (S.is_error()) {
+          VLOG(FULL_NODE_DEBUG) << "Failed to download block candidate " << block_id.to_str() << ": "
+                                << S.move_as_error();
+          return;
+        }
+        td::actor::send_closure(SelfId, &FullNodePrivateBlockOverlay::got_block_candidate, src, block_id, cc_seqno,
+                                validator_set_hash, S.move_as_ok());
+      });
+  td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, adnl::AdnlNodeIdShort{src}, local_id_,
+                          overlay_id_, "get_block_candidate", std::move(P), td::Timestamp::in(5.0),
+                          create_serialize_tl_object<ton_api::tonNode_downloadBlockCandidate>(
+                              create_tl_block_id(block_id), cc_seqno, validator_set_hash),
+                          FullNode::max_block_size() + 128, rldp_);
+}
+
+void FullNodePrivateBlockOverlay::add_sent_block(BlockIdExt block_id, td::BufferSlice proof, td::BufferSlice data) {
+  trim_sent_blocks(sent_blocks_, max_sent_blocks());
+  sent_blocks_[block_id] = SentBlock{std::move(proof), std::move(data), td::Timestamp::in(sent_block_ttl())};
+}
+
+void FullNodePrivateBlockOverlay::add_sent_block_candidate(BlockIdExt block_id, CatchainSeqno cc_seqno,
+                                                           td::uint32 validator_set_hash, td::BufferSlice data) {
+  trim_sent_blocks(sent_candidates_, max_sent_blocks());
+  sent_candidates_[{block_id, cc_seqno, validator_set_hash}] =
+      SentBlockCandidate{std::move(data), td::Timestamp::in(sent_block_ttl())};
+}
+
 void FullNodePrivateBlockOverlay::send_shard_block_info(BlockIdExt block_id, CatchainSeqno cc_seqno,
                                                         td::BufferSlice data) {
   if (!inited_) {
@@ -118,12 +337,15 @@ void FullNodePrivateBlockOverlay::send_block_candidate(BlockIdExt block_id, Catc
   if (!inited_) {
     return;
   }
-  auto B =
-      serialize_block_candidate_broadcast(block_id, cc_seqno, validator_set_hash, data, true);  // compression enabled
+  auto B = serialize_block_candidate_broadcast(block_id, cc_seqno, validator_set_hash, data, true,
+                                               broadcast_cell_delta_);  // compression enabled
   if (B.is_error()) {
     VLOG(FULL_NODE_WARNING) << "failed to serialize block candidate broadcast: " << B.move_as_error();
     return;
   }
+  if (broadcast_cell_delta_) {
+    add_sent_block_candidate(block_id, cc_seqno, validator_set_hash, std::move(data));
+  }
   VLOG(FULL_NODE_DEBUG) << "Sending newBlockCandidate in private overlay: " << block_id.to_str();
   td::actor::send_closure(overlays_, &overlay::Overlays::send_broadcast_fec_ex, local_id_, overlay_id_,
                           local_id_.pubkey_hash(), overlay::Overlays::BroadcastFlagAnySender(), B.move_as_ok());
@@ -135,11 +357,14 @@ void FullNodePrivateBlockOverlay::send_broadcast(BlockBroadcast broadcast) {
   }
   VLOG(FULL_NODE_DEBUG) << "Sending block broadcast in private overlay"
                         << (enable_compression_ ? " (with compression)" : "") << ": " << broadcast.block_id.to_str();
-  auto B = serialize_block_broadcast(broadcast, enable_compression_);
+  auto B = serialize_block_broadcast(broadcast, enable_compression_, enable_compression_ && broadcast_cell_delta_);
   if (B.is_error()) {
     VLOG(FULL_NODE_WARNING) << "failed to serialize block broadcast: " << B.move_as_error();
     return;
   }
+  if (enable_compression_ && broadcast_cell_delta_) {
+    add_sent_block(broadcast.block_id, std::move(broadcast.proof), std::move(broadcast.data));
+  }
   td::actor::send_closure(overlays_, &overlay::Overlays::send_broadcast_fec_ex, local_id_, overlay_id_,
                           local_id_.pubkey_hash(), overlay::Overlays::BroadcastFlagAnySender(), B.move_as_ok());
 }
@@ -158,6 +383,13 @@ void FullNodePrivateBlockOverlay::start_up() {
   overlay_id_full_ = overlay::OverlayIdFull{std::move(b)};
   overlay_id_ = overlay_id_full_.compute_short_id();
 
+  td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_cell_db_reader,
+                          [SelfId = actor_id(this)](td::Result<std::shared_ptr<vm::CellDbReader>> R) {
+                            if (R.is_ok()) {
+                              td::actor::send_closure(SelfId, &FullNodePrivateBlockOverlay::set_cell_db_reader,
+                                                      R.move_as_ok());
+                            }
+                          });
   try_init();
 }
 
@@ -183,6 +415,8 @@ void FullNodePrivateBlockOverlay::init() {
     }
     void receive_query(adnl::AdnlNodeIdShort src, overlay::OverlayIdShort overlay_id, td::BufferSlice data,
                        td::Promise<td::BufferSlice> promise) override {
+      td::actor::send_closure(node_, &FullNodePrivateBlockOverlay::receive_query, src, std::move(data),
+                              std::move(promise));
     }
     void receive_broadcast(PublicKeyHash src, overlay::OverlayIdShort overlay_id, td::BufferSlice data) override {
       td::actor::send_closure(node_, &FullNodePrivateBlockOverlay::receive_broadcast, src, std::move(data));
@@ -31,12 +31,37 @@ class FullNodePrivateBlockOverlay : public td::actor::Actor {
   void process_broadcast(PublicKeyHash src, ton_api::tonNode_newBlockCandidateBroadcast &query);
   void process_broadcast(PublicKeyHash src, ton_api::tonNode_newBlockCandidateBroadcastCompressed &query);
   void process_block_candidate_broadcast(PublicKeyHash src, ton_api::tonNode_Broadcast &query);
+  void got_block_broadcast(PublicKeyHash src, BlockBroadcast broadcast, bool cells_missing);
+  void got_block_candidate_broadcast(PublicKeyHash src, BlockIdExt block_id, CatchainSeqno cc_seqno,
+                                     td::uint32 validator_set_hash, td::BufferSlice data, bool cells_missing);
+  void got_block_candidate(PublicKeyHash src, BlockIdExt block_id, CatchainSeqno cc_seqno,
+                           td::uint32 validator_set_hash, td::BufferSlice data);
 
   template <class T>
   void process_broadcast(PublicKeyHash, T &) {
     VLOG(FULL_NODE_WARNING) << "dropping unknown broadcast";
   }
   void receive_broadcast(PublicKeyHash src, td::BufferSlice query);
+  void receive_query(adnl::AdnlNodeIdShort src, td::BufferSlice query, td::Promise<td::BufferSlice> promise);
+
+  template <class T>
+  void process_query(adnl::AdnlNodeIdShort src, T &query, td::Promise<td::BufferSlice> promise) {
+    promise.set_error(td::Status::Error(ErrorCode::protoviolation, "unknown query"));
+  }
+  void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadBlockFull &query,
+                     td::Promise<td::BufferSlice> promise);
+  void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadBlockCandidate &query,
+                     td::Promise<td::BufferSlice> promise);
+
+  // Cell delta broadcasts (see full-node-serializer.hpp) are decoded in a separate actor, since loading cells from
+  // celldb may take a while. Those that cannot be decoded from the local celldb are downloaded in full from the
+  // sender, which keeps recently sent blocks and candidates for this
+  void download_block_broadcast(PublicKeyHash src, BlockBroadcast broadcast);
+  void download_block_candidate(PublicKeyHash src, BlockIdExt block_id, CatchainSeqno cc_seqno,
+                                td::uint32 validator_set_hash);
+  void set_cell_db_reader(std::shared_ptr<vm::CellDbReader> cell_db_reader) {
+    cell_db_reader_ = std::move(cell_db_reader);
+  }
 
   void send_shard_block_info(BlockIdExt block_id, CatchainSeqno cc_seqno, td::BufferSlice data);
   void send_block_candidate(BlockIdExt block_id, CatchainSeqno cc_seqno, td::uint32 validator_set_hash,
@@ -46,6 +71,9 @@ class FullNodePrivateBlockOverlay : public td::actor::Actor {
   void set_config(FullNodeConfig config) {
     config_ = std::move(config);
   }
+  void set_broadcast_cell_delta(bool value) {
+    broadcast_cell_delta_ = value;
+  }
 
   void start_up() override;
   void tear_down() override;
@@ -76,6 +104,32 @@ class FullNodePrivateBlockOverlay : public td::actor::Actor {
   FileHash zero_state_file_hash_;
   FullNodeConfig config_;
   bool enable_compression_ = true;
+  bool broadcast_cell_delta_ = false;
+  std::shared_ptr<vm::CellDbReader> cell_db_reader_;
+
+  struct SentBlock {
+    td::BufferSlice proof;
+    td::BufferSlice data;
+    td::Timestamp expire_at;
+  };
+  struct SentBlockCandidate {
+    td::BufferSlice data;
+    td::Timestamp expire_at;
+  };
+  // blocks and candidates sent with cell delta, for download_block_broadcast and download_block_candidate
+  // a candidate is not a block yet, so the two are kept apart and candidates are identified by the session too
+  std::map<BlockIdExt, SentBlock> sent_blocks_;
+  std::map<std::tuple<BlockIdExt, CatchainSeqno, td::uint32>, SentBlockCandidate> sent_candidates_;
+
+  static constexpr size_t max_sent_blocks() {
+    return 16;
+  }
+  static constexpr double sent_block_ttl() {
+    return 60.0;
+  }
+  void add_sent_block(BlockIdExt block_id, td::BufferSlice proof, td::BufferSlice data);
+  void add_sent_block_candidate(BlockIdExt block_id, CatchainSeqno cc_seqno, td::uint32 validator_set_hash,
+                                td::BufferSlice data);
 
   td::actor::ActorId<keyring::Keyring> keyring_;
   td::actor::ActorId<adnl::Adnl> adnl_;
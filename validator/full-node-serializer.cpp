@@ -21,12 +21,182 @@
 #include "tl-utils/tl-utils.hpp"
 #include "vm/boc.h"
 #include "td/utils/lz4.h"
+#include "vm/cells/CellSlice.h"
 #include "full-node.h"
 #include "td/utils/overloaded.h"
 
 namespace ton::validator::fullnode {
 
-td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broadcast, bool compression_enabled) {
+namespace {
+
+/*
+ * Cell-level delta encoding (broadcast_flag_cell_delta).
+ * Cells of the previous state of the shard - level 0 cells of the "from" side of the block's state update - are
+ * replaced with pruned branches of level cell_delta_level. Such a pruned branch keeps hashes and depths of all cells
+ * above it at levels 0..2, and blocks and proofs have merkle depth at most 2, so pruned branches of this level never
+ * appear in them otherwise. The receiver loads the replaced cells from its celldb.
+ */
+constexpr td::uint32 cell_delta_level = 3;
+
+class CellDeltaEncoder {
+ public:
+  explicit CellDeltaEncoder(const td::Ref<vm::Cell>& block_root) {
+    vm::CellSlice cs(vm::NoVm(), block_root);
+    if (cs.size_refs() < 3) {
+      return;
+    }
+    vm::CellSlice state_update(vm::NoVm(), cs.prefetch_ref(2));
+    if (state_update.special_type() != vm::Cell::SpecialType::MerkleUpdate) {
+      return;
+    }
+    std::set<vm::CellHash> visited;
+    collect_known(state_update.prefetch_ref(0), visited);
+  }
+
+  td::Ref<vm::Cell> encode(const td::Ref<vm::Cell>& cell) {
+    auto it = cells_.find(cell->get_hash());
+    if (it != cells_.end()) {
+      return it->second;
+    }
+    vm::CellSlice cs(vm::NoVm(), cell);
+    td::Ref<vm::Cell> res = cell;
+    if (cell->get_level() == 0 && known_.count(cell->get_hash()) && worth_replacing(cs)) {
+      res = vm::CellBuilder::do_create_pruned_branch(cell, cell_delta_level);
+      replaced_++;
+    } else if (cs.size_refs() > 0) {
+      std::vector<td::Ref<vm::Cell>> refs;
+      bool changed = false;
+      for (unsigned i = 0; i < cs.size_refs(); i++) {
+        refs.push_back(encode(cs.prefetch_ref(i)));
+        changed |= refs.back() != cs.prefetch_ref(i);
+      }
+      if (changed) {
+        vm::CellBuilder cb;
+        cb.store_bits(cs.fetch_bits(cs.size()));
+        for (auto& ref : refs) {
+          cb.store_ref(std::move(ref));
+        }
+        res = cb.finalize_novm(cs.is_special());
+      }
+    }
+    cells_.emplace(cell->get_hash(), res);
+    return res;
+  }
+
+  size_t replaced() const {
+    return replaced_;
+  }
+
+ private:
+  std::set<vm::CellHash> known_;
+  std::map<vm::CellHash, td::Ref<vm::Cell>> cells_;
+  size_t replaced_ = 0;
+
+  void collect_known(const td::Ref<vm::Cell>& cell, std::set<vm::CellHash>& visited) {
+    if (!visited.insert(cell->get_hash()).second) {
+      return;
+    }
+    if (cell->get_level() == 0) {
+      known_.insert(cell->get_hash());
+    }
+    vm::CellSlice cs(vm::NoVm(), cell);
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      collect_known(cs.prefetch_ref(i), visited);
+    }
+  }
+
+  // a pruned branch takes 38 bytes, small leaves are cheaper to send as is
+  static bool worth_replacing(const vm::CellSlice& cs) {
+    return cs.size_refs() > 0 || cs.size() > 38 * 8;
+  }
+};
+
+class CellDeltaDecoder {
+ public:
+  explicit CellDeltaDecoder(vm::CellDbReader& cell_db) : cell_db_(cell_db) {
+  }
+
+  // returns false if some cells are not in celldb
+  td::Result<bool> decode(std::vector<td::Ref<vm::Cell>>& roots, int max_decompressed_size) {
+    for (auto& root : roots) {
+      TRY_RESULT(res, decode(root));
+      if (res.is_null()) {
+        return false;
+      }
+      if (res->get_hash() != root->get_hash(0)) {
+        return td::Status::Error("hash mismatch after cell delta decoding");
+      }
+      root = std::move(res);
+    }
+    // replaced cells may refer to arbitrarily large subtrees
+    vm::CellStorageStat stat{static_cast<td::uint64>(max_decompressed_size)};
+    stat.limit_bits = static_cast<td::uint64>(max_decompressed_size) * 8;
+    for (auto& root : roots) {
+      TRY_STATUS(stat.add_used_storage(root).move_as_status());
+    }
+    return true;
+  }
+
+ private:
+  vm::CellDbReader& cell_db_;
+  std::map<vm::CellHash, td::Ref<vm::Cell>> cells_;
+
+  static bool is_replaced_cell(const td::Ref<vm::Cell>& cell, const vm::CellSlice& cs) {
+    return cs.special_type() == vm::Cell::SpecialType::PrunnedBranch &&
+           cell->get_level_mask() == vm::Cell::LevelMask::one_level(cell_delta_level);
+  }
+
+  // null if a cell is not in celldb
+  td::Result<td::Ref<vm::Cell>> decode(const td::Ref<vm::Cell>& cell) {
+    auto it = cells_.find(cell->get_hash());
+    if (it != cells_.end()) {
+      return it->second;
+    }
+    vm::CellSlice cs(vm::NoVm(), cell);
+    td::Ref<vm::Cell> res = cell;
+    if (is_replaced_cell(cell, cs)) {
+      auto hash = cell->get_hash(0);
+      auto R = cell_db_.load_cell(hash.as_slice());
+      if (R.is_error()) {
+        return td::Ref<vm::Cell>{};
+      }
+      res = R.move_as_ok();
+      if (res->get_hash() != hash) {
+        return td::Status::Error("celldb returned a cell with a different hash");
+      }
+    } else if (cs.size_refs() > 0) {
+      vm::CellBuilder cb;
+      cb.store_bits(cs.fetch_bits(cs.size()));
+      for (unsigned i = 0; i < cs.size_refs(); i++) {
+        TRY_RESULT(ref, decode(cs.prefetch_ref(i)));
+        if (ref.is_null()) {
+          return ref;
+        }
+        cb.store_ref(std::move(ref));
+      }
+      TRY_RESULT_ASSIGN(res, cb.finalize_novm_nothrow(cs.is_special()));
+    }
+    cells_.emplace(cell->get_hash(), res);
+    return res;
+  }
+};
+
+}  // namespace
+
+bool is_cell_delta_broadcast(const ton_api::tonNode_Broadcast& obj) {
+  switch (obj.get_id()) {
+    case ton_api::tonNode_blockBroadcastCompressed::ID:
+      return static_cast<const ton_api::tonNode_blockBroadcastCompressed&>(obj).flags_ & broadcast_flag_cell_delta;
+    case ton_api::tonNode_newBlockCandidateBroadcastCompressed::ID:
+      return static_cast<const ton_api::tonNode_newBlockCandidateBroadcastCompressed&>(obj).flags_ &
+             broadcast_flag_cell_delta;
+    default:
+      return false;
+  }
+}
+
+td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broadcast, bool compression_enabled,
+                                                      bool cell_delta) {
   std::vector<tl_object_ptr<ton_api::tonNode_blockSignature>> sigs;
   for (auto& sig : broadcast.signatures) {
     sigs.emplace_back(create_tl_object<ton_api::tonNode_blockSignature>(sig.node, sig.signature.clone()));
@@ -39,15 +209,24 @@ td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broa
 
   TRY_RESULT(proof_root, vm::std_boc_deserialize(broadcast.proof));
   TRY_RESULT(data_root, vm::std_boc_deserialize(broadcast.data));
+  td::int32 flags = 0;
+  if (cell_delta) {
+    CellDeltaEncoder encoder{data_root};
+    proof_root = encoder.encode(proof_root);
+    data_root = encoder.encode(data_root);
+    if (encoder.replaced() > 0) {
+      flags |= broadcast_flag_cell_delta;
+    }
+  }
   TRY_RESULT(boc, vm::std_boc_serialize_multi({proof_root, data_root}, 2));
   td::BufferSlice data =
       create_serialize_tl_object<ton_api::tonNode_blockBroadcastCompressed_data>(std::move(sigs), std::move(boc));
   td::BufferSlice compressed = td::lz4_compress(data);
-  VLOG(FULL_NODE_DEBUG) << "Compressing block broadcast: "
-                        << broadcast.data.size() + broadcast.proof.size() + broadcast.signatures.size() * 96 << " -> "
-                        << compressed.size();
+  VLOG(FULL_NODE_DEBUG) << "Compressing block broadcast" << (flags & broadcast_flag_cell_delta ? " (cell delta)" : "")
+                        << ": " << broadcast.data.size() + broadcast.proof.size() + broadcast.signatures.size() * 96
+                        << " -> " << compressed.size();
   return create_serialize_tl_object<ton_api::tonNode_blockBroadcastCompressed>(
-      create_tl_block_id(broadcast.block_id), broadcast.catchain_seqno, broadcast.validator_set_hash, 0,
+      create_tl_block_id(broadcast.block_id), broadcast.catchain_seqno, broadcast.validator_set_hash, flags,
       std::move(compressed));
 }
 
@@ -64,18 +243,47 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
                         std::move(f.proof_)};
 }
 
+// decodes roots of a cell delta broadcast in place, returns false if some cells are missing or there is no celldb
+static td::Result<bool> decode_cell_delta(std::vector<td::Ref<vm::Cell>>& roots, vm::CellDbReader* cell_db,
+                                          bool* cells_missing, int max_decompressed_size) {
+  bool complete = false;
+  if (cell_db != nullptr) {
+    TRY_RESULT_ASSIGN(complete, CellDeltaDecoder{*cell_db}.decode(roots, max_decompressed_size));
+  }
+  if (!complete) {
+    if (cells_missing == nullptr) {
+      return td::Status::Error(ErrorCode::notready, "cells of cell delta broadcast are not in celldb");
+    }
+    *cells_missing = true;
+  }
+  return complete;
+}
+
 static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_blockBroadcastCompressed& f,
-                                                              int max_decompressed_size) {
+                                                              int max_decompressed_size, vm::CellDbReader* cell_db,
+                                                              bool* cells_missing) {
   TRY_RESULT(decompressed, td::lz4_decompress(f.compressed_, max_decompressed_size));
   TRY_RESULT(f2, fetch_tl_object<ton_api::tonNode_blockBroadcastCompressed_data>(decompressed, true));
   std::vector<BlockSignature> signatures;
   for (auto& sig : f2->signatures_) {
     signatures.emplace_back(BlockSignature{sig->who_, std::move(sig->signature_)});
   }
-  TRY_RESULT(roots, vm::std_boc_deserialize_multi(f2->proof_data_, 2));
+  bool cell_delta = f.flags_ & broadcast_flag_cell_delta;
+  TRY_RESULT(roots, vm::std_boc_deserialize_multi(f2->proof_data_, 2, cell_delta));
   if (roots.size() != 2) {
     return td::Status::Error("expected 2 roots in boc");
   }
+  if (cell_delta) {
+    TRY_RESULT(complete, decode_cell_delta(roots, cell_db, cells_missing, max_decompressed_size));
+    if (!complete) {
+      return BlockBroadcast{create_block_id(f.id_),
+                            std::move(signatures),
+                            static_cast<UnixTime>(f.catchain_seqno_),
+                            static_cast<td::uint32>(f.validator_set_hash_),
+                            td::BufferSlice(),
+                            td::BufferSlice()};
+    }
+  }
   TRY_RESULT(proof, vm::std_boc_serialize(roots[0], 0));
   TRY_RESULT(data, vm::std_boc_serialize(roots[1], 31));
   VLOG(FULL_NODE_DEBUG) << "Decompressing block broadcast: " << f.compressed_.size() << " -> "
@@ -88,13 +296,14 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
                         std::move(proof)};
 }
 
-td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj,
-                                                       int max_decompressed_data_size) {
+td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size,
+                                                       vm::CellDbReader* cell_db, bool* cells_missing) {
   td::Result<BlockBroadcast> B;
   ton_api::downcast_call(obj,
                          td::overloaded([&](ton_api::tonNode_blockBroadcast& f) { B = deserialize_block_broadcast(f); },
                                         [&](ton_api::tonNode_blockBroadcastCompressed& f) {
-                                          B = deserialize_block_broadcast(f, max_decompressed_data_size);
+                                          B = deserialize_block_broadcast(f, max_decompressed_data_size, cell_db,
+                                                                          cells_missing);
                                         },
                                         [&](auto&) { B = td::Status::Error("unknown broadcast type"); }));
   return B;
@@ -154,19 +363,30 @@ td::Status deserialize_block_full(ton_api::tonNode_DataFull& obj, BlockIdExt& id
 
 td::Result<td::BufferSlice> serialize_block_candidate_broadcast(BlockIdExt block_id, CatchainSeqno cc_seqno,
                                                                 td::uint32 validator_set_hash, td::Slice data,
-                                                                bool compression_enabled) {
+                                                                bool compression_enabled, bool cell_delta) {
   if (!compression_enabled) {
     return create_serialize_tl_object<ton_api::tonNode_newBlockCandidateBroadcast>(
         create_tl_block_id(block_id), cc_seqno, validator_set_hash,
         create_tl_object<ton_api::tonNode_blockSignature>(Bits256::zero(), td::BufferSlice()), td::BufferSlice(data));
   }
   TRY_RESULT(root, vm::std_boc_deserialize(data));
+  td::int32 flags = 0;
+  if (cell_delta) {
+    CellDeltaEncoder encoder{root};
+    root = encoder.encode(root);
+    if (encoder.replaced() > 0) {
+      flags |= broadcast_flag_cell_delta;
+    }
+  }
   TRY_RESULT(data_new, vm::std_boc_serialize(root, 2));
   td::BufferSlice compressed = td::lz4_compress(data_new);
-  VLOG(FULL_NODE_DEBUG) << "Compressing block candidate broadcast: " << data.size() << " -> " << compressed.size();
+  VLOG(FULL_NODE_DEBUG) << "Compressing block candidate broadcast"
+                        << (flags & broadcast_flag_cell_delta ? " (cell delta)" : "") << ": " << data.size() << " -> "
+                        << compressed.size();
   return create_serialize_tl_object<ton_api::tonNode_newBlockCandidateBroadcastCompressed>(
       create_tl_block_id(block_id), cc_seqno, validator_set_hash,
-      create_tl_object<ton_api::tonNode_blockSignature>(Bits256::zero(), td::BufferSlice()), 0, std::move(compressed));
+      create_tl_object<ton_api::tonNode_blockSignature>(Bits256::zero(), td::BufferSlice()), flags,
+      std::move(compressed));
 }
 
 static td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_newBlockCandidateBroadcast& obj,
@@ -182,12 +402,23 @@ static td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_newBloc
 static td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_newBlockCandidateBroadcastCompressed& obj,
                                                         BlockIdExt& block_id, CatchainSeqno& cc_seqno,
                                                         td::uint32& validator_set_hash, td::BufferSlice& data,
-                                                        int max_decompressed_data_size) {
+                                                        int max_decompressed_data_size, vm::CellDbReader* cell_db,
+                                                        bool* cells_missing) {
   block_id = create_block_id(obj.id_);
   cc_seqno = obj.catchain_seqno_;
   validator_set_hash = obj.validator_set_hash_;
   TRY_RESULT(decompressed, td::lz4_decompress(obj.compressed_, max_decompressed_data_size));
-  TRY_RESULT(root, vm::std_boc_deserialize(decompressed));
+  bool cell_delta = obj.flags_ & broadcast_flag_cell_delta;
+  TRY_RESULT(root, vm::std_boc_deserialize(decompressed, false, cell_delta));
+  if (cell_delta) {
+    std::vector<td::Ref<vm::Cell>> roots{root};
+    TRY_RESULT(complete, decode_cell_delta(roots, cell_db, cells_missing, max_decompressed_data_size));
+    if (!complete) {
+      data = td::BufferSlice();
+      return td::Status::OK();
+    }
+    root = std::move(roots[0]);
+  }
   TRY_RESULT_ASSIGN(data, vm::std_boc_serialize(root, 31));
   VLOG(FULL_NODE_DEBUG) << "Decompressing block candidate broadcast: " << obj.compressed_.size() << " -> "
                         << data.size();
@@ -196,7 +427,8 @@ static td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_newBloc
 
 td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_Broadcast& obj, BlockIdExt& block_id,
                                                  CatchainSeqno& cc_seqno, td::uint32& validator_set_hash,
-                                                 td::BufferSlice& data, int max_decompressed_data_size) {
+                                                 td::BufferSlice& data, int max_decompressed_data_size,
+                                                 vm::CellDbReader* cell_db, bool* cells_missing) {
   td::Status S;
   ton_api::downcast_call(obj, td::overloaded(
                                   [&](ton_api::tonNode_newBlockCandidateBroadcast& f) {
@@ -205,7 +437,8 @@ td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_Broadcast& obj
                                   },
                                   [&](ton_api::tonNode_newBlockCandidateBroadcastCompressed& f) {
                                     S = deserialize_block_candidate_broadcast(f, block_id, cc_seqno, validator_set_hash,
-                                                                              data, max_decompressed_data_size);
+                                                                              data, max_decompressed_data_size, cell_db,
+                                                                              cells_missing);
                                   },
                                   [&](auto&) { S = td::Status::Error("unknown data type"); }));
   return S;
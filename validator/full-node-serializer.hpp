@@ -17,11 +17,26 @@
 #pragma once
 #include "ton/ton-types.h"
 #include "auto/tl/ton_api.h"
+#include "crypto/vm/db/DynamicBagOfCellsDb.h"
 
 namespace ton::validator::fullnode {
 
-td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broadcast, bool compression_enabled);
-td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size);
+// Flag in tonNode.blockBroadcastCompressed and tonNode.newBlockCandidateBroadcastCompressed: cells of the previous
+// state of the shard are replaced with their hashes, the receiver loads them from its celldb.
+// Nodes that do not know the flag cannot decode such broadcasts, so it is used only where enabled explicitly.
+constexpr td::int32 broadcast_flag_cell_delta = 1;
+
+bool is_cell_delta_broadcast(const ton_api::tonNode_Broadcast& obj);
+
+// cell_delta requires compression_enabled
+td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broadcast, bool compression_enabled,
+                                                      bool cell_delta = false);
+// cell_db is required to decode cell delta broadcasts. If some cells are not in celldb, or there is no celldb yet, then
+// either cells_missing is set and the broadcast is returned without proof and data (they should be downloaded from
+// the sender), or, if cells_missing is null, an error is returned.
+td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size,
+                                                       vm::CellDbReader* cell_db = nullptr,
+                                                       bool* cells_missing = nullptr);
 
 td::Result<td::BufferSlice> serialize_block_full(const BlockIdExt& id, td::Slice proof, td::Slice data,
                                                  bool is_proof_link, bool compression_enabled);
@@ -30,9 +45,11 @@ td::Status deserialize_block_full(ton_api::tonNode_DataFull& obj, BlockIdExt& id
 
 td::Result<td::BufferSlice> serialize_block_candidate_broadcast(BlockIdExt block_id, CatchainSeqno cc_seqno,
                                                                 td::uint32 validator_set_hash, td::Slice data,
-                                                                bool compression_enabled);
+                                                                bool compression_enabled, bool cell_delta = false);
+// see deserialize_block_broadcast, data is left empty if cells are missing
 td::Status deserialize_block_candidate_broadcast(ton_api::tonNode_Broadcast& obj, BlockIdExt& block_id,
                                                  CatchainSeqno& cc_seqno, td::uint32& validator_set_hash,
-                                                 td::BufferSlice& data, int max_decompressed_data_size);
+                                                 td::BufferSlice& data, int max_decompressed_data_size,
+                                                 vm::CellDbReader* cell_db = nullptr, bool* cells_missing = nullptr);
 
 }  // namespace ton::validator::fullnode
@@ -39,6 +39,7 @@
 #include "net/download-archive-slice.hpp"
 
 #include "td/utils/Random.h"
+#include "td/utils/port/Stat.h"
 
 #include "common/delay.h"
 
@@ -71,6 +72,10 @@ void Neighbour::update_roundtrip(double t) {
   roundtrip = (t + roundtrip) * 0.5;
 }
 
+void Neighbour::update_archive_speed(double speed) {
+  archive_speed = archive_speed == 0 ? speed : archive_speed * 0.7 + speed * 0.3;
+}
+
 void FullNodeShardImpl::create_overlay() {
   class Callback : public overlay::Overlays::Callback {
    public:
@@ -561,17 +566,30 @@ void FullNodeShardImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNod
   VLOG(FULL_NODE_DEBUG) << "Got query downloadPersistentState " << block_id.to_str() << " "
                         << masterchain_block_id.to_str() << " from " << src;
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_persistent_state_slice, block_id,
-                          masterchain_block_id, 0, max_size + 1, std::move(P));
+                          masterchain_block_id, 0, max_size + 1, false, std::move(P));
 }
 
 void FullNodeShardImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSlice &query,
                                       td::Promise<td::BufferSlice> promise) {
-  auto block_id = create_block_id(query.block_);
-  auto masterchain_block_id = create_block_id(query.masterchain_block_);
-  VLOG(FULL_NODE_DEBUG) << "Got query downloadPersistentStateSlice " << block_id.to_str() << " "
-                        << masterchain_block_id.to_str() << " " << query.offset_ << " " << query.max_size_ << " from "
-                        << src;
-  if (query.max_size_ < 0 || query.max_size_ > (1 << 24)) {
+  get_persistent_state_slice(src, create_block_id(query.block_), create_block_id(query.masterchain_block_),
+                             query.offset_, query.max_size_, false, std::move(promise));
+}
+
+void FullNodeShardImpl::process_query(adnl::AdnlNodeIdShort src,
+                                      ton_api::tonNode_downloadPersistentStateSliceStored &query,
+                                      td::Promise<td::BufferSlice> promise) {
+  get_persistent_state_slice(src, create_block_id(query.block_), create_block_id(query.masterchain_block_),
+                             query.offset_, query.max_size_, true, std::move(promise));
+}
+
+void FullNodeShardImpl::get_persistent_state_slice(adnl::AdnlNodeIdShort src, BlockIdExt block_id,
+                                                   BlockIdExt masterchain_block_id, td::int64 offset,
+                                                   td::int64 max_size, bool stored_format,
+                                                   td::Promise<td::BufferSlice> promise) {
+  VLOG(FULL_NODE_DEBUG) << "Got query downloadPersistentStateSlice" << (stored_format ? "Stored " : " ")
+                        << block_id.to_str() << " " << masterchain_block_id.to_str() << " " << offset << " "
+                        << max_size << " from " << src;
+  if (max_size < 0 || max_size > (1 << 24)) {
     promise.set_error(td::Status::Error(ErrorCode::protoviolation, "invalid max_size"));
     return;
   }
@@ -585,7 +603,7 @@ void FullNodeShardImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNod
         promise.set_value(R.move_as_ok());
       });
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_persistent_state_slice, block_id,
-                          masterchain_block_id, query.offset_, query.max_size_, std::move(P));
+                          masterchain_block_id, offset, max_size, stored_format, std::move(P));
 }
 
 void FullNodeShardImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getCapabilities &query,
@@ -865,13 +883,43 @@ void FullNodeShardImpl::get_next_key_blocks(BlockIdExt block_id, td::Timestamp t
 
 void FullNodeShardImpl::download_archive(BlockSeqno masterchain_seqno, std::string tmp_dir, td::Timestamp timeout,
                                          td::Promise<std::string> promise) {
-  auto &b = choose_neighbour();
+  auto &b = choose_archive_neighbour();
+  auto it = neighbours_.find(b.adnl_id);
+  if (it != neighbours_.end()) {
+    it->second.archive_downloads++;
+  }
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), id = b.adnl_id, ts = td::Time::now(),
+                                       promise = std::move(promise)](td::Result<std::string> R) mutable {
+    td::uint64 size = 0;
+    if (R.is_ok()) {
+      auto S = td::stat(R.ok());
+      if (S.is_ok()) {
+        size = S.ok().size_;
+      }
+    }
+    td::actor::send_closure(SelfId, &FullNodeShardImpl::finished_archive_download, id, td::Time::now() - ts, size);
+    promise.set_result(std::move(R));
+  });
   td::actor::create_actor<DownloadArchiveSlice>("archive", masterchain_seqno, std::move(tmp_dir), adnl_id_, overlay_id_,
                                                 b.adnl_id, timeout, validator_manager_, rldp2_, overlays_, adnl_,
-                                                client_, create_neighbour_promise(b, std::move(promise)))
+                                                client_,
+                                                create_neighbour_promise(b, td::Promise<std::string>(std::move(P))))
       .release();
 }
 
+void FullNodeShardImpl::finished_archive_download(adnl::AdnlNodeIdShort adnl_id, double t, td::uint64 size) {
+  auto it = neighbours_.find(adnl_id);
+  if (it == neighbours_.end()) {
+    return;
+  }
+  if (it->second.archive_downloads > 0) {
+    it->second.archive_downloads--;
+  }
+  if (size > 0 && t > 0) {
+    it->second.update_archive_speed(static_cast<double>(size) / t);
+  }
+}
+
 void FullNodeShardImpl::set_handle(BlockHandle handle, td::Promise<td::Unit> promise) {
   CHECK(!handle_);
   handle_ = std::move(handle);
@@ -1091,7 +1139,8 @@ const Neighbour &FullNodeShardImpl::choose_neighbour() const {
 
     if (x.second.proto_version < proto_version()) {
       unr += 4;
-    } else if (x.second.proto_version == proto_version() && x.second.capabilities < proto_capabilities()) {
+    } else if (x.second.proto_version == proto_version() &&
+               (x.second.capabilities & required_capabilities()) != required_capabilities()) {
       unr += 2;
     }
 
@@ -1108,6 +1157,41 @@ const Neighbour &FullNodeShardImpl::choose_neighbour() const {
   return best ? *best : Neighbour::zero;
 }
 
+const Neighbour &FullNodeShardImpl::choose_archive_neighbour() const {
+  // Archive slices are large, so peers are weighted by the throughput observed on previous slices.
+  // Peers without measurements get the average speed, so that they are tried too.
+  // A peer that is already sending us a slice is chosen only if no idle peer is available.
+  double speed_sum = 0;
+  size_t speed_cnt = 0;
+  for (auto &x : neighbours_) {
+    if (x.second.archive_speed > 0) {
+      speed_sum += x.second.archive_speed;
+      speed_cnt++;
+    }
+  }
+  double default_speed = speed_cnt > 0 ? speed_sum / static_cast<double>(speed_cnt) : 1.0;
+
+  for (bool allow_busy : {false, true}) {
+    const Neighbour *best = nullptr;
+    double sum = 0;
+    for (auto &x : neighbours_) {
+      if (x.second.unreliability > fail_unreliability() || (!allow_busy && x.second.archive_downloads > 0)) {
+        continue;
+      }
+      double w = x.second.archive_speed > 0 ? x.second.archive_speed : default_speed;
+      w /= 1 + x.second.archive_downloads;
+      sum += w;
+      if (td::Random::fast(0.0, sum) <= w) {
+        best = &x.second;
+      }
+    }
+    if (best) {
+      return *best;
+    }
+  }
+  return choose_neighbour();
+}
+
 void FullNodeShardImpl::update_neighbour_stats(adnl::AdnlNodeIdShort adnl_id, double t, bool success) {
   auto it = neighbours_.find(adnl_id);
   if (it != neighbours_.end()) {
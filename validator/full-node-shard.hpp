@@ -38,6 +38,8 @@ struct Neighbour {
   double roundtrip_relax_at = 0;
   double roundtrip_weight = 0;
   double unreliability = 0;
+  double archive_speed = 0;  // bytes per second, 0 if not measured yet
+  td::uint32 archive_downloads = 0;
 
   Neighbour(adnl::AdnlNodeIdShort adnl_id) : adnl_id(std::move(adnl_id)) {
   }
@@ -45,6 +47,7 @@ struct Neighbour {
   void query_success(double t);
   void query_failed();
   void update_roundtrip(double t);
+  void update_archive_speed(double speed);
 
   static Neighbour zero;
 };
@@ -68,6 +71,10 @@ class FullNodeShardImpl : public FullNodeShard {
     return 2;
   }
   static constexpr td::uint64 proto_capabilities() {
+    return 3 | FullNode::capability_persistent_state_stored();
+  }
+  // capabilities a neighbour of the same protocol version must have not to be deprioritized; the others are optional
+  static constexpr td::uint64 required_capabilities() {
     return 3;
   }
   static constexpr td::uint32 max_neighbours() {
@@ -132,6 +139,11 @@ class FullNodeShardImpl : public FullNodeShard {
                      td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSlice &query,
                      td::Promise<td::BufferSlice> promise);
+  void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_downloadPersistentStateSliceStored &query,
+                     td::Promise<td::BufferSlice> promise);
+  void get_persistent_state_slice(adnl::AdnlNodeIdShort src, BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                  td::int64 offset, td::int64 max_size, bool stored_format,
+                                  td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getCapabilities &query,
                      td::Promise<td::BufferSlice> promise);
   void process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getArchiveInfo &query,
@@ -199,6 +211,8 @@ class FullNodeShardImpl : public FullNodeShard {
   void update_neighbour_stats(adnl::AdnlNodeIdShort adnl_id, double t, bool success);
   void got_neighbour_capabilities(adnl::AdnlNodeIdShort adnl_id, double t, td::BufferSlice data);
   const Neighbour &choose_neighbour() const;
+  const Neighbour &choose_archive_neighbour() const;
+  void finished_archive_download(adnl::AdnlNodeIdShort adnl_id, double t, td::uint64 size);
 
   template <typename T>
   td::Promise<T> create_neighbour_promise(const Neighbour &x, td::Promise<T> p) {
@@ -139,6 +139,13 @@ void FullNodeImpl::set_config(FullNodeConfig config) {
   }
 }
 
+void FullNodeImpl::set_broadcast_cell_delta(bool value) {
+  broadcast_cell_delta_ = value;
+  for (auto& overlay : private_block_overlays_) {
+    td::actor::send_closure(overlay.second, &FullNodePrivateBlockOverlay::set_broadcast_cell_delta, value);
+  }
+}
+
 void FullNodeImpl::add_custom_overlay(CustomOverlayParams params, td::Promise<td::Unit> promise) {
   if (params.nodes_.empty()) {
     promise.set_error(td::Status::Error("list of nodes is empty"));
@@ -572,6 +579,10 @@ void FullNodeImpl::create_private_block_overlay(PublicKeyHash key) {
     private_block_overlays_[key] = td::actor::create_actor<FullNodePrivateBlockOverlay>(
         "BlocksPrivateOverlay", current_validators_[key], std::move(nodes), zero_state_file_hash_, config_, keyring_,
         adnl_, rldp_, rldp2_, overlays_, validator_manager_, actor_id(this));
+    if (broadcast_cell_delta_) {
+      td::actor::send_closure(private_block_overlays_[key], &FullNodePrivateBlockOverlay::set_broadcast_cell_delta,
+                              true);
+    }
   }
 }
 
@@ -82,6 +82,9 @@ class FullNode : public td::actor::Actor {
 
   virtual void update_adnl_id(adnl::AdnlNodeIdShort adnl_id, td::Promise<td::Unit> promise) = 0;
   virtual void set_config(FullNodeConfig config) = 0;
+  // send block broadcasts and candidates in validators' private overlays with cell delta encoding
+  // (see full-node-serializer.hpp); all validators should be able to decode it
+  virtual void set_broadcast_cell_delta(bool value) = 0;
 
   virtual void add_custom_overlay(CustomOverlayParams params, td::Promise<td::Unit> promise) = 0;
   virtual void del_custom_overlay(std::string name, td::Promise<td::Unit> promise) = 0;
@@ -99,6 +102,11 @@ class FullNode : public td::actor::Actor {
   static constexpr td::uint64 max_state_size() {
     return 4ull << 30;
   }
+  // Capability bit in tonNode.capabilities: the node answers downloadPersistentStateSliceStored with the state
+  // file as it is stored, which may be lz4 frames (vm/boc-frames.h) instead of a plain bag of cells
+  static constexpr td::uint64 capability_persistent_state_stored() {
+    return 4;
+  }
 
   static td::actor::ActorOwn<FullNode> create(ton::PublicKeyHash local_id, adnl::AdnlNodeIdShort adnl_id,
                                               FileHash zero_state_file_hash, FullNodeConfig config,
@@ -53,6 +53,7 @@ class FullNodeImpl : public FullNode {
 
   void update_adnl_id(adnl::AdnlNodeIdShort adnl_id, td::Promise<td::Unit> promise) override;
   void set_config(FullNodeConfig config) override;
+  void set_broadcast_cell_delta(bool value) override;
 
   void add_custom_overlay(CustomOverlayParams params, td::Promise<td::Unit> promise) override;
   void del_custom_overlay(std::string name, td::Promise<td::Unit> promise) override;
@@ -125,6 +126,7 @@ class FullNodeImpl : public FullNode {
 
   std::set<PublicKeyHash> local_keys_;
   FullNodeConfig config_;
+  bool broadcast_cell_delta_ = false;
 
   std::map<PublicKeyHash, td::actor::ActorOwn<FullNodePrivateBlockOverlay>> private_block_overlays_;
   bool broadcast_block_candidates_in_public_overlay_ = false;
@@ -228,6 +228,7 @@ class Collator final : public td::actor::Actor {
   std::unique_ptr<block::Account> make_account_from(td::ConstBitPtr addr, Ref<vm::CellSlice> account,
                                                     bool force_create);
   td::Result<block::Account*> make_account(td::ConstBitPtr addr, bool force_create = false);
+  bool prefetch_accounts();
   td::actor::ActorId<Collator> get_self() {
     return actor_id(this);
   }
@@ -322,6 +323,8 @@ class Collator final : public td::actor::Actor {
   bool register_out_msg_queue_op(bool force = false);
   bool update_min_mc_seqno(ton::BlockSeqno some_mc_seqno);
   bool combine_account_transactions();
+  bool update_shard_accounts(std::vector<std::pair<StdSmcAddress, Ref<vm::CellSlice>>> updates,
+                             std::vector<vm::Dictionary::SetMode> modes);
   bool update_public_libraries();
   bool update_account_public_libraries(Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs, const td::Bits256& addr);
   bool add_public_library(td::ConstBitPtr key, td::ConstBitPtr addr, Ref<vm::Cell> library);
@@ -1978,6 +1978,7 @@ bool Collator::fetch_config_params() {
     return fatal_error(res.move_as_error());
   }
   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config_->get_libraries_root(), 256);
+  action_phase_cfg_.storage_stat_cache = std::make_shared<vm::StorageStatCache>();
   defer_out_queue_size_limit_ = std::max<td::uint64>(collator_opts_->defer_out_queue_size_limit,
                                                      compute_phase_cfg_.size_limits.defer_out_queue_size_limit);
   // This one is checked in validate-query
@@ -2112,6 +2113,10 @@ bool Collator::do_collate() {
   if (!init_value_create()) {
     return fatal_error("cannot compute the value to be created / minted / recovered");
   }
+  // 1.5. load accounts that are known to receive messages in this block
+  if (!prefetch_accounts()) {
+    return fatal_error("cannot prefetch accounts");
+  }
   // 2-. take messages from dispatch queue
   LOG(INFO) << "process dispatch queue";
   if (!process_dispatch_queue()) {
@@ -2466,6 +2471,64 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
   return ins.first->second.get();
 }
 
+/**
+ * Loads the ShardAccounts entries of the accounts that are destinations of inbound external messages
+ * before processing starts.
+ * The previous states are walked without usage tracking, so accounts whose messages are never processed don't get
+ * into the state update proof. The addresses are visited in key order by one dictionary iterator, which reuses the
+ * common part of the path between consecutive keys, so every upper node of ShardAccounts is loaded once.
+ * The cells are shared with the usage-tracked state, and make_account() later finds them already loaded.
+ *
+ * @returns True if the operation is successful, false otherwise.
+ */
+bool Collator::prefetch_accounts() {
+  td::Timer timer;
+  std::vector<StdSmcAddress> addrs;
+  addrs.reserve(ext_msg_list_.size());
+  for (const auto& ext_msg_struct : ext_msg_list_) {
+    block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
+    WorkchainId wc;
+    StdSmcAddress addr;
+    if (tlb::unpack_cell_inexact(ext_msg_struct.cell, info) &&
+        block::tlb::t_MsgAddressInt.extract_std_address(info.dest, wc, addr) && wc == workchain() &&
+        ton::shard_contains(shard_.shard, addr)) {
+      addrs.push_back(addr);
+    }
+  }
+  std::sort(addrs.begin(), addrs.end());
+  addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+  if (addrs.empty()) {
+    return true;
+  }
+  size_t loaded = 0;
+  for (const auto& prev_state : prev_states) {
+    block::gen::ShardStateUnsplit::Record state;
+    if (prev_state.is_null() || !tlb::unpack_cell(prev_state->root_cell(), state)) {
+      continue;
+    }
+    vm::AugmentedDictionary dict{vm::load_cell_slice(state.accounts).prefetch_ref(), 256,
+                                 block::tlb::aug_ShardAccounts, false};
+    vm::DictIterator it{dict};
+    for (const auto& addr : addrs) {
+      if (!it.lookup(addr) || it.eof()) {
+        // no more keys in this dictionary
+        break;
+      }
+      if (!it.cur_pos().equals(addr.cbits(), 256)) {
+        continue;
+      }
+      auto value = it.cur_value();
+      if (value.not_null() && value->size_refs() > 0) {
+        vm::load_cell_slice(value->prefetch_ref());
+        ++loaded;
+      }
+    }
+  }
+  LOG(DEBUG) << "prefetched " << loaded << " accounts out of " << addrs.size() << " ext message destinations in "
+             << timer.elapsed() << "s";
+  return true;
+}
+
 /**
  * Combines account transactions and updates the ShardAccountBlocks and ShardAccounts.
  *
@@ -2473,6 +2536,8 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
  */
 bool Collator::combine_account_transactions() {
   vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccountBlocks};
+  std::vector<std::pair<StdSmcAddress, Ref<vm::CellSlice>>> account_updates;
+  std::vector<vm::Dictionary::SetMode> account_update_modes;
   for (auto& z : accounts) {
     block::Account& acc = *(z.second);
     CHECK(acc.addr == z.first);
@@ -2505,42 +2570,35 @@ bool Collator::combine_account_transactions() {
         return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
                            " could not be added to ShardAccountBlocks");
       }
-      // update account_dict
+      // collect the new value of ShardAccounts entry; all entries are written back at once below
       if (acc.total_state->get_hash() != acc.orig_total_state->get_hash()) {
         // account changed
-        if (acc.orig_status == block::Account::acc_nonexist) {
-          // account created
-          CHECK(acc.status != block::Account::acc_nonexist);
-          vm::CellBuilder cb;
-          if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
-                && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
-                && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Add))) {
-            return fatal_error(std::string{"cannot add newly-created account "} + acc.addr.to_hex() +
-                               " into ShardAccounts");
-          }
-        } else if (acc.status == block::Account::acc_nonexist) {
+        if (acc.status == block::Account::acc_nonexist) {
           // account deleted
+          CHECK(acc.orig_status != block::Account::acc_nonexist);
           if (verbosity > 2) {
             std::cerr << "deleting account " << acc.addr.to_hex() << " with empty new value ";
             block::gen::t_Account.print_ref(std::cerr, acc.total_state);
           }
-          if (account_dict->lookup_delete(acc.addr).is_null()) {
-            return fatal_error(std::string{"cannot delete account "} + acc.addr.to_hex() + " from ShardAccounts");
-          }
+          account_updates.emplace_back(acc.addr, Ref<vm::CellSlice>{});
+          account_update_modes.push_back(vm::Dictionary::SetMode::Replace);
         } else {
-          // existing account modified
+          // account created or existing account modified
           if (verbosity > 4) {
             std::cerr << "modifying account " << acc.addr.to_hex() << " to ";
             block::gen::t_Account.print_ref(std::cerr, acc.total_state);
           }
+          vm::CellBuilder cb;
           if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
                 && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
-                && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Replace))) {
-            return fatal_error(std::string{"cannot modify existing account "} + acc.addr.to_hex() +
-                               " in ShardAccounts");
+                && cb.store_long_bool(acc.last_trans_lt_, 64))) {  // last_trans_lt:uint64
+            return fatal_error(std::string{"cannot serialize new state of account "} + acc.addr.to_hex());
           }
+          account_updates.emplace_back(acc.addr, vm::load_cell_slice_ref(cb.finalize()));
+          // a newly-created account must not be in ShardAccounts yet, a modified one must be there
+          account_update_modes.push_back(acc.orig_status == block::Account::acc_nonexist
+                                             ? vm::Dictionary::SetMode::Add
+                                             : vm::Dictionary::SetMode::Replace);
         }
       }
     } else {
@@ -2550,6 +2608,9 @@ bool Collator::combine_account_transactions() {
       }
     }
   }
+  if (!update_shard_accounts(std::move(account_updates), std::move(account_update_modes))) {
+    return false;
+  }
   vm::CellBuilder cb;
   if (!(cb.append_cellslice_bool(std::move(dict).extract_root()) && cb.finalize_to(shard_account_blocks_))) {
     return fatal_error("cannot serialize ShardAccountBlocks");
@@ -2583,6 +2644,37 @@ bool Collator::combine_account_transactions() {
   return true;
 }
 
+/**
+ * Writes back modified accounts into ShardAccounts.
+ *
+ * @param updates New ShardAccount values sorted by address; null value means that the account is deleted.
+ * @param modes SetMode::Add for newly-created accounts, SetMode::Replace for modified and deleted ones.
+ *
+ * @returns True if the operation is successful, false otherwise.
+ */
+bool Collator::update_shard_accounts(std::vector<std::pair<StdSmcAddress, Ref<vm::CellSlice>>> updates,
+                                     std::vector<vm::Dictionary::SetMode> modes) {
+  // all modified paths of ShardAccounts are rebuilt in one pass, each fork node and its extra is recomputed once
+  if (account_dict->bulk_update(updates, modes)) {
+    return true;
+  }
+  // find the offending account to report the same error as a one-by-one update would
+  for (std::size_t i = 0; i < updates.size(); i++) {
+    const auto& addr = updates[i].first;
+    bool present = account_dict->lookup(addr).not_null();
+    if (updates[i].second.is_null()) {
+      if (!present) {
+        return fatal_error(std::string{"cannot delete account "} + addr.to_hex() + " from ShardAccounts");
+      }
+    } else if (modes[i] == vm::Dictionary::SetMode::Add && present) {
+      return fatal_error(std::string{"cannot add newly-created account "} + addr.to_hex() + " into ShardAccounts");
+    } else if (modes[i] == vm::Dictionary::SetMode::Replace && !present) {
+      return fatal_error(std::string{"cannot modify existing account "} + addr.to_hex() + " in ShardAccounts");
+    }
+  }
+  return fatal_error(PSTRING() << "cannot write back " << updates.size() << " modified accounts into ShardAccounts");
+}
+
 /**
  * Creates a special transaction to recover a specified amount of currency to a destination address.
  *
@@ -0,0 +1,167 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-checker.hpp"
+#include "fabric.h"
+
+namespace ton::validator {
+
+ExtMessageChecker::ExtMessageChecker(td::actor::ActorId<ValidatorManager> manager)
+    : fetch_account_state_([manager = std::move(manager)](WorkchainId wc, StdSmcAddress addr,
+                                                          td::Promise<ExtMessageQ::FetchedAccountState> promise) {
+      run_fetch_account_state(wc, addr, manager, std::move(promise));
+    }) {
+}
+
+void ExtMessageChecker::start_up() {
+  for (size_t i = 0; i < WORKERS; ++i) {
+    workers_.push_back(td::actor::create_actor<ExtMessageCheckWorker>(PSTRING() << "extmsgcheck" << i));
+  }
+  alarm_timestamp() = td::Timestamp::in(60.0);
+}
+
+void ExtMessageChecker::alarm() {
+  alarm_timestamp() = td::Timestamp::in(60.0);
+  if (stats_checked_ > 0 || stats_overloaded_ > 0) {
+    VLOG(VALIDATOR_INFO) << "Ext message checker stats: " << stats_checked_ << " checks, " << stats_cache_hits_
+                         << " account cache hits, " << stats_fetched_ << " account loads, " << stats_overloaded_
+                         << " rejected (overloaded); " << ready_accounts_ << " cached accounts, " << in_flight_
+                         << " checks in progress";
+    stats_checked_ = stats_cache_hits_ = stats_fetched_ = stats_overloaded_ = 0;
+  }
+}
+
+void ExtMessageChecker::check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise) {
+  if (in_flight_ >= MAX_IN_FLIGHT) {
+    ++stats_overloaded_;
+    promise.set_error(td::Status::Error(ErrorCode::notready, "too many external messages are being checked"));
+    return;
+  }
+  ++in_flight_;
+  ++stats_checked_;
+  promise = [SelfId = actor_id(this), promise = std::move(promise)](td::Result<td::Ref<ExtMessage>> R) mutable {
+    td::actor::send_closure(SelfId, &ExtMessageChecker::finished_check);
+    promise.set_result(std::move(R));
+  };
+
+  AccountKey key{mc_seqno_, message->wc(), message->addr()};
+  auto it = accounts_.find(key);
+  if (it != accounts_.end()) {
+    AccountEntry &entry = it->second;
+    if (entry.ready) {
+      ++stats_cache_hits_;
+      run_check(std::move(message), entry.state, std::move(promise));
+    } else {
+      entry.waiters.push_back(Waiter{std::move(message), std::move(promise)});
+    }
+    return;
+  }
+
+  AccountEntry &entry = accounts_[key];
+  entry.waiters.push_back(Waiter{std::move(message), std::move(promise)});
+  ++stats_fetched_;
+  fetch_account_state_(std::get<1>(key), std::get<2>(key),
+                       [SelfId = actor_id(this), key](td::Result<ExtMessageQ::FetchedAccountState> R) mutable {
+                         td::actor::send_closure(SelfId, &ExtMessageChecker::got_account_state, key, std::move(R));
+                       });
+}
+
+void ExtMessageChecker::got_account_state(AccountKey key, td::Result<ExtMessageQ::FetchedAccountState> R) {
+  auto it = accounts_.find(key);
+  CHECK(it != accounts_.end());
+  AccountEntry &entry = it->second;
+  CHECK(!entry.ready);
+  auto waiters = std::move(entry.waiters);
+  if (R.is_error()) {
+    accounts_.erase(it);
+    auto S = R.move_as_error_prefix("Failed to get account state: ");
+    for (auto &w : waiters) {
+      w.promise.set_error(S.clone());
+    }
+    return;
+  }
+  auto tuple = R.move_as_ok();
+  AccountState state;
+  state.shard_account = std::move(std::get<0>(tuple));
+  state.utime = std::get<1>(tuple);
+  state.lt = std::get<2>(tuple);
+  auto &config = std::get<3>(tuple);
+  state.mc_state_root = config->get_state_root();
+  state.mc_block_id = config->block_id;
+  for (auto &w : waiters) {
+    run_check(std::move(w.message), state, std::move(w.promise));
+  }
+  if (std::get<0>(key) != mc_seqno_ || state.mc_block_id.seqno() < mc_seqno_ ||
+      ready_accounts_ >= MAX_CACHED_ACCOUNTS) {
+    // state was requested before the last masterchain block, don't cache it
+    accounts_.erase(it);
+    return;
+  }
+  entry.ready = true;
+  entry.state = std::move(state);
+  ++ready_accounts_;
+}
+
+void ExtMessageChecker::run_check(td::Ref<ExtMessage> message, const AccountState &state,
+                                  td::Promise<td::Ref<ExtMessage>> promise) {
+  // Each worker unpacks its own copy of the account, so even messages to one hot contract run in parallel
+  auto &worker = workers_[next_worker_++ % workers_.size()];
+  td::actor::send_closure(worker, &ExtMessageCheckWorker::run, std::move(message), state, std::move(promise));
+}
+
+void ExtMessageChecker::finished_check() {
+  CHECK(in_flight_ > 0);
+  --in_flight_;
+}
+
+void ExtMessageChecker::new_masterchain_block(BlockSeqno seqno) {
+  if (seqno <= mc_seqno_) {
+    return;
+  }
+  mc_seqno_ = seqno;
+  // loads in progress stay until they finish: their waiters still need the result
+  for (auto it = accounts_.begin(); it != accounts_.end();) {
+    if (it->second.ready) {
+      it = accounts_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ready_accounts_ = 0;
+}
+
+void ExtMessageCheckWorker::run(td::Ref<ExtMessage> message, ExtMessageChecker::AccountState state,
+                                td::Promise<td::Ref<ExtMessage>> promise) {
+  if (!config_ || config_state_hash_ != state.mc_state_root->get_hash()) {
+    config_ = nullptr;
+    auto R = block::ConfigInfo::extract_config(state.mc_state_root, ExtMessageQ::config_mode);
+    if (R.is_error()) {
+      promise.set_error(R.move_as_error_prefix("Failed to extract config: "));
+      return;
+    }
+    config_ = R.move_as_ok();
+    config_->set_block_id_ext(state.mc_block_id);
+    config_state_hash_ = state.mc_state_root->get_hash();
+  }
+  auto status = ExtMessageQ::check_message_on_account(*message, state.shard_account, state.utime, state.lt, *config_);
+  if (status.is_ok()) {
+    promise.set_value(std::move(message));
+  } else {
+    promise.set_error(std::move(status));
+  }
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,107 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "ton/ton-types.h"
+#include "td/actor/actor.h"
+#include "interfaces/validator-manager.h"
+#include "block/mc-config.h"
+#include "external-message.hpp"
+
+#include <functional>
+#include <map>
+
+namespace ton::validator {
+
+class ExtMessageCheckWorker;
+
+/*
+ * Pre-validates inbound external messages (runs them until accept_message on the destination account).
+ * Account states are cached per masterchain block: concurrent checks of messages to the same account share
+ * one state load, and VM runs are spread over a pool of worker actors, so that independent accounts are
+ * checked in parallel on the scheduler's CPU threads.
+ * The number of checks in progress is bounded; messages above the limit are rejected right away.
+ */
+class ExtMessageChecker : public td::actor::Actor {
+ public:
+  using FetchAccountState = std::function<void(WorkchainId, StdSmcAddress,
+                                               td::Promise<ExtMessageQ::FetchedAccountState>)>;
+
+  explicit ExtMessageChecker(td::actor::ActorId<ValidatorManager> manager);
+  explicit ExtMessageChecker(FetchAccountState fetch_account_state)
+      : fetch_account_state_(std::move(fetch_account_state)) {
+  }
+
+  struct AccountState {
+    td::Ref<vm::CellSlice> shard_account;
+    UnixTime utime = 0;
+    LogicalTime lt = 0;
+    td::Ref<vm::Cell> mc_state_root;
+    BlockIdExt mc_block_id;
+  };
+
+  void start_up() override;
+  void alarm() override;
+
+  void check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise);
+  void new_masterchain_block(BlockSeqno seqno);
+
+ private:
+  FetchAccountState fetch_account_state_;
+
+  // states are loaded and cached per masterchain block: a load started before a new masterchain block
+  // is never joined by checks that come after it
+  using AccountKey = std::tuple<BlockSeqno, WorkchainId, StdSmcAddress>;
+  struct Waiter {
+    td::Ref<ExtMessage> message;
+    td::Promise<td::Ref<ExtMessage>> promise;
+  };
+  struct AccountEntry {
+    bool ready = false;
+    AccountState state;
+    std::vector<Waiter> waiters;
+  };
+  std::map<AccountKey, AccountEntry> accounts_;
+  size_t ready_accounts_ = 0;
+  BlockSeqno mc_seqno_ = 0;
+
+  std::vector<td::actor::ActorOwn<ExtMessageCheckWorker>> workers_;
+  size_t next_worker_ = 0;
+  size_t in_flight_ = 0;
+
+  size_t stats_checked_ = 0, stats_cache_hits_ = 0, stats_fetched_ = 0, stats_overloaded_ = 0;
+
+  void got_account_state(AccountKey key, td::Result<ExtMessageQ::FetchedAccountState> R);
+  void run_check(td::Ref<ExtMessage> message, const AccountState &state, td::Promise<td::Ref<ExtMessage>> promise);
+  void finished_check();
+
+  static constexpr size_t WORKERS = 16;
+  static constexpr size_t MAX_IN_FLIGHT = 4096;
+  static constexpr size_t MAX_CACHED_ACCOUNTS = 1 << 16;
+};
+
+class ExtMessageCheckWorker : public td::actor::Actor {
+ public:
+  void run(td::Ref<ExtMessage> message, ExtMessageChecker::AccountState state,
+           td::Promise<td::Ref<ExtMessage>> promise);
+
+ private:
+  // Config is extracted once per masterchain state and reused for all messages checked by this worker
+  std::unique_ptr<block::ConfigInfo> config_;
+  vm::CellHash config_state_hash_;
+};
+
+}  // namespace ton::validator
@@ -61,13 +61,29 @@ class ExtMessageQ : public ExtMessage {
               ton::StdSmcAddress addr);
   static td::Result<td::Ref<ExtMessageQ>> create_ext_message(td::BufferSlice data,
                                                              block::SizeLimitsConfig::ExtMsgLimits limits);
+  // parts of the masterchain configuration needed to run a message on an account
+  static constexpr int config_mode = block::ConfigInfo::needLibraries | block::ConfigInfo::needSpecialSmc |
+                                     block::ConfigInfo::needWorkchainInfo | block::ConfigInfo::needCapabilities |
+                                     block::ConfigInfo::needPrevBlocks;
+  using FetchedAccountState =
+      std::tuple<td::Ref<vm::CellSlice>, UnixTime, LogicalTime, std::unique_ptr<block::ConfigInfo>>;
+
   static void run_message(td::Ref<ExtMessage> message, td::actor::ActorId<ton::validator::ValidatorManager> manager,
                           td::Promise<td::Ref<ExtMessage>> promise);
+  static void run_message_on_fetched_state(td::Ref<ExtMessage> message, td::Result<FetchedAccountState> R,
+                                           td::Promise<td::Ref<ExtMessage>> promise);
+  static td::Status check_message_on_account(const ExtMessage &message, td::Ref<vm::CellSlice> shard_account,
+                                             UnixTime utime, LogicalTime lt, const block::ConfigInfo &config);
   static td::Status run_message_on_account(ton::WorkchainId wc,
                                            block::Account* acc,
                                            UnixTime utime, LogicalTime lt,
                                            td::Ref<vm::Cell> msg_root,
                                            std::unique_ptr<block::ConfigInfo> config);
+  static td::Status run_message_on_account(ton::WorkchainId wc,
+                                           block::Account* acc,
+                                           UnixTime utime, LogicalTime lt,
+                                           td::Ref<vm::Cell> msg_root,
+                                           const block::ConfigInfo& config);
 };
 
 }  // namespace validator
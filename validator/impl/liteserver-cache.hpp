@@ -17,63 +17,72 @@
 #pragma once
 
 #include "interfaces/liteserver.h"
+#include "auto/tl/lite_api.hpp"
+#include "ton/lite-tl.hpp"
+#include "tl-utils/lite-utils.hpp"
+#include "common/checksum.h"
 #include <map>
+#include <set>
 
 namespace ton::validator {
 
+// Key of the account state cache: the hash of getAccountState for the reference block, so that every reference block
+// has its own entry
+inline td::Bits256 account_state_cache_key(const BlockIdExt &blkid, WorkchainId workchain, const StdSmcAddress &addr) {
+  auto query = create_serialize_tl_object<lite_api::liteServer_getAccountState>(
+      create_tl_lite_block_id(blkid), create_tl_object<lite_api::liteServer_accountId>(workchain, addr));
+  return td::sha256_bits256(query);
+}
+
 class LiteServerCacheImpl : public LiteServerCache {
  public:
+  static constexpr size_t MAX_CACHE_SIZE = 64 << 20;
+  static constexpr size_t MAX_ACCOUNT_CACHE_SIZE = 64 << 20;
+
   void start_up() override {
     alarm();
   }
 
   void alarm() override {
     alarm_timestamp() = td::Timestamp::in(60.0);
-    if (queries_cnt_ > 0 || !send_message_cache_.empty()) {
-      LOG(WARNING) << "LS Cache stats: " << queries_cnt_ << " queries, " << queries_hit_cnt_ << " hits; "
-                   << cache_.size() << " entries, size=" << total_size_ << "/" << MAX_CACHE_SIZE << ";   "
-                   << send_message_cache_.size() << " different sendMessage queries, " << send_message_error_cnt_
-                   << " duplicates";
-      queries_cnt_ = 0;
-      queries_hit_cnt_ = 0;
+    if (results_.queries_cnt > 0 || accounts_.queries_cnt > 0 || !send_message_cache_.empty()) {
+      LOG(WARNING) << "LS Cache stats: " << results_.queries_cnt << " queries, " << results_.queries_hit_cnt
+                   << " hits; " << results_.size() << " entries, size=" << results_.total_size << "/"
+                   << MAX_CACHE_SIZE << ";   " << accounts_.queries_cnt << " account state queries, "
+                   << accounts_.queries_hit_cnt << " hits; " << accounts_.size() << " entries, size="
+                   << accounts_.total_size << "/" << MAX_ACCOUNT_CACHE_SIZE << ";   " << send_message_cache_.size()
+                   << " different sendMessage queries, " << send_message_error_cnt_ << " duplicates";
+      results_.reset_stats();
+      accounts_.reset_stats();
       send_message_cache_.clear();
       send_message_error_cnt_ = 0;
     }
   }
 
   void lookup(td::Bits256 key, td::Promise<td::BufferSlice> promise) override {
-    ++queries_cnt_;
-    auto it = cache_.find(key);
-    if (it == cache_.end()) {
+    auto value = results_.lookup(key);
+    if (value == nullptr) {
       promise.set_error(td::Status::Error("not found"));
       return;
     }
-    ++queries_hit_cnt_;
-    auto entry = it->second.get();
-    entry->remove();
-    lru_.put(entry);
-    promise.set_value(entry->value_.clone());
+    promise.set_value(value->clone());
   }
 
   void update(td::Bits256 key, td::BufferSlice value) override {
-    std::unique_ptr<CacheEntry> &entry = cache_[key];
-    if (entry == nullptr) {
-      entry = std::make_unique<CacheEntry>(key, std::move(value));
-    } else {
-      total_size_ -= entry->size();
-      entry->value_ = std::move(value);
-      entry->remove();
-    }
-    lru_.put(entry.get());
-    total_size_ += entry->size();
-
-    while (total_size_ > MAX_CACHE_SIZE) {
-      auto to_remove = (CacheEntry *)lru_.get();
-      CHECK(to_remove);
-      total_size_ -= to_remove->size();
-      to_remove->remove();
-      cache_.erase(to_remove->key_);
+    results_.update(key, std::move(value));
+  }
+
+  void lookup_account_state(td::Bits256 key, td::Promise<LiteServerAccountState> promise) override {
+    auto value = accounts_.lookup(key);
+    if (value == nullptr) {
+      promise.set_error(td::Status::Error("not found"));
+      return;
     }
+    promise.set_value(value->clone());
+  }
+
+  void update_account_state(td::Bits256 key, LiteServerAccountState value) override {
+    accounts_.update(key, std::move(value));
   }
 
   void process_send_message(td::Bits256 key, td::Promise<td::Unit> promise) override {
@@ -90,27 +99,77 @@ class LiteServerCacheImpl : public LiteServerCache {
   }
 
  private:
-  struct CacheEntry : public td::ListNode {
-    explicit CacheEntry(td::Bits256 key, td::BufferSlice value) : key_(key), value_(std::move(value)) {
-    }
-    td::Bits256 key_;
-    td::BufferSlice value_;
+  template <class ValueT, size_t max_size>
+  struct Lru {
+    struct CacheEntry : public td::ListNode {
+      explicit CacheEntry(td::Bits256 key, ValueT value) : key_(key), value_(std::move(value)) {
+      }
+      td::Bits256 key_;
+      ValueT value_;
+
+      size_t size() const {
+        return value_.size() + 32 * 2;
+      }
+    };
+
+    std::map<td::Bits256, std::unique_ptr<CacheEntry>> cache;
+    td::ListNode lru;
+    size_t total_size = 0;
+    size_t queries_cnt = 0, queries_hit_cnt = 0;
 
     size_t size() const {
-      return value_.size() + 32 * 2;
+      return cache.size();
     }
-  };
 
-  std::map<td::Bits256, std::unique_ptr<CacheEntry>> cache_;
-  td::ListNode lru_;
-  size_t total_size_ = 0;
+    void reset_stats() {
+      queries_cnt = 0;
+      queries_hit_cnt = 0;
+    }
 
-  size_t queries_cnt_ = 0, queries_hit_cnt_ = 0;
+    const ValueT *lookup(const td::Bits256 &key) {
+      ++queries_cnt;
+      auto it = cache.find(key);
+      if (it == cache.end()) {
+        return nullptr;
+      }
+      ++queries_hit_cnt;
+      auto entry = it->second.get();
+      entry->remove();
+      lru.put(entry);
+      return &entry->value_;
+    }
+
+    void update(const td::Bits256 &key, ValueT value) {
+      if (value.size() + 32 * 2 > max_size) {
+        // would evict everything else and still not fit
+        return;
+      }
+      std::unique_ptr<CacheEntry> &entry = cache[key];
+      if (entry == nullptr) {
+        entry = std::make_unique<CacheEntry>(key, std::move(value));
+      } else {
+        total_size -= entry->size();
+        entry->value_ = std::move(value);
+        entry->remove();
+      }
+      lru.put(entry.get());
+      total_size += entry->size();
+
+      while (total_size > max_size) {
+        auto to_remove = (CacheEntry *)lru.get();
+        CHECK(to_remove);
+        total_size -= to_remove->size();
+        to_remove->remove();
+        cache.erase(to_remove->key_);
+      }
+    }
+  };
+
+  Lru<td::BufferSlice, MAX_CACHE_SIZE> results_;
+  Lru<LiteServerAccountState, MAX_ACCOUNT_CACHE_SIZE> accounts_;
 
   std::set<td::Bits256> send_message_cache_;
   size_t send_message_error_cnt_ = 0;
-
-  static constexpr size_t MAX_CACHE_SIZE = 64 << 20;
 };
 
 }  // namespace ton::validator
@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "liteserver.hpp"
+#include "liteserver-cache.hpp"
 #include "td/utils/Slice.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
@@ -810,13 +811,8 @@ void LiteQuery::perform_getAccountState(BlockIdExt blkid, WorkchainId workchain,
   acc_workchain_ = workchain;
   acc_addr_ = addr;
   mode_ = mode;
-  if (blkid.id.workchain != masterchainId) {
-    base_blk_id_ = blkid;
-    set_continuation([&]() -> void { finish_getAccountState({}); });
-    request_block_data_state(blkid);
-  } else if (blkid.id.seqno != ~0U) {
-    set_continuation([&]() -> void { continue_getAccountState(); });
-    request_mc_block_data_state(blkid);
+  if (blkid.id.workchain != masterchainId || blkid.id.seqno != ~0U) {
+    lookup_cached_account_state(blkid);
   } else {
     LOG(INFO) << "sending a get_last_liteserver_state_block query to manager";
     td::actor::send_closure_later(
@@ -839,8 +835,39 @@ void LiteQuery::continue_getAccountState_0(Ref<ton::validator::MasterchainState>
   CHECK(mc_state.not_null());
   mc_state_ = Ref<MasterchainStateQ>(std::move(mc_state));
   CHECK(mc_state_.not_null());
-  set_continuation([&]() -> void { continue_getAccountState(); });
-  request_mc_block_data(blkid);
+  lookup_cached_account_state(blkid);
+}
+
+void LiteQuery::lookup_cached_account_state(BlockIdExt blkid) {
+  if (cache_.empty() || (mode_ & 0x80000000)) {
+    load_account_state(blkid);
+    return;
+  }
+  use_account_cache_ = true;
+  account_cache_key_ = account_state_cache_key(blkid, acc_workchain_, acc_addr_);
+  td::actor::send_closure(cache_, &LiteServerCache::lookup_account_state, account_cache_key_,
+                          [SelfId = actor_id(this), blkid](td::Result<LiteServerAccountState> R) {
+                            if (R.is_error()) {
+                              td::actor::send_closure(SelfId, &LiteQuery::load_account_state, blkid);
+                            } else {
+                              td::actor::send_closure(SelfId, &LiteQuery::finish_getAccountState_cached,
+                                                      R.move_as_ok());
+                            }
+                          });
+}
+
+void LiteQuery::load_account_state(BlockIdExt blkid) {
+  if (blkid.id.workchain != masterchainId) {
+    base_blk_id_ = blkid;
+    set_continuation([&]() -> void { finish_getAccountState({}); });
+    request_block_data_state(blkid);
+  } else if (mc_state_.not_null() && mc_state_->get_block_id() == blkid) {
+    set_continuation([&]() -> void { continue_getAccountState(); });
+    request_mc_block_data(blkid);
+  } else {
+    set_continuation([&]() -> void { continue_getAccountState(); });
+    request_mc_block_data_state(blkid);
+  }
 }
 
 void LiteQuery::perform_fetchAccountState() {
@@ -1303,6 +1330,21 @@ void LiteQuery::continue_getAccountState() {
   }
 }
 
+// Size of the account for the account state cache, from the storage stat of the account.
+// Each cell is charged for its data and for its hashes and references.
+static td::uint64 account_cache_size(const Ref<vm::Cell>& account) {
+  block::gen::Account::Record_account acc;
+  block::gen::StorageInfo::Record info;
+  block::gen::StorageUsed::Record used;
+  if (account.is_null() || !tlb::unpack_cell(account, acc) || !tlb::csr_unpack(acc.storage_stat, info) ||
+      !tlb::csr_unpack(info.used, used)) {
+    return 0;
+  }
+  td::uint64 cells = block::tlb::t_VarUInteger_7.as_uint(*used.cells);
+  td::uint64 bits = block::tlb::t_VarUInteger_7.as_uint(*used.bits);
+  return bits / 8 + cells * 64;
+}
+
 void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   LOG(INFO) << "completing getAccountState() query";
   Ref<vm::Cell> proof1, proof2;
@@ -1345,27 +1387,73 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
     fatal_error(proof.move_as_error());
     return;
   }
-  if (mode_ & 0x10000) {
-    if (!mc_state_.is_null()) {
-      finish_runSmcMethod(std::move(shard_proof), proof.move_as_ok(), std::move(acc_root), sstate.gen_utime,
-                          sstate.gen_lt);
-      return;
+  td::optional<BlockIdExt> master_ref;
+  if (mc_state_.not_null()) {
+    master_ref = mc_state_->get_block_id();
+  } else {
+    master_ref = state_->get_master_ref();
+  }
+  if (use_account_cache_ && master_ref) {
+    // cache the account itself, not its usage-tracking wrapper from pb
+    Ref<vm::Cell> account;
+    block::gen::ShardStateUnsplit::Record raw_sstate;
+    if (acc_root.not_null() && tlb::unpack_cell(state_->root_cell(), raw_sstate)) {
+      auto account_csr =
+          vm::AugmentedDictionary{vm::load_cell_slice_ref(raw_sstate.accounts), 256, block::tlb::aug_ShardAccounts}
+              .lookup(acc_addr_);
+      if (account_csr.not_null()) {
+        account = account_csr->prefetch_ref();
+      }
     }
-    shard_proof_ = std::move(shard_proof);
-    proof_ = proof.move_as_ok();
-    set_continuation(
-        [&, base_blk_id = base_blk_id_, acc_root, utime = sstate.gen_utime, lt = sstate.gen_lt]() mutable -> void {
-          base_blk_id_ = base_blk_id;  // It gets overridden by request_mc_block_data_state
-          finish_runSmcMethod(std::move(shard_proof_), std::move(proof_), std::move(acc_root), utime, lt);
-        });
-    td::optional<BlockIdExt> master_ref = state_->get_master_ref();
+    if (acc_root.is_null() || account.not_null()) {
+      auto account_size = account_cache_size(account);
+      td::actor::send_closure(cache_, &LiteServerCache::update_account_state, account_cache_key_,
+                              LiteServerAccountState{base_blk_id_, blk_id_, master_ref.value(), sstate.gen_utime,
+                                                     sstate.gen_lt, shard_proof.clone(), proof.ok().clone(),
+                                                     std::move(account), account_size});
+    }
+  }
+  if (mode_ & 0x10000) {
     if (!master_ref) {
       fatal_error("masterchain ref block is not available");
       return;
     }
-    request_mc_block_data_state(master_ref.value());
+    finish_getAccountState_runSmcMethod(std::move(shard_proof), proof.move_as_ok(), std::move(acc_root),
+                                        sstate.gen_utime, sstate.gen_lt, master_ref.value());
     return;
   }
+  finish_getAccountState_2(std::move(shard_proof), proof.move_as_ok(), std::move(acc_root));
+}
+
+void LiteQuery::finish_getAccountState_cached(LiteServerAccountState entry) {
+  LOG(INFO) << "completing getAccountState() query using cached account state";
+  base_blk_id_ = entry.base_blk_id;
+  blk_id_ = entry.blk_id;
+  if (mode_ & 0x10000) {
+    finish_getAccountState_runSmcMethod(std::move(entry.shard_proof), std::move(entry.state_proof),
+                                        std::move(entry.account), entry.gen_utime, entry.gen_lt, entry.master_ref);
+    return;
+  }
+  finish_getAccountState_2(std::move(entry.shard_proof), std::move(entry.state_proof), std::move(entry.account));
+}
+
+void LiteQuery::finish_getAccountState_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof,
+                                                    Ref<vm::Cell> acc_root, UnixTime gen_utime, LogicalTime gen_lt,
+                                                    BlockIdExt master_ref) {
+  if (mc_state_.not_null() && mc_state_->get_block_id() == master_ref) {
+    finish_runSmcMethod(std::move(shard_proof), std::move(state_proof), std::move(acc_root), gen_utime, gen_lt);
+    return;
+  }
+  shard_proof_ = std::move(shard_proof);
+  proof_ = std::move(state_proof);
+  set_continuation([&, base_blk_id = base_blk_id_, acc_root, utime = gen_utime, lt = gen_lt]() mutable -> void {
+    base_blk_id_ = base_blk_id;  // It gets overridden by request_mc_block_state
+    finish_runSmcMethod(std::move(shard_proof_), std::move(proof_), std::move(acc_root), utime, lt);
+  });
+  request_mc_block_state(master_ref);
+}
+
+void LiteQuery::finish_getAccountState_2(td::BufferSlice shard_proof, td::BufferSlice proof, Ref<vm::Cell> acc_root) {
   td::BufferSlice data;
   if (acc_root.not_null()) {
     if (mode_ & 0x40000000) {
@@ -1394,7 +1482,7 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   LOG(INFO) << "getAccountState(" << acc_workchain_ << ":" << acc_addr_.to_hex() << ") query completed";
   auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountState>(
       ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blk_id_), std::move(shard_proof),
-      proof.move_as_ok(), std::move(data));
+      std::move(proof), std::move(data));
   finish_query(std::move(b));
 }
 
@@ -2096,7 +2184,8 @@ void LiteQuery::continue_lookupBlockWithProof_getHeaderProof(Ref<ton::validator:
     return;
   }
 
-  vm::MerkleProofBuilder mpb{block_root};
+  vm::PreciseMerkleProofBuilder mpb{block_root};
+  auto tracking = mpb.track();
   std::vector<BlockIdExt> prev;
   BlockIdExt mc_blkid;
   bool after_split;
@@ -2147,7 +2236,8 @@ void LiteQuery::continue_lookupBlockWithProof_gotPrevBlockData(Ref<BlockData> pr
       fatal_error("block has no valid root cell");
       return;
     }
-    vm::MerkleProofBuilder mpb{prev_block->root_cell()};
+    vm::PreciseMerkleProofBuilder mpb{prev_block->root_cell()};
+    auto tracking = mpb.track();
     block::gen::Block::Record blk;
     block::gen::BlockInfo::Record info;
     if (!(tlb::unpack_cell(mpb.root(), blk) && tlb::unpack_cell(blk.info, info))) {
@@ -2189,7 +2279,8 @@ void LiteQuery::continue_lookupBlockWithProof_buildProofLinks(td::Ref<BlockData>
                                         std::vector<std::pair<BlockIdExt, td::Ref<vm::Cell>>> result) {
   BlockIdExt cur_id = cur_block->block_id();
   BlockIdExt prev_id;
-  vm::MerkleProofBuilder mpb{cur_block->root_cell()};
+  vm::PreciseMerkleProofBuilder mpb{cur_block->root_cell()};
+  auto tracking = mpb.track();
   if (cur_id.is_masterchain()) {
     base_blk_id_alt_ = cur_id;
     block::gen::Block::Record blk;
@@ -2845,7 +2936,8 @@ bool LiteQuery::adjust_last_proof_link(ton::BlockIdExt cur, Ref<vm::Cell> block_
   if (cur.root_hash != block_root->get_hash().bits()) {
     return fatal_error("root hash mismatch in block root of "s + cur.to_str());
   }
-  vm::MerkleProofBuilder mpb{std::move(block_root)};
+  vm::PreciseMerkleProofBuilder mpb{std::move(block_root)};
+  auto tracking = mpb.track();
   block::gen::Block::Record blk;
   block::gen::BlockInfo::Record info;
   if (!(tlb::unpack_cell(mpb.root(), blk) && tlb::unpack_cell(blk.info, info))) {
@@ -3239,7 +3331,8 @@ void LiteQuery::continue_getShardBlockProof(Ref<BlockData> cur_block,
                                             std::vector<std::pair<BlockIdExt, td::BufferSlice>> result) {
   BlockIdExt cur_id = cur_block->block_id();
   BlockIdExt prev_id;
-  vm::MerkleProofBuilder mpb{cur_block->root_cell()};
+  vm::PreciseMerkleProofBuilder mpb{cur_block->root_cell()};
+  auto tracking = mpb.track();
   if (cur_id.is_masterchain()) {
     base_blk_id_ = cur_id;
     block::gen::Block::Record blk;
@@ -46,6 +46,8 @@ class LiteQuery : public td::actor::Actor {
   tl_object_ptr<ton::lite_api::Function> query_obj_;
   bool use_cache_{false};
   td::Bits256 cache_key_;
+  bool use_account_cache_{false};
+  td::Bits256 account_cache_key_;
 
   int pending_{0};
   int mode_{0};
@@ -120,6 +122,13 @@ class LiteQuery : public td::actor::Actor {
   void continue_getAccountState_0(Ref<MasterchainState> mc_state, BlockIdExt blkid);
   void continue_getAccountState();
   void finish_getAccountState(td::BufferSlice shard_proof);
+  void finish_getAccountState_cached(LiteServerAccountState entry);
+  void finish_getAccountState_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof,
+                                           Ref<vm::Cell> acc_root, UnixTime gen_utime, LogicalTime gen_lt,
+                                           BlockIdExt master_ref);
+  void finish_getAccountState_2(td::BufferSlice shard_proof, td::BufferSlice proof, Ref<vm::Cell> acc_root);
+  void lookup_cached_account_state(BlockIdExt blkid);
+  void load_account_state(BlockIdExt blkid);
   void perform_fetchAccountState();
   void perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, int mode, td::int64 method_id,
                             td::BufferSlice params);
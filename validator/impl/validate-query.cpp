@@ -1001,6 +1001,7 @@ bool ValidateQuery::fetch_config_params() {
     action_phase_cfg_.message_skip_enabled = config_->get_global_version() >= 8;
     action_phase_cfg_.disable_custom_fess = config_->get_global_version() >= 8;
     action_phase_cfg_.mc_blackhole_addr = config_->get_burning_config().blackhole_addr;
+    action_phase_cfg_.storage_stat_cache = std::make_shared<vm::StorageStatCache>();
   }
   {
     // fetch block_grams_created
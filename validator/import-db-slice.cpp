@@ -25,6 +25,8 @@
 #include "td/utils/port/path.h"
 #include "ton/ton-io.hpp"
 #include "downloaders/download-state.hpp"
+#include "block/block.h"
+#include "ton/ton-shard.h"
 
 namespace ton {
 
@@ -219,66 +221,174 @@ void ArchiveImporter::got_new_materchain_state(td::Ref<MasterchainState> state)
 }
 
 void ArchiveImporter::checked_all_masterchain_blocks(BlockSeqno seqno) {
-  check_next_shard_client_seqno(shard_client_seqno_ + 1);
+  if (shard_client_seqno_ >= state_->get_seqno()) {
+    finish_query();
+    return;
+  }
+  shard_client_expanded_seqno_ = shard_client_seqno_;
+  if (shard_client_seqno_ == 0) {
+    expand_next_masterchain_block();
+    return;
+  }
+  // shard blocks referenced by this masterchain block are applied already, don't walk past them
+  load_masterchain_state(shard_client_seqno_, [SelfId = actor_id(this)](td::Result<td::Ref<MasterchainState>> R) {
+    R.ensure();
+    td::actor::send_closure(SelfId, &ArchiveImporter::got_base_masterchain_state, R.move_as_ok());
+  });
 }
 
-void ArchiveImporter::check_next_shard_client_seqno(BlockSeqno seqno) {
-  if (seqno > state_->get_seqno()) {
-    finish_query();
-  } else if (seqno == state_->get_seqno()) {
-    got_masterchain_state(state_);
-  } else {
-    BlockIdExt b;
-    bool f = state_->get_old_mc_block_id(seqno, b);
-    CHECK(f);
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<ShardState>> R) {
-      R.ensure();
-      td::actor::send_closure(SelfId, &ArchiveImporter::got_masterchain_state,
-                              td::Ref<MasterchainState>{R.move_as_ok()});
-    });
-    td::actor::send_closure(manager_, &ValidatorManager::get_shard_state_from_db_short, b, std::move(P));
+void ArchiveImporter::load_masterchain_state(BlockSeqno seqno, td::Promise<td::Ref<MasterchainState>> promise) {
+  if (seqno == state_->get_seqno()) {
+    promise.set_value(td::Ref<MasterchainState>{state_});
+    return;
+  }
+  BlockIdExt b;
+  bool f = state_->get_old_mc_block_id(seqno, b);
+  CHECK(f);
+  td::actor::send_closure(manager_, &ValidatorManager::get_shard_state_from_db_short, b,
+                          [promise = std::move(promise)](td::Result<td::Ref<ShardState>> R) mutable {
+                            TRY_RESULT_PROMISE(promise, state, std::move(R));
+                            promise.set_value(td::Ref<MasterchainState>{std::move(state)});
+                          });
+}
+
+void ArchiveImporter::got_base_masterchain_state(td::Ref<MasterchainState> state) {
+  for (auto &shard : state->get_shards()) {
+    base_top_blocks_.push_back(shard->top_block_id());
   }
+  expand_next_masterchain_block();
+}
+
+void ArchiveImporter::expand_next_masterchain_block() {
+  if (loading_masterchain_state_ || shard_client_expanded_seqno_ >= state_->get_seqno()) {
+    return;
+  }
+  // look ahead while there is not enough work for the workers
+  if (shard_client_expanded_seqno_ > shard_client_seqno_ && shard_blocks_.unapplied() >= 4 * apply_parallelism()) {
+    return;
+  }
+  loading_masterchain_state_ = true;
+  load_masterchain_state(shard_client_expanded_seqno_ + 1,
+                         [SelfId = actor_id(this)](td::Result<td::Ref<MasterchainState>> R) {
+                           R.ensure();
+                           td::actor::send_closure(SelfId, &ArchiveImporter::got_masterchain_state, R.move_as_ok());
+                         });
 }
 
 void ArchiveImporter::got_masterchain_state(td::Ref<MasterchainState> state) {
-  auto s = state->get_shards();
+  loading_masterchain_state_ = false;
+  auto seqno = state->get_seqno();
+  CHECK(seqno == shard_client_expanded_seqno_ + 1);
+  shard_client_expanded_seqno_ = seqno;
+
+  for (auto &shard : state->get_shards()) {
+    auto S = add_shard_block(shard->top_block_id(), state->get_block_id());
+    if (S.is_error()) {
+      abort_query(std::move(S));
+      return;
+    }
+  }
+  run_shard_blocks();
+  if (!advance_shard_client_seqno()) {
+    expand_next_masterchain_block();
+  }
+}
 
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), seqno = state->get_seqno()](td::Result<td::Unit> R) {
-    if (R.is_error()) {
-      td::actor::send_closure(SelfId, &ArchiveImporter::abort_query, R.move_as_error());
-    } else {
-      td::actor::send_closure(SelfId, &ArchiveImporter::checked_shard_client_seqno, seqno);
+bool ArchiveImporter::is_base_shard_block(const BlockIdExt &block_id) const {
+  for (auto &top : base_top_blocks_) {
+    if (shard_intersects(top.shard_full(), block_id.shard_full()) && block_id.seqno() <= top.seqno()) {
+      return true;
     }
-  });
+  }
+  return false;
+}
 
-  td::MultiPromise mp;
-  auto ig = mp.init_guard();
-  ig.add_promise(std::move(P));
+td::Status ArchiveImporter::add_shard_block(BlockIdExt block_id, BlockIdExt masterchain_block_id) {
+  auto get_prev = [&](const BlockIdExt &id) -> td::Result<std::vector<BlockIdExt>> {
+    std::vector<BlockIdExt> prev;
+    auto it = blocks_.find(id);
+    if (it == blocks_.end() || id.seqno() == 0) {
+      // blocks that are not in the archive have no known dependencies: they must be applied already
+      return prev;
+    }
+    TRY_RESULT(data, package_->read(it->second[1]));
+    if (sha256_bits256(data.second.as_slice()) != id.file_hash) {
+      return td::Status::Error(ErrorCode::protoviolation, "bad block file hash");
+    }
+    TRY_RESULT(block, create_block(id, std::move(data.second)));
+    BlockIdExt mc_blkid;
+    bool after_split;
+    TRY_STATUS(block::unpack_block_prev_blk_try(block->root_cell(), id, prev, mc_blkid, after_split));
+    shard_block_data_[id] = std::move(block);
+    return prev;
+  };
+  // the walk stops at the shard top blocks of the last masterchain block the shard client has processed
+  return shard_blocks_.add_top_block(block_id, masterchain_block_id, get_prev,
+                                     [&](const BlockIdExt &id) { return is_base_shard_block(id); });
+}
 
-  for (auto &shard : s) {
-    apply_shard_block(shard->top_block_id(), state->get_block_id(), ig.get_promise());
+void ArchiveImporter::run_shard_blocks() {
+  while (shard_blocks_running_ < apply_parallelism()) {
+    auto R = shard_blocks_.take_ready();
+    if (!R) {
+      break;
+    }
+    auto block_id = R.unwrap();
+    td::Ref<BlockData> data;
+    auto it = shard_block_data_.find(block_id);
+    if (it != shard_block_data_.end()) {
+      data = std::move(it->second);
+      shard_block_data_.erase(it);
+    }
+    shard_blocks_running_++;
+    apply_shard_block(block_id, shard_blocks_.masterchain_block_id(block_id), std::move(data),
+                      [SelfId = actor_id(this), block_id](td::Result<td::Unit> R) {
+                        td::actor::send_closure(SelfId, &ArchiveImporter::applied_shard_block, block_id,
+                                                std::move(R));
+                      });
+  }
+}
+
+void ArchiveImporter::applied_shard_block(BlockIdExt block_id, td::Result<td::Unit> R) {
+  CHECK(shard_blocks_running_ > 0);
+  shard_blocks_running_--;
+  if (R.is_error()) {
+    abort_query(R.move_as_error_prefix(PSTRING() << "failed to apply shard block " << block_id.to_str() << ": "));
+    return;
+  }
+  shard_blocks_.applied(block_id);
+
+  run_shard_blocks();
+  if (!advance_shard_client_seqno()) {
+    expand_next_masterchain_block();
   }
 }
 
-void ArchiveImporter::checked_shard_client_seqno(BlockSeqno seqno) {
-  CHECK(shard_client_seqno_ + 1 == seqno);
-  shard_client_seqno_++;
-  check_next_shard_client_seqno(seqno + 1);
+bool ArchiveImporter::advance_shard_client_seqno() {
+  while (shard_client_seqno_ < shard_client_expanded_seqno_ && shard_blocks_.unapplied(shard_client_seqno_ + 1) == 0) {
+    shard_client_seqno_++;
+  }
+  if (shard_client_seqno_ >= state_->get_seqno()) {
+    CHECK(shard_blocks_running_ == 0);
+    finish_query();
+    return true;
+  }
+  return false;
 }
 
 void ArchiveImporter::apply_shard_block(BlockIdExt block_id, BlockIdExt masterchain_block_id,
-                                        td::Promise<td::Unit> promise) {
-  auto P = td::PromiseCreator::lambda(
-      [SelfId = actor_id(this), masterchain_block_id, promise = std::move(promise)](td::Result<BlockHandle> R) mutable {
-        R.ensure();
-        td::actor::send_closure(SelfId, &ArchiveImporter::apply_shard_block_cont1, R.move_as_ok(), masterchain_block_id,
-                                std::move(promise));
-      });
+                                        td::Ref<BlockData> data, td::Promise<td::Unit> promise) {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), masterchain_block_id, data = std::move(data),
+                                       promise = std::move(promise)](td::Result<BlockHandle> R) mutable {
+    R.ensure();
+    td::actor::send_closure(SelfId, &ArchiveImporter::apply_shard_block_cont1, R.move_as_ok(), masterchain_block_id,
+                            std::move(data), std::move(promise));
+  });
   td::actor::send_closure(manager_, &ValidatorManager::get_block_handle, block_id, true, std::move(P));
 }
 
 void ArchiveImporter::apply_shard_block_cont1(BlockHandle handle, BlockIdExt masterchain_block_id,
-                                              td::Promise<td::Unit> promise) {
+                                              td::Ref<BlockData> data, td::Promise<td::Unit> promise) {
   if (handle->is_applied()) {
     promise.set_value(td::Unit());
     return;
@@ -294,86 +404,36 @@ void ArchiveImporter::apply_shard_block_cont1(BlockHandle handle, BlockIdExt mas
   }
 
   auto it = blocks_.find(handle->id());
-  if (it == blocks_.end()) {
+  if (it == blocks_.end() || data.is_null()) {
     promise.set_error(td::Status::Error(ErrorCode::notready, PSTRING() << "no proof for shard block " << handle->id()));
     return;
   }
-  TRY_RESULT_PROMISE(promise, data, package_->read(it->second[0]));
-  TRY_RESULT_PROMISE(promise, proof, create_proof_link(handle->id(), std::move(data.second)));
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), handle, masterchain_block_id,
+  TRY_RESULT_PROMISE(promise, proof_data, package_->read(it->second[0]));
+  TRY_RESULT_PROMISE(promise, proof, create_proof_link(handle->id(), std::move(proof_data.second)));
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), handle, masterchain_block_id, data = std::move(data),
                                        promise = std::move(promise)](td::Result<BlockHandle> R) mutable {
     if (R.is_error()) {
       promise.set_error(R.move_as_error());
     } else {
       td::actor::send_closure(SelfId, &ArchiveImporter::apply_shard_block_cont2, std::move(handle),
-                              masterchain_block_id, std::move(promise));
+                              masterchain_block_id, std::move(data), std::move(promise));
     }
   });
   run_check_proof_link_query(handle->id(), std::move(proof), manager_, td::Timestamp::in(10.0), std::move(P));
 }
 
 void ArchiveImporter::apply_shard_block_cont2(BlockHandle handle, BlockIdExt masterchain_block_id,
-                                              td::Promise<td::Unit> promise) {
+                                              td::Ref<BlockData> data, td::Promise<td::Unit> promise) {
   if (handle->is_applied()) {
     promise.set_value(td::Unit());
     return;
   }
   CHECK(handle->id().seqno() > 0);
-
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), handle, masterchain_block_id,
-                                       promise = std::move(promise)](td::Result<td::Unit> R) mutable {
-    if (R.is_error()) {
-      promise.set_error(R.move_as_error());
-    } else {
-      td::actor::send_closure(SelfId, &ArchiveImporter::apply_shard_block_cont3, std::move(handle),
-                              masterchain_block_id, std::move(promise));
-    }
-  });
-  if (!handle->merge_before() && handle->one_prev(true).shard_full() == handle->id().shard_full()) {
-    apply_shard_block(handle->one_prev(true), masterchain_block_id, std::move(P));
-  } else {
-    td::MultiPromise mp;
-    auto ig = mp.init_guard();
-    ig.add_promise(std::move(P));
-    check_shard_block_applied(handle->one_prev(true), ig.get_promise());
-    if (handle->merge_before()) {
-      check_shard_block_applied(handle->one_prev(false), ig.get_promise());
-    }
-  }
-}
-
-void ArchiveImporter::apply_shard_block_cont3(BlockHandle handle, BlockIdExt masterchain_block_id,
-                                              td::Promise<td::Unit> promise) {
-  auto it = blocks_.find(handle->id());
-  CHECK(it != blocks_.end());
-  TRY_RESULT_PROMISE(promise, data, package_->read(it->second[1]));
-  if (sha256_bits256(data.second.as_slice()) != handle->id().file_hash) {
-    promise.set_error(td::Status::Error(ErrorCode::protoviolation, "bad block file hash"));
-    return;
-  }
-  TRY_RESULT_PROMISE(promise, block, create_block(handle->id(), std::move(data.second)));
-
-  run_apply_block_query(handle->id(), std::move(block), masterchain_block_id, manager_, td::Timestamp::in(600.0),
+  // previous blocks are applied: they are dependencies of this block in shard_blocks_
+  run_apply_block_query(handle->id(), std::move(data), masterchain_block_id, manager_, td::Timestamp::in(600.0),
                         std::move(promise));
 }
 
-void ArchiveImporter::check_shard_block_applied(BlockIdExt block_id, td::Promise<td::Unit> promise) {
-  auto P = td::PromiseCreator::lambda(
-      [SelfId = actor_id(this), promise = std::move(promise)](td::Result<BlockHandle> R) mutable {
-        if (R.is_error()) {
-          promise.set_error(R.move_as_error());
-        } else {
-          auto handle = R.move_as_ok();
-          if (!handle->is_applied()) {
-            promise.set_error(td::Status::Error(ErrorCode::notready, "not applied"));
-          } else {
-            promise.set_value(td::Unit());
-          }
-        }
-      });
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_handle, block_id, false, std::move(P));
-}
-
 void ArchiveImporter::abort_query(td::Status error) {
   LOG(INFO) << error;
   finish_query();
@@ -21,6 +21,7 @@
 #include "td/actor/actor.h"
 #include "validator/interfaces/validator-manager.h"
 #include "validator/db/package.hpp"
+#include "validator/shard-block-graph.hpp"
 
 namespace ton {
 
@@ -42,14 +43,21 @@ class ArchiveImporter : public td::actor::Actor {
   void got_new_materchain_state(td::Ref<MasterchainState> state);
   void checked_all_masterchain_blocks(BlockSeqno seqno);
 
-  void check_next_shard_client_seqno(BlockSeqno seqno);
-  void checked_shard_client_seqno(BlockSeqno seqno);
+  void load_masterchain_state(BlockSeqno seqno, td::Promise<td::Ref<MasterchainState>> promise);
+  void got_base_masterchain_state(td::Ref<MasterchainState> state);
+  void expand_next_masterchain_block();
   void got_masterchain_state(td::Ref<MasterchainState> state);
-  void apply_shard_block(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::Unit> promise);
-  void apply_shard_block_cont1(BlockHandle handle, BlockIdExt masterchain_block_id, td::Promise<td::Unit> promise);
-  void apply_shard_block_cont2(BlockHandle handle, BlockIdExt masterchain_block_id, td::Promise<td::Unit> promise);
-  void apply_shard_block_cont3(BlockHandle handle, BlockIdExt masterchain_block_id, td::Promise<td::Unit> promise);
-  void check_shard_block_applied(BlockIdExt block_id, td::Promise<td::Unit> promise);
+  td::Status add_shard_block(BlockIdExt block_id, BlockIdExt masterchain_block_id);
+  bool is_base_shard_block(const BlockIdExt &block_id) const;
+  void run_shard_blocks();
+  void applied_shard_block(BlockIdExt block_id, td::Result<td::Unit> R);
+  bool advance_shard_client_seqno();
+  void apply_shard_block(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Ref<BlockData> data,
+                         td::Promise<td::Unit> promise);
+  void apply_shard_block_cont1(BlockHandle handle, BlockIdExt masterchain_block_id, td::Ref<BlockData> data,
+                               td::Promise<td::Unit> promise);
+  void apply_shard_block_cont2(BlockHandle handle, BlockIdExt masterchain_block_id, td::Ref<BlockData> data,
+                               td::Promise<td::Unit> promise);
 
  private:
   std::string path_;
@@ -65,6 +73,18 @@ class ArchiveImporter : public td::actor::Actor {
 
   std::map<BlockSeqno, BlockIdExt> masterchain_blocks_;
   std::map<BlockIdExt, std::array<td::uint64, 2>> blocks_;
+
+  // shard blocks waiting to be applied, with the data of those read from the archive
+  ShardBlockGraph shard_blocks_;
+  std::map<BlockIdExt, td::Ref<BlockData>> shard_block_data_;
+  size_t shard_blocks_running_ = 0;
+  BlockSeqno shard_client_expanded_seqno_ = 0;
+  bool loading_masterchain_state_ = false;
+  std::vector<BlockIdExt> base_top_blocks_;
+
+  size_t apply_parallelism() const {
+    return std::max<size_t>(opts_->get_archive_import_parallelism(), 1);
+  }
 };
 
 }  // namespace validator
@@ -50,6 +50,7 @@ class Db : public td::actor::Actor {
   virtual void store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                                  td::Promise<td::Ref<ShardState>> promise) = 0;
   virtual void get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) = 0;
+  virtual void get_block_state_for_litequery(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) = 0;
   virtual void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) = 0;
   virtual void get_last_deleted_mc_state(td::Promise<BlockSeqno> promise) = 0;
 
@@ -61,7 +62,8 @@ class Db : public td::actor::Actor {
   virtual void get_persistent_state_file(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                          td::Promise<td::BufferSlice> promise) = 0;
   virtual void get_persistent_state_file_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                               td::int64 max_length, td::Promise<td::BufferSlice> promise) = 0;
+                                               td::int64 max_length, bool stored_format,
+                                               td::Promise<td::BufferSlice> promise) = 0;
   virtual void check_persistent_state_file_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                                   td::Promise<bool> promise) = 0;
   virtual void store_zero_state_file(BlockIdExt block_id, td::BufferSlice state, td::Promise<td::Unit> promise) = 0;
@@ -21,9 +21,31 @@
 #include "td/actor/actor.h"
 #include "td/utils/buffer.h"
 #include "common/bitstring.h"
+#include "ton/ton-types.h"
+#include "vm/cells.h"
 
 namespace ton::validator {
 
+// Account state with its proofs, as computed for getAccountState and runSmcMethod.
+// Cached per (reference block, account) and shared between these queries.
+struct LiteServerAccountState {
+  BlockIdExt base_blk_id, blk_id, master_ref;
+  UnixTime gen_utime = 0;
+  LogicalTime gen_lt = 0;
+  td::BufferSlice shard_proof, state_proof;
+  td::Ref<vm::Cell> account;
+  // size of the account cells, taken from its storage stat when the entry is created
+  td::uint64 account_size = 0;
+
+  LiteServerAccountState clone() const {
+    return {base_blk_id, blk_id, master_ref, gen_utime, gen_lt, shard_proof.clone(), state_proof.clone(),
+            account, account_size};
+  }
+  size_t size() const {
+    return shard_proof.size() + state_proof.size() + 3 * sizeof(BlockIdExt) + account_size;
+  }
+};
+
 class LiteServerCache : public td::actor::Actor {
  public:
   ~LiteServerCache() override = default;
@@ -31,6 +53,9 @@ class LiteServerCache : public td::actor::Actor {
   virtual void lookup(td::Bits256 key, td::Promise<td::BufferSlice> promise) = 0;
   virtual void update(td::Bits256 key, td::BufferSlice value) = 0;
 
+  virtual void lookup_account_state(td::Bits256 key, td::Promise<LiteServerAccountState> promise) = 0;
+  virtual void update_account_state(td::Bits256 key, LiteServerAccountState value) = 0;
+
   virtual void process_send_message(td::Bits256 key, td::Promise<td::Unit> promise) = 0;
   virtual void drop_send_message_from_cache(td::Bits256 key) = 0;
 };
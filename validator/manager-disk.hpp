@@ -113,7 +113,8 @@ class ValidatorManagerImpl : public ValidatorManager {
   void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                             td::Promise<td::BufferSlice> promise) override;
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                  td::int64 max_length, td::Promise<td::BufferSlice> promise) override {
+                                  td::int64 max_length, bool stored_format,
+                                  td::Promise<td::BufferSlice> promise) override {
     UNREACHABLE();
   }
   void get_previous_persistent_state_files(
@@ -41,6 +41,7 @@
 
 #include "td/utils/Random.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/JsonBuilder.h"
 
 #include "common/delay.h"
@@ -303,10 +304,10 @@ void ValidatorManagerImpl::get_persistent_state(BlockIdExt block_id, BlockIdExt
 }
 
 void ValidatorManagerImpl::get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id,
-                                                      td::int64 offset, td::int64 max_length,
+                                                      td::int64 offset, td::int64 max_length, bool stored_format,
                                                       td::Promise<td::BufferSlice> promise) {
   td::actor::send_closure(db_, &Db::get_persistent_state_file_slice, block_id, masterchain_block_id, offset, max_length,
-                          std::move(promise));
+                          stored_format, std::move(promise));
 }
 
 void ValidatorManagerImpl::get_previous_persistent_state_files(
@@ -412,11 +413,40 @@ void ValidatorManagerImpl::add_external_message(td::Ref<ExtMessage> msg, int pri
       return;
     }
     ext_msgs_[old_priority].erase(id);
+  } else {
+    ShardIdFull partition = ext_msg_partition(id.dst);
+    size_t partition_size = 0;
+    for (auto &p : ext_msgs_) {
+      partition_size += p.second.partition_size(partition);
+    }
+    if (partition_size >= max_ext_msg_per_partition() && !evict_ext_message_from_partition(partition, priority)) {
+      VLOG(VALIDATOR_DEBUG) << "dropping ext message: mempool partition " << partition.to_str() << " is full";
+      return;
+    }
   }
-  msgs.ext_messages_.emplace(id, std::move(message));
-  msgs.ext_addr_messages_[address].emplace(id.hash, id);
+  msgs.insert(id, std::move(message));
   ext_messages_hashes_[id.hash] = {priority, id};
 }
+
+bool ValidatorManagerImpl::evict_ext_message_from_partition(ShardIdFull partition, int max_priority) {
+  // evict a message with the lowest priority present in the partition (must be below max_priority)
+  MessageId<ExtMessage> left{AccountIdPrefixFull{partition.workchain, partition.shard & (partition.shard - 1)},
+                             Bits256::zero()};
+  for (auto &p : ext_msgs_) {
+    if (p.first >= max_priority) {
+      break;
+    }
+    auto &msgs = p.second;
+    auto it = msgs.ext_messages_.lower_bound(left);
+    if (it != msgs.ext_messages_.end() && shard_contains(partition, it->first.dst)) {
+      ext_messages_hashes_.erase(it->first.hash);
+      msgs.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
 void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) {
   auto state = do_get_last_liteserver_state();
   if (state.is_null()) {
@@ -453,7 +483,7 @@ void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Prom
     });
   };
   ++ls_stats_check_ext_messages_;
-  run_check_external_message(std::move(message), actor_id(this), std::move(promise));
+  td::actor::send_closure(ext_msg_checker_, &ExtMessageChecker::check_message, std::move(message), std::move(promise));
 }
 
 void ValidatorManagerImpl::new_ihr_message(td::BufferSlice data) {
@@ -889,9 +919,8 @@ void ValidatorManagerImpl::get_external_messages(
       }
       ++processed;
       if (it->second->expired()) {
-        msgs.ext_addr_messages_[it->second->address()].erase(it->first.hash);
         ext_messages_hashes_.erase(it->first.hash);
-        it = msgs.ext_messages_.erase(it);
+        it = msgs.erase(it);
         ++deleted;
         continue;
       }
@@ -1613,6 +1642,7 @@ void ValidatorManagerImpl::send_block_broadcast(BlockBroadcast broadcast, bool c
 void ValidatorManagerImpl::start_up() {
   db_ = create_db_actor(actor_id(this), db_root_, opts_);
   lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
+  ext_msg_checker_ = td::actor::create_actor<ExtMessageChecker>("extmsgchecker", actor_id(this));
   token_manager_ = td::actor::create_actor<TokenManager>("tokenmanager");
   td::mkdir(db_root_ + "/tmp/").ensure();
   td::mkdir(db_root_ + "/catchains/").ensure();
@@ -1805,6 +1835,10 @@ void ValidatorManagerImpl::prestart_sync() {
 }
 
 void ValidatorManagerImpl::download_next_archive() {
+  if (archive_importing_) {
+    return;
+  }
+  archive_waiting_ = false;
   if (!out_of_sync()) {
     finish_prestart_sync();
     return;
@@ -1820,28 +1854,90 @@ void ValidatorManagerImpl::download_next_archive() {
       return;
     }
   }
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::string> R) {
-    if (R.is_error()) {
-      LOG(INFO) << "failed to download archive slice: " << R.error();
-      delay_action([SelfId]() { td::actor::send_closure(SelfId, &ValidatorManagerImpl::download_next_archive); },
-                   td::Timestamp::in(2.0));
-    } else {
-      td::actor::send_closure(SelfId, &ValidatorManagerImpl::downloaded_archive_slice, R.move_as_ok(), true);
-    }
+
+  if (!archive_prefetcher_) {
+    archive_prefetcher_ =
+        std::make_unique<ArchivePrefetcher>(opts_->get_sync_archive_window(), opts_->get_sync_archive_temp_limit());
+  }
+  for (auto &name : archive_prefetcher_->set_next(seqno + 1)) {
+    td::unlink(name).ignore();
+  }
+  auto name = archive_prefetcher_->take_next();
+  if (name) {
+    downloaded_archive_slice(name.unwrap(), true);
+  } else {
+    archive_waiting_ = true;
+  }
+  prefetch_archives();
+}
+
+void ValidatorManagerImpl::start_archive_download(BlockSeqno seqno) {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), seqno](td::Result<std::string> R) {
+    td::actor::send_closure(SelfId, &ValidatorManagerImpl::got_archive_download, seqno, std::move(R));
   });
-  callback_->download_archive(seqno + 1, db_root_ + "/tmp/", td::Timestamp::in(36000.0), std::move(P));
+  callback_->download_archive(seqno, db_root_ + "/tmp/", td::Timestamp::in(36000.0), std::move(P));
+}
+
+void ValidatorManagerImpl::got_archive_download(BlockSeqno seqno, td::Result<std::string> R) {
+  if (!archive_prefetcher_) {
+    if (R.is_ok()) {
+      td::unlink(R.ok()).ignore();
+    }
+    return;
+  }
+  if (R.is_error()) {
+    LOG(INFO) << "failed to download archive slice #" << seqno << ": " << R.error();
+    archive_prefetcher_->download_failed(seqno, td::Timestamp::now());
+    prefetch_archives();
+    return;
+  }
+  auto name = R.move_as_ok();
+  auto S = td::stat(name);
+  td::uint64 size = S.is_ok() ? S.ok().size_ : 0;
+  if (!archive_prefetcher_->download_finished(seqno, name, size)) {
+    td::unlink(name).ignore();
+  }
+  if (archive_waiting_ && seqno == archive_prefetcher_->next()) {
+    download_next_archive();
+  } else {
+    prefetch_archives();
+  }
+}
+
+void ValidatorManagerImpl::prefetch_archives() {
+  auto now = td::Timestamp::now();
+  for (auto seqno : archive_prefetcher_->start_downloads(now)) {
+    start_archive_download(seqno);
+  }
+  auto retry_at = archive_prefetcher_->next_retry(now);
+  if (retry_at && (!archive_retry_at_ || retry_at < archive_retry_at_)) {
+    archive_retry_at_ = retry_at;
+    delay_action([SelfId = actor_id(this)]() {
+                   td::actor::send_closure(SelfId, &ValidatorManagerImpl::retry_archive_downloads);
+                 },
+                 retry_at);
+  }
+}
+
+void ValidatorManagerImpl::retry_archive_downloads() {
+  if (archive_retry_at_ && archive_retry_at_.is_in_past()) {
+    archive_retry_at_ = td::Timestamp::never();
+  }
+  if (archive_prefetcher_) {
+    prefetch_archives();
+  }
 }
 
 void ValidatorManagerImpl::downloaded_archive_slice(std::string name, bool is_tmp) {
   LOG(INFO) << "downloaded archive slice: " << name;
+  archive_importing_ = true;
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), name, is_tmp](td::Result<std::vector<BlockSeqno>> R) {
     if (is_tmp) {
       td::unlink(name).ensure();
     }
     if (R.is_error()) {
       LOG(INFO) << "failed to check downloaded archive slice: " << R.error();
-      delay_action([SelfId]() { td::actor::send_closure(SelfId, &ValidatorManagerImpl::download_next_archive); },
-                   td::Timestamp::in(2.0));
+      td::actor::send_closure(SelfId, &ValidatorManagerImpl::checked_archive_slice, std::vector<BlockSeqno>{});
     } else {
       td::actor::send_closure(SelfId, &ValidatorManagerImpl::checked_archive_slice, R.move_as_ok());
     }
@@ -1855,6 +1951,14 @@ void ValidatorManagerImpl::downloaded_archive_slice(std::string name, bool is_tm
 }
 
 void ValidatorManagerImpl::checked_archive_slice(std::vector<BlockSeqno> seqno) {
+  if (seqno.empty()) {
+    // import failed
+    archive_importing_ = false;
+    delay_action(
+        [SelfId = actor_id(this)]() { td::actor::send_closure(SelfId, &ValidatorManagerImpl::download_next_archive); },
+        td::Timestamp::in(2.0));
+    return;
+  }
   CHECK(seqno.size() == 2);
   LOG(INFO) << "checked downloaded archive slice: mc_top_seqno=" << seqno[0] << " shard_top_seqno_=" << seqno[1];
   CHECK(seqno[0] <= last_masterchain_seqno_);
@@ -1874,7 +1978,7 @@ void ValidatorManagerImpl::checked_archive_slice(std::vector<BlockSeqno> seqno)
         auto P = td::PromiseCreator::lambda([SelfId, client, handle](td::Result<td::Ref<ShardState>> R) mutable {
           auto P = td::PromiseCreator::lambda([SelfId](td::Result<td::Unit> R) {
             R.ensure();
-            td::actor::send_closure(SelfId, &ValidatorManagerImpl::download_next_archive);
+            td::actor::send_closure(SelfId, &ValidatorManagerImpl::finished_archive_import);
           });
           td::actor::send_closure(client, &ShardClient::force_update_shard_client_ex, std::move(handle),
                                   td::Ref<MasterchainState>{R.move_as_ok()}, std::move(P));
@@ -1884,8 +1988,23 @@ void ValidatorManagerImpl::checked_archive_slice(std::vector<BlockSeqno> seqno)
   get_block_handle(b, true, std::move(P));
 }
 
+void ValidatorManagerImpl::finished_archive_import() {
+  archive_importing_ = false;
+  download_next_archive();
+}
+
 void ValidatorManagerImpl::finish_prestart_sync() {
   to_import_.clear();
+  if (archive_prefetcher_) {
+    LOG(INFO) << "initial sync: " << archive_prefetcher_->stats_hits() << " archive slices were downloaded ahead, "
+              << archive_prefetcher_->stats_misses() << " were waited for, " << archive_prefetcher_->stats_dropped()
+              << " were dropped, " << archive_prefetcher_->stats_failed() << " downloads failed";
+    for (auto &name : archive_prefetcher_->clear()) {
+      td::unlink(name).ignore();
+    }
+    archive_prefetcher_ = nullptr;
+    archive_retry_at_ = td::Timestamp::never();
+  }
 
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Unit> R) {
     R.ensure();
@@ -1919,6 +2038,7 @@ void ValidatorManagerImpl::new_masterchain_block() {
 
   update_shards();
   update_shard_blocks();
+  td::actor::send_closure(ext_msg_checker_, &ExtMessageChecker::new_masterchain_block, last_masterchain_seqno_);
 
   if (!shard_client_.empty()) {
     td::actor::send_closure(shard_client_, &ShardClient::new_masterchain_block_notification,
@@ -2767,6 +2887,14 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
     vec.emplace_back("rotatemasterchainblock", last_rotate_block_id_.to_str());
     //vec.emplace_back("shardclientmasterchainseqno", td::to_string(min_confirmed_masterchain_seqno_));
     vec.emplace_back("stateserializermasterchainseqno", td::to_string(state_serializer_masterchain_seqno_));
+    if (archive_prefetcher_) {
+      auto &p = *archive_prefetcher_;
+      vec.emplace_back("syncarchives", PSTRING() << "downloading=" << p.downloading() << " ready=" << p.ready()
+                                                 << " (" << td::format::as_size(p.ready_size())
+                                                 << ") hits=" << p.stats_hits() << " misses=" << p.stats_misses()
+                                                 << " dropped=" << p.stats_dropped()
+                                                 << " failed=" << p.stats_failed());
+    }
 
     td::actor::send_closure(db_, &Db::get_last_deleted_mc_state,
                             [promise = merger.make_promise(""),
@@ -2888,11 +3016,17 @@ void ValidatorManagerImpl::log_validator_session_stats(BlockIdExt block_id,
     rounds.push_back(create_tl_object<ton_api::validatorSession_statsRound>(round.timestamp, std::move(producers)));
   }
 
+  const auto &db = stats.catchain_db;
+  std::vector<double> latency_buckets(db.LATENCY_BOUNDS.begin(), db.LATENCY_BOUNDS.end());
+  std::vector<td::int32> latency_hist(db.latency_hist.begin(), db.latency_hist.end());
+  auto catchain_db = create_tl_object<ton_api::validatorSession_statsCatchainDb>(
+      db.writes, db.batches, db.bytes, db.max_latency, std::move(latency_buckets), std::move(latency_hist));
+
   auto obj = create_tl_object<ton_api::validatorSession_stats>(
       stats.success, create_tl_block_id(block_id), stats.timestamp, stats.self.bits256_value(), stats.session_id,
       stats.cc_seqno, stats.creator.bits256_value(), stats.total_validators, stats.total_weight, stats.signatures,
       stats.signatures_weight, stats.approve_signatures, stats.approve_signatures_weight, stats.first_round,
-      std::move(rounds));
+      std::move(rounds), std::move(catchain_db));
   auto s = td::json_encode<std::string>(td::ToJson(*obj.get()), false);
   s.erase(std::remove_if(s.begin(), s.end(), [](char c) { return c == '\n' || c == '\r'; }), s.end());
 
@@ -2993,25 +3127,26 @@ void ValidatorManagerImpl::get_block_data_for_litequery(BlockIdExt block_id, td:
 
 void ValidatorManagerImpl::get_block_state_for_litequery(BlockIdExt block_id,
                                                          td::Promise<td::Ref<ShardState>> promise) {
+  // states for lite queries are loaded from CellDb replicas, if there are any
   if (candidates_buffer_.empty()) {
     get_block_handle_for_litequery(
-        block_id, [manager = actor_id(this), promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
+        block_id, [db = db_.get(), promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
           TRY_RESULT_PROMISE(promise, handle, std::move(R));
-          td::actor::send_closure_later(manager, &ValidatorManager::get_shard_state_from_db, std::move(handle),
-                                        std::move(promise));
+          td::actor::send_closure_later(db, &Db::get_block_state_for_litequery, std::move(handle), std::move(promise));
         });
   } else {
     td::actor::send_closure(
         candidates_buffer_, &CandidatesBuffer::get_block_state, block_id,
-        [manager = actor_id(this), promise = std::move(promise), block_id](td::Result<td::Ref<ShardState>> R) mutable {
+        [manager = actor_id(this), db = db_.get(), promise = std::move(promise),
+         block_id](td::Result<td::Ref<ShardState>> R) mutable {
           if (R.is_ok()) {
             promise.set_result(R.move_as_ok());
             return;
           }
           td::actor::send_closure(manager, &ValidatorManagerImpl::get_block_handle_for_litequery,
-              block_id, [manager, promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
+              block_id, [db, promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
                 TRY_RESULT_PROMISE(promise, handle, std::move(R));
-                td::actor::send_closure_later(manager, &ValidatorManager::get_shard_state_from_db, std::move(handle),
+                td::actor::send_closure_later(db, &Db::get_block_state_for_litequery, std::move(handle),
                                               std::move(promise));
               });
         });
@@ -33,7 +33,9 @@
 #include "rldp/rldp.h"
 #include "token-manager.h"
 #include "queue-size-counter.hpp"
+#include "archive-prefetcher.hpp"
 #include "impl/candidates-buffer.hpp"
+#include "impl/ext-message-checker.hpp"
 
 #include <map>
 #include <set>
@@ -233,15 +235,39 @@ class ValidatorManagerImpl : public ValidatorManager {
     std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>> ext_messages_;
     std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, std::map<ExtMessage::Hash, MessageId<ExtMessage>>>
         ext_addr_messages_;
+    // mempool is partitioned by the top bits of the destination address, see ext_msg_partition()
+    std::map<ShardIdFull, size_t> partition_size_;
+    void insert(MessageId<ExtMessage> id, std::unique_ptr<MessageExt<ExtMessage>> message) {
+      ext_addr_messages_[message->address()].emplace(id.hash, id);
+      ++partition_size_[ext_msg_partition(id.dst)];
+      ext_messages_.emplace(id, std::move(message));
+    }
     void erase(const MessageId<ExtMessage>& id) {
       auto it = ext_messages_.find(id);
       CHECK(it != ext_messages_.end());
-      ext_addr_messages_[it->second->address()].erase(id.hash);
-      ext_messages_.erase(it);
+      erase(it);
+    }
+    decltype(ext_messages_)::iterator erase(decltype(ext_messages_)::iterator it) {
+      ext_addr_messages_[it->second->address()].erase(it->first.hash);
+      auto it2 = partition_size_.find(ext_msg_partition(it->first.dst));
+      CHECK(it2 != partition_size_.end() && it2->second > 0);
+      if (--it2->second == 0) {
+        partition_size_.erase(it2);
+      }
+      return ext_messages_.erase(it);
+    }
+    size_t partition_size(ShardIdFull partition) const {
+      auto it = partition_size_.find(partition);
+      return it == partition_size_.end() ? 0 : it->second;
     }
   };
   std::map<int, ExtMessages> ext_msgs_;  // priority -> messages
   std::map<ExtMessage::Hash, std::pair<int, MessageId<ExtMessage>>> ext_messages_hashes_;  // hash -> priority
+  td::actor::ActorOwn<ExtMessageChecker> ext_msg_checker_;
+  static ShardIdFull ext_msg_partition(const AccountIdPrefixFull &dst) {
+    return shard_prefix(dst.as_leaf_shard(), ext_msg_partition_bits());
+  }
+  bool evict_ext_message_from_partition(ShardIdFull partition, int max_priority);
   td::Timestamp cleanup_mempool_at_;
   // IHR ?
   std::map<MessageId<IhrMessage>, std::unique_ptr<MessageExt<IhrMessage>>> ihr_messages_;
@@ -321,8 +347,13 @@ class ValidatorManagerImpl : public ValidatorManager {
   void applied_hardfork();
   void prestart_sync();
   void download_next_archive();
+  void start_archive_download(BlockSeqno seqno);
+  void got_archive_download(BlockSeqno seqno, td::Result<std::string> R);
+  void prefetch_archives();
+  void retry_archive_downloads();
   void downloaded_archive_slice(std::string name, bool is_tmp);
   void checked_archive_slice(std::vector<BlockSeqno> seqno);
+  void finished_archive_import();
   void finish_prestart_sync();
   void completed_prestart_sync();
 
@@ -371,7 +402,8 @@ class ValidatorManagerImpl : public ValidatorManager {
   void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                             td::Promise<td::BufferSlice> promise) override;
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                  td::int64 max_length, td::Promise<td::BufferSlice> promise) override;
+                                  td::int64 max_length, bool stored_format,
+                                  td::Promise<td::BufferSlice> promise) override;
   void get_previous_persistent_state_files(
       BlockSeqno cur_mc_seqno, td::Promise<std::vector<std::pair<std::string, ShardIdFull>>> promise) override;
   void get_block_proof(BlockHandle handle, td::Promise<td::BufferSlice> promise) override;
@@ -674,6 +706,12 @@ class ValidatorManagerImpl : public ValidatorManager {
 
   std::map<BlockSeqno, std::pair<std::string, bool>> to_import_;
 
+  // Initial sync downloads up to get_sync_archive_window() archive slices ahead of the importer
+  std::unique_ptr<ArchivePrefetcher> archive_prefetcher_;
+  td::Timestamp archive_retry_at_;
+  bool archive_waiting_ = false;
+  bool archive_importing_ = false;
+
  private:
   std::unique_ptr<Callback> callback_;
   td::actor::ActorOwn<Db> db_;
@@ -700,6 +738,13 @@ class ValidatorManagerImpl : public ValidatorManager {
   static size_t max_ext_msg_per_addr() {
     return 3 * 10;
   }
+  static td::uint32 ext_msg_partition_bits() {
+    return 4;
+  }
+  size_t max_ext_msg_per_partition() const {
+    // one hot partition may not take more than a quarter of the mempool
+    return std::max<size_t>((size_t)max_mempool_num() / 4, 1);
+  }
 
  private:
   std::map<BlockSeqno, WaitList<td::actor::Actor, td::Unit>> shard_client_waiters_;
@@ -159,7 +159,19 @@ void DownloadState::got_block_state_description(td::BufferSlice data) {
           },
           [&, self = this](ton_api::tonNode_preparedState &f) {
             if (masterchain_block_id_.is_valid()) {
-              got_block_state_part(td::BufferSlice{}, 0);
+              auto P = td::PromiseCreator::lambda([SelfId = actor_id(self)](td::Result<td::BufferSlice> R) {
+                td::actor::send_closure(SelfId, &DownloadState::got_capabilities, std::move(R));
+              });
+              td::BufferSlice query = create_serialize_tl_object<ton_api::tonNode_getCapabilities>();
+              if (client_.empty()) {
+                td::actor::send_closure(overlays_, &overlay::Overlays::send_query, download_from_, local_id_,
+                                        overlay_id_, "get_capabilities", std::move(P), td::Timestamp::in(1.0),
+                                        std::move(query));
+              } else {
+                td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get_capabilities",
+                                        create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
+                                        td::Timestamp::in(1.0), std::move(P));
+              }
               return;
             }
             auto P = td::PromiseCreator::lambda([SelfId = actor_id(self)](td::Result<td::BufferSlice> R) {
@@ -184,10 +196,37 @@ void DownloadState::got_block_state_description(td::BufferSlice data) {
           }));
 }
 
+void DownloadState::got_capabilities(td::Result<td::BufferSlice> R) {
+  if (R.is_ok()) {
+    auto F = fetch_tl_object<ton_api::tonNode_capabilities>(R.move_as_ok(), true);
+    if (F.is_ok()) {
+      stored_format_ = F.ok()->capabilities_ & FullNode::capability_persistent_state_stored();
+    }
+  }
+  // an old node, or a node that did not answer, gets plain slices
+  got_block_state_part(td::BufferSlice{}, 0);
+}
+
 void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 requested_size) {
   bool last_part = data.size() < requested_size;
   sum_ += data.size();
-  parts_.push_back(std::move(data));
+  if (stored_format_) {
+    auto S = decoder_.feed(data);
+    if (S.is_error()) {
+      abort_query(S.move_as_error_prefix("failed to decode state: "));
+      return;
+    }
+    // the compressed stream is bounded by what is downloaded, the decoded state is not
+    if (decoder_.raw_size() > FullNode::max_state_size()) {
+      abort_query(td::Status::Error(ErrorCode::protoviolation, "decoded state is too big"));
+      return;
+    }
+    for (auto &part : decoder_.extract_decoded()) {
+      parts_.push_back(std::move(part));
+    }
+  } else {
+    parts_.push_back(std::move(data));
+  }
 
   double elapsed = prev_logged_timer_.elapsed();
   if (elapsed > 10.0) {
@@ -198,7 +237,18 @@ void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 reques
   }
 
   if (last_part) {
-    td::BufferSlice res{td::narrow_cast<std::size_t>(sum_)};
+    if (stored_format_) {
+      auto S = decoder_.finish();
+      if (S.is_error()) {
+        abort_query(S.move_as_error_prefix("failed to decode state: "));
+        return;
+      }
+    }
+    td::uint64 size = 0;
+    for (auto &p : parts_) {
+      size += p.size();
+    }
+    td::BufferSlice res{td::narrow_cast<std::size_t>(size)};
     auto S = res.as_slice();
     for (auto &p : parts_) {
       S.copy_from(p.as_slice());
@@ -219,8 +269,11 @@ void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 reques
     }
   });
 
-  td::BufferSlice query = create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSlice>(
-      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size);
+  td::BufferSlice query =
+      stored_format_ ? create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSliceStored>(
+                           create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size)
+                     : create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSlice>(
+                           create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size);
   if (client_.empty()) {
     td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
                             "download state", std::move(P), td::Timestamp::in(20.0), std::move(query),
@@ -233,8 +286,9 @@ void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 reques
 }
 
 void DownloadState::got_block_state(td::BufferSlice data) {
+  LOG(INFO) << "finished downloading state " << block_id_.to_str() << ": total=" << sum_
+            << (stored_format_ ? " (stored format)" : "") << ", bag of cells " << data.size();
   state_ = std::move(data);
-  LOG(INFO) << "finished downloading state " << block_id_.to_str() << ": total=" << sum_;
   finish_query();
 }
 
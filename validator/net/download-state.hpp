@@ -22,6 +22,7 @@
 #include "ton/ton-types.h"
 #include "validator/validator.h"
 #include "adnl/adnl-ext-client.h"
+#include "vm/boc-frames.h"
 
 namespace ton {
 
@@ -46,6 +47,7 @@ class DownloadState : public td::actor::Actor {
   void got_block_handle(BlockHandle handle);
   void got_node_to_download(adnl::AdnlNodeIdShort node);
   void got_block_state_description(td::BufferSlice data_description);
+  void got_capabilities(td::Result<td::BufferSlice> R);
   void got_block_state_part(td::BufferSlice data, td::uint32 requested_size);
   void got_block_state(td::BufferSlice data);
 
@@ -71,6 +73,9 @@ class DownloadState : public td::actor::Actor {
   td::BufferSlice state_;
   std::vector<td::BufferSlice> parts_;
   td::uint64 sum_ = 0;
+  // the peer sends the state file as it is stored, possibly compressed
+  bool stored_format_ = false;
+  vm::boc_frames::StreamDecoder decoder_;
 
   td::uint64 prev_logged_sum_ = 0;
   td::Timer prev_logged_timer_;
@@ -0,0 +1,98 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "shard-block-graph.hpp"
+
+namespace ton::validator {
+
+td::Status ShardBlockGraph::add_top_block(const BlockIdExt &block_id, const BlockIdExt &masterchain_block_id,
+                                          const GetPrev &get_prev, const IsApplied &is_applied) {
+  auto create = [&](const BlockIdExt &id) {
+    nodes_[id].masterchain_block_id = masterchain_block_id;
+    unapplied_by_masterchain_seqno_[masterchain_block_id.seqno()]++;
+    unapplied_++;
+  };
+  if (nodes_.count(block_id) || is_applied(block_id)) {
+    return td::Status::OK();
+  }
+  create(block_id);
+  std::vector<BlockIdExt> stack{block_id};
+  while (!stack.empty()) {
+    auto id = stack.back();
+    stack.pop_back();
+    TRY_RESULT(prev, get_prev(id));
+    auto &node = nodes_[id];
+    for (auto &p : prev) {
+      if (!nodes_.count(p)) {
+        if (is_applied(p)) {
+          continue;
+        }
+        create(p);
+        stack.push_back(p);
+      }
+      auto &prev_node = nodes_[p];
+      if (!prev_node.applied) {
+        prev_node.next.push_back(id);
+        node.waiting_prev++;
+      }
+    }
+    if (node.waiting_prev == 0) {
+      ready_.emplace(masterchain_block_id.seqno(), id);
+    }
+  }
+  return td::Status::OK();
+}
+
+td::optional<BlockIdExt> ShardBlockGraph::take_ready() {
+  if (ready_.empty()) {
+    return {};
+  }
+  auto block_id = ready_.begin()->second;
+  ready_.erase(ready_.begin());
+  return block_id;
+}
+
+BlockIdExt ShardBlockGraph::applied(const BlockIdExt &block_id) {
+  auto it = nodes_.find(block_id);
+  CHECK(it != nodes_.end());
+  auto &node = it->second;
+  CHECK(!node.applied && node.waiting_prev == 0);
+  node.applied = true;
+  unapplied_--;
+  unapplied_by_masterchain_seqno_[node.masterchain_block_id.seqno()]--;
+  for (auto &next_id : node.next) {
+    auto &next = nodes_[next_id];
+    CHECK(next.waiting_prev > 0);
+    if (--next.waiting_prev == 0) {
+      ready_.emplace(next.masterchain_block_id.seqno(), next_id);
+    }
+  }
+  node.next.clear();
+  return node.masterchain_block_id;
+}
+
+BlockIdExt ShardBlockGraph::masterchain_block_id(const BlockIdExt &block_id) const {
+  auto it = nodes_.find(block_id);
+  CHECK(it != nodes_.end());
+  return it->second.masterchain_block_id;
+}
+
+size_t ShardBlockGraph::unapplied(BlockSeqno masterchain_seqno) const {
+  auto it = unapplied_by_masterchain_seqno_.find(masterchain_seqno);
+  return it == unapplied_by_masterchain_seqno_.end() ? 0 : it->second;
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,70 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ton/ton-types.h"
+#include "td/utils/optional.h"
+#include "td/utils/Status.h"
+
+#include <functional>
+#include <map>
+#include <set>
+
+namespace ton::validator {
+
+/*
+ * Shard blocks of an imported archive slice as a dependency graph: a block becomes ready when all its previous
+ * blocks are applied, so chains of different shards (and of consecutive masterchain blocks) are applied concurrently.
+ * Ready blocks are taken in the order of the masterchain blocks that reference them.
+ */
+class ShardBlockGraph {
+ public:
+  // Returns the previous blocks of a block; an empty list if they are not known
+  using GetPrev = std::function<td::Result<std::vector<BlockIdExt>>(const BlockIdExt &)>;
+  // Blocks that are applied already; the walk to previous blocks stops at them
+  using IsApplied = std::function<bool(const BlockIdExt &)>;
+
+  // Adds a shard top block of a masterchain block, together with all its unapplied ancestors.
+  // The walk is iterative, so long shard chains do not grow the stack.
+  td::Status add_top_block(const BlockIdExt &block_id, const BlockIdExt &masterchain_block_id, const GetPrev &get_prev,
+                           const IsApplied &is_applied);
+  // Takes a block whose previous blocks are all applied
+  td::optional<BlockIdExt> take_ready();
+  // Marks a taken block as applied; returns the first masterchain block that references it
+  BlockIdExt applied(const BlockIdExt &block_id);
+
+  BlockIdExt masterchain_block_id(const BlockIdExt &block_id) const;
+  size_t unapplied() const {
+    return unapplied_;
+  }
+  // Number of unapplied blocks first referenced by the masterchain block
+  size_t unapplied(BlockSeqno masterchain_seqno) const;
+
+ private:
+  struct Node {
+    BlockIdExt masterchain_block_id;  // first masterchain block that references this block
+    size_t waiting_prev = 0;
+    std::vector<BlockIdExt> next;
+    bool applied = false;
+  };
+  std::map<BlockIdExt, Node> nodes_;
+  std::set<std::pair<BlockSeqno, BlockIdExt>> ready_;
+  std::map<BlockSeqno, size_t> unapplied_by_masterchain_seqno_;
+  size_t unapplied_ = 0;
+};
+
+}  // namespace ton::validator
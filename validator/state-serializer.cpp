@@ -22,6 +22,7 @@
 #include "ton/ton-io.hpp"
 #include "common/delay.h"
 #include "td/utils/filesystem.h"
+#include "vm/boc-frames.h"
 
 namespace ton {
 
@@ -294,6 +295,11 @@ void AsyncStateSerializer::PreviousStateCache::prepare_cache(ShardIdFull shard)
       continue;
     }
     LOG(INFO) << "Reading " << file << " : " << td::format::as_size(r_data.ok().size());
+    r_data = vm::boc_frames::decompress(r_data.move_as_ok());
+    if (r_data.is_error()) {
+      LOG(WARNING) << "Decompress error : " << r_data.move_as_error();
+      continue;
+    }
     auto r_root = vm::std_boc_deserialize(r_data.move_as_ok());
     if (r_root.is_error()) {
       LOG(WARNING) << "Deserialize error : " << r_root.move_as_error();
@@ -325,12 +331,14 @@ void AsyncStateSerializer::got_masterchain_state(td::Ref<MasterchainState> state
   auto write_data = [shard = state->get_shard(), hash = state->root_cell()->get_hash(), cell_db_reader,
                      previous_state_cache = previous_state_cache_,
                      fast_serializer_enabled = opts_->get_fast_state_serializer_enabled(),
+                     compress = opts_->get_persistent_state_compression(),
                      cancellation_token = cancellation_token_source_.get_cancellation_token()](td::FileFd& fd) mutable {
     if (fast_serializer_enabled) {
       previous_state_cache->prepare_cache(shard);
     }
     auto new_cell_db_reader = std::make_shared<CachedCellDbReader>(cell_db_reader, previous_state_cache->cache);
-    auto res = vm::std_boc_serialize_to_file_large(new_cell_db_reader, hash, fd, 31, std::move(cancellation_token));
+    auto res = vm::std_boc_serialize_to_file_large(new_cell_db_reader, hash, fd, 31, std::move(cancellation_token),
+                                                   compress);
     new_cell_db_reader->print_stats();
     return res;
   };
@@ -387,12 +395,14 @@ void AsyncStateSerializer::got_shard_state(BlockHandle handle, td::Ref<ShardStat
   auto write_data = [shard = state->get_shard(), hash = state->root_cell()->get_hash(), cell_db_reader,
                      previous_state_cache = previous_state_cache_,
                      fast_serializer_enabled = opts_->get_fast_state_serializer_enabled(),
+                     compress = opts_->get_persistent_state_compression(),
                      cancellation_token = cancellation_token_source_.get_cancellation_token()](td::FileFd& fd) mutable {
     if (fast_serializer_enabled) {
       previous_state_cache->prepare_cache(shard);
     }
     auto new_cell_db_reader = std::make_shared<CachedCellDbReader>(cell_db_reader, previous_state_cache->cache);
-    auto res = vm::std_boc_serialize_to_file_large(new_cell_db_reader, hash, fd, 31, std::move(cancellation_token));
+    auto res = vm::std_boc_serialize_to_file_large(new_cell_db_reader, hash, fd, 31, std::move(cancellation_token),
+                                                   compress);
     new_cell_db_reader->print_stats();
     return res;
   };
@@ -0,0 +1,200 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "db/archive-group-commit.hpp"
+
+#include "td/utils/tests.h"
+
+#include <map>
+
+namespace {
+
+using namespace ton::validator;
+
+// key-value storage where only committed transactions are durable, reads see the writes of the open transaction
+class TestKeyValue : public td::KeyValue {
+ public:
+  td::Result<GetStatus> get(td::Slice key, std::string &value) override {
+    auto it = pending_.find(key.str());
+    if (it != pending_.end()) {
+      value = it->second;
+      return GetStatus::Ok;
+    }
+    it = durable_.find(key.str());
+    if (it == durable_.end()) {
+      return GetStatus::NotFound;
+    }
+    value = it->second;
+    return GetStatus::Ok;
+  }
+  td::Result<size_t> count(td::Slice prefix) override {
+    UNREACHABLE();
+  }
+  td::Status set(td::Slice key, td::Slice value) override {
+    CHECK(in_transaction_);
+    pending_[key.str()] = value.str();
+    return td::Status::OK();
+  }
+  td::Status erase(td::Slice key) override {
+    UNREACHABLE();
+  }
+  td::Status begin_write_batch() override {
+    UNREACHABLE();
+  }
+  td::Status commit_write_batch() override {
+    UNREACHABLE();
+  }
+  td::Status abort_write_batch() override {
+    UNREACHABLE();
+  }
+  td::Status begin_transaction() override {
+    CHECK(!in_transaction_);
+    in_transaction_ = true;
+    return td::Status::OK();
+  }
+  td::Status commit_transaction() override {
+    CHECK(in_transaction_);
+    in_transaction_ = false;
+    for (auto &p : pending_) {
+      durable_[p.first] = p.second;
+    }
+    pending_.clear();
+    commits_++;
+    return td::Status::OK();
+  }
+  td::Status abort_transaction() override {
+    UNREACHABLE();
+  }
+  std::unique_ptr<td::KeyValueReader> snapshot() override {
+    UNREACHABLE();
+  }
+
+  // value that survives a crash right now
+  std::string durable(const std::string &key) const {
+    auto it = durable_.find(key);
+    return it == durable_.end() ? "" : it->second;
+  }
+  int commits() const {
+    return commits_;
+  }
+
+ private:
+  std::map<std::string, std::string> durable_, pending_;
+  bool in_transaction_ = false;
+  int commits_ = 0;
+};
+
+// a query of the archive slice: one index update in the group transaction
+struct Writer {
+  ArchiveIndexGroupCommit &group;
+  TestKeyValue &kv;
+  std::vector<int> done;
+  std::vector<std::string> durable_when_done;
+
+  void write(int query, std::string key, std::string value) {
+    group.begin(kv);
+    kv.set(key, value).ensure();
+    if (group.end_query()) {
+      group.commit(kv);
+    }
+    group.after_commit([this, query, key](td::Result<td::Unit> R) {
+      R.ensure();
+      done.push_back(query);
+      durable_when_done.push_back(kv.durable(key));
+    });
+  }
+};
+
+}  // namespace
+
+TEST(ArchiveGroupCommit, GroupedWrites) {
+  TestKeyValue kv;
+  ArchiveIndexGroupCommit group;
+  Writer writer{group, kv};
+
+  writer.write(0, "a", "a0");
+  writer.write(1, "b", "b1");
+  writer.write(2, "a", "a2");
+  writer.write(3, "c", "c3");
+  ASSERT_TRUE(group.started());
+  ASSERT_EQ(4u, group.size());
+
+  // nothing is durable and nobody is told it is done before the commit, but the queries see each other's writes
+  ASSERT_TRUE(writer.done.empty());
+  ASSERT_EQ(0, kv.commits());
+  ASSERT_EQ("", kv.durable("a"));
+  std::string value;
+  ASSERT_TRUE(kv.get("a", value).move_as_ok() == td::KeyValue::GetStatus::Ok);
+  ASSERT_EQ("a2", value);
+
+  ASSERT_EQ(4u, group.commit(kv));
+  ASSERT_EQ(1, kv.commits());
+  ASSERT_TRUE(!group.started());
+
+  // promises are resolved in the order of the queries, each of them after its update is durable
+  ASSERT_TRUE((std::vector<int>{0, 1, 2, 3}) == writer.done);
+  ASSERT_TRUE((std::vector<std::string>{"a2", "b1", "a2", "c3"}) == writer.durable_when_done);
+  // the last write of a key wins
+  ASSERT_EQ("a2", kv.durable("a"));
+  ASSERT_EQ("b1", kv.durable("b"));
+  ASSERT_EQ("c3", kv.durable("c"));
+
+  // the next query starts a new group
+  writer.write(4, "a", "a4");
+  ASSERT_TRUE(group.started());
+  ASSERT_EQ("a2", kv.durable("a"));
+  group.commit(kv);
+  ASSERT_EQ(2, kv.commits());
+  ASSERT_EQ(4, writer.done.back());
+  ASSERT_EQ("a4", writer.durable_when_done.back());
+}
+
+TEST(ArchiveGroupCommit, FullGroup) {
+  TestKeyValue kv;
+  ArchiveIndexGroupCommit group;
+  Writer writer{group, kv};
+
+  std::map<std::string, std::string> last_value;
+  std::vector<std::string> keys;
+  for (td::uint32 i = 0; i < ArchiveIndexGroupCommit::MAX_SIZE; i++) {
+    ASSERT_TRUE(writer.done.empty());
+    ASSERT_EQ(0, kv.commits());
+    auto key = "key" + std::to_string(i % 10);
+    auto value = "value" + std::to_string(i);
+    keys.push_back(key);
+    last_value[key] = value;
+    writer.write(i, key, value);
+  }
+
+  // the query that fills the group commits it, the promises of the whole group are resolved
+  ASSERT_EQ(1, kv.commits());
+  ASSERT_TRUE(!group.started());
+  ASSERT_EQ(ArchiveIndexGroupCommit::MAX_SIZE, writer.done.size());
+  for (size_t i = 0; i < writer.done.size(); i++) {
+    ASSERT_EQ(static_cast<int>(i), writer.done[i]);
+    ASSERT_EQ(last_value[keys[i]], writer.durable_when_done[i]);
+  }
+}
+
+TEST(ArchiveGroupCommit, NoGroup) {
+  ArchiveIndexGroupCommit group;
+  bool done = false;
+  group.after_commit([&](td::Result<td::Unit> R) {
+    R.ensure();
+    done = true;
+  });
+  ASSERT_TRUE(done);
+}
@@ -0,0 +1,150 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "archive-prefetcher.hpp"
+
+#include "td/utils/tests.h"
+
+namespace {
+
+using ton::BlockSeqno;
+using ton::validator::ArchivePrefetcher;
+
+std::string slice_name(BlockSeqno seqno) {
+  return "slice" + td::to_string(seqno);
+}
+
+td::Timestamp at(double t) {
+  return td::Timestamp::at(1000.0 + t);
+}
+
+}  // namespace
+
+TEST(ArchivePrefetcher, Order) {
+  ArchivePrefetcher p(3, 1 << 30);
+  ASSERT_TRUE(p.set_next(1).empty());
+  ASSERT_TRUE(!p.take_next());
+  // the slice length is not known yet: only the next slice is downloaded
+  ASSERT_EQ(std::vector<BlockSeqno>{1}, p.start_downloads(at(0)));
+  ASSERT_TRUE(p.start_downloads(at(0)).empty());
+  ASSERT_TRUE(p.download_finished(1, slice_name(1), 10));
+  ASSERT_EQ(slice_name(1), p.take_next().unwrap());
+
+  // the slice that is being imported is not downloaded again
+  ASSERT_TRUE(p.start_downloads(at(0)).empty());
+
+  // the first slice was 100 blocks long: the next ones are downloaded ahead, the next slice first
+  ASSERT_TRUE(p.set_next(101).empty());
+  ASSERT_EQ((std::vector<BlockSeqno>{101, 201, 301}), p.start_downloads(at(0)));
+  ASSERT_EQ(3u, p.downloading());
+
+  // slices arrive out of order
+  ASSERT_TRUE(p.download_finished(301, slice_name(301), 10));
+  ASSERT_TRUE(p.download_finished(201, slice_name(201), 10));
+  ASSERT_TRUE(!p.take_next());
+  ASSERT_TRUE(p.download_finished(101, slice_name(101), 10));
+  ASSERT_EQ(slice_name(101), p.take_next().unwrap());
+  ASSERT_EQ(2u, p.stats_misses());
+
+  // the window counts the slice being imported
+  ASSERT_TRUE(p.start_downloads(at(0)).empty());
+  ASSERT_TRUE(p.set_next(201).empty());
+  ASSERT_EQ(slice_name(201), p.take_next().unwrap());
+  ASSERT_EQ(std::vector<BlockSeqno>{401}, p.start_downloads(at(0)));
+
+  // a slice of another length makes the downloads ahead useless
+  auto dropped = p.set_next(351);
+  ASSERT_EQ(std::vector<std::string>{slice_name(301)}, dropped);
+  ASSERT_TRUE(!p.download_finished(401, slice_name(401), 10));
+  ASSERT_EQ((std::vector<BlockSeqno>{351, 501, 651}), p.start_downloads(at(0)));
+  ASSERT_EQ(2u, p.stats_dropped());
+  ASSERT_EQ(0u, p.ready_size());
+
+  ASSERT_TRUE(p.download_finished(501, slice_name(501), 10));
+  ASSERT_EQ(std::vector<std::string>{slice_name(501)}, p.clear());
+  ASSERT_TRUE(p.start_downloads(at(0)).empty());
+}
+
+TEST(ArchivePrefetcher, TempLimit) {
+  ArchivePrefetcher p(4, 25);
+  p.set_next(1);
+  p.start_downloads(at(0));
+  p.download_finished(1, slice_name(1), 10);
+  p.take_next();
+  p.set_next(101);
+  ASSERT_EQ((std::vector<BlockSeqno>{101, 201, 301, 401}), p.start_downloads(at(0)));
+  p.download_finished(201, slice_name(201), 20);
+  p.download_finished(301, slice_name(301), 20);
+  ASSERT_EQ(40u, p.ready_size());
+  ASSERT_TRUE(p.start_downloads(at(0)).empty());
+
+  // above the limit only the next slice is downloaded
+  p.download_failed(101, at(0));
+  ASSERT_EQ(std::vector<BlockSeqno>{101}, p.start_downloads(at(10)));
+}
+
+TEST(ArchivePrefetcher, RetryBackoff) {
+  ArchivePrefetcher p(2, 1 << 30);
+  p.set_next(1);
+  ASSERT_EQ(std::vector<BlockSeqno>{1}, p.start_downloads(at(0)));
+
+  // every failure doubles the delay before the next attempt
+  double t = 0;
+  double delay = ArchivePrefetcher::RETRY_DELAY;
+  for (int i = 0; i < 8; i++) {
+    p.download_failed(1, at(t));
+    ASSERT_EQ(at(t + delay).at(), p.next_retry(at(t)).at());
+    ASSERT_TRUE(p.start_downloads(at(t + delay - 0.1)).empty());
+    t += delay;
+    ASSERT_TRUE(!p.next_retry(at(t)));
+    ASSERT_EQ(std::vector<BlockSeqno>{1}, p.start_downloads(at(t)));
+    delay = std::min(delay * 2, ArchivePrefetcher::MAX_RETRY_DELAY);
+  }
+  ASSERT_EQ(ArchivePrefetcher::MAX_RETRY_DELAY, delay);
+  ASSERT_EQ(8u, p.stats_failed());
+
+  // a successful download resets the backoff
+  ASSERT_TRUE(p.download_finished(1, slice_name(1), 10));
+  p.take_next();
+  p.set_next(1);
+  ASSERT_EQ(std::vector<BlockSeqno>{1}, p.start_downloads(at(t)));
+  p.download_failed(1, at(t));
+  ASSERT_EQ(at(t + ArchivePrefetcher::RETRY_DELAY).at(), p.next_retry(at(t)).at());
+}
+
+TEST(ArchivePrefetcher, FailuresAhead) {
+  ArchivePrefetcher p(3, 1 << 30);
+  p.set_next(1);
+  p.start_downloads(at(0));
+  p.download_finished(1, slice_name(1), 10);
+  p.take_next();
+  p.set_next(101);
+  ASSERT_EQ((std::vector<BlockSeqno>{101, 201, 301}), p.start_downloads(at(0)));
+
+  // a failed slice ahead is retried later, the others are not held back
+  p.download_failed(201, at(0));
+  ASSERT_TRUE(p.start_downloads(at(1)).empty());
+  ASSERT_TRUE(p.download_finished(101, slice_name(101), 10));
+  ASSERT_EQ(slice_name(101), p.take_next().unwrap());
+  ASSERT_EQ(std::vector<BlockSeqno>{201}, p.start_downloads(at(2)));
+
+  // failures of slices that are not needed anymore are forgotten
+  p.download_failed(201, at(2));
+  p.set_next(151);
+  ASSERT_TRUE(!p.next_retry(at(2)));
+  ASSERT_EQ(1u, p.downloading());
+  ASSERT_EQ((std::vector<BlockSeqno>{151, 251}), p.start_downloads(at(2)));
+}
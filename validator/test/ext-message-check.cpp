@@ -0,0 +1,268 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-checker.hpp"
+#include "external-message.hpp"
+
+#include "block/block-parse.h"
+#include "vm/boc.h"
+#include "vm/dict.h"
+#include "vm/vm.h"
+
+#include "td/utils/tests.h"
+
+#include <map>
+
+namespace {
+
+using namespace ton;
+using namespace ton::validator;
+
+const UnixTime now = 1700000000;
+const LogicalTime state_lt = 1000000;
+
+vm::CellBuilder &store_empty_currencies(vm::CellBuilder &cb) {
+  // grams:(VarUInteger 16) = 0, other:ExtraCurrencyCollection = empty
+  return cb.store_long(0, 4).store_long(0, 1);
+}
+
+td::Ref<vm::Cell> make_config() {
+  vm::Dictionary config{32};
+  auto set_param = [&](int idx, td::Ref<vm::Cell> value) {
+    CHECK(config.set_ref(td::BitArray<32>(idx), std::move(value)));
+  };
+  {
+    vm::Dictionary prices{32};
+    vm::CellBuilder cb;
+    cb.store_long(0xcc, 8).store_long(0, 32).store_long(1, 64).store_long(500, 64).store_long(1000, 64).store_long(
+        500000, 64);
+    CHECK(prices.set_builder(td::BitArray<32>(0LL), cb));
+    set_param(18, prices.get_root_cell());
+  }
+  for (int idx : {20, 21}) {
+    vm::CellBuilder cb;
+    cb.store_long(0xde, 8)
+        .store_long(1000 << 16, 64)  // gas_price
+        .store_long(1000000, 64)     // gas_limit
+        .store_long(1000000, 64)     // special_gas_limit
+        .store_long(10000, 64)       // gas_credit
+        .store_long(10000000, 64)    // block_gas_limit
+        .store_long(100000000, 64)   // freeze_due_limit
+        .store_long(1000000000, 64);  // delete_due_limit
+    set_param(idx, cb.finalize());
+  }
+  for (int idx : {24, 25}) {
+    vm::CellBuilder cb;
+    cb.store_long(0xea, 8)
+        .store_long(1000000, 64)
+        .store_long(65536000, 64)
+        .store_long(6553600000, 64)
+        .store_long(98304, 32)
+        .store_long(21845, 16)
+        .store_long(21845, 16);
+    set_param(idx, cb.finalize());
+  }
+  return config.get_root_cell();
+}
+
+td::Ref<vm::Cell> make_mc_state() {
+  vm::CellBuilder extra_info;
+  extra_info.store_long(0, 16)                                      // flags
+      .store_long(0, 32)                                            // validator_list_hash_short
+      .store_long(1, 32)                                            // catchain_seqno
+      .store_long(0, 1)                                             // nx_cc_updated
+      .store_long(0, 1)                                             // prev_blocks: ahme_empty
+      .store_long(0, 1)                                             // key:Bool
+      .store_long(0, 64)                                            // max_end_lt
+      .store_long(1, 1)                                             // after_key_block
+      .store_long(0, 1);                                            // last_key_block: nothing
+  vm::CellBuilder extra;
+  extra.store_long(0xcc26, 16)
+      .store_long(0, 1)  // shard_hashes
+      .store_zeroes(256)
+      .store_ref(make_config())
+      .store_ref(extra_info.finalize());
+  store_empty_currencies(extra);
+
+  vm::CellBuilder r1;
+  r1.store_long(0, 64).store_long(0, 64);
+  store_empty_currencies(r1);
+  store_empty_currencies(r1);
+  r1.store_long(0, 1)   // libraries
+      .store_long(0, 1);  // master_ref
+
+  vm::CellBuilder cb;
+  cb.store_long(0x9023afe2, 32)
+      .store_long(42, 32)  // global_id
+      .store_long(0, 2)    // shard_ident
+      .store_long(0, 6)
+      .store_long(masterchainId, 32)
+      .store_long(0, 64)
+      .store_long(0, 32)  // seq_no
+      .store_long(0, 32)  // vert_seq_no
+      .store_long(now, 32)
+      .store_long(state_lt, 64)
+      .store_long(0, 32)  // min_ref_mc_seqno
+      .store_ref(vm::CellBuilder().finalize())
+      .store_long(0, 1)  // before_split
+      .store_ref(vm::CellBuilder().finalize())
+      .store_ref(r1.finalize())
+      .store_long(1, 1)
+      .store_ref(extra.finalize());
+  return cb.finalize();
+}
+
+StdSmcAddress make_addr(td::uint8 x) {
+  StdSmcAddress addr = StdSmcAddress::zero();
+  addr.as_slice()[0] = x;
+  return addr;
+}
+
+td::Ref<vm::CellSlice> make_shard_account(StdSmcAddress addr, td::Ref<vm::Cell> code) {
+  vm::CellBuilder acc;
+  acc.store_long(1, 1)  // account$1
+      .store_long(2, 2)
+      .store_long(0, 1)
+      .store_long(basechainId, 8)
+      .store_bits(addr.cbits(), 256);
+  CHECK(block::tlb::t_VarUInteger_7.store_integer_value(acc, td::BigInt256(2)));
+  CHECK(block::tlb::t_VarUInteger_7.store_integer_value(acc, td::BigInt256(vm::load_cell_slice(code).size())));
+  CHECK(block::tlb::t_VarUInteger_7.store_integer_value(acc, td::BigInt256(0)));
+  acc.store_long(now, 32)  // last_paid
+      .store_long(0, 1)    // due_payment
+      .store_long(100, 64);  // last_trans_lt
+  CHECK(block::tlb::t_Grams.store_integer_value(acc, td::BigInt256(10000000000LL)));
+  acc.store_long(0, 1)  // extra currencies
+      .store_long(1, 1)  // account_active
+      .store_long(0, 2)  // split_depth, special
+      .store_long(1, 1)
+      .store_ref(std::move(code))
+      .store_long(1, 1)
+      .store_ref(vm::CellBuilder().finalize())
+      .store_long(0, 1);  // library
+  return vm::CellBuilder().store_ref(acc.finalize()).store_zeroes(256).store_long(99, 64).as_cellslice_ref();
+}
+
+td::Ref<vm::CellSlice> make_none_shard_account() {
+  td::Ref<vm::Cell> account_root;
+  CHECK(block::gen::Account().cell_pack_account_none(account_root));
+  return vm::CellBuilder().store_ref(account_root).store_zeroes(256).store_long(0, 64).as_cellslice_ref();
+}
+
+td::Ref<ExtMessage> make_message(StdSmcAddress addr, td::uint32 body) {
+  vm::CellBuilder cb;
+  cb.store_long(2, 2)     // ext_in_msg_info$10
+      .store_long(0, 2)   // src: addr_none
+      .store_long(2, 2)   // dest: addr_std
+      .store_long(0, 1)
+      .store_long(basechainId, 8)
+      .store_bits(addr.cbits(), 256)
+      .store_long(0, 4)   // import_fee
+      .store_long(0, 1)   // init
+      .store_long(0, 1)   // body
+      .store_long(body, 32);
+  auto data = vm::std_boc_serialize(cb.finalize()).move_as_ok();
+  return ExtMessageQ::create_ext_message(std::move(data), block::SizeLimitsConfig::ExtMsgLimits{}).move_as_ok();
+}
+
+struct TestAccounts {
+  td::Ref<vm::Cell> mc_state = make_mc_state();
+  std::map<StdSmcAddress, td::Ref<vm::CellSlice>> accounts;
+  std::map<StdSmcAddress, size_t> fetches;
+
+  td::Result<ExtMessageQ::FetchedAccountState> fetch(WorkchainId wc, StdSmcAddress addr) {
+    ++fetches[addr];
+    auto it = accounts.find(addr);
+    if (it == accounts.end()) {
+      return td::Status::Error(ErrorCode::notready, "state is not available");
+    }
+    // the checker takes the masterchain state root from the fetched config
+    TRY_RESULT(config, block::ConfigInfo::extract_config(
+                           mc_state, ExtMessageQ::config_mode | block::ConfigInfo::needStateRoot));
+    config->set_block_id_ext(BlockIdExt{masterchainId, shardIdAll, 0, RootHash::zero(), FileHash::zero()});
+    return std::make_tuple(it->second, now, state_lt, std::move(config));
+  }
+};
+
+std::string result_str(const td::Result<td::Ref<ExtMessage>> &R) {
+  return R.is_ok() ? "OK" : R.error().to_string();
+}
+
+}  // namespace
+
+TEST(ExtMessageCheck, CachedMatchesUncached) {
+  vm::init_vm().ensure();
+  TestAccounts test;
+  auto accepting = make_addr(1), rejecting = make_addr(2), uninit = make_addr(3), unavailable = make_addr(4);
+  test.accounts[accepting] = make_shard_account(accepting, vm::CellBuilder().store_long(0xf800, 16).finalize());
+  // the contract returns without accepting the message
+  test.accounts[rejecting] = make_shard_account(rejecting, vm::CellBuilder().finalize());
+  test.accounts[uninit] = make_none_shard_account();
+
+  std::vector<td::Ref<ExtMessage>> messages;
+  for (td::uint32 i = 0; i < 4; i++) {
+    for (auto addr : {accepting, rejecting, uninit, unavailable}) {
+      messages.push_back(make_message(addr, i));
+    }
+  }
+
+  std::vector<std::string> uncached;
+  for (auto &message : messages) {
+    ExtMessageQ::run_message_on_fetched_state(
+        message, test.fetch(message->wc(), message->addr()),
+        [&](td::Result<td::Ref<ExtMessage>> R) { uncached.push_back(result_str(R)); });
+  }
+  ASSERT_EQ(messages.size(), uncached.size());
+  ASSERT_EQ("OK", uncached[0]);
+  for (size_t i = 1; i < 4; i++) {
+    ASSERT_TRUE(uncached[i] != "OK");
+  }
+  ASSERT_TRUE(uncached[3].find("Failed to get account state: ") != std::string::npos);
+  ASSERT_TRUE(uncached[3].find("state is not available") != std::string::npos);
+  test.fetches.clear();
+
+  std::vector<std::string> cached(messages.size());
+  size_t remaining = messages.size();
+  td::actor::Scheduler scheduler({1});
+  td::actor::ActorOwn<ExtMessageChecker> checker;
+  scheduler.run_in_context([&] {
+    checker = td::actor::create_actor<ExtMessageChecker>(
+        "checker", [&](WorkchainId wc, StdSmcAddress addr, td::Promise<ExtMessageQ::FetchedAccountState> promise) {
+          promise.set_result(test.fetch(wc, addr));
+        });
+    td::actor::send_closure(checker, &ExtMessageChecker::new_masterchain_block, 1);
+    for (size_t i = 0; i < messages.size(); i++) {
+      td::actor::send_closure(checker, &ExtMessageChecker::check_message, messages[i],
+                              [&, i](td::Result<td::Ref<ExtMessage>> R) {
+                                cached[i] = result_str(R);
+                                if (--remaining == 0) {
+                                  checker.reset();
+                                  td::actor::SchedulerContext::get()->stop();
+                                }
+                              });
+    }
+  });
+  scheduler.run();
+
+  for (size_t i = 0; i < messages.size(); i++) {
+    ASSERT_EQ(uncached[i], cached[i]);
+  }
+  // all messages to an account share one state load, failed loads are not cached
+  ASSERT_EQ(1u, test.fetches[accepting]);
+  ASSERT_EQ(1u, test.fetches[rejecting]);
+  ASSERT_EQ(1u, test.fetches[uninit]);
+  ASSERT_TRUE(test.fetches[unavailable] >= 1);
+}
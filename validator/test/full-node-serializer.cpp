@@ -0,0 +1,167 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "full-node-serializer.hpp"
+#include "ton/ton-tl.hpp"
+#include "tl-utils/tl-utils.hpp"
+#include "vm/boc.h"
+#include "vm/dict.h"
+
+#include "common/checksum.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <map>
+
+namespace {
+
+using namespace ton;
+using namespace ton::validator::fullnode;
+
+class TestCellDb : public vm::CellDbReader {
+ public:
+  void add(const td::Ref<vm::Cell> &cell) {
+    auto data_cell = cell->load_cell().move_as_ok().data_cell;
+    if (!cells_.emplace(cell->get_hash(), data_cell).second) {
+      return;
+    }
+    for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+      add(data_cell->get_ref(i));
+    }
+  }
+  td::Result<td::Ref<vm::DataCell>> load_cell(td::Slice hash) override {
+    auto it = cells_.find(vm::CellHash::from_slice(hash));
+    if (it == cells_.end()) {
+      return td::Status::Error("not found");
+    }
+    return it->second;
+  }
+
+ private:
+  std::map<vm::CellHash, td::Ref<vm::DataCell>> cells_;
+};
+
+td::Ref<vm::Cell> gen_state(td::Random::Xorshift128plus &rnd, int size) {
+  vm::Dictionary dict{64};
+  for (int i = 0; i < size; i++) {
+    vm::CellBuilder account, value;
+    account.store_long(rnd(), 64).store_long(rnd(), 64).store_long(rnd(), 64).store_long(rnd(), 64);
+    value.store_long(i, 32).store_ref(account.finalize());
+    CHECK(dict.set_builder(td::BitArray<64>(i), value));
+  }
+  return dict.get_root_cell();
+}
+
+// a cell with the layout of a block: the state update is the third reference
+td::Ref<vm::Cell> gen_block(const td::Ref<vm::Cell> &prev_state, td::Random::Xorshift128plus &rnd) {
+  vm::Dictionary state{prev_state, 64};
+  for (int i = 0; i < 10; i++) {
+    vm::CellBuilder value;
+    value.store_long(rnd(), 64);
+    CHECK(state.set_builder(td::BitArray<64>(rnd.fast(0, 999)), value));
+  }
+  vm::CellBuilder info, value_flow, extra, block;
+  info.store_long(rnd(), 64);
+  value_flow.store_long(rnd(), 64);
+  extra.store_long(rnd(), 64);
+  block.store_long(0x11ef55aa, 32)
+      .store_ref(info.finalize())
+      .store_ref(value_flow.finalize())
+      .store_ref(vm::CellBuilder::create_merkle_update(prev_state, state.get_root_cell()))
+      .store_ref(extra.finalize());
+  return block.finalize();
+}
+
+BlockIdExt block_id_of(td::Slice data, const td::Ref<vm::Cell> &root) {
+  return BlockIdExt{basechainId, shardIdAll, 100, RootHash{root->get_hash().bits()}, td::sha256_bits256(data)};
+}
+
+}  // namespace
+
+TEST(FullNodeSerializer, CandidateQuery) {
+  td::Random::Xorshift128plus rnd(123);
+  auto root = gen_block(gen_state(rnd, 1000), rnd);
+  auto data = vm::std_boc_serialize(root, 31).move_as_ok();
+  auto block_id = block_id_of(data, root);
+
+  auto query = create_serialize_tl_object<ton_api::tonNode_downloadBlockCandidate>(create_tl_block_id(block_id), 7,
+                                                                                   0x12345678);
+  auto F = fetch_tl_object<ton_api::Function>(std::move(query), true).move_as_ok();
+  ASSERT_EQ(ton_api::tonNode_downloadBlockCandidate::ID, F->get_id());
+  auto &f = static_cast<ton_api::tonNode_downloadBlockCandidate &>(*F);
+  ASSERT_TRUE(block_id == create_block_id(f.id_));
+  ASSERT_EQ(7, f.catchain_seqno_);
+  ASSERT_EQ(0x12345678u, static_cast<td::uint32>(f.validator_set_hash_));
+
+  // the answer is the candidate without cell delta, it is decoded without celldb
+  for (bool compression : {false, true}) {
+    auto answer = serialize_block_candidate_broadcast(block_id, 7, 0x12345678, data, compression).move_as_ok();
+    auto B = fetch_tl_object<ton_api::tonNode_Broadcast>(std::move(answer), true).move_as_ok();
+    ASSERT_TRUE(!is_cell_delta_broadcast(*B));
+    BlockIdExt id;
+    CatchainSeqno cc_seqno;
+    td::uint32 validator_set_hash;
+    td::BufferSlice got_data;
+    deserialize_block_candidate_broadcast(*B, id, cc_seqno, validator_set_hash, got_data, 1 << 24).ensure();
+    ASSERT_TRUE(block_id == id);
+    ASSERT_EQ(7, cc_seqno);
+    ASSERT_EQ(0x12345678u, validator_set_hash);
+    ASSERT_TRUE(block_id.file_hash == td::sha256_bits256(got_data));
+  }
+}
+
+TEST(FullNodeSerializer, CandidateCellDelta) {
+  td::Random::Xorshift128plus rnd(123);
+  auto prev_state = gen_state(rnd, 1000);
+  auto root = gen_block(prev_state, rnd);
+  auto data = vm::std_boc_serialize(root, 31).move_as_ok();
+  auto block_id = block_id_of(data, root);
+
+  auto broadcast = serialize_block_candidate_broadcast(block_id, 7, 0x12345678, data, true, true).move_as_ok();
+  auto plain = serialize_block_candidate_broadcast(block_id, 7, 0x12345678, data, true).move_as_ok();
+  ASSERT_TRUE(broadcast.size() < plain.size() / 2);
+
+  TestCellDb full_db, empty_db;
+  full_db.add(prev_state);
+  // no celldb yet is the same as an empty one
+  for (auto *cell_db : std::vector<vm::CellDbReader *>{&full_db, &empty_db, nullptr}) {
+    auto B = fetch_tl_object<ton_api::tonNode_Broadcast>(broadcast.clone(), true).move_as_ok();
+    ASSERT_TRUE(is_cell_delta_broadcast(*B));
+    BlockIdExt id;
+    CatchainSeqno cc_seqno;
+    td::uint32 validator_set_hash;
+    td::BufferSlice got_data;
+    bool cells_missing = false;
+    deserialize_block_candidate_broadcast(*B, id, cc_seqno, validator_set_hash, got_data, 1 << 24, cell_db,
+                                          &cells_missing)
+        .ensure();
+    ASSERT_TRUE(block_id == id);
+    ASSERT_EQ(7, cc_seqno);
+    ASSERT_EQ(0x12345678u, validator_set_hash);
+    if (cell_db == &full_db) {
+      ASSERT_TRUE(!cells_missing);
+      ASSERT_TRUE(block_id.file_hash == td::sha256_bits256(got_data));
+    } else {
+      ASSERT_TRUE(cells_missing);
+      ASSERT_TRUE(got_data.empty());
+      // without cells_missing, missing cells are an error
+      B = fetch_tl_object<ton_api::tonNode_Broadcast>(broadcast.clone(), true).move_as_ok();
+      ASSERT_TRUE(deserialize_block_candidate_broadcast(*B, id, cc_seqno, validator_set_hash, got_data, 1 << 24,
+                                                        cell_db)
+                      .is_error());
+    }
+  }
+}
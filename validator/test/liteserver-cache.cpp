@@ -0,0 +1,129 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-cache.hpp"
+
+#include "td/utils/tests.h"
+
+namespace {
+
+using namespace ton;
+using namespace ton::validator;
+
+BlockIdExt block_id(BlockSeqno seqno) {
+  RootHash root_hash;
+  FileHash file_hash;
+  root_hash.as_slice().fill(static_cast<char>(seqno));
+  file_hash.as_slice().fill(static_cast<char>(seqno + 1));
+  return BlockIdExt{masterchainId, shardIdAll, seqno, root_hash, file_hash};
+}
+
+StdSmcAddress account_addr(int i) {
+  StdSmcAddress addr = StdSmcAddress::zero();
+  addr.as_slice().truncate(4).copy_from(td::Slice(reinterpret_cast<const char *>(&i), 4));
+  return addr;
+}
+
+LiteServerAccountState account_state(BlockIdExt blkid, td::uint64 account_size) {
+  return LiteServerAccountState{blkid,
+                                blkid,
+                                blkid,
+                                1000,
+                                2000,
+                                td::BufferSlice("shard proof"),
+                                td::BufferSlice("state proof"),
+                                {},
+                                account_size};
+}
+
+td::Result<LiteServerAccountState> lookup(LiteServerCacheImpl &cache, td::Bits256 key) {
+  td::Result<LiteServerAccountState> result = td::Status::Error("no answer");
+  cache.lookup_account_state(key, [&](td::Result<LiteServerAccountState> R) { result = std::move(R); });
+  return result;
+}
+
+}  // namespace
+
+TEST(LiteServerCache, AccountStatePerBlock) {
+  LiteServerCacheImpl cache;
+  auto blk1 = block_id(1), blk2 = block_id(2);
+  auto addr = account_addr(1);
+  auto key1 = account_state_cache_key(blk1, masterchainId, addr);
+  auto key2 = account_state_cache_key(blk2, masterchainId, addr);
+  ASSERT_TRUE(key1 != key2);
+  ASSERT_TRUE(key1 != account_state_cache_key(blk1, basechainId, addr));
+  ASSERT_TRUE(key1 != account_state_cache_key(blk1, masterchainId, account_addr(2)));
+  ASSERT_TRUE(key1 == account_state_cache_key(blk1, masterchainId, addr));
+
+  ASSERT_TRUE(lookup(cache, key1).is_error());
+  cache.update_account_state(key1, account_state(blk1, 12345));
+
+  auto R = lookup(cache, key1);
+  ASSERT_TRUE(R.is_ok());
+  auto entry = R.move_as_ok();
+  ASSERT_TRUE(entry.blk_id == blk1);
+  ASSERT_EQ(12345u, entry.account_size);
+  ASSERT_EQ("state proof", entry.state_proof.as_slice().str());
+  // another reference block misses until its state is cached too
+  ASSERT_TRUE(lookup(cache, key2).is_error());
+
+  cache.update_account_state(key2, account_state(blk2, 1));
+  R = lookup(cache, key2);
+  ASSERT_TRUE(R.is_ok());
+  ASSERT_TRUE(R.ok().blk_id == blk2);
+  R = lookup(cache, key1);
+  ASSERT_TRUE(R.is_ok());
+  ASSERT_TRUE(R.ok().blk_id == blk1);
+}
+
+TEST(LiteServerCache, AccountStateEviction) {
+  // the account size is charged, so large accounts evict each other well before the cache has many entries
+  const td::uint64 account_size = 1 << 20;
+  auto entry_size = account_state(block_id(0), account_size).size() + 32 * 2;
+  ASSERT_TRUE(entry_size > account_size);
+  auto fit = static_cast<int>(LiteServerCacheImpl::MAX_ACCOUNT_CACHE_SIZE / entry_size);
+  ASSERT_TRUE(fit < 64);
+
+  LiteServerCacheImpl cache;
+  auto addr = account_addr(1);
+  auto key = [&](int i) { return account_state_cache_key(block_id(i), masterchainId, addr); };
+  for (int i = 0; i < fit; i++) {
+    cache.update_account_state(key(i), account_state(block_id(i), account_size));
+  }
+  for (int i = 0; i < fit; i++) {
+    ASSERT_TRUE(lookup(cache, key(i)).is_ok());
+  }
+
+  // the least recently used entry is evicted first: after 0 is looked up again, 1 is the oldest one
+  ASSERT_TRUE(lookup(cache, key(0)).is_ok());
+  cache.update_account_state(key(fit), account_state(block_id(fit), account_size));
+  ASSERT_TRUE(lookup(cache, key(fit)).is_ok());
+  ASSERT_TRUE(lookup(cache, key(0)).is_ok());
+  ASSERT_TRUE(lookup(cache, key(1)).is_error());
+  for (int i = 2; i < fit; i++) {
+    ASSERT_TRUE(lookup(cache, key(i)).is_ok());
+  }
+
+  // an account larger than the whole cache is not kept, and does not evict anything
+  cache.update_account_state(key(1000), account_state(block_id(1000), LiteServerCacheImpl::MAX_ACCOUNT_CACHE_SIZE));
+  ASSERT_TRUE(lookup(cache, key(1000)).is_error());
+  ASSERT_TRUE(lookup(cache, key(1)).is_error());
+  for (int i = 0; i <= fit; i++) {
+    if (i != 1) {
+      ASSERT_TRUE(lookup(cache, key(i)).is_ok());
+    }
+  }
+}
@@ -0,0 +1,196 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "shard-block-graph.hpp"
+
+#include "td/utils/tests.h"
+
+namespace {
+
+using namespace ton;
+using ton::validator::ShardBlockGraph;
+
+const ShardId left = shardIdAll - (shardIdAll >> 2);
+const ShardId right = shardIdAll + (shardIdAll >> 2);
+
+BlockIdExt block(ShardId shard, BlockSeqno seqno) {
+  return BlockIdExt{basechainId, shard, seqno, RootHash::zero(), FileHash::zero()};
+}
+
+BlockIdExt mc_block(BlockSeqno seqno) {
+  return BlockIdExt{masterchainId, shardIdAll, seqno, RootHash::zero(), FileHash::zero()};
+}
+
+struct TestChain {
+  std::map<BlockIdExt, std::vector<BlockIdExt>> prev;
+  std::set<BlockIdExt> applied;
+  size_t loads = 0;
+
+  ShardBlockGraph::GetPrev get_prev() {
+    return [this](const BlockIdExt &id) -> td::Result<std::vector<BlockIdExt>> {
+      loads++;
+      auto it = prev.find(id);
+      if (it == prev.end()) {
+        return std::vector<BlockIdExt>{};
+      }
+      return it->second;
+    };
+  }
+  ShardBlockGraph::IsApplied is_applied() {
+    return [this](const BlockIdExt &id) { return applied.count(id) > 0; };
+  }
+  void add_chain(ShardId shard, BlockSeqno from, BlockSeqno to) {
+    for (BlockSeqno seqno = from + 1; seqno <= to; seqno++) {
+      prev[block(shard, seqno)] = {block(shard, seqno - 1)};
+    }
+  }
+};
+
+// applies all ready blocks one by one, returns the apply order
+std::vector<BlockIdExt> apply_all(ShardBlockGraph &graph) {
+  std::vector<BlockIdExt> order;
+  while (true) {
+    auto R = graph.take_ready();
+    if (!R) {
+      break;
+    }
+    auto id = R.unwrap();
+    graph.applied(id);
+    order.push_back(id);
+  }
+  return order;
+}
+
+size_t position(const std::vector<BlockIdExt> &order, const BlockIdExt &id) {
+  auto it = std::find(order.begin(), order.end(), id);
+  CHECK(it != order.end());
+  return it - order.begin();
+}
+
+}  // namespace
+
+TEST(ShardBlockGraph, ApplyOrder) {
+  TestChain chain;
+  chain.applied.insert(block(shardIdAll, 10));
+  chain.add_chain(shardIdAll, 10, 12);
+  // split after block 12, merge at block 16
+  chain.prev[block(left, 13)] = {block(shardIdAll, 12)};
+  chain.prev[block(right, 13)] = {block(shardIdAll, 12)};
+  chain.add_chain(left, 13, 15);
+  chain.add_chain(right, 13, 14);
+  chain.prev[block(shardIdAll, 16)] = {block(left, 15), block(right, 14)};
+
+  ShardBlockGraph graph;
+  graph.add_top_block(block(shardIdAll, 12), mc_block(1), chain.get_prev(), chain.is_applied()).ensure();
+  graph.add_top_block(block(left, 14), mc_block(2), chain.get_prev(), chain.is_applied()).ensure();
+  graph.add_top_block(block(right, 14), mc_block(2), chain.get_prev(), chain.is_applied()).ensure();
+  graph.add_top_block(block(shardIdAll, 16), mc_block(3), chain.get_prev(), chain.is_applied()).ensure();
+  ASSERT_EQ(8u, graph.unapplied());
+  ASSERT_EQ(2u, graph.unapplied(1));
+  ASSERT_EQ(4u, graph.unapplied(2));
+  ASSERT_EQ(2u, graph.unapplied(3));
+  ASSERT_EQ(mc_block(2).to_str(), graph.masterchain_block_id(block(left, 13)).to_str());
+  ASSERT_EQ(mc_block(3).to_str(), graph.masterchain_block_id(block(left, 15)).to_str());
+  // every block is read once
+  ASSERT_EQ(8u, chain.loads);
+
+  // only the first block after the applied one is ready
+  auto R = graph.take_ready();
+  ASSERT_TRUE(R);
+  ASSERT_EQ(block(shardIdAll, 11).to_str(), R.value().to_str());
+  ASSERT_TRUE(!graph.take_ready());
+  ASSERT_EQ(mc_block(1).to_str(), graph.applied(block(shardIdAll, 11)).to_str());
+
+  auto order = apply_all(graph);
+  ASSERT_EQ(7u, order.size());
+  ASSERT_EQ(0u, graph.unapplied());
+  // every block is applied after its previous blocks
+  for (auto &id : order) {
+    auto it = chain.prev.find(id);
+    if (it == chain.prev.end()) {
+      continue;
+    }
+    for (auto &p : it->second) {
+      if (p != block(shardIdAll, 11)) {
+        ASSERT_TRUE(position(order, p) < position(order, id));
+      }
+    }
+  }
+  // blocks of earlier masterchain blocks go first when both are ready
+  ASSERT_TRUE(position(order, block(right, 14)) < position(order, block(left, 15)));
+  ASSERT_EQ(block(shardIdAll, 16).to_str(), order.back().to_str());
+}
+
+TEST(ShardBlockGraph, ParallelChains) {
+  TestChain chain;
+  chain.applied.insert(block(left, 0));
+  chain.applied.insert(block(right, 0));
+  chain.add_chain(left, 0, 3);
+  chain.add_chain(right, 0, 3);
+
+  ShardBlockGraph graph;
+  graph.add_top_block(block(left, 3), mc_block(1), chain.get_prev(), chain.is_applied()).ensure();
+  graph.add_top_block(block(right, 3), mc_block(1), chain.get_prev(), chain.is_applied()).ensure();
+  // a top block that is already known adds nothing
+  graph.add_top_block(block(left, 3), mc_block(2), chain.get_prev(), chain.is_applied()).ensure();
+  ASSERT_EQ(0u, graph.unapplied(2));
+
+  // the first blocks of both chains can be applied concurrently
+  auto a = graph.take_ready();
+  auto b = graph.take_ready();
+  ASSERT_TRUE(a && b);
+  ASSERT_TRUE(!graph.take_ready());
+  ASSERT_EQ(1u, a.value().seqno());
+  ASSERT_EQ(1u, b.value().seqno());
+  ASSERT_TRUE(a.value().shard_full() != b.value().shard_full());
+  graph.applied(b.value());
+  ASSERT_EQ(2u, graph.take_ready().value().seqno());
+  ASSERT_TRUE(!graph.take_ready());
+}
+
+TEST(ShardBlockGraph, LongChain) {
+  // the walk does not recurse, so a long chain does not exhaust the stack
+  const BlockSeqno length = 100000;
+  TestChain chain;
+  chain.applied.insert(block(shardIdAll, 0));
+  chain.add_chain(shardIdAll, 0, length);
+
+  ShardBlockGraph graph;
+  graph.add_top_block(block(shardIdAll, length), mc_block(1), chain.get_prev(), chain.is_applied()).ensure();
+  ASSERT_EQ(length, graph.unapplied());
+  auto order = apply_all(graph);
+  ASSERT_EQ(length, order.size());
+  for (BlockSeqno i = 0; i < length; i++) {
+    ASSERT_EQ(i + 1, order[i].seqno());
+  }
+}
+
+TEST(ShardBlockGraph, Error) {
+  TestChain chain;
+  chain.add_chain(shardIdAll, 0, 5);
+  ShardBlockGraph graph;
+  auto S = graph.add_top_block(
+      block(shardIdAll, 5), mc_block(1),
+      [&](const BlockIdExt &id) -> td::Result<std::vector<BlockIdExt>> {
+        if (id.seqno() == 3) {
+          return td::Status::Error("bad block file hash");
+        }
+        return chain.get_prev()(id);
+      },
+      chain.is_applied());
+  ASSERT_TRUE(S.is_error());
+  ASSERT_EQ("bad block file hash", S.message().str());
+}
@@ -138,6 +138,15 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_celldb_preload_all() const override {
     return celldb_preload_all_;
   }
+  td::uint64 get_celldb_cell_cache_size() const override {
+    return celldb_cell_cache_size_;
+  }
+  td::uint32 get_celldb_replicas() const override {
+    return celldb_replicas_;
+  }
+  td::uint64 get_celldb_replica_cache_size() const override {
+    return celldb_replica_cache_size_;
+  }
   td::optional<double> get_catchain_max_block_delay() const override {
     return catchain_max_block_delay_;
   }
@@ -153,6 +162,21 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_fast_state_serializer_enabled() const override {
     return fast_state_serializer_enabled_;
   }
+  size_t get_sync_archive_window() const override {
+    return sync_archive_window_;
+  }
+  td::uint64 get_sync_archive_temp_limit() const override {
+    return sync_archive_temp_limit_;
+  }
+  size_t get_archive_import_parallelism() const override {
+    return archive_import_parallelism_;
+  }
+  bool get_persistent_state_compression() const override {
+    return persistent_state_compression_;
+  }
+  double get_archive_group_commit_window() const override {
+    return archive_group_commit_window_;
+  }
 
   void set_zero_block_id(BlockIdExt block_id) override {
     zero_block_id_ = block_id;
@@ -230,6 +254,15 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_celldb_preload_all(bool value) override {
     celldb_preload_all_ = value;
   }
+  void set_celldb_cell_cache_size(td::uint64 value) override {
+    celldb_cell_cache_size_ = value;
+  }
+  void set_celldb_replicas(td::uint32 value) override {
+    celldb_replicas_ = value;
+  }
+  void set_celldb_replica_cache_size(td::uint64 value) override {
+    celldb_replica_cache_size_ = value;
+  }
   void set_catchain_max_block_delay(double value) override {
     catchain_max_block_delay_ = value;
   }
@@ -245,6 +278,21 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_fast_state_serializer_enabled(bool value) override {
     fast_state_serializer_enabled_ = value;
   }
+  void set_sync_archive_window(size_t value) override {
+    sync_archive_window_ = value;
+  }
+  void set_sync_archive_temp_limit(td::uint64 value) override {
+    sync_archive_temp_limit_ = value;
+  }
+  void set_archive_import_parallelism(size_t value) override {
+    archive_import_parallelism_ = value;
+  }
+  void set_persistent_state_compression(bool value) override {
+    persistent_state_compression_ = value;
+  }
+  void set_archive_group_commit_window(double value) override {
+    archive_group_commit_window_ = value;
+  }
 
   ValidatorManagerOptionsImpl *make_copy() const override {
     return new ValidatorManagerOptionsImpl(*this);
@@ -295,10 +343,18 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   td::optional<td::uint64> celldb_cache_size_;
   bool celldb_direct_io_ = false;
   bool celldb_preload_all_ = false;
+  td::uint64 celldb_cell_cache_size_ = 0;
+  td::uint32 celldb_replicas_ = 0;
+  td::uint64 celldb_replica_cache_size_ = 1 << 30;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool state_serializer_enabled_ = true;
   td::Ref<CollatorOptions> collator_options_{true};
   bool fast_state_serializer_enabled_ = false;
+  size_t sync_archive_window_ = 4;
+  td::uint64 sync_archive_temp_limit_ = 4ULL << 30;
+  size_t archive_import_parallelism_ = 8;
+  bool persistent_state_compression_ = false;
+  double archive_group_commit_window_ = 0.0;
 };
 
 }  // namespace validator
@@ -36,6 +36,7 @@
 #include "interfaces/shard.h"
 #include "catchain/catchain-types.h"
 #include "interfaces/external-message.h"
+#include "crypto/vm/db/DynamicBagOfCellsDb.h"
 
 namespace ton {
 
@@ -109,11 +110,19 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual td::optional<td::uint64> get_celldb_cache_size() const = 0;
   virtual bool get_celldb_direct_io() const = 0;
   virtual bool get_celldb_preload_all() const = 0;
+  virtual td::uint64 get_celldb_cell_cache_size() const = 0;
+  virtual td::uint32 get_celldb_replicas() const = 0;
+  virtual td::uint64 get_celldb_replica_cache_size() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay_slow() const = 0;
   virtual bool get_state_serializer_enabled() const = 0;
   virtual td::Ref<CollatorOptions> get_collator_options() const = 0;
   virtual bool get_fast_state_serializer_enabled() const = 0;
+  virtual size_t get_sync_archive_window() const = 0;
+  virtual td::uint64 get_sync_archive_temp_limit() const = 0;
+  virtual size_t get_archive_import_parallelism() const = 0;
+  virtual bool get_persistent_state_compression() const = 0;
+  virtual double get_archive_group_commit_window() const = 0;
 
   virtual void set_zero_block_id(BlockIdExt block_id) = 0;
   virtual void set_init_block_id(BlockIdExt block_id) = 0;
@@ -141,11 +150,19 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_celldb_cache_size(td::uint64 value) = 0;
   virtual void set_celldb_direct_io(bool value) = 0;
   virtual void set_celldb_preload_all(bool value) = 0;
+  virtual void set_celldb_cell_cache_size(td::uint64 value) = 0;
+  virtual void set_celldb_replicas(td::uint32 value) = 0;
+  virtual void set_celldb_replica_cache_size(td::uint64 value) = 0;
   virtual void set_catchain_max_block_delay(double value) = 0;
   virtual void set_catchain_max_block_delay_slow(double value) = 0;
   virtual void set_state_serializer_enabled(bool value) = 0;
   virtual void set_collator_options(td::Ref<CollatorOptions> value) = 0;
   virtual void set_fast_state_serializer_enabled(bool value) = 0;
+  virtual void set_sync_archive_window(size_t value) = 0;
+  virtual void set_sync_archive_temp_limit(td::uint64 value) = 0;
+  virtual void set_archive_import_parallelism(size_t value) = 0;
+  virtual void set_persistent_state_compression(bool value) = 0;
+  virtual void set_archive_group_commit_window(double value) = 0;
 
   static td::Ref<ValidatorManagerOptions> create(
       BlockIdExt zero_block_id, BlockIdExt init_block_id,
@@ -224,8 +241,10 @@ class ValidatorManagerInterface : public td::actor::Actor {
                                              td::Promise<bool> promise) = 0;
   virtual void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                     td::Promise<td::BufferSlice> promise) = 0;
+  // stored_format = true: bytes of the file as it is stored (possibly lz4 frames, see vm/boc-frames.h)
   virtual void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
-                                          td::int64 max_length, td::Promise<td::BufferSlice> promise) = 0;
+                                          td::int64 max_length, bool stored_format,
+                                          td::Promise<td::BufferSlice> promise) = 0;
   virtual void get_previous_persistent_state_files(
       BlockSeqno cur_mc_seqno, td::Promise<std::vector<std::pair<std::string, ShardIdFull>>> promise) = 0;
   virtual void get_block_proof(BlockHandle handle, td::Promise<td::BufferSlice> promise) = 0;
@@ -250,6 +269,7 @@ class ValidatorManagerInterface : public td::actor::Actor {
   virtual void get_download_token(size_t download_size, td::uint32 priority, td::Timestamp timeout,
                                   td::Promise<std::unique_ptr<DownloadToken>> promise) = 0;
 
+  virtual void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) = 0;
   virtual void get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise) = 0;
   virtual void get_block_data_from_db_short(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) = 0;
   virtual void get_block_candidate_from_db(PublicKey source, BlockIdExt id, FileHash collated_data_file_hash,